@@ -59,6 +59,16 @@ using namespace phrasedml;
 %newobject getLastPhraSEDML;
 %newobject getPhrasedWarnings;
 %newobject setWorkingDirectory;
+%newobject getShardPhraSEDML;
+%newobject getShardSEDML;
+%newobject getArchiveDocumentLocation;
+%newobject getArchivePhraSEDML;
+%newobject getOutputShapes;
+%newobject getCostEstimate;
+%newobject getJobPlan;
+%newobject getContentHashes;
+%newobject getExperimentDiff;
+%newobject materializeModel;
 
 %rename(getLastError) getLastPhrasedError;
 %rename(getWarnings) getPhrasedWarnings;
@@ -71,6 +81,9 @@ using namespace phrasedml;
  */
 
 %ignore freeAllPhrased;
+%ignore streamPhraSEDMLFile;
+%ignore streamPhraSEDMLString;
+%ignore setReferencedSBMLBuffers;
 
 %include "std_vector.i"
 %include "std_string.i"
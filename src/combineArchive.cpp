@@ -0,0 +1,205 @@
+#include "combineArchive.h"
+#include "parallelJobs.h"
+#include "sbml/xml/XMLInputStream.h"
+#include "sbml/xml/XMLToken.h"
+
+using namespace std;
+using namespace libsbml;
+
+PHRASEDML_CPP_NAMESPACE_BEGIN
+
+static bool hasSuffix(const string& name, const string& suffix)
+{
+  return name.size() >= suffix.size() && name.compare(name.size()-suffix.size(), suffix.size(), suffix) == 0;
+}
+
+//Reads every SED-ML document and SBML model of an archive, each on whichever thread is free.  SBML models are indexed as soon as they are read.
+class ArchiveLoadJobs : public ParallelJobs
+{
+public:
+  const ZipArchive& zip;
+  vector<string> locations;
+  size_t numSEDML;
+  vector<string> contents;
+  vector<shared_ptr<const SBMLIndex> > sbml;
+  vector<string> errors;
+
+  ArchiveLoadJobs(const ZipArchive& z, const vector<string>& sedmlLocations, const vector<string>& sbmlLocations)
+    : zip(z)
+    , locations(sedmlLocations)
+    , numSEDML(sedmlLocations.size())
+    , contents()
+    , sbml()
+    , errors()
+  {
+    locations.insert(locations.end(), sbmlLocations.begin(), sbmlLocations.end());
+    contents.resize(locations.size());
+    sbml.resize(locations.size());
+    errors.resize(locations.size());
+  }
+
+  virtual void run(size_t job)
+  {
+    if (zip.readEntry(zip.findEntry(locations[job]), contents[job], errors[job])) {
+      return;
+    }
+    if (job >= numSEDML) {
+      //A model that isn't valid XML gets an empty index, as a file would.
+      shared_ptr<SBMLIndex> index(new SBMLIndex());
+      string xmlerror;
+      index->read(contents[job], xmlerror);
+      sbml[job] = index;
+      //Only the index is needed from now on.
+      string().swap(contents[job]);
+    }
+  }
+};
+
+//Removes any './' and 'dir/../' from an archive location, along with any leading '/', since locations are relative to the root of the archive.
+string normalizeArchivePath(const string& path)
+{
+  vector<string> parts;
+  size_t start = 0;
+  while (start <= path.size()) {
+    size_t slash = path.find('/', start);
+    if (slash == string::npos) {
+      slash = path.size();
+    }
+    string part = path.substr(start, slash-start);
+    if (part == "..") {
+      if (!parts.empty()) {
+        parts.pop_back();
+      }
+    }
+    else if (!part.empty() && part != ".") {
+      parts.push_back(part);
+    }
+    start = slash+1;
+  }
+  string ret;
+  for (size_t p=0; p<parts.size(); p++) {
+    if (p > 0) {
+      ret += "/";
+    }
+    ret += parts[p];
+  }
+  return ret;
+}
+
+CombineArchive::CombineArchive()
+  : m_zip()
+  , m_sedmlLocations()
+  , m_sbmlLocations()
+  , m_sedml()
+  , m_sbml()
+{
+}
+
+CombineArchive::~CombineArchive()
+{
+}
+
+//Reads the archive's directory and manifest, but none of its documents yet.  Returns true on error, with the reason in 'error'.
+bool CombineArchive::open(const string& filename, string& error)
+{
+  m_sedmlLocations.clear();
+  m_sbmlLocations.clear();
+  m_sedml.clear();
+  m_sbml.clear();
+  if (m_zip.open(filename, error)) {
+    return true;
+  }
+  return readManifest(error);
+}
+
+//The manifest lists the format of each file.  An archive without one is read anyway, with SED-ML found by its '.sedml' extension, and models by '.xml' or '.sbml'.
+bool CombineArchive::readManifest(string& error)
+{
+  size_t manifest = m_zip.findEntry("manifest.xml");
+  if (manifest == string::npos) {
+    for (size_t e=0; e<m_zip.getNumEntries(); e++) {
+      const string& name = m_zip.getEntryName(e);
+      if (hasSuffix(name, ".sedml")) {
+        m_sedmlLocations.push_back(name);
+      }
+      else if (hasSuffix(name, ".xml") || hasSuffix(name, ".sbml")) {
+        m_sbmlLocations.push_back(name);
+      }
+    }
+    return false;
+  }
+
+  string contents;
+  if (m_zip.readEntry(manifest, contents, error)) {
+    return true;
+  }
+  XMLInputStream stream(contents.c_str(), false);
+  while (stream.isGood()) {
+    const XMLToken token = stream.next();
+    if (!token.isStart() || token.getName() != "content") {
+      continue;
+    }
+    string location = normalizeArchivePath(token.getAttrValue("location"));
+    string format = token.getAttrValue("format");
+    //Files the manifest lists but the archive lacks are skipped; any model among them will be reported as missing when it's used.
+    if (location.empty() || m_zip.findEntry(location) == string::npos) {
+      continue;
+    }
+    if (format.find("sed-ml") != string::npos || format.find("sedml") != string::npos) {
+      m_sedmlLocations.push_back(location);
+    }
+    else if (format.find("sbml") != string::npos) {
+      m_sbmlLocations.push_back(location);
+    }
+  }
+  if (stream.isError()) {
+    error = "Unable to read the manifest of the archive '" + m_zip.getFilename() + "':  it is not valid XML.";
+    return true;
+  }
+  return false;
+}
+
+//Reads every SED-ML document in the archive, and indexes every SBML model unless 'withSBML' is false, on up to 'numThreads' threads (one per core if zero).  Returns true on error, with the reason in 'error'.
+bool CombineArchive::load(size_t numThreads, bool withSBML, string& error)
+{
+  ArchiveLoadJobs jobs(m_zip, m_sedmlLocations, withSBML ? m_sbmlLocations : vector<string>());
+  runParallelJobs(jobs, jobs.locations.size(), numThreads, 1);
+  for (size_t job=0; job<jobs.locations.size(); job++) {
+    if (!jobs.errors[job].empty()) {
+      error = jobs.errors[job];
+      return true;
+    }
+  }
+  m_sedml.assign(jobs.contents.begin(), jobs.contents.begin() + jobs.numSEDML);
+  for (size_t job=jobs.numSEDML; job<jobs.locations.size(); job++) {
+    m_sbml[jobs.locations[job]] = jobs.sbml[job];
+  }
+  return false;
+}
+
+size_t CombineArchive::getNumSEDML() const
+{
+  return m_sedml.size();
+}
+
+const string& CombineArchive::getSEDMLLocation(size_t document) const
+{
+  return m_sedmlLocations[document];
+}
+
+const string& CombineArchive::getSEDML(size_t document) const
+{
+  return m_sedml[document];
+}
+
+//The index of the SBML model at 'location' (relative to the root of the archive), or nothing if the archive has none there.
+shared_ptr<const SBMLIndex> CombineArchive::getSBMLIndex(const string& location) const
+{
+  map<string, shared_ptr<const SBMLIndex> >::const_iterator found = m_sbml.find(location);
+  if (found == m_sbml.end()) {
+    return shared_ptr<const SBMLIndex>();
+  }
+  return found->second;
+}
+
+PHRASEDML_CPP_NAMESPACE_END
@@ -0,0 +1,45 @@
+#ifndef PHRASEDCOMBINEARCHIVE_H
+#define PHRASEDCOMBINEARCHIVE_H
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "sbmlIndex.h"
+#include "zipArchive.h"
+#include "phrasedml-namespace.h"
+
+PHRASEDML_CPP_NAMESPACE_BEGIN
+
+//A COMBINE archive (an .omex file):  a zip archive of SED-ML documents and the models they use, listed in its 'manifest.xml'.  The archive is read in place, and every SBML model in it is indexed once, however many documents use it.
+class CombineArchive
+{
+private:
+  ZipArchive m_zip;
+  std::vector<std::string> m_sedmlLocations;
+  std::vector<std::string> m_sbmlLocations;
+  std::vector<std::string> m_sedml;
+  std::map<std::string, std::shared_ptr<const SBMLIndex> > m_sbml;
+
+public:
+  CombineArchive();
+  ~CombineArchive();
+
+  bool open(const std::string& filename, std::string& error);
+  bool load(size_t numThreads, bool withSBML, std::string& error);
+
+  size_t getNumSEDML() const;
+  const std::string& getSEDMLLocation(size_t document) const;
+  const std::string& getSEDML(size_t document) const;
+  std::shared_ptr<const SBMLIndex> getSBMLIndex(const std::string& location) const;
+
+private:
+  bool readManifest(std::string& error);
+};
+
+std::string normalizeArchivePath(const std::string& path);
+
+PHRASEDML_CPP_NAMESPACE_END
+
+#endif //PHRASEDCOMBINEARCHIVE_H
@@ -0,0 +1,509 @@
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+#include <sstream>
+
+#include "compiledFormula.h"
+#include "registry.h"
+
+#include "sbml/math/L3FormulaFormatter.h"
+
+using namespace std;
+using namespace libsbml;
+
+PHRASEDML_CPP_NAMESPACE_BEGIN
+
+//The number of rows each instruction is applied to at once.
+static const size_t FORMULA_BLOCK_SIZE = 256;
+
+static bool isTrue(double value)
+{
+  return value != 0 && value == value;
+}
+
+static double truncate(double value)
+{
+  return value < 0 ? ceil(value) : floor(value);
+}
+
+CompiledFormula::CompiledFormula()
+  : m_code()
+  , m_variables()
+  , m_numRegisters(0)
+  , m_result(0)
+{
+}
+
+CompiledFormula::~CompiledFormula()
+{
+}
+
+//Compiles the formula, replacing anything previously compiled.  Every AST_NAME becomes an input variable, in the order returned by getVariables().  Returns true on error, which is set in the registry.
+bool CompiledFormula::compile(const ASTNode* astn)
+{
+  m_code.clear();
+  m_variables.clear();
+  m_numRegisters = 0;
+  m_result = 0;
+  if (astn == NULL) {
+    g_registry.setError("Unable to compile an empty formula.", 0);
+    return true;
+  }
+  bool error = false;
+  m_result = compileNode(astn, error);
+  if (error) {
+    char* formula = SBML_formulaToL3String(astn);
+    g_registry.addErrorPrefix("Unable to compile the formula '" + string(formula) + "':  ");
+    free(formula);
+    m_code.clear();
+    m_variables.clear();
+    return true;
+  }
+  allocateRegisters();
+  return false;
+}
+
+vector<string> CompiledFormula::getVariables() const
+{
+  return m_variables;
+}
+
+size_t CompiledFormula::getNumInstructions() const
+{
+  return m_code.size();
+}
+
+size_t CompiledFormula::emit(opcode op, size_t a, size_t b, size_t c, double value)
+{
+  Instruction instruction;
+  instruction.op = op;
+  instruction.dest = m_code.size();
+  instruction.a = a;
+  instruction.b = b;
+  instruction.c = c;
+  instruction.value = value;
+  m_code.push_back(instruction);
+  return instruction.dest;
+}
+
+size_t CompiledFormula::getVariable(const string& name)
+{
+  for (size_t v=0; v<m_variables.size(); v++) {
+    if (m_variables[v] == name) {
+      return v;
+    }
+  }
+  m_variables.push_back(name);
+  return m_variables.size()-1;
+}
+
+size_t CompiledFormula::compileUnary(const ASTNode* astn, opcode op, bool& error)
+{
+  if (astn->getNumChildren() != 1) {
+    stringstream err;
+    err << "a function that takes one argument was given " << astn->getNumChildren() << ".";
+    g_registry.setError(err.str(), 0);
+    error = true;
+    return 0;
+  }
+  size_t a = compileNode(astn->getChild(0), error);
+  return emit(op, a);
+}
+
+size_t CompiledFormula::compileBinary(const ASTNode* astn, opcode op, bool& error)
+{
+  if (astn->getNumChildren() != 2) {
+    stringstream err;
+    err << "a function that takes two arguments was given " << astn->getNumChildren() << ".";
+    g_registry.setError(err.str(), 0);
+    error = true;
+    return 0;
+  }
+  size_t a = compileNode(astn->getChild(0), error);
+  size_t b = compileNode(astn->getChild(1), error);
+  return emit(op, a, b);
+}
+
+//n-ary operators like 'plus' and 'and' are applied left to right; with no arguments, they have the value 'empty'.
+size_t CompiledFormula::compileChain(const ASTNode* astn, opcode op, double empty, bool& error)
+{
+  if (astn->getNumChildren() == 0) {
+    return emit(op_const, 0, 0, 0, empty);
+  }
+  size_t ret = compileNode(astn->getChild(0), error);
+  for (unsigned int c=1; c<astn->getNumChildren(); c++) {
+    size_t next = compileNode(astn->getChild(c), error);
+    ret = emit(op, ret, next);
+  }
+  return ret;
+}
+
+//n-ary relations like 'a < b < c' are true if each neighboring pair is.
+size_t CompiledFormula::compileRelation(const ASTNode* astn, opcode op, bool& error)
+{
+  if (astn->getNumChildren() < 2) {
+    g_registry.setError("a relational operator was given fewer than two arguments.", 0);
+    error = true;
+    return 0;
+  }
+  size_t ret = 0;
+  size_t prev = compileNode(astn->getChild(0), error);
+  for (unsigned int c=1; c<astn->getNumChildren(); c++) {
+    size_t next = compileNode(astn->getChild(c), error);
+    size_t rel = emit(op, prev, next);
+    ret = (c==1) ? rel : emit(op_and, ret, rel);
+    prev = next;
+  }
+  return ret;
+}
+
+size_t CompiledFormula::compileNode(const ASTNode* astn, bool& error)
+{
+  if (error) {
+    return 0;
+  }
+  switch(astn->getType()) {
+  case AST_INTEGER:
+  case AST_REAL:
+  case AST_REAL_E:
+  case AST_RATIONAL:
+    return emit(op_const, 0, 0, 0, astn->getValue());
+  case AST_NAME_AVOGADRO:
+    return emit(op_const, 0, 0, 0, astn->getReal());
+  case AST_CONSTANT_E:
+    return emit(op_const, 0, 0, 0, exp(1.0));
+  case AST_CONSTANT_PI:
+    return emit(op_const, 0, 0, 0, 4.0*atan(1.0));
+  case AST_CONSTANT_TRUE:
+    return emit(op_const, 0, 0, 0, 1);
+  case AST_CONSTANT_FALSE:
+    return emit(op_const, 0, 0, 0, 0);
+  case AST_NAME:
+    return emit(op_load, getVariable(astn->getName()));
+  case AST_NAME_TIME:
+    return emit(op_load, getVariable("time"));
+  case AST_PLUS:
+    return compileChain(astn, op_add, 0, error);
+  case AST_TIMES:
+    return compileChain(astn, op_mul, 1, error);
+  case AST_MINUS:
+    if (astn->getNumChildren() == 1) {
+      return compileUnary(astn, op_neg, error);
+    }
+    return compileBinary(astn, op_sub, error);
+  case AST_DIVIDE:
+    return compileBinary(astn, op_div, error);
+  case AST_POWER:
+  case AST_FUNCTION_POWER:
+    return compileBinary(astn, op_pow, error);
+  case AST_FUNCTION_ABS:
+    return compileUnary(astn, op_abs, error);
+  case AST_FUNCTION_EXP:
+    return compileUnary(astn, op_exp, error);
+  case AST_FUNCTION_LN:
+    return compileUnary(astn, op_ln, error);
+  case AST_FUNCTION_LOG:
+    if (astn->getNumChildren() == 1 || astn->isLog10()) {
+      if (astn->getNumChildren() == 2) {
+        size_t a = compileNode(astn->getChild(1), error);
+        return emit(op_log10, a);
+      }
+      return compileUnary(astn, op_log10, error);
+    }
+    return compileBinary(astn, op_log, error);
+  case AST_FUNCTION_ROOT:
+    if (astn->getNumChildren() == 1) {
+      return compileUnary(astn, op_sqrt, error);
+    }
+    return compileBinary(astn, op_root, error);
+  case AST_FUNCTION_FLOOR:
+    return compileUnary(astn, op_floor, error);
+  case AST_FUNCTION_CEILING:
+    return compileUnary(astn, op_ceil, error);
+  case AST_FUNCTION_FACTORIAL:
+    return compileUnary(astn, op_factorial, error);
+  case AST_FUNCTION_SIN:
+    return compileUnary(astn, op_sin, error);
+  case AST_FUNCTION_COS:
+    return compileUnary(astn, op_cos, error);
+  case AST_FUNCTION_TAN:
+    return compileUnary(astn, op_tan, error);
+  case AST_FUNCTION_SEC:
+    return emit(op_inverse, compileUnary(astn, op_cos, error));
+  case AST_FUNCTION_CSC:
+    return emit(op_inverse, compileUnary(astn, op_sin, error));
+  case AST_FUNCTION_COT:
+    return emit(op_inverse, compileUnary(astn, op_tan, error));
+  case AST_FUNCTION_SINH:
+    return compileUnary(astn, op_sinh, error);
+  case AST_FUNCTION_COSH:
+    return compileUnary(astn, op_cosh, error);
+  case AST_FUNCTION_TANH:
+    return compileUnary(astn, op_tanh, error);
+  case AST_FUNCTION_SECH:
+    return emit(op_inverse, compileUnary(astn, op_cosh, error));
+  case AST_FUNCTION_CSCH:
+    return emit(op_inverse, compileUnary(astn, op_sinh, error));
+  case AST_FUNCTION_COTH:
+    return emit(op_inverse, compileUnary(astn, op_tanh, error));
+  case AST_FUNCTION_ARCSIN:
+    return compileUnary(astn, op_asin, error);
+  case AST_FUNCTION_ARCCOS:
+    return compileUnary(astn, op_acos, error);
+  case AST_FUNCTION_ARCTAN:
+    return compileUnary(astn, op_atan, error);
+  case AST_FUNCTION_ARCSEC:
+    return emit(op_acos, compileUnary(astn, op_inverse, error));
+  case AST_FUNCTION_ARCCSC:
+    return emit(op_asin, compileUnary(astn, op_inverse, error));
+  case AST_FUNCTION_ARCCOT:
+    return emit(op_atan, compileUnary(astn, op_inverse, error));
+  case AST_FUNCTION_ARCSINH:
+    return compileUnary(astn, op_asinh, error);
+  case AST_FUNCTION_ARCCOSH:
+    return compileUnary(astn, op_acosh, error);
+  case AST_FUNCTION_ARCTANH:
+    return compileUnary(astn, op_atanh, error);
+  case AST_FUNCTION_ARCSECH:
+    return emit(op_acosh, compileUnary(astn, op_inverse, error));
+  case AST_FUNCTION_ARCCSCH:
+    return emit(op_asinh, compileUnary(astn, op_inverse, error));
+  case AST_FUNCTION_ARCCOTH:
+    return emit(op_atanh, compileUnary(astn, op_inverse, error));
+  case AST_FUNCTION_MAX:
+    return compileChain(astn, op_max, -numeric_limits<double>::infinity(), error);
+  case AST_FUNCTION_MIN:
+    return compileChain(astn, op_min, numeric_limits<double>::infinity(), error);
+  case AST_FUNCTION_QUOTIENT:
+    return compileBinary(astn, op_quotient, error);
+  case AST_FUNCTION_REM:
+    return compileBinary(astn, op_rem, error);
+  case AST_LOGICAL_AND:
+    return compileChain(astn, op_and, 1, error);
+  case AST_LOGICAL_OR:
+    return compileChain(astn, op_or, 0, error);
+  case AST_LOGICAL_XOR:
+    return compileChain(astn, op_xor, 0, error);
+  case AST_LOGICAL_NOT:
+    return compileUnary(astn, op_not, error);
+  case AST_LOGICAL_IMPLIES:
+    {
+      if (astn->getNumChildren() != 2) {
+        g_registry.setError("'implies' must have exactly two arguments.", 0);
+        error = true;
+        return 0;
+      }
+      size_t a = emit(op_not, compileNode(astn->getChild(0), error));
+      size_t b = compileNode(astn->getChild(1), error);
+      return emit(op_or, a, b);
+    }
+  case AST_RELATIONAL_EQ:
+    return compileRelation(astn, op_eq, error);
+  case AST_RELATIONAL_NEQ:
+    return compileBinary(astn, op_neq, error);
+  case AST_RELATIONAL_LT:
+    return compileRelation(astn, op_lt, error);
+  case AST_RELATIONAL_LEQ:
+    return compileRelation(astn, op_leq, error);
+  case AST_RELATIONAL_GT:
+    return compileRelation(astn, op_gt, error);
+  case AST_RELATIONAL_GEQ:
+    return compileRelation(astn, op_geq, error);
+  case AST_FUNCTION_PIECEWISE:
+    {
+      //Children are value/condition pairs, with an optional 'otherwise' value at the end.  Build the selection from the end backwards, so the first true condition wins.
+      unsigned int numchildren = astn->getNumChildren();
+      size_t ret;
+      if (numchildren % 2 == 1) {
+        ret = compileNode(astn->getChild(numchildren-1), error);
+        numchildren--;
+      }
+      else {
+        ret = emit(op_const, 0, 0, 0, numeric_limits<double>::quiet_NaN());
+      }
+      for (unsigned int c=numchildren; c>=2; c-=2) {
+        size_t value = compileNode(astn->getChild(c-2), error);
+        size_t condition = compileNode(astn->getChild(c-1), error);
+        ret = emit(op_select, condition, value, ret);
+      }
+      return ret;
+    }
+  default:
+    break;
+  }
+  char* formula = SBML_formulaToL3String(astn);
+  g_registry.setError("the function or construct '" + string(formula) + "' cannot be evaluated outside of a simulation.", 0);
+  free(formula);
+  error = true;
+  return 0;
+}
+
+//Each instruction was given its own register as it was emitted; here, registers are reused once the value they hold has been read for the last time, so only as many blocks of rows are needed as there are values alive at once.
+//How many of an instruction's a, b, and c are registers.  The a of op_load is the index of a variable instead.
+static size_t getNumOperands(CompiledFormula::opcode op)
+{
+  if (op == CompiledFormula::op_const || op == CompiledFormula::op_load) {
+    return 0;
+  }
+  if (op < CompiledFormula::op_add) {
+    return 1;
+  }
+  if (op < CompiledFormula::op_select) {
+    return 2;
+  }
+  return 3;
+}
+
+void CompiledFormula::allocateRegisters()
+{
+  size_t numinstructions = m_code.size();
+  vector<size_t> lastuse(numinstructions, 0);
+  vector<size_t> numoperands(numinstructions, 0);
+  for (size_t i=0; i<numinstructions; i++) {
+    const Instruction& in = m_code[i];
+    numoperands[i] = getNumOperands(in.op);
+    size_t operands[3] = {in.a, in.b, in.c};
+    for (size_t o=0; o<numoperands[i]; o++) {
+      lastuse[operands[o]] = i;
+    }
+  }
+  lastuse[m_result] = numinstructions;
+
+  vector<size_t> physical(numinstructions, 0);
+  vector<size_t> available;
+  m_numRegisters = 0;
+  for (size_t i=0; i<numinstructions; i++) {
+    Instruction& in = m_code[i];
+    size_t* operands[3] = {&in.a, &in.b, &in.c};
+    vector<size_t> released;
+    for (size_t o=0; o<numoperands[i]; o++) {
+      size_t virt = *operands[o];
+      if (lastuse[virt] == i && find(released.begin(), released.end(), physical[virt]) == released.end()) {
+        released.push_back(physical[virt]);
+      }
+      *operands[o] = physical[virt];
+    }
+    available.insert(available.end(), released.begin(), released.end());
+    if (available.empty()) {
+      physical[i] = m_numRegisters;
+      m_numRegisters++;
+    }
+    else {
+      physical[i] = available.back();
+      available.pop_back();
+    }
+    in.dest = physical[i];
+  }
+  m_result = physical[m_result];
+}
+
+//Evaluates the formula once; 'values' are the inputs in the order given by getVariables().
+double CompiledFormula::evaluate(const vector<double>& values) const
+{
+  vector<FormulaInput> inputs;
+  for (size_t v=0; v<m_variables.size(); v++) {
+    FormulaInput input;
+    input.values = v < values.size() ? &values[v] : NULL;
+    input.stride = 0;
+    inputs.push_back(input);
+  }
+  double result = numeric_limits<double>::quiet_NaN();
+  evaluate(inputs, 1, &result);
+  return result;
+}
+
+//Evaluates the formula for 'length' rows, writing each to 'result'.  The inputs are read in place:  inputs with a stride of one are never copied.
+void CompiledFormula::evaluate(const vector<FormulaInput>& inputs, size_t length, double* result) const
+{
+  if (m_code.empty() || inputs.size() < m_variables.size()) {
+    fill(result, result+length, numeric_limits<double>::quiet_NaN());
+    return;
+  }
+  vector<double> buffer(m_numRegisters * FORMULA_BLOCK_SIZE);
+  vector<const double*> regs(m_numRegisters, (const double*)NULL);
+  for (size_t start=0; start<length; start += FORMULA_BLOCK_SIZE) {
+    size_t n = min(FORMULA_BLOCK_SIZE, length-start);
+    for (size_t k=0; k<m_code.size(); k++) {
+      const Instruction& in = m_code[k];
+      double* d = &buffer[in.dest * FORMULA_BLOCK_SIZE];
+      //Only operands are register numbers:  any other a, b, or c may be past the end of 'regs'.
+      size_t numoperands = getNumOperands(in.op);
+      const double* a = numoperands > 0 ? regs[in.a] : NULL;
+      const double* b = numoperands > 1 ? regs[in.b] : NULL;
+      const double* c = numoperands > 2 ? regs[in.c] : NULL;
+      switch(in.op) {
+      case op_const:
+        for (size_t i=0; i<n; i++) d[i] = in.value;
+        break;
+      case op_load:
+        {
+          const FormulaInput& input = inputs[in.a];
+          if (input.values == NULL) {
+            for (size_t i=0; i<n; i++) d[i] = numeric_limits<double>::quiet_NaN();
+          }
+          else if (input.stride == 1) {
+            regs[in.dest] = input.values + start;
+            continue;
+          }
+          else if (input.stride == 0) {
+            for (size_t i=0; i<n; i++) d[i] = input.values[0];
+          }
+          else {
+            for (size_t i=0; i<n; i++) d[i] = input.values[(start+i)*input.stride];
+          }
+        }
+        break;
+      case op_neg:       for (size_t i=0; i<n; i++) d[i] = -a[i]; break;
+      case op_not:       for (size_t i=0; i<n; i++) d[i] = isTrue(a[i]) ? 0 : 1; break;
+      case op_abs:       for (size_t i=0; i<n; i++) d[i] = fabs(a[i]); break;
+      case op_exp:       for (size_t i=0; i<n; i++) d[i] = exp(a[i]); break;
+      case op_ln:        for (size_t i=0; i<n; i++) d[i] = log(a[i]); break;
+      case op_log10:     for (size_t i=0; i<n; i++) d[i] = log10(a[i]); break;
+      case op_sqrt:      for (size_t i=0; i<n; i++) d[i] = sqrt(a[i]); break;
+      case op_floor:     for (size_t i=0; i<n; i++) d[i] = floor(a[i]); break;
+      case op_ceil:      for (size_t i=0; i<n; i++) d[i] = ceil(a[i]); break;
+      case op_factorial: for (size_t i=0; i<n; i++) d[i] = tgamma(a[i]+1); break;
+      case op_sin:       for (size_t i=0; i<n; i++) d[i] = sin(a[i]); break;
+      case op_cos:       for (size_t i=0; i<n; i++) d[i] = cos(a[i]); break;
+      case op_tan:       for (size_t i=0; i<n; i++) d[i] = tan(a[i]); break;
+      case op_asin:      for (size_t i=0; i<n; i++) d[i] = asin(a[i]); break;
+      case op_acos:      for (size_t i=0; i<n; i++) d[i] = acos(a[i]); break;
+      case op_atan:      for (size_t i=0; i<n; i++) d[i] = atan(a[i]); break;
+      case op_sinh:      for (size_t i=0; i<n; i++) d[i] = sinh(a[i]); break;
+      case op_cosh:      for (size_t i=0; i<n; i++) d[i] = cosh(a[i]); break;
+      case op_tanh:      for (size_t i=0; i<n; i++) d[i] = tanh(a[i]); break;
+      case op_asinh:     for (size_t i=0; i<n; i++) d[i] = asinh(a[i]); break;
+      case op_acosh:     for (size_t i=0; i<n; i++) d[i] = acosh(a[i]); break;
+      case op_atanh:     for (size_t i=0; i<n; i++) d[i] = atanh(a[i]); break;
+      case op_inverse:   for (size_t i=0; i<n; i++) d[i] = 1/a[i]; break;
+      case op_add:       for (size_t i=0; i<n; i++) d[i] = a[i] + b[i]; break;
+      case op_sub:       for (size_t i=0; i<n; i++) d[i] = a[i] - b[i]; break;
+      case op_mul:       for (size_t i=0; i<n; i++) d[i] = a[i] * b[i]; break;
+      case op_div:       for (size_t i=0; i<n; i++) d[i] = a[i] / b[i]; break;
+      case op_pow:       for (size_t i=0; i<n; i++) d[i] = pow(a[i], b[i]); break;
+      case op_log:       for (size_t i=0; i<n; i++) d[i] = log(b[i]) / log(a[i]); break;
+      case op_root:      for (size_t i=0; i<n; i++) d[i] = pow(b[i], 1/a[i]); break;
+      case op_eq:        for (size_t i=0; i<n; i++) d[i] = (a[i] == b[i]) ? 1 : 0; break;
+      case op_neq:       for (size_t i=0; i<n; i++) d[i] = (a[i] != b[i]) ? 1 : 0; break;
+      case op_lt:        for (size_t i=0; i<n; i++) d[i] = (a[i] < b[i]) ? 1 : 0; break;
+      case op_leq:       for (size_t i=0; i<n; i++) d[i] = (a[i] <= b[i]) ? 1 : 0; break;
+      case op_gt:        for (size_t i=0; i<n; i++) d[i] = (a[i] > b[i]) ? 1 : 0; break;
+      case op_geq:       for (size_t i=0; i<n; i++) d[i] = (a[i] >= b[i]) ? 1 : 0; break;
+      case op_and:       for (size_t i=0; i<n; i++) d[i] = (isTrue(a[i]) && isTrue(b[i])) ? 1 : 0; break;
+      case op_or:        for (size_t i=0; i<n; i++) d[i] = (isTrue(a[i]) || isTrue(b[i])) ? 1 : 0; break;
+      case op_xor:       for (size_t i=0; i<n; i++) d[i] = (isTrue(a[i]) != isTrue(b[i])) ? 1 : 0; break;
+      case op_max:       for (size_t i=0; i<n; i++) d[i] = (a[i] > b[i] || b[i] != b[i]) ? a[i] : b[i]; break;
+      case op_min:       for (size_t i=0; i<n; i++) d[i] = (a[i] < b[i] || b[i] != b[i]) ? a[i] : b[i]; break;
+      case op_quotient:  for (size_t i=0; i<n; i++) d[i] = truncate(a[i] / b[i]); break;
+      case op_rem:       for (size_t i=0; i<n; i++) d[i] = fmod(a[i], b[i]); break;
+      case op_select:    for (size_t i=0; i<n; i++) d[i] = isTrue(a[i]) ? b[i] : c[i]; break;
+      }
+      regs[in.dest] = d;
+    }
+    const double* r = regs[m_result];
+    copy(r, r+n, result+start);
+  }
+}
+
+PHRASEDML_CPP_NAMESPACE_END
@@ -0,0 +1,116 @@
+#ifndef COMPILEDFORMULA_H
+#define COMPILEDFORMULA_H
+
+#include <string>
+#include <vector>
+
+#include "phrasedml-namespace.h"
+#include "sbml/math/ASTNode.h"
+
+PHRASEDML_CPP_NAMESPACE_BEGIN
+
+//One input to a vectorized evaluation:  row i reads values[i*stride], so a stride of zero uses the same value for every row.
+struct FormulaInput
+{
+  const double* values;
+  size_t stride;
+};
+
+//A formula compiled from an ASTNode to a flat list of register instructions, so it can be evaluated over whole arrays at once instead of walking the tree for every point.  Each instruction is applied to a block of rows at a time in a tight loop.
+class CompiledFormula
+{
+public:
+  enum opcode {
+      op_const
+    , op_load
+    //Unary:
+    , op_neg
+    , op_not
+    , op_abs
+    , op_exp
+    , op_ln
+    , op_log10
+    , op_sqrt
+    , op_floor
+    , op_ceil
+    , op_factorial
+    , op_sin
+    , op_cos
+    , op_tan
+    , op_asin
+    , op_acos
+    , op_atan
+    , op_sinh
+    , op_cosh
+    , op_tanh
+    , op_asinh
+    , op_acosh
+    , op_atanh
+    , op_inverse
+    //Binary:
+    , op_add
+    , op_sub
+    , op_mul
+    , op_div
+    , op_pow
+    , op_log
+    , op_root
+    , op_eq
+    , op_neq
+    , op_lt
+    , op_leq
+    , op_gt
+    , op_geq
+    , op_and
+    , op_or
+    , op_xor
+    , op_max
+    , op_min
+    , op_quotient
+    , op_rem
+    //Ternary:
+    , op_select
+  };
+
+private:
+  struct Instruction
+  {
+    opcode op;
+    size_t dest;
+    size_t a;
+    size_t b;
+    size_t c;
+    double value;
+  };
+
+  std::vector<Instruction> m_code;
+  std::vector<std::string> m_variables;
+  size_t m_numRegisters;
+  size_t m_result;
+
+public:
+  CompiledFormula();
+  ~CompiledFormula();
+
+  bool compile(const libsbml::ASTNode* astn);
+
+  std::vector<std::string> getVariables() const;
+  size_t getNumInstructions() const;
+
+  double evaluate(const std::vector<double>& values) const;
+  void evaluate(const std::vector<FormulaInput>& inputs, size_t length, double* result) const;
+
+private:
+  size_t compileNode(const libsbml::ASTNode* astn, bool& error);
+  size_t compileChain(const libsbml::ASTNode* astn, opcode op, double empty, bool& error);
+  size_t compileRelation(const libsbml::ASTNode* astn, opcode op, bool& error);
+  size_t compileUnary(const libsbml::ASTNode* astn, opcode op, bool& error);
+  size_t compileBinary(const libsbml::ASTNode* astn, opcode op, bool& error);
+  size_t emit(opcode op, size_t a=0, size_t b=0, size_t c=0, double value=0);
+  size_t getVariable(const std::string& name);
+  void allocateRegisters();
+};
+
+PHRASEDML_CPP_NAMESPACE_END
+
+#endif //COMPILEDFORMULA_H
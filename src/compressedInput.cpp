@@ -0,0 +1,313 @@
+#include <cstring>
+
+#include "compressedInput.h"
+#include "zlib.h"
+#ifdef USE_ZSTD
+#include "zstd.h"
+#endif
+
+using namespace std;
+
+PHRASEDML_CPP_NAMESPACE_BEGIN
+
+static const size_t BLOCK_SIZE = 65536;
+
+//Compressed files are recognized by their contents, not their names.
+static compression_type getMagicCompression(const char* bytes, size_t length)
+{
+  if (length >= 2 && bytes[0] == '\x1f' && bytes[1] == '\x8b') {
+    return compression_gzip;
+  }
+  if (length >= 4 && bytes[0] == '\x28' && bytes[1] == '\xb5' && bytes[2] == '\x2f' && bytes[3] == '\xfd') {
+    return compression_zstd;
+  }
+  return compression_none;
+}
+
+//How 'filename' is compressed, if at all.  A file that cannot be read is not compressed.
+compression_type getFileCompression(const string& filename)
+{
+  ifstream file(filename.c_str(), ios::in | ios::binary);
+  char magic[4];
+  file.read(magic, 4);
+  return getMagicCompression(magic, static_cast<size_t>(file.gcount()));
+}
+
+string getCompressionString(compression_type type)
+{
+  switch(type) {
+  case compression_none:
+    return "none";
+  case compression_gzip:
+    return "gzip";
+  case compression_zstd:
+    return "zstd";
+  }
+  return "unknown";
+}
+
+//zstd support is optional, and only there if phraSED-ML was built with WITH_ZSTD.
+bool isCompressionSupported(compression_type type)
+{
+#ifdef USE_ZSTD
+  return true;
+#else
+  return type != compression_zstd;
+#endif
+}
+
+//'model.xml.gz' becomes 'model.xml'.  Any other filename is returned as is.
+string removeCompressionSuffix(const string& filename)
+{
+  const char* suffixes[] = {".gz", ".zst"};
+  for (size_t s=0; s<2; s++) {
+    size_t len = strlen(suffixes[s]);
+    if (filename.size() > len && filename.compare(filename.size()-len, len, suffixes[s]) == 0) {
+      return filename.substr(0, filename.size()-len);
+    }
+  }
+  return filename;
+}
+
+//Reads all of 'filename' into 'contents', decompressing it if need be.  Returns true on error, with the reason in 'error'.
+bool readDecompressedFile(const string& filename, string& contents, string& error)
+{
+  contents.clear();
+  DecompressingInputStream stream(filename);
+  if (!stream.isOpen()) {
+    error = "Input file '" + filename + "' cannot be read.  Check to see if the file exists and that the permissions are correct, and try again.";
+    return true;
+  }
+  char block[4096];
+  streamsize got;
+  while ((got = stream.rdbuf()->sgetn(block, sizeof(block))) > 0) {
+    contents.append(block, static_cast<size_t>(got));
+  }
+  error = stream.getError();
+  return !error.empty();
+}
+
+DecompressingStreamBuf::DecompressingStreamBuf(const string& filename)
+  : m_file(filename.c_str(), ios::in | ios::binary)
+  , m_compression(compression_none)
+  , m_zstream(NULL)
+  , m_zstd(NULL)
+  , m_in(BLOCK_SIZE)
+  , m_out(BLOCK_SIZE)
+  , m_inStart(0)
+  , m_inEnd(0)
+  , m_inMember(false)
+  , m_filename(filename)
+  , m_error()
+{
+  if (!fillInput()) {
+    return;
+  }
+  m_compression = getMagicCompression(&m_in[0], m_inEnd);
+  switch(m_compression) {
+  case compression_none:
+    break;
+  case compression_gzip:
+    m_zstream = new z_stream();
+    //16 more window bits tells zlib to expect a gzip header and trailer.
+    if (inflateInit2(m_zstream, 16 + MAX_WBITS) != Z_OK) {
+      setError("Unable to start decompressing '" + m_filename + "'.");
+    }
+    break;
+  case compression_zstd:
+#ifdef USE_ZSTD
+    m_zstd = ZSTD_createDStream();
+    if (m_zstd == NULL || ZSTD_isError(ZSTD_initDStream(static_cast<ZSTD_DStream*>(m_zstd)))) {
+      setError("Unable to start decompressing '" + m_filename + "'.");
+    }
+#else
+    setError("Input file '" + m_filename + "' is compressed with zstd, which this build of phraSED-ML cannot read.  Decompress it first, or rebuild phraSED-ML with WITH_ZSTD turned on.");
+#endif
+    break;
+  }
+}
+
+DecompressingStreamBuf::~DecompressingStreamBuf()
+{
+  if (m_zstream != NULL) {
+    inflateEnd(m_zstream);
+    delete m_zstream;
+  }
+#ifdef USE_ZSTD
+  ZSTD_freeDStream(static_cast<ZSTD_DStream*>(m_zstd));
+#endif
+}
+
+bool DecompressingStreamBuf::isOpen() const
+{
+  return m_file.is_open();
+}
+
+compression_type DecompressingStreamBuf::getCompression() const
+{
+  return m_compression;
+}
+
+const string& DecompressingStreamBuf::getError() const
+{
+  return m_error;
+}
+
+DecompressingStreamBuf::int_type DecompressingStreamBuf::underflow()
+{
+  if (gptr() < egptr()) {
+    return traits_type::to_int_type(*gptr());
+  }
+  if (!m_error.empty()) {
+    return traits_type::eof();
+  }
+  size_t produced = decompress();
+  if (produced == 0) {
+    return traits_type::eof();
+  }
+  setg(&m_out[0], &m_out[0], &m_out[0] + produced);
+  return traits_type::to_int_type(*gptr());
+}
+
+//Reads the next block of the file into m_in.  Returns false at the end of the file.
+bool DecompressingStreamBuf::fillInput()
+{
+  if (!m_file.is_open() || !m_file.good()) {
+    return false;
+  }
+  m_file.read(&m_in[0], static_cast<streamsize>(m_in.size()));
+  m_inStart = 0;
+  m_inEnd = static_cast<size_t>(m_file.gcount());
+  return m_inEnd > 0;
+}
+
+//Fills m_out with the next block of the file's contents, and returns how much it holds.  Returns 0 at the end of the file, or on error.
+size_t DecompressingStreamBuf::decompress()
+{
+  switch(m_compression) {
+  case compression_none:
+    return copyBlock();
+  case compression_gzip:
+    return inflateBlock();
+  case compression_zstd:
+    return zstdBlock();
+  }
+  return 0;
+}
+
+size_t DecompressingStreamBuf::copyBlock()
+{
+  if (m_inStart == m_inEnd && !fillInput()) {
+    return 0;
+  }
+  size_t copied = m_inEnd - m_inStart;
+  memcpy(&m_out[0], &m_in[m_inStart], copied);
+  m_inStart = m_inEnd;
+  return copied;
+}
+
+//A gzip file may be several gzip members, one after the other; they are read as one.
+size_t DecompressingStreamBuf::inflateBlock()
+{
+  while (true) {
+    //At the end of the file, zlib may still have output it had no room for last time.
+    bool atEnd = (m_inStart == m_inEnd && !fillInput());
+    if (atEnd && !m_inMember) {
+      return 0;
+    }
+    if (!m_inMember) {
+      //Like gzip itself, ignore anything after the last member.
+      if (m_in[m_inStart] != '\x1f') {
+        m_inStart = m_inEnd;
+        return 0;
+      }
+      inflateReset(m_zstream);
+      m_inMember = true;
+    }
+    m_zstream->next_in = reinterpret_cast<Bytef*>(&m_in[0] + m_inStart);
+    m_zstream->avail_in = static_cast<uInt>(m_inEnd - m_inStart);
+    m_zstream->next_out = reinterpret_cast<Bytef*>(&m_out[0]);
+    m_zstream->avail_out = static_cast<uInt>(m_out.size());
+    int result = inflate(m_zstream, Z_NO_FLUSH);
+    m_inStart = m_inEnd - m_zstream->avail_in;
+    if (result == Z_STREAM_END) {
+      m_inMember = false;
+    }
+    else if (result != Z_OK && result != Z_BUF_ERROR) {
+      string error = "Unable to decompress input file '" + m_filename + "'";
+      if (m_zstream->msg != NULL) {
+        error += ": ";
+        error += m_zstream->msg;
+      }
+      setError(error + ".");
+      return 0;
+    }
+    size_t produced = m_out.size() - m_zstream->avail_out;
+    if (produced > 0) {
+      return produced;
+    }
+    if (atEnd) {
+      setError("Input file '" + m_filename + "' ends in the middle of its compressed data, and may have been truncated.");
+      return 0;
+    }
+  }
+}
+
+size_t DecompressingStreamBuf::zstdBlock()
+{
+#ifdef USE_ZSTD
+  ZSTD_DStream* zstd = static_cast<ZSTD_DStream*>(m_zstd);
+  while (true) {
+    bool atEnd = (m_inStart == m_inEnd && !fillInput());
+    if (atEnd && !m_inMember) {
+      return 0;
+    }
+    ZSTD_inBuffer in = {&m_in[0], m_inEnd, m_inStart};
+    ZSTD_outBuffer out = {&m_out[0], m_out.size(), 0};
+    size_t result = ZSTD_decompressStream(zstd, &out, &in);
+    m_inStart = in.pos;
+    if (ZSTD_isError(result)) {
+      setError("Unable to decompress input file '" + m_filename + "': " + ZSTD_getErrorName(result) + ".");
+      return 0;
+    }
+    //Zero means a frame just ended; zstd carries on with the next one by itself.
+    m_inMember = (result != 0);
+    if (out.pos > 0) {
+      return out.pos;
+    }
+    if (atEnd) {
+      setError("Input file '" + m_filename + "' ends in the middle of its compressed data, and may have been truncated.");
+      return 0;
+    }
+  }
+#else
+  return 0;
+#endif
+}
+
+//Only the first error is kept, since any others follow from it.
+void DecompressingStreamBuf::setError(const string& error)
+{
+  if (m_error.empty()) {
+    m_error = error;
+  }
+}
+
+DecompressingInputStream::DecompressingInputStream(const string& filename)
+  : std::istream(NULL)
+  , m_buf(filename)
+{
+  rdbuf(&m_buf);
+}
+
+bool DecompressingInputStream::isOpen() const
+{
+  return m_buf.isOpen();
+}
+
+const string& DecompressingInputStream::getError() const
+{
+  return m_buf.getError();
+}
+
+PHRASEDML_CPP_NAMESPACE_END
@@ -0,0 +1,80 @@
+#ifndef PHRASEDCOMPRESSEDINPUT_H
+#define PHRASEDCOMPRESSEDINPUT_H
+
+#include <fstream>
+#include <istream>
+#include <string>
+#include <vector>
+
+#include "phrasedml-namespace.h"
+
+struct z_stream_s;
+
+PHRASEDML_CPP_NAMESPACE_BEGIN
+
+enum compression_type {
+    compression_none
+  , compression_gzip
+  , compression_zstd
+};
+
+compression_type getFileCompression(const std::string& filename);
+std::string getCompressionString(compression_type type);
+bool isCompressionSupported(compression_type type);
+std::string removeCompressionSuffix(const std::string& filename);
+bool readDecompressedFile(const std::string& filename, std::string& contents, std::string& error);
+
+//Reads a file a block at a time, decompressing it first if it starts with a gzip or zstd header, so that the whole file is never in memory.  If the file cannot be read or decompressed, the stream stops early, and getError says why.
+class DecompressingStreamBuf : public std::streambuf
+{
+private:
+  std::ifstream m_file;
+  compression_type m_compression;
+  z_stream_s* m_zstream;
+  void* m_zstd;
+  std::vector<char> m_in;
+  std::vector<char> m_out;
+  size_t m_inStart;
+  size_t m_inEnd;
+  bool m_inMember;
+  std::string m_filename;
+  std::string m_error;
+
+public:
+  DecompressingStreamBuf(const std::string& filename);
+  ~DecompressingStreamBuf();
+
+  bool isOpen() const;
+  compression_type getCompression() const;
+  const std::string& getError() const;
+
+protected:
+  virtual int_type underflow();
+
+private:
+  bool fillInput();
+  size_t decompress();
+  size_t copyBlock();
+  size_t inflateBlock();
+  size_t zstdBlock();
+  void setError(const std::string& error);
+
+  DecompressingStreamBuf(const DecompressingStreamBuf&);
+  DecompressingStreamBuf& operator=(const DecompressingStreamBuf&);
+};
+
+class DecompressingInputStream : public std::istream
+{
+private:
+  DecompressingStreamBuf m_buf;
+
+public:
+  DecompressingInputStream(const std::string& filename);
+
+  bool isOpen() const;
+  const std::string& getError() const;
+};
+
+PHRASEDML_CPP_NAMESPACE_END
+
+#endif //PHRASEDCOMPRESSEDINPUT_H
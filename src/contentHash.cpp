@@ -0,0 +1,300 @@
+#include <cstdlib>
+#include <locale>
+#include <sstream>
+
+#include "contentHash.h"
+#include "model.h"
+#include "modelChange.h"
+#include "oneStep.h"
+#include "output.h"
+#include "registry.h"
+#include "repeatedTask.h"
+#include "sbmlx.h"
+#include "simulation.h"
+#include "stringx.h"
+#include "task.h"
+#include "uniform.h"
+
+#include "sbml/SBMLTypes.h"
+
+using namespace std;
+using namespace libsbml;
+
+PHRASEDML_CPP_NAMESPACE_BEGIN
+
+//Numbers are written with enough digits to tell apart any two doubles, regardless of the current locale.
+static string getCanonicalDouble(double value)
+{
+  stringstream ret;
+  ret.imbue(locale::classic());
+  ret.precision(17);
+  ret << value;
+  return ret.str();
+}
+
+static string getFormulaKey(const ASTNode* astn)
+{
+  char* formula = SBML_formulaToL3String(astn);
+  string ret = formula;
+  free(formula);
+  return ret;
+}
+
+PhrasedContentHasher::PhrasedContentHasher()
+  : m_modelHashes()
+  , m_simulationHashes()
+  , m_taskHashes()
+  , m_parents()
+{
+}
+
+PhrasedContentHasher::~PhrasedContentHasher()
+{
+}
+
+//Hashes are remembered until cleared, so that shared models and subtasks are only hashed once; clear them if g_registry changes.
+void PhrasedContentHasher::clear()
+{
+  m_modelHashes.clear();
+  m_simulationHashes.clear();
+  m_taskHashes.clear();
+  m_parents.clear();
+}
+
+//The model's source content (or the hash of the model it is based on) and its changes.  Returns true on error.
+bool PhrasedContentHasher::getModelHash(const string& modelid, unsigned long long& hash)
+{
+  map<string, unsigned long long>::iterator found = m_modelHashes.find(modelid);
+  if (found != m_modelHashes.end()) {
+    hash = found->second;
+    return false;
+  }
+  const PhrasedModel* model = g_registry.getModel(modelid);
+  if (model == NULL) {
+    g_registry.setError("Unable to hash model '" + modelid + "':  no such model exists.", 0);
+    return true;
+  }
+  stringstream key;
+  string source = model->getSource();
+  if (!model->getIsFile() && g_registry.getModel(source) != NULL) {
+    if (m_parents.find(modelid) != m_parents.end()) {
+      g_registry.setError("Unable to hash model '" + modelid + "':  it is based on itself.", 0);
+      return true;
+    }
+    m_parents.insert(modelid);
+    unsigned long long basehash;
+    bool error = getModelHash(source, basehash);
+    m_parents.erase(modelid);
+    if (error) {
+      return true;
+    }
+    key << "model " << HashToString(basehash);
+  }
+  else if (model->getIsFile() && model->getSBMLIndex()->hasModel()) {
+    //Hashed once, when it was indexed, in the same form whether the file was scanned or its document was given directly.
+    key << "sbml " << HashToString(model->getSBMLIndex()->getContentHash());
+  }
+  else {
+    //The source could not be read, so its location is all we have.
+    key << "file " << source;
+  }
+  const vector<ModelChange>& changes = model->getChanges();
+  for (size_t c=0; c<changes.size(); c++) {
+    string changekey;
+    if (getChangeKey(changes[c], modelid, changekey)) {
+      return true;
+    }
+    key << "\nchange " << changekey;
+  }
+  hash = getFNV1aHash(key.str());
+  m_modelHashes[modelid] = hash;
+  return false;
+}
+
+//The simulation's type, times, algorithm, and algorithm parameters.  Returns true on error.
+bool PhrasedContentHasher::getSimulationHash(const string& simid, unsigned long long& hash)
+{
+  map<string, unsigned long long>::iterator found = m_simulationHashes.find(simid);
+  if (found != m_simulationHashes.end()) {
+    hash = found->second;
+    return false;
+  }
+  const PhrasedSimulation* sim = g_registry.getSimulation(simid);
+  if (sim == NULL) {
+    g_registry.setError("Unable to hash simulation '" + simid + "':  no such simulation exists.", 0);
+    return true;
+  }
+  stringstream key;
+  key << "simulation " << sim->getType();
+  switch(sim->getType()) {
+  case simtype_uniform:
+  case simtype_uniform_stochastic:
+    {
+      const PhrasedUniform* uniform = static_cast<const PhrasedUniform*>(sim);
+      key << " " << getCanonicalDouble(uniform->getStart()) << " " << getCanonicalDouble(uniform->getOutputStart()) << " " << getCanonicalDouble(uniform->getEnd()) << " " << uniform->getNumPoints();
+    }
+    break;
+  case simtype_onestep:
+    key << " " << getCanonicalDouble(static_cast<const PhrasedOneStep*>(sim)->getStep());
+    break;
+  case simtype_steadystate:
+  case simtype_unknown:
+    break;
+  }
+  key << "\nkisao " << sim->getKisao();
+  const map<int, string>& algparams = sim->getAlgorithmParameters();
+  for (map<int, string>::const_iterator algparam = algparams.begin(); algparam != algparams.end(); algparam++) {
+    key << "\nparameter " << algparam->first << " ";
+    if (IsReal(algparam->second)) {
+      key << getCanonicalDouble(atof(algparam->second.c_str()));
+    }
+    else {
+      key << algparam->second;
+    }
+  }
+  hash = getFNV1aHash(key.str());
+  m_simulationHashes[simid] = hash;
+  return false;
+}
+
+//A task is hashed by the hashes of its model and simulation; a repeated task by whether it resets the model, the hashes of its subtasks (in order), and its changes.  Returns true on error.
+bool PhrasedContentHasher::getTaskHash(const string& taskid, unsigned long long& hash)
+{
+  map<string, unsigned long long>::iterator found = m_taskHashes.find(taskid);
+  if (found != m_taskHashes.end()) {
+    hash = found->second;
+    return false;
+  }
+  const PhrasedTask* task = g_registry.getTask(taskid);
+  if (task == NULL) {
+    g_registry.setError("Unable to hash task '" + taskid + "':  no such task exists.", 0);
+    return true;
+  }
+  stringstream key;
+  if (!task->isRepeated()) {
+    unsigned long long modelhash, simhash;
+    if (getModelHash(task->getModelReference(), modelhash) || getSimulationHash(task->getSimulationReference(), simhash)) {
+      g_registry.addErrorPrefix("Unable to hash task '" + taskid + "':  ");
+      return true;
+    }
+    key << "task " << HashToString(modelhash) << " " << HashToString(simhash);
+  }
+  else {
+    if (m_parents.find(taskid) != m_parents.end()) {
+      g_registry.setError("Unable to hash task '" + taskid + "':  it references itself.", 0);
+      return true;
+    }
+    m_parents.insert(taskid);
+    const PhrasedRepeatedTask* rt = static_cast<const PhrasedRepeatedTask*>(task);
+    key << "repeat " << rt->getResetModel();
+    vector<string> subtasks = rt->getTasks();
+    for (size_t t=0; t<subtasks.size(); t++) {
+      unsigned long long subhash;
+      if (getTaskHash(subtasks[t], subhash)) {
+        m_parents.erase(taskid);
+        return true;
+      }
+      key << "\nsubtask " << HashToString(subhash);
+    }
+    m_parents.erase(taskid);
+    const vector<ModelChange>& changes = rt->getChanges();
+    for (size_t c=0; c<changes.size(); c++) {
+      string changekey;
+      if (getChangeKey(changes[c], "", changekey)) {
+        g_registry.addErrorPrefix("Unable to hash task '" + taskid + "':  ");
+        return true;
+      }
+      key << "\nchange " << changekey;
+    }
+  }
+  hash = getFNV1aHash(key.str());
+  m_taskHashes[taskid] = hash;
+  return false;
+}
+
+//Whether the output is a plot or a report, and the formulas it plots or reports, with the tasks and models they reference replaced by their hashes.  Returns true on error.
+bool PhrasedContentHasher::getOutputHash(const PhrasedOutput* output, unsigned long long& hash)
+{
+  map<string, string> replacements;
+  const map<string, vector<string> >& variables = output->getVariableMap();
+  for (map<string, vector<string> >::const_iterator var = variables.begin(); var != variables.end(); var++) {
+    vector<string> element = var->second;
+    if (element.empty()) {
+      continue;
+    }
+    unsigned long long elementhash;
+    if (getTaskHash(element[0], elementhash)) {
+      g_registry.addErrorPrefix("Unable to hash output '" + output->getId() + "':  ");
+      return true;
+    }
+    element[0] = "#" + HashToString(elementhash);
+    if (element.size() > 2 && g_registry.getModel(element[1]) != NULL) {
+      if (getModelHash(element[1], elementhash)) {
+        g_registry.addErrorPrefix("Unable to hash output '" + output->getId() + "':  ");
+        return true;
+      }
+      element[1] = "#" + HashToString(elementhash);
+    }
+    replacements[var->first] = getStringFrom(&element, ".");
+  }
+  stringstream key;
+  key << (output->isPlot() ? "plot" : "report");
+  const vector<vector<OwnedAST> >& rows = output->getOutputVariables();
+  for (size_t r=0; r<rows.size(); r++) {
+    key << "\n";
+    for (size_t a=0; a<rows[r].size(); a++) {
+      ASTNode* astn = rows[r][a]->deepCopy();
+      replaceVariablesInASTNodeWith(astn, replacements);
+      key << getFormulaKey(astn) << ";";
+      delete astn;
+    }
+  }
+  hash = getFNV1aHash(key.str());
+  return false;
+}
+
+//A single change of a repeated task, hashed as it is in the task's own hash.  Returns true on error.
+bool PhrasedContentHasher::getChangeHash(const ModelChange& change, unsigned long long& hash)
+{
+  string key;
+  if (getChangeKey(change, "", key)) {
+    return true;
+  }
+  hash = getFNV1aHash(key);
+  return false;
+}
+
+//The change's type, target, values, and formula.  Any model it is restricted to (other than 'ownerid', the model the change is part of, if any) is replaced by that model's hash, and removed from the start of the target, where a repeated task's changes have it.
+bool PhrasedContentHasher::getChangeKey(const ModelChange& change, const string& ownerid, string& key)
+{
+  stringstream ret;
+  vector<string> variable = change.getVariable();
+  if (variable.size() > 1 && variable[0] == change.getModel()) {
+    variable.erase(variable.begin());
+  }
+  ret << change.getType() << " " << getStringFrom(&variable, ".");
+  if (!change.getModel().empty() && change.getModel() != ownerid) {
+    unsigned long long modelhash;
+    if (getModelHash(change.getModel(), modelhash)) {
+      return true;
+    }
+    ret << " on " << HashToString(modelhash);
+  }
+  vector<double> values = change.getValues();
+  for (size_t v=0; v<values.size(); v++) {
+    ret << " " << getCanonicalDouble(values[v]);
+  }
+  if (change.getType() == ctype_loop_functional) {
+    ret << " from " << change.getSourceRange();
+  }
+  if (change.getASTNode() != NULL) {
+    ret << " = " << getFormulaKey(change.getASTNode());
+  }
+  else if (change.getType() == ctype_formula_assignment || change.getType() == ctype_loop_functional) {
+    ret << " = " << change.getPhraSEDML();
+  }
+  key = ret.str();
+  return false;
+}
+
+PHRASEDML_CPP_NAMESPACE_END
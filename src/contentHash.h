@@ -0,0 +1,42 @@
+#ifndef PHRASEDCONTENTHASH_H
+#define PHRASEDCONTENTHASH_H
+
+#include <map>
+#include <set>
+#include <string>
+
+#include "phrasedml-namespace.h"
+
+PHRASEDML_CPP_NAMESPACE_BEGIN
+
+class ModelChange;
+class PhrasedOutput;
+
+//Stable hashes of what each element of an experiment means, for use as result cache keys.  IDs, names, and how the element was written never change its hash:  models are hashed by the content of their source (or the hash of the model they are based on) and their changes, simulations by their settings, tasks by the hashes of their model and simulation or (for repeated tasks) of their subtasks and changes, and outputs by their formulas, with every task and model they reference replaced by its hash.
+class PhrasedContentHasher
+{
+private:
+  std::map<std::string, unsigned long long> m_modelHashes;
+  std::map<std::string, unsigned long long> m_simulationHashes;
+  std::map<std::string, unsigned long long> m_taskHashes;
+  std::set<std::string> m_parents;
+
+public:
+  PhrasedContentHasher();
+  ~PhrasedContentHasher();
+
+  bool getModelHash(const std::string& modelid, unsigned long long& hash);
+  bool getSimulationHash(const std::string& simid, unsigned long long& hash);
+  bool getTaskHash(const std::string& taskid, unsigned long long& hash);
+  bool getOutputHash(const PhrasedOutput* output, unsigned long long& hash);
+  bool getChangeHash(const ModelChange& change, unsigned long long& hash);
+
+  void clear();
+
+private:
+  bool getChangeKey(const ModelChange& change, const std::string& ownerid, std::string& key);
+};
+
+PHRASEDML_CPP_NAMESPACE_END
+
+#endif //PHRASEDCONTENTHASH_H
@@ -0,0 +1,112 @@
+#include <limits>
+#include <set>
+
+#include "costEstimate.h"
+#include "registry.h"
+#include "repeatedTask.h"
+#include "simulation.h"
+#include "task.h"
+
+using namespace std;
+
+PHRASEDML_CPP_NAMESPACE_BEGIN
+
+//Counts can be far too large to ever run; rather than wrap around, they stop at the largest size_t.
+size_t addSaturated(size_t a, size_t b)
+{
+  if (a > numeric_limits<size_t>::max() - b) {
+    return numeric_limits<size_t>::max();
+  }
+  return a + b;
+}
+
+size_t multiplySaturated(size_t a, size_t b)
+{
+  if (b != 0 && a > numeric_limits<size_t>::max() / b) {
+    return numeric_limits<size_t>::max();
+  }
+  return a * b;
+}
+
+static void clearTaskCost(TaskCost& cost, const string& taskid)
+{
+  cost.task = taskid;
+  cost.numRuns = 0;
+  cost.numOutputPoints = 0;
+  cost.numRecordedVariables = 0;
+  cost.resultBytes = 0;
+  cost.seconds = 0;
+  cost.calibrated = true;
+}
+
+static bool getTaskCost(const string& taskid, const RunCosts& runCosts, set<string>& parents, TaskCost& cost)
+{
+  clearTaskCost(cost, taskid);
+  const PhrasedTask* task = g_registry.getTask(taskid);
+  if (task == NULL) {
+    g_registry.setError("Unable to estimate the cost of task '" + taskid + "':  no such task exists.", 0);
+    return true;
+  }
+  if (!task->isRepeated()) {
+    const PhrasedSimulation* sim = g_registry.getSimulation(task->getSimulationReference());
+    if (sim == NULL) {
+      g_registry.setError("Unable to estimate the cost of task '" + taskid + "':  its simulation '" + task->getSimulationReference() + "' does not exist.", 0);
+      return true;
+    }
+    cost.numRuns = 1;
+    cost.numOutputPoints = sim->getNumOutputPoints();
+    RunCosts::const_iterator measured = runCosts.find(sim->getKisao());
+    if (measured == runCosts.end()) {
+      measured = runCosts.find(0);
+    }
+    if (measured == runCosts.end()) {
+      cost.calibrated = false;
+    }
+    else {
+      cost.seconds = measured->second.first + measured->second.second * static_cast<double>(cost.numOutputPoints);
+    }
+    return false;
+  }
+  if (parents.find(taskid) != parents.end()) {
+    g_registry.setError("Unable to estimate the cost of task '" + taskid + "':  it references itself.", 0);
+    return true;
+  }
+  parents.insert(taskid);
+  const PhrasedRepeatedTask* rt = static_cast<const PhrasedRepeatedTask*>(task);
+  vector<string> subtasks = rt->getTasks();
+  TaskCost iteration;
+  clearTaskCost(iteration, taskid);
+  for (size_t t=0; t<subtasks.size(); t++) {
+    TaskCost subcost;
+    if (getTaskCost(subtasks[t], runCosts, parents, subcost)) {
+      return true;
+    }
+    addTaskCost(iteration, subcost);
+  }
+  parents.erase(taskid);
+  size_t num = rt->getNumIterations();
+  cost.numRuns = multiplySaturated(iteration.numRuns, num);
+  cost.numOutputPoints = multiplySaturated(iteration.numOutputPoints, num);
+  cost.seconds = iteration.seconds * static_cast<double>(num);
+  cost.calibrated = iteration.calibrated;
+  return false;
+}
+
+//The runs, output points, and (if calibrated) time needed to run the task, including every run of its subtasks.  The recorded variables and result size depend on the outputs, and are left at zero.  Returns true on error.
+bool getTaskCost(const string& taskid, const RunCosts& runCosts, TaskCost& cost)
+{
+  set<string> parents;
+  return getTaskCost(taskid, runCosts, parents, cost);
+}
+
+void addTaskCost(TaskCost& total, const TaskCost& cost)
+{
+  total.numRuns = addSaturated(total.numRuns, cost.numRuns);
+  total.numOutputPoints = addSaturated(total.numOutputPoints, cost.numOutputPoints);
+  total.numRecordedVariables = addSaturated(total.numRecordedVariables, cost.numRecordedVariables);
+  total.resultBytes = addSaturated(total.resultBytes, cost.resultBytes);
+  total.seconds += cost.seconds;
+  total.calibrated = total.calibrated && cost.calibrated;
+}
+
+PHRASEDML_CPP_NAMESPACE_END
@@ -0,0 +1,35 @@
+#ifndef PHRASEDCOSTESTIMATE_H
+#define PHRASEDCOSTESTIMATE_H
+
+#include <map>
+#include <string>
+#include <utility>
+
+#include "phrasedml-namespace.h"
+
+PHRASEDML_CPP_NAMESPACE_BEGIN
+
+//What running a task is expected to take:  how many times a simulation is run, how many time points those runs produce in total, and how much memory the recorded results need.  The time is only known if every simulation's algorithm has been calibrated.
+struct TaskCost
+{
+  std::string task;
+  size_t numRuns;
+  size_t numOutputPoints;
+  size_t numRecordedVariables;
+  size_t resultBytes;
+  double seconds;
+  bool calibrated;
+};
+
+//Measured costs, by KiSAO ID:  seconds per run, and seconds per output point.  KiSAO ID 0 is used for any algorithm without costs of its own.
+typedef std::map<int, std::pair<double, double> > RunCosts;
+
+size_t addSaturated(size_t a, size_t b);
+size_t multiplySaturated(size_t a, size_t b);
+
+bool getTaskCost(const std::string& taskid, const RunCosts& runCosts, TaskCost& cost);
+void addTaskCost(TaskCost& total, const TaskCost& cost);
+
+PHRASEDML_CPP_NAMESPACE_END
+
+#endif //PHRASEDCOSTESTIMATE_H
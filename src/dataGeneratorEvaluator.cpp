@@ -0,0 +1,304 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <sstream>
+
+#include "dataGeneratorEvaluator.h"
+#include "registry.h"
+
+using namespace std;
+using namespace libsbml;
+using namespace libsedml;
+
+PHRASEDML_CPP_NAMESPACE_BEGIN
+
+DataGeneratorEvaluator::DataGeneratorEvaluator()
+  : m_generators()
+  , m_columns()
+{
+}
+
+DataGeneratorEvaluator::~DataGeneratorEvaluator()
+{
+}
+
+//Adds every data generator in the document.  Returns true on error.
+bool DataGeneratorEvaluator::addDataGenerators(SedDocument* sedml)
+{
+  if (sedml == NULL) {
+    g_registry.setError("Unable to evaluate data generators from an empty SED-ML document.", 0);
+    return true;
+  }
+  for (unsigned int d=0; d<sedml->getNumDataGenerators(); d++) {
+    if (addDataGenerator(sedml->getDataGenerator(d))) {
+      return true;
+    }
+  }
+  return false;
+}
+
+//Compiles the data generator's math.  Returns true on error.
+bool DataGeneratorEvaluator::addDataGenerator(SedDataGenerator* sdg)
+{
+  if (sdg == NULL || sdg->getMath() == NULL) {
+    g_registry.setError("Unable to evaluate a data generator with no math.", 0);
+    return true;
+  }
+  Generator generator;
+  generator.id = sdg->getId();
+  for (unsigned int p=0; p<sdg->getNumParameters(); p++) {
+    SedParameter* param = sdg->getParameter(p);
+    generator.parameters[param->getId()] = param->getValue();
+  }
+  bool error = false;
+  ASTNode* astn = sdg->getMath()->deepCopy();
+  ASTNode* outer = extractAggregates(astn, generator, error);
+  if (outer != astn) {
+    delete astn;
+  }
+  if (!error) {
+    error = generator.formula.compile(outer);
+  }
+  delete outer;
+  if (error) {
+    g_registry.addErrorPrefix("Unable to evaluate data generator '" + generator.id + "':  ");
+    return true;
+  }
+  for (size_t g=0; g<m_generators.size(); g++) {
+    if (m_generators[g].id == generator.id) {
+      m_generators[g] = generator;
+      return false;
+    }
+  }
+  m_generators.push_back(generator);
+  return false;
+}
+
+vector<string> DataGeneratorEvaluator::getDataGeneratorIds() const
+{
+  vector<string> ret;
+  for (size_t g=0; g<m_generators.size(); g++) {
+    ret.push_back(m_generators[g].id);
+  }
+  return ret;
+}
+
+//Points the SedVariable with this ID at its simulation results:  row i is values[i*stride].  The values are not copied, and must stay valid until evaluation is done.
+void DataGeneratorEvaluator::setVariableValues(const string& variableId, const double* values, size_t length, size_t stride)
+{
+  Column column;
+  column.values = values;
+  column.length = length;
+  column.stride = stride;
+  m_columns[variableId] = column;
+}
+
+void DataGeneratorEvaluator::clearVariableValues()
+{
+  m_columns.clear();
+}
+
+const DataGeneratorEvaluator::Generator* DataGeneratorEvaluator::getGenerator(const string& id) const
+{
+  for (size_t g=0; g<m_generators.size(); g++) {
+    if (m_generators[g].id == id) {
+      return &m_generators[g];
+    }
+  }
+  return NULL;
+}
+
+//Aggregates are 'min' or 'max' with a single argument, whether from MathML's own <min/> and <max/> or from a SED-ML csymbol.
+bool isAggregateFunction(const ASTNode* astn, bool& isMax)
+{
+  if (astn->getNumChildren() != 1) {
+    return false;
+  }
+  switch(astn->getType()) {
+  case AST_FUNCTION_MAX:
+    isMax = true;
+    return true;
+  case AST_FUNCTION_MIN:
+    isMax = false;
+    return true;
+  case AST_FUNCTION:
+    {
+      string url = astn->getDefinitionURLString();
+      string name = astn->getName() == NULL ? "" : astn->getName();
+      if (url == "http://sed-ml.org/#max" || (url.empty() && name == "max")) {
+        isMax = true;
+        return true;
+      }
+      if (url == "http://sed-ml.org/#min" || (url.empty() && name == "min")) {
+        isMax = false;
+        return true;
+      }
+    }
+    break;
+  default:
+    break;
+  }
+  return false;
+}
+
+//Replaces every aggregate in the tree with a name standing for its (single) value, compiling its argument separately.  Inner aggregates are added first, so they are always calculated before the aggregates that use them.  Returns the new root, which is a new node if the root itself was an aggregate.
+ASTNode* DataGeneratorEvaluator::extractAggregates(ASTNode* astn, Generator& generator, bool& error) const
+{
+  for (unsigned int c=0; c<astn->getNumChildren() && !error; c++) {
+    ASTNode* child = astn->getChild(c);
+    ASTNode* replacement = extractAggregates(child, generator, error);
+    if (replacement != child) {
+      astn->replaceChild(c, replacement, true);
+    }
+  }
+  bool isMax = false;
+  if (error || !isAggregateFunction(astn, isMax)) {
+    return astn;
+  }
+  Aggregate aggregate;
+  stringstream name;
+  name << "__" << (isMax ? "max" : "min") << "_" << generator.aggregates.size();
+  aggregate.name = name.str();
+  aggregate.isMax = isMax;
+  if (aggregate.formula.compile(astn->getChild(0))) {
+    error = true;
+    return astn;
+  }
+  generator.aggregates.push_back(aggregate);
+  ASTNode* ret = new ASTNode(AST_NAME);
+  ret->setName(aggregate.name.c_str());
+  return ret;
+}
+
+//Sets up the inputs for a formula:  named scalars are used for every row, and columns are read in place.  The length is that of the shortest column, or 1 if there are none.  Returns true if a variable has no values, with its name in 'missing'.
+bool DataGeneratorEvaluator::getInputs(const CompiledFormula& formula, const map<string, double>& scalars, vector<FormulaInput>& inputs, size_t& length, string& missing) const
+{
+  vector<string> variables = formula.getVariables();
+  inputs.clear();
+  length = 1;
+  bool foundcolumn = false;
+  for (size_t v=0; v<variables.size(); v++) {
+    FormulaInput input;
+    map<string, double>::const_iterator scalar = scalars.find(variables[v]);
+    map<string, Column>::const_iterator column = m_columns.find(variables[v]);
+    if (scalar != scalars.end()) {
+      input.values = &scalar->second;
+      input.stride = 0;
+    }
+    else if (column != m_columns.end()) {
+      input.values = column->second.values;
+      input.stride = column->second.stride;
+      if (!foundcolumn || column->second.length < length) {
+        length = column->second.length;
+      }
+      foundcolumn = true;
+    }
+    else {
+      missing = variables[v];
+      return true;
+    }
+    inputs.push_back(input);
+  }
+  return false;
+}
+
+//Sets 'length' to the number of rows the data generator has with the current columns:  the length of its shortest column.  Returns true, without setting any error, if the generator is missing or any of its variables has no values.
+bool DataGeneratorEvaluator::getLength(const string& id, size_t& length) const
+{
+  length = 0;
+  const Generator* generator = getGenerator(id);
+  if (generator == NULL) {
+    return true;
+  }
+  map<string, double> scalars = generator->parameters;
+  for (size_t a=0; a<generator->aggregates.size(); a++) {
+    scalars[generator->aggregates[a].name] = 0;
+  }
+  vector<FormulaInput> inputs;
+  string missing;
+  if (getInputs(generator->formula, scalars, inputs, length, missing)) {
+    length = 0;
+    return true;
+  }
+  return false;
+}
+
+//Whether the data generator uses an aggregate, like max(S1), whose value depends on every row instead of just its own.
+bool DataGeneratorEvaluator::hasAggregates(const string& id) const
+{
+  const Generator* generator = getGenerator(id);
+  return (generator != NULL && !generator->aggregates.empty());
+}
+
+bool DataGeneratorEvaluator::evaluate(const Generator& generator, double* result, size_t length) const
+{
+  map<string, double> scalars = generator.parameters;
+  vector<FormulaInput> inputs;
+  vector<double> values;
+  string missing;
+  for (size_t a=0; a<generator.aggregates.size(); a++) {
+    const Aggregate& aggregate = generator.aggregates[a];
+    size_t num = 0;
+    if (getInputs(aggregate.formula, scalars, inputs, num, missing)) {
+      g_registry.setError("No values have been set for the variable '" + missing + "'.", 0);
+      return true;
+    }
+    values.resize(num);
+    double value = numeric_limits<double>::quiet_NaN();
+    if (num > 0) {
+      aggregate.formula.evaluate(inputs, num, &values[0]);
+      //NaN values are skipped, as with fmax and fmin.
+      for (size_t i=0; i<num; i++) {
+        double v = values[i];
+        if (value != value || (aggregate.isMax ? v > value : v < value)) {
+          value = v;
+        }
+      }
+    }
+    scalars[aggregate.name] = value;
+  }
+  size_t num = 0;
+  if (getInputs(generator.formula, scalars, inputs, num, missing)) {
+    g_registry.setError("No values have been set for the variable '" + missing + "'.", 0);
+    return true;
+  }
+  generator.formula.evaluate(inputs, min(num, length), result);
+  return false;
+}
+
+//Evaluates the data generator into 'result', which must have room for getLength(id) values.  If 'logScale' is set, the log10 of each value is returned instead, for data generators on a logarithmic axis (whose math, in the SED-ML, does not include the log).  Returns true on error.
+bool DataGeneratorEvaluator::evaluate(const string& id, double* result, bool logScale) const
+{
+  const Generator* generator = getGenerator(id);
+  if (generator == NULL) {
+    g_registry.setError("Unable to evaluate data generator '" + id + "':  no such data generator has been added.", 0);
+    return true;
+  }
+  //Without a length, evaluating the generator fails, and says which variable is missing.
+  size_t length = 0;
+  getLength(id, length);
+  if (evaluate(*generator, result, length)) {
+    g_registry.addErrorPrefix("Unable to evaluate data generator '" + id + "':  ");
+    return true;
+  }
+  if (logScale) {
+    for (size_t i=0; i<length; i++) {
+      result[i] = log10(result[i]);
+    }
+  }
+  return false;
+}
+
+bool DataGeneratorEvaluator::evaluate(const string& id, vector<double>& result, bool logScale) const
+{
+  size_t length = 0;
+  getLength(id, length);
+  result.resize(length);
+  if (result.empty()) {
+    double scratch;
+    return evaluate(id, &scratch, logScale);
+  }
+  return evaluate(id, &result[0], logScale);
+}
+
+PHRASEDML_CPP_NAMESPACE_END
@@ -0,0 +1,76 @@
+#ifndef DATAGENERATOREVALUATOR_H
+#define DATAGENERATOREVALUATOR_H
+
+#include <string>
+#include <vector>
+#include <map>
+
+#include "compiledFormula.h"
+#include "phrasedml-namespace.h"
+
+#include "sbml/math/ASTNode.h"
+#include "sedml/SedDocument.h"
+#include "sedml/SedDataGenerator.h"
+
+PHRASEDML_CPP_NAMESPACE_BEGIN
+
+//Whether the node is one of the SED-ML aggregates:  'min' or 'max' with a single argument.
+bool isAggregateFunction(const libsbml::ASTNode* astn, bool& isMax);
+
+//Evaluates SED-ML data generators over columns of simulation results.  Each generator's math is compiled once; the caller then points each SedVariable ID at its column of results (which is read in place, never copied), and every generator can be evaluated over whole columns at once.
+//
+//The SED-ML aggregate functions 'min' and 'max' (the single-argument forms) reduce their argument over the whole column to one value, which is then used for every row.  Multiple-argument min and max work row by row, as in SBML.
+class DataGeneratorEvaluator
+{
+private:
+  struct Column
+  {
+    const double* values;
+    size_t length;
+    size_t stride;
+  };
+
+  struct Aggregate
+  {
+    std::string name;
+    bool isMax;
+    CompiledFormula formula;
+  };
+
+  struct Generator
+  {
+    std::string id;
+    CompiledFormula formula;
+    std::vector<Aggregate> aggregates;
+    std::map<std::string, double> parameters;
+  };
+
+  std::vector<Generator> m_generators;
+  std::map<std::string, Column> m_columns;
+
+public:
+  DataGeneratorEvaluator();
+  ~DataGeneratorEvaluator();
+
+  bool addDataGenerators(libsedml::SedDocument* sedml);
+  bool addDataGenerator(libsedml::SedDataGenerator* sdg);
+  std::vector<std::string> getDataGeneratorIds() const;
+
+  void setVariableValues(const std::string& variableId, const double* values, size_t length, size_t stride=1);
+  void clearVariableValues();
+
+  bool getLength(const std::string& id, size_t& length) const;
+  bool hasAggregates(const std::string& id) const;
+  bool evaluate(const std::string& id, double* result, bool logScale=false) const;
+  bool evaluate(const std::string& id, std::vector<double>& result, bool logScale=false) const;
+
+private:
+  const Generator* getGenerator(const std::string& id) const;
+  libsbml::ASTNode* extractAggregates(libsbml::ASTNode* astn, Generator& generator, bool& error) const;
+  bool getInputs(const CompiledFormula& formula, const std::map<std::string, double>& scalars, std::vector<FormulaInput>& inputs, size_t& length, std::string& missing) const;
+  bool evaluate(const Generator& generator, double* result, size_t length) const;
+};
+
+PHRASEDML_CPP_NAMESPACE_END
+
+#endif //DATAGENERATOREVALUATOR_H
@@ -0,0 +1,413 @@
+#include <cctype>
+#include <map>
+#include <sstream>
+
+#include "editSession.h"
+#include "registry.h"
+#include "stringx.h"
+
+using namespace std;
+
+PHRASEDML_CPP_NAMESPACE_BEGIN
+
+PhrasedEditSession::PhrasedEditSession()
+  : m_lines()
+  , m_groups()
+  , m_revision(0)
+  , m_valid(false)
+  , m_numReparsed(0)
+{
+}
+
+PhrasedEditSession::~PhrasedEditSession()
+{
+}
+
+//Replaces the whole document, and parses all of it.  Returns true on error.
+bool PhrasedEditSession::setText(const string& text)
+{
+  size_t first = text.find_first_not_of(" \t\r\n");
+  if (first != string::npos && text[first] == '<') {
+    g_registry.setError("Unable to edit this document:  only phraSED-ML documents can be edited line by line.", 0);
+    m_valid = false;
+    return true;
+  }
+  m_lines.clear();
+  size_t start = 0;
+  while (start < text.size()) {
+    size_t end = text.find('\n', start);
+    if (end == string::npos) {
+      end = text.size();
+    }
+    m_lines.push_back(text.substr(start, end-start));
+    start = end+1;
+  }
+  m_valid = false;
+  vector<StatementGroup> groups;
+  getStatementGroups(groups);
+  return update(groups);
+}
+
+//Replaces 'numLines' lines, starting at 'firstLine' (counting from 1), with the lines of 'text', and parses whatever changed.  With 'numLines' of zero, the text is inserted before 'firstLine'.  Returns true on error.
+bool PhrasedEditSession::edit(size_t firstLine, size_t numLines, const string& text)
+{
+  if (firstLine == 0 || firstLine > m_lines.size() + 1 || numLines > m_lines.size() + 1 - firstLine) {
+    stringstream err;
+    err << "Unable to edit lines " << firstLine << " through " << firstLine + numLines - 1 << ":  the document only has " << m_lines.size() << " lines.";
+    g_registry.setError(err.str(), 0);
+    return true;
+  }
+  vector<string> lines;
+  size_t start = 0;
+  while (start < text.size()) {
+    size_t end = text.find('\n', start);
+    if (end == string::npos) {
+      end = text.size();
+    }
+    lines.push_back(text.substr(start, end-start));
+    start = end+1;
+  }
+  m_lines.erase(m_lines.begin() + (firstLine-1), m_lines.begin() + (firstLine-1+numLines));
+  m_lines.insert(m_lines.begin() + (firstLine-1), lines.begin(), lines.end());
+  vector<StatementGroup> groups;
+  getStatementGroups(groups);
+  return update(groups);
+}
+
+string PhrasedEditSession::getText() const
+{
+  string ret;
+  for (size_t l=0; l<m_lines.size(); l++) {
+    if (l>0) {
+      ret += "\n";
+    }
+    ret += m_lines[l];
+  }
+  return ret;
+}
+
+//The number of statements parsed by the last edit.
+size_t PhrasedEditSession::getNumReparsed() const
+{
+  return m_numReparsed;
+}
+
+static string getGroupContent(const StatementGroup& group)
+{
+  string ret;
+  for (size_t s=0; s<group.statements.size(); s++) {
+    ret += group.statements[s].text + "\n";
+  }
+  return ret;
+}
+
+//Brings g_registry up to date with the new statement groups:  every group that changed, and every group that mentions the owner of one that did, has what it defined removed and is parsed again.  Everything is parsed if the last edit failed or g_registry was used for something else.  Returns true on error.
+bool PhrasedEditSession::update(const vector<StatementGroup>& groups)
+{
+  m_numReparsed = 0;
+  vector<StatementGroup> newgroups = groups;
+  vector<bool> newdirty(newgroups.size(), false);
+  vector<bool> olddirty(m_groups.size(), false);
+  map<string, size_t> oldkeys, newkeys;
+  for (size_t g=0; g<m_groups.size(); g++) {
+    oldkeys.insert(make_pair(m_groups[g].key, g));
+  }
+  for (size_t g=0; g<newgroups.size(); g++) {
+    newkeys.insert(make_pair(newgroups[g].key, g));
+  }
+  bool reparseAll = (!m_valid || g_registry.getRevision() != m_revision);
+
+  set<string> dirtyowners;
+  vector<size_t> queue;
+  for (size_t g=0; g<newgroups.size(); g++) {
+    map<string, size_t>::iterator old = oldkeys.find(newgroups[g].key);
+    if (reparseAll || old == oldkeys.end() || getGroupContent(m_groups[old->second]) != getGroupContent(newgroups[g])) {
+      newdirty[g] = true;
+      queue.push_back(g);
+    }
+  }
+  for (size_t g=0; g<m_groups.size(); g++) {
+    if (newkeys.find(m_groups[g].key) == newkeys.end()) {
+      olddirty[g] = true;
+      if (!m_groups[g].owner.empty()) {
+        dirtyowners.insert(m_groups[g].owner);
+      }
+    }
+  }
+  //Anything that mentions a changed ID must be parsed again, too.
+  map<string, vector<size_t> > mentions;
+  for (size_t g=0; g<newgroups.size(); g++) {
+    for (set<string>::const_iterator word = newgroups[g].words.begin(); word != newgroups[g].words.end(); word++) {
+      mentions[*word].push_back(g);
+    }
+  }
+  vector<string> owners(dirtyowners.begin(), dirtyowners.end());
+  size_t q = 0;
+  while (q < queue.size() || !owners.empty()) {
+    if (!owners.empty()) {
+      string owner = owners.back();
+      owners.pop_back();
+      vector<size_t>& mentioned = mentions[owner];
+      for (size_t m=0; m<mentioned.size(); m++) {
+        if (!newdirty[mentioned[m]]) {
+          newdirty[mentioned[m]] = true;
+          queue.push_back(mentioned[m]);
+        }
+      }
+      continue;
+    }
+    const string& owner = newgroups[queue[q]].owner;
+    if (!owner.empty() && dirtyowners.insert(owner).second) {
+      owners.push_back(owner);
+    }
+    q++;
+  }
+  for (size_t g=0; g<m_groups.size(); g++) {
+    map<string, size_t>::iterator found = newkeys.find(m_groups[g].key);
+    if (found != newkeys.end() && newdirty[found->second]) {
+      olddirty[g] = true;
+    }
+  }
+  if (!reparseAll && queue.empty() && dirtyowners.empty()) {
+    //Only whitespace, comments, or line numbers changed.  Every group was kept, along with its warnings.
+    for (size_t g=0; g<newgroups.size(); g++) {
+      newgroups[g].warnings = m_groups[oldkeys[newgroups[g].key]].warnings;
+    }
+    m_groups = newgroups;
+    return false;
+  }
+
+  g_registry.setError("", 0);
+  if (reparseAll) {
+    g_registry.clearElements();
+  }
+  else {
+    size_t numoutputs = 0;
+    vector<size_t> dirtyoutputs;
+    for (size_t g=0; g<m_groups.size(); g++) {
+      if (m_groups[g].owner.empty()) {
+        if (olddirty[g]) {
+          dirtyoutputs.push_back(numoutputs);
+        }
+        numoutputs++;
+      }
+      else if (olddirty[g]) {
+        g_registry.removeElement(m_groups[g].owner);
+      }
+    }
+    for (size_t d=dirtyoutputs.size(); d>0; d--) {
+      g_registry.removeOutput(dirtyoutputs[d-1]);
+    }
+  }
+
+  m_valid = false;
+  g_registry.clearWarnings();
+  size_t numwarnings = 0;
+  for (size_t g=0; g<newgroups.size(); g++) {
+    if (!newdirty[g]) {
+      newgroups[g].warnings = m_groups[oldkeys[newgroups[g].key]].warnings;
+      continue;
+    }
+    if (g_registry.parseStatements(getGroupText(newgroups[g]), static_cast<int>(newgroups[g].statements[0].line))) {
+      return true;
+    }
+    vector<string> warnings = g_registry.getPhrasedWarnings();
+    newgroups[g].warnings.assign(warnings.begin() + numwarnings, warnings.end());
+    numwarnings = warnings.size();
+    m_numReparsed += newgroups[g].statements.size();
+  }
+  if (g_registry.finalizeParsedStatements()) {
+    return true;
+  }
+
+  //Put everything back in document order:  outputs that were kept are still in their old order, followed by the ones just parsed.
+  map<string, size_t> positions;
+  vector<size_t> outputpositions;
+  for (size_t g=0; g<newgroups.size(); g++) {
+    if (!newgroups[g].owner.empty()) {
+      positions.insert(make_pair(newgroups[g].owner, g));
+    }
+  }
+  if (!reparseAll) {
+    for (size_t g=0; g<m_groups.size(); g++) {
+      if (m_groups[g].owner.empty() && !olddirty[g]) {
+        outputpositions.push_back(newkeys[m_groups[g].key]);
+      }
+    }
+  }
+  for (size_t g=0; g<newgroups.size(); g++) {
+    if (newgroups[g].owner.empty() && newdirty[g]) {
+      outputpositions.push_back(g);
+    }
+  }
+  g_registry.sortElements(positions, outputpositions);
+
+  vector<string> finalizewarnings = g_registry.getPhrasedWarnings();
+  finalizewarnings.erase(finalizewarnings.begin(), finalizewarnings.begin() + numwarnings);
+  g_registry.clearWarnings();
+  for (size_t g=0; g<newgroups.size(); g++) {
+    for (size_t w=0; w<newgroups[g].warnings.size(); w++) {
+      g_registry.addWarning(newgroups[g].warnings[w]);
+    }
+  }
+  for (size_t w=0; w<finalizewarnings.size(); w++) {
+    g_registry.addWarning(finalizewarnings[w]);
+  }
+
+  m_groups = newgroups;
+  m_revision = g_registry.getRevision();
+  m_valid = true;
+  return false;
+}
+
+static bool isStatementEnd(char cc)
+{
+  return (cc == '\n' || cc == '\r' || cc == ';');
+}
+
+//Splits the document into statements the way the parser does:  at semicolons and line ends (unless the line ends with a backslash), skipping comments and the insides of quoted strings.  Each statement is then grouped with the others about the same ID.
+void PhrasedEditSession::getStatementGroups(vector<StatementGroup>& groups) const
+{
+  groups.clear();
+  string text = getText();
+  map<string, size_t> groupkeys;
+  map<string, size_t> outputcounts;
+  size_t line = 1;
+  size_t start = string::npos;
+  size_t startline = 0;
+  vector<string> tokens;
+  set<string> words;
+  size_t i = 0;
+  while (i <= text.size()) {
+    if (i == text.size() || isStatementEnd(text[i])) {
+      if (start != string::npos) {
+        EditStatement statement;
+        statement.text = text.substr(start, i-start);
+        statement.line = startline;
+        string owner;
+        if (tokens.size() > 1 && (isalpha(tokens[0][0]) || tokens[0][0] == '_') && (tokens[1] == "=" || tokens[1] == "." || CaselessStrCmp(tokens[1], "is"))) {
+          owner = tokens[0];
+        }
+        string key;
+        if (owner.empty()) {
+          size_t count = outputcounts[statement.text]++;
+          key = "output " + SizeTToString(count) + " " + statement.text;
+        }
+        else {
+          key = "id " + owner;
+        }
+        map<string, size_t>::iterator found = groupkeys.find(key);
+        if (found == groupkeys.end()) {
+          StatementGroup group;
+          group.key = key;
+          group.owner = owner;
+          found = groupkeys.insert(make_pair(key, groups.size())).first;
+          groups.push_back(group);
+        }
+        groups[found->second].statements.push_back(statement);
+        groups[found->second].words.insert(words.begin(), words.end());
+        start = string::npos;
+        tokens.clear();
+        words.clear();
+      }
+      if (i < text.size() && text[i] == '\n') {
+        line++;
+      }
+      i++;
+      continue;
+    }
+    char cc = text[i];
+    if (cc == ' ' || cc == '\t') {
+      i++;
+      continue;
+    }
+    if (cc == '\\' && i+1 < text.size() && (text[i+1] == '\r' || text[i+1] == '\n' || text[i+1] == ' ')) {
+      //A continued line.
+      i++;
+      while (i < text.size() && (text[i] == '\r' || text[i] == '\n' || text[i] == ' ')) {
+        if (text[i] == '\n') {
+          line++;
+        }
+        i++;
+      }
+      continue;
+    }
+    if (cc == '#' || (cc == '/' && i+1 < text.size() && text[i+1] == '/')) {
+      while (i < text.size() && text[i] != '\n' && text[i] != '\r') {
+        i++;
+      }
+      continue;
+    }
+    if (cc == '/' && i+1 < text.size() && text[i+1] == '*') {
+      size_t end = text.find("*/", i+2);
+      end = (end == string::npos) ? text.size() : end+2;
+      for (; i<end; i++) {
+        if (text[i] == '\n') {
+          line++;
+        }
+      }
+      continue;
+    }
+    if (start == string::npos) {
+      start = i;
+      startline = line;
+    }
+    if (cc == '"') {
+      size_t end = text.find_first_of("\"\r\n", i+1);
+      if (end != string::npos && text[end] == '"') {
+        i = end;
+      }
+      tokens.push_back("\"");
+      i++;
+      continue;
+    }
+    if (isalpha(cc) || cc == '_') {
+      size_t end = i;
+      while (end < text.size() && (isalnum(text[end]) || text[end] == '_')) {
+        end++;
+      }
+      string word = text.substr(i, end-i);
+      words.insert(word);
+      tokens.push_back(word);
+      i = end;
+      continue;
+    }
+    if (isdigit(cc)) {
+      while (i < text.size() && (isalnum(text[i]) || text[i] == '.')) {
+        i++;
+      }
+      tokens.push_back("0");
+      continue;
+    }
+    tokens.push_back(string(1, cc));
+    i++;
+  }
+}
+
+//The group's statements, with blank lines in between so that the parser's line numbers match the document's.
+string PhrasedEditSession::getGroupText(const StatementGroup& group) const
+{
+  string ret;
+  size_t line = group.statements[0].line;
+  for (size_t s=0; s<group.statements.size(); s++) {
+    const EditStatement& statement = group.statements[s];
+    if (s > 0) {
+      if (statement.line > line) {
+        ret.append(statement.line - line, '\n');
+      }
+      else {
+        ret += ";";
+      }
+    }
+    ret += statement.text;
+    line = statement.line;
+    for (size_t c=0; c<statement.text.size(); c++) {
+      if (statement.text[c] == '\n') {
+        line++;
+      }
+    }
+  }
+  return ret;
+}
+
+PHRASEDML_CPP_NAMESPACE_END
@@ -0,0 +1,59 @@
+#ifndef PHRASEDEDITSESSION_H
+#define PHRASEDEDITSESSION_H
+
+#include <set>
+#include <string>
+#include <vector>
+
+#include "phrasedml-namespace.h"
+
+PHRASEDML_CPP_NAMESPACE_BEGIN
+
+//One top-level phraSED-ML statement, and the line it starts on.
+struct EditStatement
+{
+  std::string text;
+  size_t line;
+};
+
+//Every statement about one element:  its definition, plus any lines that set its name or algorithm.  Each output is its own group, with no owner.  'words' are every ID the statements mention.
+struct StatementGroup
+{
+  std::string key;
+  std::string owner;
+  std::vector<EditStatement> statements;
+  std::set<std::string> words;
+  std::vector<std::string> warnings;
+};
+
+//A phraSED-ML document that is edited a few lines at a time, as in an editor.  After each edit, only the statements that changed, plus those that mention anything they define, are parsed and finalized again; everything else in g_registry is kept.  That includes the index of every SBML file it read:  a model that is parsed again reuses the index of its file, so a change to the file itself is only seen once the whole document is parsed again.  The SED-ML is only rebuilt when it is next asked for.
+//
+//If g_registry is used for anything else in between (such as another conversion), or an edit fails, the next edit parses the whole document again.
+class PhrasedEditSession
+{
+private:
+  std::vector<std::string> m_lines;
+  std::vector<StatementGroup> m_groups;
+  size_t m_revision;
+  bool m_valid;
+  size_t m_numReparsed;
+
+public:
+  PhrasedEditSession();
+  ~PhrasedEditSession();
+
+  bool setText(const std::string& text);
+  bool edit(size_t firstLine, size_t numLines, const std::string& text);
+
+  std::string getText() const;
+  size_t getNumReparsed() const;
+
+private:
+  bool update(const std::vector<StatementGroup>& groups);
+  void getStatementGroups(std::vector<StatementGroup>& groups) const;
+  std::string getGroupText(const StatementGroup& group) const;
+};
+
+PHRASEDML_CPP_NAMESPACE_END
+
+#endif //PHRASEDEDITSESSION_H
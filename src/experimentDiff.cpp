@@ -0,0 +1,194 @@
+#include <map>
+#include <set>
+
+#include "experimentDiff.h"
+#include "contentHash.h"
+#include "model.h"
+#include "output.h"
+#include "registry.h"
+#include "repeatedTask.h"
+#include "simulation.h"
+#include "task.h"
+
+using namespace std;
+
+PHRASEDML_CPP_NAMESPACE_BEGIN
+
+//The models the changes are restricted to, other than 'ownerid', the model they are part of (if any).
+static void addChangeDependencies(const vector<ModelChange>& changes, const string& ownerid, vector<string>& dependencies)
+{
+  for (size_t c=0; c<changes.size(); c++) {
+    if (!changes[c].getModel().empty() && changes[c].getModel() != ownerid) {
+      dependencies.push_back(changes[c].getModel());
+    }
+  }
+}
+
+//The content hash of every model, simulation, task, and output in g_registry, in that order, along with what each depends on.  Returns true on error.
+bool takeExperimentSnapshot(ExperimentSnapshot& snapshot)
+{
+  snapshot.clear();
+  PhrasedContentHasher hasher;
+  for (size_t m=0; m<g_registry.getNumModels(); m++) {
+    const PhrasedModel* model = g_registry.getModel(m);
+    SnapshotElement element;
+    element.kind = "model";
+    element.id = model->getId();
+    if (hasher.getModelHash(element.id, element.hash)) {
+      return true;
+    }
+    if (!model->getIsFile() && g_registry.getModel(model->getSource()) != NULL) {
+      element.dependencies.push_back(model->getSource());
+    }
+    addChangeDependencies(model->getChanges(), element.id, element.dependencies);
+    snapshot.push_back(element);
+  }
+  for (size_t s=0; s<g_registry.getNumSimulations(); s++) {
+    SnapshotElement element;
+    element.kind = "simulation";
+    element.id = g_registry.getSimulation(s)->getId();
+    if (hasher.getSimulationHash(element.id, element.hash)) {
+      return true;
+    }
+    snapshot.push_back(element);
+  }
+  for (size_t t=0; t<g_registry.getNumTasks(); t++) {
+    const PhrasedTask* task = g_registry.getTask(t);
+    SnapshotElement element;
+    element.id = task->getId();
+    if (hasher.getTaskHash(element.id, element.hash)) {
+      return true;
+    }
+    if (task->isRepeated()) {
+      const PhrasedRepeatedTask* rt = static_cast<const PhrasedRepeatedTask*>(task);
+      element.kind = "repeatedTask";
+      element.dependencies = rt->getTasks();
+      addChangeDependencies(rt->getChanges(), "", element.dependencies);
+    }
+    else {
+      element.kind = "task";
+      element.dependencies.push_back(task->getModelReference());
+      element.dependencies.push_back(task->getSimulationReference());
+    }
+    snapshot.push_back(element);
+  }
+  for (size_t o=0; o<g_registry.getNumOutputs(); o++) {
+    const PhrasedOutput* output = g_registry.getOutput(o);
+    SnapshotElement element;
+    element.kind = "output";
+    element.id = output->getId();
+    if (hasher.getOutputHash(output, element.hash)) {
+      return true;
+    }
+    set<string> references = output->getTaskReferences();
+    element.dependencies.insert(element.dependencies.end(), references.begin(), references.end());
+    snapshot.push_back(element);
+  }
+  return false;
+}
+
+//Elements are matched by ID.  An element that was removed and one that was added with the same kind and content are reported as a single rename; each removed element is matched to at most one added element, preferring one with the same dependencies, so that elements with the same content are paired up by what they use.  Differences are listed in the order of 'after', followed by anything removed, in the order of 'before'.
+void diffExperimentSnapshots(const ExperimentSnapshot& before, const ExperimentSnapshot& after, vector<ExperimentDifference>& differences)
+{
+  differences.clear();
+  map<string, size_t> beforeIds;
+  for (size_t b=0; b<before.size(); b++) {
+    beforeIds[before[b].id] = b;
+  }
+  set<string> afterIds;
+  for (size_t a=0; a<after.size(); a++) {
+    afterIds.insert(after[a].id);
+  }
+  //Removed elements that could still be matched to an added one with the same content.
+  vector<bool> unmatched(before.size(), false);
+  for (size_t b=0; b<before.size(); b++) {
+    unmatched[b] = (afterIds.find(before[b].id) == afterIds.end());
+  }
+
+  //The first pass only pairs elements with the same dependencies; the second pairs whatever is left, in order.
+  vector<size_t> renamedFrom(after.size(), string::npos);
+  for (size_t pass=0; pass<2; pass++) {
+    for (size_t a=0; a<after.size(); a++) {
+      if (renamedFrom[a] != string::npos || beforeIds.find(after[a].id) != beforeIds.end()) {
+        continue;
+      }
+      for (size_t b=0; b<before.size(); b++) {
+        if (unmatched[b] && before[b].kind == after[a].kind && before[b].hash == after[a].hash && (pass == 1 || before[b].dependencies == after[a].dependencies)) {
+          renamedFrom[a] = b;
+          unmatched[b] = false;
+          break;
+        }
+      }
+    }
+  }
+
+  map<string, diff_status> statuses;
+  for (size_t a=0; a<after.size(); a++) {
+    const SnapshotElement& element = after[a];
+    ExperimentDifference difference;
+    difference.kind = element.kind;
+    difference.id = element.id;
+    map<string, size_t>::iterator found = beforeIds.find(element.id);
+    if (found == beforeIds.end()) {
+      difference.status = diff_added;
+      if (renamedFrom[a] != string::npos) {
+        difference.status = diff_renamed;
+        difference.oldId = before[renamedFrom[a]].id;
+      }
+    }
+    else if (before[found->second].hash != element.hash || before[found->second].kind != element.kind) {
+      difference.status = diff_changed;
+    }
+    else {
+      continue;
+    }
+    statuses[element.id] = difference.status;
+    differences.push_back(difference);
+  }
+
+  //A changed element's causes are whichever of its dependencies differ, too.
+  map<string, size_t> afterIndex;
+  for (size_t a=0; a<after.size(); a++) {
+    afterIndex[after[a].id] = a;
+  }
+  for (size_t d=0; d<differences.size(); d++) {
+    if (differences[d].status != diff_changed) {
+      continue;
+    }
+    const SnapshotElement& element = after[afterIndex[differences[d].id]];
+    set<string> seen;
+    for (size_t dep=0; dep<element.dependencies.size(); dep++) {
+      const string& id = element.dependencies[dep];
+      if (statuses.find(id) != statuses.end() && seen.insert(id).second) {
+        differences[d].causes.push_back(id);
+      }
+    }
+  }
+
+  for (size_t b=0; b<before.size(); b++) {
+    if (unmatched[b]) {
+      ExperimentDifference difference;
+      difference.status = diff_removed;
+      difference.kind = before[b].kind;
+      difference.id = before[b].id;
+      differences.push_back(difference);
+    }
+  }
+}
+
+string getDiffStatusString(diff_status status)
+{
+  switch(status) {
+  case diff_added:
+    return "added";
+  case diff_removed:
+    return "removed";
+  case diff_changed:
+    return "changed";
+  case diff_renamed:
+    return "renamed";
+  }
+  return "unknown";
+}
+
+PHRASEDML_CPP_NAMESPACE_END
@@ -0,0 +1,45 @@
+#ifndef PHRASEDEXPERIMENTDIFF_H
+#define PHRASEDEXPERIMENTDIFF_H
+
+#include <string>
+#include <vector>
+
+#include "phrasedml-namespace.h"
+
+PHRASEDML_CPP_NAMESPACE_BEGIN
+
+//One element of an experiment:  its kind ('model', 'simulation', 'task', 'repeatedTask', or 'output'), its content hash, and the IDs of the elements it directly depends on.
+struct SnapshotElement
+{
+  std::string kind;
+  std::string id;
+  unsigned long long hash;
+  std::vector<std::string> dependencies;
+};
+
+typedef std::vector<SnapshotElement> ExperimentSnapshot;
+
+enum diff_status {
+    diff_added
+  , diff_removed
+  , diff_changed
+  , diff_renamed
+};
+
+//How one element differs between two snapshots.  A renamed element has the same content under a new ID ('oldId').  A changed element's 'causes' are the dependencies that were added, changed, or renamed; if there are none, the element's own definition changed.
+struct ExperimentDifference
+{
+  diff_status status;
+  std::string kind;
+  std::string id;
+  std::string oldId;
+  std::vector<std::string> causes;
+};
+
+bool takeExperimentSnapshot(ExperimentSnapshot& snapshot);
+void diffExperimentSnapshots(const ExperimentSnapshot& before, const ExperimentSnapshot& after, std::vector<ExperimentDifference>& differences);
+std::string getDiffStatusString(diff_status status);
+
+PHRASEDML_CPP_NAMESPACE_END
+
+#endif //PHRASEDEXPERIMENTDIFF_H
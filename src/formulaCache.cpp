@@ -0,0 +1,94 @@
+#include "formulaCache.h"
+
+using namespace std;
+using namespace libsbml;
+
+PHRASEDML_CPP_NAMESPACE_BEGIN
+
+FormulaCache::FormulaCache()
+  : m_formulas()
+  , m_uses()
+  , m_maxSize(10000)
+  , m_numHits(0)
+  , m_numMisses(0)
+{
+}
+
+FormulaCache::~FormulaCache()
+{
+}
+
+//The AST cached for 'formula', which then becomes the most recently used, or an empty pointer if it hasn't been parsed yet.
+shared_ptr<const ASTNode> FormulaCache::find(const string& formula)
+{
+  map<string, CachedFormula>::iterator found = m_formulas.find(formula);
+  if (found == m_formulas.end()) {
+    m_numMisses++;
+    return shared_ptr<const ASTNode>();
+  }
+  m_numHits++;
+  m_uses.splice(m_uses.begin(), m_uses, found->second.use);
+  return found->second.astn;
+}
+
+//Caches the AST parsed from 'formula', dropping the least recently used formula if the cache is full.
+void FormulaCache::insert(const string& formula, shared_ptr<const ASTNode> astn)
+{
+  if (m_maxSize == 0 || !astn) {
+    return;
+  }
+  map<string, CachedFormula>::iterator found = m_formulas.find(formula);
+  if (found != m_formulas.end()) {
+    found->second.astn = astn;
+    m_uses.splice(m_uses.begin(), m_uses, found->second.use);
+    return;
+  }
+  while (m_formulas.size() >= m_maxSize) {
+    m_formulas.erase(m_uses.back());
+    m_uses.pop_back();
+  }
+  m_uses.push_front(formula);
+  CachedFormula cached;
+  cached.astn = astn;
+  cached.use = m_uses.begin();
+  m_formulas.insert(make_pair(formula, cached));
+}
+
+//Drops every cached formula, but keeps counting hits and misses.
+void FormulaCache::clear()
+{
+  m_formulas.clear();
+  m_uses.clear();
+}
+
+//Sets how many formulas are kept, dropping the least recently used until there are no more.  Zero turns the cache off.
+void FormulaCache::setMaxSize(size_t maxSize)
+{
+  m_maxSize = maxSize;
+  while (m_formulas.size() > m_maxSize) {
+    m_formulas.erase(m_uses.back());
+    m_uses.pop_back();
+  }
+}
+
+size_t FormulaCache::getMaxSize() const
+{
+  return m_maxSize;
+}
+
+size_t FormulaCache::getSize() const
+{
+  return m_formulas.size();
+}
+
+size_t FormulaCache::getNumHits() const
+{
+  return m_numHits;
+}
+
+size_t FormulaCache::getNumMisses() const
+{
+  return m_numMisses;
+}
+
+PHRASEDML_CPP_NAMESPACE_END
@@ -0,0 +1,49 @@
+#ifndef PHRASEDFORMULACACHE_H
+#define PHRASEDFORMULACACHE_H
+
+#include <list>
+#include <map>
+#include <memory>
+#include <string>
+
+#include "sbml/math/ASTNode.h"
+#include "phrasedml-namespace.h"
+
+PHRASEDML_CPP_NAMESPACE_BEGIN
+
+//Formulas that have already been parsed, by their text, so that an expression repeated throughout an experiment (or from one conversion to the next) is only parsed once.  The ASTs are shared, and must never be changed once cached.  When full, the formula used longest ago is dropped.
+class FormulaCache
+{
+private:
+  //Formulas, most recently used first.
+  typedef std::list<std::string> UseList;
+  struct CachedFormula
+  {
+    std::shared_ptr<const libsbml::ASTNode> astn;
+    UseList::iterator use;
+  };
+
+  std::map<std::string, CachedFormula> m_formulas;
+  UseList m_uses;
+  size_t m_maxSize;
+  size_t m_numHits;
+  size_t m_numMisses;
+
+public:
+  FormulaCache();
+  ~FormulaCache();
+
+  std::shared_ptr<const libsbml::ASTNode> find(const std::string& formula);
+  void insert(const std::string& formula, std::shared_ptr<const libsbml::ASTNode> astn);
+  void clear();
+
+  void setMaxSize(size_t maxSize);
+  size_t getMaxSize() const;
+  size_t getSize() const;
+  size_t getNumHits() const;
+  size_t getNumMisses() const;
+};
+
+PHRASEDML_CPP_NAMESPACE_END
+
+#endif //PHRASEDFORMULACACHE_H
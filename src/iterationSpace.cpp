@@ -0,0 +1,271 @@
+#include <algorithm>
+#include <cassert>
+#include <limits>
+#include <sstream>
+#include <set>
+
+#include "iterationSpace.h"
+#include "registry.h"
+#include "task.h"
+#include "repeatedTask.h"
+#include "stringx.h"
+
+using namespace std;
+
+PHRASEDML_CPP_NAMESPACE_BEGIN
+
+size_t getChunkStart(size_t size, size_t chunk, size_t numChunks)
+{
+  if (numChunks == 0) {
+    return 0;
+  }
+  if (chunk >= numChunks) {
+    return size;
+  }
+  return (size/numChunks)*chunk + min(chunk, size%numChunks);
+}
+
+PhrasedIterationSpace::PhrasedIterationSpace(const string& task)
+  : m_task(task)
+  , m_nodes()
+{
+}
+
+PhrasedIterationSpace::~PhrasedIterationSpace()
+{
+}
+
+//Walks the task tree from m_task, recording how many runs each task performs.  Returns true on error.
+bool PhrasedIterationSpace::build()
+{
+  m_nodes.clear();
+  set<string> parents;
+  size_t root;
+  if (addNode(m_task, parents, root)) {
+    m_nodes.clear();
+    return true;
+  }
+  return false;
+}
+
+bool PhrasedIterationSpace::addNode(const string& task, set<string>& parents, size_t& nodenum)
+{
+  const PhrasedTask* pt = g_registry.getTask(task);
+  if (pt == NULL) {
+    g_registry.setError("Unable to find the task '" + task + "' when computing the iterations of repeated task '" + m_task + "'.", 0);
+    return true;
+  }
+  if (parents.find(task) != parents.end()) {
+    g_registry.setError("Unable to compute the iterations of repeated task '" + m_task + "':  the task '" + task + "' references itself.", 0);
+    return true;
+  }
+  nodenum = m_nodes.size();
+  Node node;
+  node.task = task;
+  node.repeated = NULL;
+  node.numIterations = 1;
+  node.perIteration = 1;
+  node.size = 1;
+  m_nodes.push_back(node);
+  if (!pt->isRepeated()) {
+    return false;
+  }
+
+  const PhrasedRepeatedTask* rt = static_cast<const PhrasedRepeatedTask*>(pt);
+  vector<string> subtasks = rt->getTasks();
+  vector<size_t> subnodes;
+  vector<size_t> offsets;
+  size_t per = 0;
+  size_t maxsize = numeric_limits<size_t>::max();
+  parents.insert(task);
+  for (size_t t=0; t<subtasks.size(); t++) {
+    size_t subnum;
+    if (addNode(subtasks[t], parents, subnum)) {
+      return true;
+    }
+    size_t subsize = m_nodes[subnum].size;
+    if (subsize > maxsize - per) {
+      g_registry.setError("The repeated task '" + m_task + "' has too many iterations to count.", 0);
+      return true;
+    }
+    offsets.push_back(per);
+    subnodes.push_back(subnum);
+    per += subsize;
+  }
+  parents.erase(task);
+
+  size_t num = rt->getNumIterations();
+  if (per > 0 && num > maxsize / per) {
+    g_registry.setError("The repeated task '" + m_task + "' has too many iterations to count.", 0);
+    return true;
+  }
+  Node& added = m_nodes[nodenum];
+  added.repeated = rt;
+  added.numIterations = num;
+  added.perIteration = per;
+  added.size = num * per;
+  added.subtasks = subnodes;
+  added.offsets = offsets;
+  return false;
+}
+
+string PhrasedIterationSpace::getTask() const
+{
+  return m_task;
+}
+
+//The total number of (non-repeated) task runs.
+size_t PhrasedIterationSpace::getSize() const
+{
+  if (m_nodes.empty()) {
+    return 0;
+  }
+  return m_nodes[0].size;
+}
+
+//Looks up the task run at position 'flat' without expanding anything:  each level of nesting is a division plus a search over that level's subtasks.  Returns true if 'flat' is out of range.
+bool PhrasedIterationSpace::getPoint(size_t flat, IterationPoint& point) const
+{
+  point.indices.clear();
+  point.task.clear();
+  if (flat >= getSize()) {
+    stringstream err;
+    err << "Iteration " << flat << " is out of range for repeated task '" << m_task << "', which only has " << getSize() << " iterations.";
+    g_registry.setError(err.str(), 0);
+    return true;
+  }
+  size_t n = 0;
+  while (m_nodes[n].repeated != NULL) {
+    const Node& node = m_nodes[n];
+    IterationIndex index;
+    index.repeatedTask = node.task;
+    index.iteration = flat / node.perIteration;
+    size_t rem = flat % node.perIteration;
+    size_t sub = static_cast<size_t>(upper_bound(node.offsets.begin(), node.offsets.end(), rem) - node.offsets.begin()) - 1;
+    index.subtask = sub;
+    point.indices.push_back(index);
+    flat = rem - node.offsets[sub];
+    n = node.subtasks[sub];
+  }
+  point.task = m_nodes[n].task;
+  return false;
+}
+
+//The values of every uniform and vector range at the given point, outermost repeated task first.
+void PhrasedIterationSpace::getRangeValues(const IterationPoint& point, vector<pair<string, double> >& values) const
+{
+  size_t n = 0;
+  for (size_t i=0; i<point.indices.size() && n<m_nodes.size(); i++) {
+    const Node& node = m_nodes[n];
+    if (node.repeated == NULL || point.indices[i].subtask >= node.subtasks.size()) {
+      return;
+    }
+    node.repeated->getRangeValues(point.indices[i].iteration, values);
+    n = node.subtasks[point.indices[i].subtask];
+  }
+}
+
+size_t PhrasedIterationSpace::getChunkBegin(size_t chunk, size_t numChunks) const
+{
+  return getChunkStart(getSize(), chunk, numChunks);
+}
+
+size_t PhrasedIterationSpace::getChunkEnd(size_t chunk, size_t numChunks) const
+{
+  return getChunkBegin(chunk+1, numChunks);
+}
+
+//Creates the repeated tasks needed to run exactly the runs [begin, end), in order.  Runs of whole iterations become a single slice of the repeated task; partial iterations at either end become a one-iteration slice whose subtasks are themselves sliced.  'toplevel' is set to the tasks that, run one after the other, perform the chunk.  Subtasks that are run in full keep their original IDs.
+//
+//Note that chunks are run independently:  if the repeated task does not reset its model, the model state at the start of a chunk will not match the state it would have had partway through the full run.
+bool PhrasedIterationSpace::getChunkTasks(size_t begin, size_t end, const string& idbase, vector<PhrasedRepeatedTask>& tasks, vector<string>& toplevel) const
+{
+  if (begin > end || end > getSize()) {
+    stringstream err;
+    err << "Unable to create a chunk of repeated task '" << m_task << "' from iteration " << begin << " to " << end << ":  it only has " << getSize() << " iterations.";
+    g_registry.setError(err.str(), 0);
+    return true;
+  }
+  set<string> ids;
+  sliceNode(0, begin, end, idbase, ids, tasks, toplevel);
+  return false;
+}
+
+void PhrasedIterationSpace::sliceNode(size_t nodenum, size_t begin, size_t end, const string& idbase, set<string>& ids, vector<PhrasedRepeatedTask>& tasks, vector<string>& runs) const
+{
+  const Node& node = m_nodes[nodenum];
+  if (begin >= end) {
+    return;
+  }
+  if (begin == 0 && end == node.size) {
+    runs.push_back(node.task);
+    return;
+  }
+  assert(node.repeated != NULL);
+  size_t per = node.perIteration;
+  size_t current = begin;
+  while (current < end) {
+    size_t iteration = current / per;
+    size_t start = current - iteration*per;
+    if (start == 0 && end - current >= per) {
+      size_t numfull = (end - current) / per;
+      string id = getNewId(idbase, ids);
+      tasks.push_back(node.repeated->getSlice(id, iteration, iteration + numfull));
+      runs.push_back(id);
+      current += numfull * per;
+    }
+    else {
+      size_t stop = min(per, end - iteration*per);
+      vector<string> subruns;
+      for (size_t s=0; s<node.subtasks.size(); s++) {
+        size_t subsize = m_nodes[node.subtasks[s]].size;
+        size_t substart = node.offsets[s];
+        size_t subend = substart + subsize;
+        if (subend <= start || substart >= stop) {
+          continue;
+        }
+        sliceNode(node.subtasks[s], max(start, substart) - substart, min(stop, subend) - substart, idbase, ids, tasks, subruns);
+      }
+      string id = getNewId(idbase, ids);
+      PhrasedRepeatedTask slice = node.repeated->getSlice(id, iteration, iteration+1);
+      slice.setTasks(subruns);
+      tasks.push_back(slice);
+      runs.push_back(id);
+      current = iteration*per + stop;
+    }
+  }
+}
+
+string PhrasedIterationSpace::getNewId(const string& idbase, set<string>& ids) const
+{
+  string id = idbase;
+  long num = 0;
+  while (ids.find(id) != ids.end() || g_registry.getTask(id) != NULL || g_registry.getModel(id) != NULL || g_registry.getSimulation(id) != NULL) {
+    num++;
+    stringstream newid;
+    newid << idbase << "_" << num;
+    id = newid.str();
+  }
+  ids.insert(id);
+  return id;
+}
+
+//The phraSED-ML for the repeated tasks that perform one chunk of the space.  The tasks refer to the original subtasks, models, and simulations, so this is a fragment to be used alongside the original document.
+string PhrasedIterationSpace::getChunkPhraSEDML(size_t chunk, size_t numChunks) const
+{
+  vector<PhrasedRepeatedTask> tasks;
+  vector<string> toplevel;
+  stringstream idbase;
+  idbase << m_task << "_chunk" << chunk;
+  if (chunk >= numChunks || getChunkTasks(getChunkBegin(chunk, numChunks), getChunkEnd(chunk, numChunks), idbase.str(), tasks, toplevel)) {
+    return "";
+  }
+  stringstream ret;
+  ret << "# Chunk " << chunk << " of " << numChunks << " of '" << m_task << "': iterations " << getChunkBegin(chunk, numChunks) << " to " << getChunkEnd(chunk, numChunks) << ", run by " << getStringFrom(&toplevel, ", ") << endl;
+  for (size_t t=0; t<tasks.size(); t++) {
+    ret << tasks[t].getPhraSEDML();
+  }
+  return ret.str();
+}
+
+PHRASEDML_CPP_NAMESPACE_END
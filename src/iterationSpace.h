@@ -0,0 +1,78 @@
+#ifndef PHRASEDITERATIONSPACE_H
+#define PHRASEDITERATIONSPACE_H
+
+#include <string>
+#include <vector>
+#include <set>
+
+#include "repeatedTask.h"
+#include "phrasedml-namespace.h"
+
+PHRASEDML_CPP_NAMESPACE_BEGIN
+
+//Where chunk 'chunk' of 'numChunks' contiguous, nearly-equal chunks of [0, size) starts.  The first (size % numChunks) chunks are one longer than the rest.
+size_t getChunkStart(size_t size, size_t chunk, size_t numChunks);
+
+//One level of a position in a nested repeated task:  which iteration of the repeated task is running, and which of its subtasks.
+struct IterationIndex
+{
+  std::string repeatedTask;
+  size_t iteration;
+  size_t subtask;
+};
+
+//A single run of a (non-repeated) task, and where it falls in each enclosing repeated task.
+struct IterationPoint
+{
+  std::vector<IterationIndex> indices;
+  std::string task;
+};
+
+//The full set of task runs a (possibly nested) repeated task performs, in the order it performs them.  Nothing is expanded:  any run can be looked up from its flat index directly, and the space can be split into contiguous chunks, each of which can be written out as its own set of repeated tasks.
+//
+//The space refers to the tasks in g_registry, and is only valid until the registry changes.
+class PhrasedIterationSpace
+{
+private:
+  PhrasedIterationSpace(); //undefined
+
+  struct Node
+  {
+    std::string task;
+    const PhrasedRepeatedTask* repeated;
+    size_t numIterations;
+    size_t perIteration;
+    size_t size;
+    std::vector<size_t> subtasks;
+    std::vector<size_t> offsets;
+  };
+
+  std::string       m_task;
+  std::vector<Node> m_nodes;
+
+public:
+  PhrasedIterationSpace(const std::string& task);
+  ~PhrasedIterationSpace();
+
+  bool build();
+
+  std::string getTask() const;
+  size_t getSize() const;
+
+  bool getPoint(size_t flat, IterationPoint& point) const;
+  void getRangeValues(const IterationPoint& point, std::vector<std::pair<std::string, double> >& values) const;
+
+  size_t getChunkBegin(size_t chunk, size_t numChunks) const;
+  size_t getChunkEnd(size_t chunk, size_t numChunks) const;
+  bool getChunkTasks(size_t begin, size_t end, const std::string& idbase, std::vector<PhrasedRepeatedTask>& tasks, std::vector<std::string>& toplevel) const;
+  std::string getChunkPhraSEDML(size_t chunk, size_t numChunks) const;
+
+private:
+  bool addNode(const std::string& task, std::set<std::string>& parents, size_t& nodenum);
+  void sliceNode(size_t nodenum, size_t begin, size_t end, const std::string& idbase, std::set<std::string>& ids, std::vector<PhrasedRepeatedTask>& tasks, std::vector<std::string>& runs) const;
+  std::string getNewId(const std::string& idbase, std::set<std::string>& ids) const;
+};
+
+PHRASEDML_CPP_NAMESPACE_END
+
+#endif //PHRASEDITERATIONSPACE_H
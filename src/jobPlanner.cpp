@@ -0,0 +1,239 @@
+#include <algorithm>
+#include <locale>
+#include <sstream>
+
+#include "jobPlanner.h"
+#include "iterationSpace.h"
+#include "model.h"
+#include "output.h"
+#include "registry.h"
+#include "repeatedTask.h"
+#include "simulation.h"
+#include "stringx.h"
+#include "task.h"
+
+using namespace std;
+
+PHRASEDML_CPP_NAMESPACE_BEGIN
+
+PhrasedJobPlanner::PhrasedJobPlanner()
+  : m_jobs()
+  , m_numRuns(0)
+  , m_hasher()
+  , m_changeColumns()
+  , m_jobsByHash()
+{
+}
+
+PhrasedJobPlanner::~PhrasedJobPlanner()
+{
+}
+
+//Plans every run of every task in g_registry, failing if there are more than 'maxRuns' of them in total.  Returns true on error.
+bool PhrasedJobPlanner::plan(size_t maxRuns)
+{
+  m_jobs.clear();
+  m_numRuns = 0;
+  m_hasher.clear();
+  m_changeColumns.clear();
+  m_jobsByHash.clear();
+  for (size_t t=0; t<g_registry.getNumTasks(); t++) {
+    if (addTaskRuns(g_registry.getTask(t)->getId(), maxRuns)) {
+      return true;
+    }
+  }
+  for (size_t o=0; o<g_registry.getNumOutputs(); o++) {
+    const PhrasedOutput* output = g_registry.getOutput(o);
+    set<string> references = output->getTaskReferences();
+    for (size_t j=0; j<m_jobs.size(); j++) {
+      for (set<string>::const_iterator task = m_jobs[j].tasks.begin(); task != m_jobs[j].tasks.end(); task++) {
+        if (references.find(*task) != references.end()) {
+          m_jobs[j].outputs.insert(output->getId());
+          break;
+        }
+      }
+    }
+  }
+  return false;
+}
+
+const vector<PlannedJob>& PhrasedJobPlanner::getJobs() const
+{
+  return m_jobs;
+}
+
+//The number of runs the experiment performs, before identical ones are collapsed.
+size_t PhrasedJobPlanner::getNumRuns() const
+{
+  return m_numRuns;
+}
+
+size_t PhrasedJobPlanner::getNumJobs() const
+{
+  return m_jobs.size();
+}
+
+//Each task is run by itself, in SED-ML, even if it is also a subtask of a repeated task.
+bool PhrasedJobPlanner::addTaskRuns(const string& taskid, size_t maxRuns)
+{
+  PhrasedIterationSpace space(taskid);
+  if (space.build()) {
+    return true;
+  }
+  size_t size = space.getSize();
+  if (size > maxRuns || m_numRuns > maxRuns - size) {
+    stringstream err;
+    err << "Unable to plan the jobs for this experiment:  it performs more than the maximum of " << maxRuns << " simulation runs.";
+    g_registry.setError(err.str(), 0);
+    return true;
+  }
+  IterationPoint previous;
+  size_t previousjob = 0;
+  for (size_t flat=0; flat<size; flat++) {
+    IterationPoint point;
+    if (space.getPoint(flat, point)) {
+      return true;
+    }
+    const PhrasedTask* task = g_registry.getTask(point.task);
+    PlannedJob job;
+    job.task = point.task;
+    job.model = task->getModelReference();
+    job.simulation = task->getSimulationReference();
+    unsigned long long modelhash, simhash;
+    if (m_hasher.getModelHash(job.model, modelhash) || m_hasher.getSimulationHash(job.simulation, simhash)) {
+      g_registry.addErrorPrefix("Unable to plan the jobs for task '" + taskid + "':  ");
+      return true;
+    }
+    stringstream key;
+    stringstream label;
+    key << "model " << HashToString(modelhash) << "\nsimulation " << HashToString(simhash);
+    for (size_t i=0; i<point.indices.size(); i++) {
+      const PhrasedRepeatedTask* rt = static_cast<const PhrasedRepeatedTask*>(g_registry.getTask(point.indices[i].repeatedTask));
+      string iterationkey;
+      if (getIterationKey(rt, point.indices[i].iteration, iterationkey)) {
+        g_registry.addErrorPrefix("Unable to plan the jobs for task '" + taskid + "':  ");
+        return true;
+      }
+      key << "\nset " << iterationkey;
+      label << point.indices[i].repeatedTask << "[" << point.indices[i].iteration << "].";
+    }
+    label << point.task;
+    if (flat > 0 && continuesFrom(previous, point)) {
+      key << "\ncontinues " << HashToString(m_jobs[previousjob].hash);
+    }
+    const PhrasedSimulation* sim = g_registry.getSimulation(job.simulation);
+    if (sim->getType() == simtype_uniform_stochastic || sim->kisaoIdIsStochastic(sim->getKisao())) {
+      key << "\nsample " << taskid << " " << flat;
+    }
+    job.key = key.str();
+    job.hash = getFNV1aHash(job.key);
+    previousjob = addJob(job);
+    m_jobs[previousjob].runs.push_back(label.str());
+    m_jobs[previousjob].tasks.insert(taskid);
+    m_numRuns++;
+    previous = point;
+  }
+  return false;
+}
+
+//Returns the index of the job with the same key, adding it if it is new.
+size_t PhrasedJobPlanner::addJob(const PlannedJob& job)
+{
+  vector<size_t>& matches = m_jobsByHash[job.hash];
+  for (size_t m=0; m<matches.size(); m++) {
+    if (m_jobs[matches[m]].key == job.key) {
+      return matches[m];
+    }
+  }
+  matches.push_back(m_jobs.size());
+  m_jobs.push_back(job);
+  return m_jobs.size()-1;
+}
+
+//The values the repeated task sets on its model for this iteration.  Values that can be calculated ahead of time are written out; those that depend on the model's state are given as the content hash of their change, along with the values of the task's ranges.  Models are given by their content hashes, not their IDs.  Returns true on error.
+bool PhrasedJobPlanner::getIterationKey(const PhrasedRepeatedTask* rt, size_t iteration, string& ret)
+{
+  map<string, vector<ChangeColumn> >::iterator found = m_changeColumns.find(rt->getId());
+  if (found == m_changeColumns.end()) {
+    vector<ChangeColumn> columns;
+    const vector<ModelChange>& changes = rt->getChanges();
+    for (size_t c=0; c<changes.size(); c++) {
+      vector<string> variable = changes[c].getVariable();
+      if (variable.empty() || variable[0] == "local") {
+        //Only used to calculate other changes.
+        continue;
+      }
+      if (variable.size() > 1 && variable[0] == changes[c].getModel()) {
+        unsigned long long modelhash;
+        if (m_hasher.getModelHash(variable[0], modelhash)) {
+          return true;
+        }
+        variable[0] = "#" + HashToString(modelhash);
+      }
+      ChangeColumn column;
+      column.target = getStringFrom(&variable, ".");
+      //A change whose values can't be calculated ahead of time is keyed by its content hash instead.  That's not an error, so the error getChangeValues set is never reported.
+      column.computed = !rt->getChangeValues(c, column.values);
+      if (!column.computed) {
+        unsigned long long changehash;
+        if (m_hasher.getChangeHash(changes[c], changehash)) {
+          return true;
+        }
+        column.formula = "#" + HashToString(changehash);
+      }
+      columns.push_back(column);
+    }
+    found = m_changeColumns.insert(make_pair(rt->getId(), columns)).first;
+  }
+
+  stringstream key;
+  key.imbue(locale::classic());
+  key.precision(17);
+  bool uncomputed = false;
+  const vector<ChangeColumn>& columns = found->second;
+  for (size_t c=0; c<columns.size(); c++) {
+    if (c > 0) {
+      key << ", ";
+    }
+    if (columns[c].computed && iteration < columns[c].values.size()) {
+      key << columns[c].target << "=" << columns[c].values[iteration];
+    }
+    else {
+      key << columns[c].formula;
+      uncomputed = true;
+    }
+  }
+  if (uncomputed) {
+    vector<pair<string, double> > ranges;
+    rt->getRangeValues(iteration, ranges);
+    key << " where";
+    for (size_t r=0; r<ranges.size(); r++) {
+      key << " " << ranges[r].second;
+    }
+  }
+  ret = key.str();
+  return false;
+}
+
+//Whether the current run starts from the state the previous run (of the same task) left its model in:  true unless a repeated task reset the model between them, or they use different models.
+bool PhrasedJobPlanner::continuesFrom(const IterationPoint& previous, const IterationPoint& current) const
+{
+  const PhrasedTask* prevtask = g_registry.getTask(previous.task);
+  const PhrasedTask* curtask = g_registry.getTask(current.task);
+  if (prevtask == NULL || curtask == NULL || prevtask->getModelReference() != curtask->getModelReference()) {
+    return false;
+  }
+  size_t levels = min(previous.indices.size(), current.indices.size());
+  for (size_t l=0; l<levels; l++) {
+    if (previous.indices[l].iteration != current.indices[l].iteration) {
+      const PhrasedRepeatedTask* rt = static_cast<const PhrasedRepeatedTask*>(g_registry.getTask(current.indices[l].repeatedTask));
+      return !rt->getResetModel();
+    }
+    if (previous.indices[l].subtask != current.indices[l].subtask) {
+      break;
+    }
+  }
+  return true;
+}
+
+PHRASEDML_CPP_NAMESPACE_END
@@ -0,0 +1,69 @@
+#ifndef PHRASEDJOBPLANNER_H
+#define PHRASEDJOBPLANNER_H
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "contentHash.h"
+#include "phrasedml-namespace.h"
+
+PHRASEDML_CPP_NAMESPACE_BEGIN
+
+class PhrasedRepeatedTask;
+struct IterationPoint;
+
+//One concrete simulation run:  the content hashes of its model and simulation (see PhrasedContentHasher), and the values set on the model by every enclosing repeated task, described canonically in 'key' (with no IDs) and hashed.  'runs' are every run in the experiment this job stands for, and 'tasks' and 'outputs' are everything that uses their results.
+struct PlannedJob
+{
+  unsigned long long hash;
+  std::string key;
+  std::string task;
+  std::string model;
+  std::string simulation;
+  std::vector<std::string> runs;
+  std::set<std::string> tasks;
+  std::set<std::string> outputs;
+};
+
+//Expands every task in g_registry into the individual simulation runs it performs, and collapses identical runs into one job, no matter which tasks they came from or what they were called.
+//
+//Runs are only identical if they start from the same state:  a run that continues from the previous run (because its repeated task does not reset the model) includes that run's hash in its key.  Runs of stochastic simulations are never collapsed, since each is a separate sample.
+class PhrasedJobPlanner
+{
+private:
+  struct ChangeColumn
+  {
+    std::string target;
+    std::string formula;
+    std::vector<double> values;
+    bool computed;
+  };
+
+  std::vector<PlannedJob> m_jobs;
+  size_t m_numRuns;
+  PhrasedContentHasher m_hasher;
+  std::map<std::string, std::vector<ChangeColumn> > m_changeColumns;
+  std::map<unsigned long long, std::vector<size_t> > m_jobsByHash;
+
+public:
+  PhrasedJobPlanner();
+  ~PhrasedJobPlanner();
+
+  bool plan(size_t maxRuns);
+
+  const std::vector<PlannedJob>& getJobs() const;
+  size_t getNumRuns() const;
+  size_t getNumJobs() const;
+
+private:
+  bool addTaskRuns(const std::string& taskid, size_t maxRuns);
+  bool getIterationKey(const PhrasedRepeatedTask* rt, size_t iteration, std::string& key);
+  bool continuesFrom(const IterationPoint& previous, const IterationPoint& current) const;
+  size_t addJob(const PlannedJob& job);
+};
+
+PHRASEDML_CPP_NAMESPACE_END
+
+#endif //PHRASEDJOBPLANNER_H
@@ -8,6 +8,7 @@
 #include <string>
 
 #include "registry.h"
+#include "compressedInput.h"
 #include "model.h"
 #include "modelChange.h"
 #include "sbml/SBMLTypes.h"
@@ -27,7 +28,9 @@ PhrasedModel::PhrasedModel(string id, string source, bool isFile)
   , m_source(source)
   , m_changes()
   , m_isFile(isFile)
-  , m_sbml(3,1)
+  , m_index(new SBMLIndex())
+  , m_document()
+  , m_pendingSBML()
 {
   processSource();
 }
@@ -36,8 +39,11 @@ PhrasedModel::PhrasedModel(string id, string source, vector<ModelChange> changes
   : Variable(id)
   , m_type(lang_XML)
   , m_source(source)
-  , m_changes(changes)
+  , m_changes(move(changes))
   , m_isFile(isFile)
+  , m_index(new SBMLIndex())
+  , m_document()
+  , m_pendingSBML()
 {
   processSource();
   for (size_t mc=0; mc<m_changes.size(); mc++) {
@@ -51,6 +57,9 @@ PhrasedModel::PhrasedModel(SedModel* sedmodel, SedDocument* seddoc)
   , m_source(sedmodel->getSource())
   , m_changes()
   , m_isFile(true)
+  , m_index(new SBMLIndex())
+  , m_document()
+  , m_pendingSBML()
 {
   m_type = getLanguageFromURI(sedmodel->getLanguage());
   SedModel* referenced = seddoc->getModel(m_source);
@@ -59,21 +68,31 @@ PhrasedModel::PhrasedModel(SedModel* sedmodel, SedDocument* seddoc)
   }
   else {
     processSource();
+    loadSBML();
   }
 
-  ostringstream stream;
-  SBMLWriter sw;
   string sbml_source;
-  if (getSBMLDocument()) {
-    sw.writeSBML(getSBMLDocument(), stream);
-    sbml_source = stream.str();
+  if (getSBMLIndex()) {
+#ifdef PHRASEDML_ENABLE_XPATH_EVAL
+    //Evaluating the change targets needs the SBML itself.  Without the model, they are read from the XPath alone.
+    const PhrasedModel* root = getRootModel();
+    if (root->m_document) {
+      char* sbml = writeSBMLToString(root->m_document.get());
+      sbml_source = sbml;
+      free(sbml);
+    }
+    else if (!g_registry.getStructural()) {
+      string error;
+      readDecompressedFile(g_registry.getWorkingFilename(root->m_source), sbml_source, error);
+    }
+#endif
 
     for (unsigned int ch=0; ch<sedmodel->getNumChanges(); ch++) {
       SedChange* sc = sedmodel->getChange(ch);
       if (sc->getTarget().find("@id=''") != string::npos)
         continue;
       try {
-        ModelChange mc(sc, seddoc, m_id, sbml_source, getSBMLDocument()->getNamespaces()->getURI(0));
+        ModelChange mc(sc, seddoc, m_id, sbml_source, getSBMLIndex()->getNamespaces().getURI(0));
         m_changes.push_back(mc);
         if (sc->getTypeCode() == SEDML_CHANGE_COMPUTECHANGE) {
           SedComputeChange* scc = static_cast<SedComputeChange*>(sc);
@@ -106,27 +125,72 @@ bool PhrasedModel::getIsFile() const
   return m_isFile;
 }
 
+//A model based on another is in the same language as the model at the end of the chain.
 language PhrasedModel::getType() const
 {
-  return m_type;
+  string error;
+  const PhrasedModel* root = findRootModel(error);
+  if (root == NULL) {
+    return m_type;
+  }
+  return root->m_type;
 }
 
-SBMLDocument* PhrasedModel::getSBMLDocument()
+//The model at the end of the chain of models this one is based on, which is this one if it is based on a file.  Returns NULL if some model in the chain does not exist, or if the chain goes round in a circle, with the reason in 'error'.
+const PhrasedModel* PhrasedModel::findRootModel(string& error) const
 {
-  if (!m_isFile && m_sbml.getModel()==NULL) {
-    PhrasedModel* referencedModel = g_registry.getModel(m_source);
-    if (referencedModel==NULL) {
-      g_registry.setError("The model '" + m_id + "' references another SED-ML model '" + m_source + "', which does not exist.", 0);
-      return NULL;
+  const PhrasedModel* model = this;
+  //Every model but this one is in the registry, so a longer chain must be a circle.
+  for (size_t depth=0; depth<=g_registry.getNumModels(); depth++) {
+    if (model->m_isFile) {
+      return model;
     }
-    m_type = referencedModel->getType();
-    SBMLDocument* doc = referencedModel->getSBMLDocument();
-    if (doc==NULL) {
+    const PhrasedModel* base = g_registry.getModel(model->m_source);
+    if (base == NULL) {
+      error = "The model '" + model->m_id + "' references another SED-ML model '" + model->m_source + "', which does not exist.";
       return NULL;
     }
-    m_sbml = *doc;
+    model = base;
+  }
+  error = "The model '" + m_id + "' is based on itself, through the models it is based on.";
+  return NULL;
+}
+
+//As findRootModel, but setting any error.
+const PhrasedModel* PhrasedModel::getRootModel() const
+{
+  string error;
+  const PhrasedModel* root = findRootModel(error);
+  if (root == NULL) {
+    g_registry.setError(error, 0);
+  }
+  return root;
+}
+
+//A model based on another has no SBML of its own, and is only an overlay of its changes on that model:  its SBML is found through the chain of models, so that however long the chain, the SBML is only held once.  Returns NULL, with an error set, if the chain doesn't end in a model of a file.
+const SBMLIndex* PhrasedModel::getSBMLIndex() const
+{
+  const PhrasedModel* root = getRootModel();
+  if (root == NULL) {
+    return NULL;
+  }
+  return root->m_index.get();
+}
+
+//Waits for the model's SBML file, if it is still being indexed.  getSBMLIndex only works after this, for this model and any based on it (which finalize ensures).
+void PhrasedModel::loadSBML()
+{
+  if (!m_pendingSBML.valid()) {
+    return;
+  }
+  shared_ptr<const SBMLIndex> index = m_pendingSBML.get();
+  m_pendingSBML = PendingSBMLIndex();
+  if (index) {
+    setSBMLIndex(index);
+  }
+  else {
+    g_registry.addWarning("The SBML model '" + m_source + "' could not be decompressed, and may be truncated or corrupt.");
   }
-  return &m_sbml;
 }
 
 string PhrasedModel::getPhraSEDML() const
@@ -156,21 +220,21 @@ void PhrasedModel::addModelToSEDML(SedDocument* sedml) const
 {
   SedModel* model = sedml->createModel();
   libsbml::XMLNamespaces* sednames = sedml->getNamespaces();
-  libsbml::XMLNamespaces* libsbmlnames = m_sbml.getNamespaces();
-  for (int i = 0; i < libsbmlnames->getNumNamespaces(); i++)
+  const libsbml::XMLNamespaces& libsbmlnames = getSBMLIndex()->getNamespaces();
+  for (int i = 0; i < libsbmlnames.getNumNamespaces(); i++)
   {
-      string prefix = libsbmlnames->getPrefix(i);
+      string prefix = libsbmlnames.getPrefix(i);
       if (prefix.empty())
       {
           prefix = "sbml";
       }
-      sednames->add(libsbmlnames->getURI(i), prefix);
+      sednames->add(libsbmlnames.getURI(i), prefix);
   }
 
   model->setId(m_id);
   model->setName(m_name);
   model->setSource(m_source);
-  model->setLanguage(getURIFromLanguage(m_type));
+  model->setLanguage(getURIFromLanguage(getType()));
   for (size_t cl=0; cl<m_changes.size(); cl++) {
     m_changes[cl].addModelChangeToSEDMLModel(model);
   }
@@ -192,7 +256,7 @@ void PhrasedModel::addLocalVariablesToComputeChange(SedComputeChange* scc, SedMo
   for (set<string>::iterator v=vars.begin(); v != vars.end(); v++) {
     vector<string> idvec;
     idvec.push_back(*v);
-    string xpath = getElementXPathFromId(&idvec, getSBMLDocument());
+    string xpath = getElementXPathFromId(&idvec, getSBMLIndex());
     if (xpath.empty()) {
       //We need a local variable for it.  Check to see if one exists:
       SedParameter* sp = scc->createParameter();
@@ -218,64 +282,83 @@ void PhrasedModel::addLocalVariablesToComputeChange(SedComputeChange* scc, SedMo
 
 void PhrasedModel::processSource()
 {
+  if (m_isFile && g_registry.getStructural()) {
+    //The model is never loaded, but the only models phraSED-ML knows are SBML.
+    m_type = lang_SBML;
+    return;
+  }
   if (m_isFile) {
-    SBMLDocument* doc = g_registry.getSavedSBML(m_source);
-    if (doc == NULL) {
-      string actualsource = g_registry.getWorkingFilename(m_source);
-      if (actualsource.empty()) {
-        //The file cannot be found, so we'll have to punt
-        return;
-      }
-      doc = readSBMLFromFile(actualsource.c_str());
+    shared_ptr<const SBMLIndex> saved = g_registry.getSavedSBMLIndex(m_source);
+    if (saved) {
+      m_document = g_registry.getSavedSBML(m_source);
+      setSBMLIndex(saved);
+      return;
+    }
+    string actualsource = g_registry.getWorkingFilename(m_source);
+    if (actualsource.empty()) {
+      //The file cannot be found, so we'll have to punt
+      return;
     }
-    m_sbml = *doc;
-    m_type = lang_SBML; //In case the levels/versions below don't work.
-    switch(m_sbml.getLevel()) {
+    compression_type compression = getFileCompression(actualsource);
+    if (!isCompressionSupported(compression)) {
+      g_registry.addWarning("The SBML model '" + m_source + "' is compressed with " + getCompressionString(compression) + ", which this build of phraSED-ML cannot read.  Decompress it first, or rebuild phraSED-ML with WITH_ZSTD turned on.");
+      return;
+    }
+    //Parsing carries on while the file is indexed; loadSBML waits for it.
+    m_pendingSBML = g_registry.indexSBMLFile(actualsource);
+  }
+  //If the referenced model is another SEDML construct, we'll have to process it later.
+}
+
+void PhrasedModel::setSBMLIndex(shared_ptr<const SBMLIndex> index)
+{
+  m_index = index;
+  m_type = lang_SBML; //In case the levels/versions below don't work.
+  switch(m_index->getLevel()) {
+  case 1:
+    switch(m_index->getVersion()) {
     case 1:
-      switch(m_sbml.getVersion()) {
-      case 1:
-        m_type = lang_SBMLl1v1;
-        break;
-      case 2:
-        m_type = lang_SBMLl1v2;
-        break;
-      }
+      m_type = lang_SBMLl1v1;
       break;
     case 2:
-      switch(m_sbml.getVersion()) {
-      case 1:
-        m_type = lang_SBMLl2v1;
-        break;
-      case 2:
-        m_type = lang_SBMLl2v2;
-        break;
-      case 3:
-        m_type = lang_SBMLl2v3;
-        break;
-      case 4:
-        m_type = lang_SBMLl2v4;
-        break;
-      case 5:
-        m_type = lang_SBMLl2v5;
-        break;
-      }
+      m_type = lang_SBMLl1v2;
+      break;
+    }
+    break;
+  case 2:
+    switch(m_index->getVersion()) {
+    case 1:
+      m_type = lang_SBMLl2v1;
+      break;
+    case 2:
+      m_type = lang_SBMLl2v2;
       break;
     case 3:
-      switch(m_sbml.getVersion()) {
-      case 1:
-        m_type = lang_SBMLl3v1;
-        break;
-      case 2:
-        m_type = lang_SBMLl3v2;
-        break;
-      }
+      m_type = lang_SBMLl2v3;
+      break;
+    case 4:
+      m_type = lang_SBMLl2v4;
+      break;
+    case 5:
+      m_type = lang_SBMLl2v5;
       break;
     }
-    if (doc->getNumErrors(LIBSBML_SEV_ERROR) != 0 || doc->getNumErrors(LIBSBML_SEV_FATAL) != 0) {
-      g_registry.addWarning("The SBML model '" + m_source + "' has one or more validation errors, and may not be simulatable on all systems.");
+    break;
+  case 3:
+    switch(m_index->getVersion()) {
+    case 1:
+      m_type = lang_SBMLl3v1;
+      break;
+    case 2:
+      m_type = lang_SBMLl3v2;
+      break;
     }
+    break;
+  }
+  //For a file, this is only whether it is valid XML:  any other errors are warned of when it is read in full, by PhrasedModelMaterializer.
+  if (m_index->hasErrors()) {
+    g_registry.addWarning("The SBML model '" + m_source + "' has one or more validation errors, and may not be simulatable on all systems.");
   }
-  //If the referenced model is another SEDML construct, we'll have to process it later.
 }
 
 language PhrasedModel::getLanguageFromURI(string uri) const
@@ -378,14 +461,13 @@ bool PhrasedModel::finalize()
   }
 
   if (m_isFile) {
-    if (m_sbml.getModel() == NULL) {
+    if (!m_index->hasModel() && !g_registry.getStructural()) {
       g_registry.setError("Unable to find model '" + m_source + "', preventing phraSED-ML from creating accurate SED-ML constructs.  Try changing the working directory with 'setWorkingDirectory', or set the model directly with 'setReferencedSBML'.", 0);
       return true;
     }
   }
   else {
-    SBMLDocument* docref = getSBMLDocument();
-    if (docref==NULL) {
+    if (getSBMLIndex()==NULL) {
       //Error was already set.
       return true;
     }
@@ -7,6 +7,7 @@
 #include "variable.h"
 #include "sbml/SBMLDocument.h"
 #include "modelChange.h"
+#include "sbmlIndex.h"
 #include "phrasedml-namespace.h"
 
 
@@ -39,20 +40,30 @@ private:
   std::vector<ModelChange> m_changes;
 
   bool m_isFile;
-  libsbml::SBMLDocument m_sbml;
+  //What's known of the model's SBML, which is all that's needed to convert it, and the full document, only if it was given to phraSED-ML as one.  A model based on another model has neither, only its own changes.
+  std::shared_ptr<const SBMLIndex> m_index;
+  std::shared_ptr<const libsbml::SBMLDocument> m_document;
+  PendingSBMLIndex m_pendingSBML;
 
 public:
 
   PhrasedModel(std::string id, std::string source, bool isFile);
   PhrasedModel(std::string id, std::string source, std::vector<ModelChange> changes, bool isFile);
   PhrasedModel(libsedml::SedModel* sedmodel, libsedml::SedDocument* seddoc);
+  PhrasedModel(const PhrasedModel& orig) = default;
+  PhrasedModel(PhrasedModel&& orig) = default;
+  PhrasedModel& operator=(const PhrasedModel& rhs) = default;
+  PhrasedModel& operator=(PhrasedModel&& rhs) = default;
   ~PhrasedModel();
 
   void setIsFile(bool isfile);
   bool getIsFile() const;
   language getType() const;
-  const libsbml::SBMLDocument* getSBMLDocument() const {return &m_sbml;} ;
-  libsbml::SBMLDocument* getSBMLDocument();
+  const SBMLIndex* getSBMLIndex() const;
+  const libsbml::SBMLDocument* getSBMLDocument() const {return m_document.get();};
+  std::shared_ptr<const libsbml::SBMLDocument> getSharedSBMLDocument() const {return m_document;};
+  const PhrasedModel* getRootModel() const;
+  void loadSBML();
 
   std::string getPhraSEDML() const;
   void addModelToSEDML(libsedml::SedDocument* sedml) const;
@@ -60,12 +71,15 @@ public:
   //void langTypeToURI(language type) const;
 
   std::string getSource() const {return m_source;};
+  const std::vector<ModelChange>& getChanges() const {return m_changes;};
   void setSource(std::string source) {m_source = source;};
 
   virtual bool changeListIsInappropriate(std::stringstream& err);
   virtual bool finalize();
 private:
   void processSource();
+  const PhrasedModel* findRootModel(std::string& error) const;
+  void setSBMLIndex(std::shared_ptr<const SBMLIndex> index);
   language getLanguageFromURI(std::string uri) const;
   std::string getURIFromLanguage(language lang) const;
   void addLocalVariablesToComputeChange(libsedml::SedComputeChange* scc, libsedml::SedModel* model) const;
@@ -1,5 +1,7 @@
 #include <algorithm>
 #include <cassert>
+#include <cmath>
+#include <limits>
 #include <functional>
 #include <iostream>
 #include <sstream>
@@ -49,7 +51,7 @@ ModelChange::ModelChange(vector<const string*>* name, std::vector<std::string>*
   , m_variable()
   , m_values()
   , m_formula()
-  , m_astnode(NULL)
+  , m_astnode()
   , m_model()
 {
   if (name==NULL) return;
@@ -57,16 +59,15 @@ ModelChange::ModelChange(vector<const string*>* name, std::vector<std::string>*
     m_variable.push_back(*(*name)[n]);
   }
   m_formula = getStringFrom(formula, " ");
-  m_astnode = g_registry.parseFormula(m_formula);
+  m_astnode.reset(g_registry.parseFormula(m_formula));
   if (m_astnode->isNumber()) {
     m_values.push_back(m_astnode->getValue());
-    delete m_astnode;
-    m_astnode = NULL;
+    m_astnode.reset();
     m_formula.clear();
     m_type = ctype_val_assignment;
     return;
   }
-  char* rt_form = SBML_formulaToL3String(m_astnode);
+  char* rt_form = SBML_formulaToL3String(m_astnode.get());
   m_formula = rt_form;
   free(rt_form);
 }
@@ -76,7 +77,7 @@ ModelChange::ModelChange(vector<const string*>* name, std::string source, std::v
   , m_variable()
   , m_values()
   , m_formula()
-  , m_astnode(NULL)
+  , m_astnode()
   , m_model()
   , m_source_range(source)
 {
@@ -85,16 +86,15 @@ ModelChange::ModelChange(vector<const string*>* name, std::string source, std::v
     m_variable.push_back(*(*name)[n]);
   }
   m_formula = getStringFrom(formula, " ");
-  m_astnode = g_registry.parseFormula(m_formula);
+  m_astnode.reset(g_registry.parseFormula(m_formula));
   if (m_astnode->isNumber()) {
     m_values.push_back(m_astnode->getValue());
-    delete m_astnode;
-    m_astnode = NULL;
+    m_astnode.reset();
     m_formula.clear();
     m_type = ctype_val_assignment;
     return;
   }
-  char* rt_form = SBML_formulaToL3String(m_astnode);
+  char* rt_form = SBML_formulaToL3String(m_astnode.get());
   m_formula = rt_form;
   free(rt_form);
 }
@@ -104,7 +104,7 @@ ModelChange::ModelChange(change_type type, vector<const string*>* name, const ve
   , m_variable()
   , m_values(*values)
   , m_formula()
-  , m_astnode(NULL)
+  , m_astnode()
   , m_model()
 {
   if (name==NULL) return;
@@ -118,13 +118,19 @@ ModelChange::ModelChange(SedChange* sedchange, SedDocument* seddoc, string model
   , m_variable()
   , m_values()
   , m_formula()
-  , m_astnode(NULL)
+  , m_astnode()
   , m_model()
   , sbml_source_(sbml_source)
 {
   string target = sedchange->getTarget();
   #ifdef PHRASEDML_ENABLE_XPATH_EVAL
-  m_variable = getIdFromXPathExtended(target, sbml_source_, sbml_ns);
+  if (sbml_source_.empty()) {
+    //No model to evaluate the XPath against (as when converting structurally).
+    m_variable = getIdFromXPath(target);
+  }
+  else {
+    m_variable = getIdFromXPathExtended(target, sbml_source_, sbml_ns);
+  }
   #else
   m_variable = getIdFromXPath(target);
   #endif
@@ -159,7 +165,7 @@ ModelChange::ModelChange(SedRange* sr)
   , m_variable()
   , m_values()
   , m_formula()
-  , m_astnode(NULL)
+  , m_astnode()
   , m_model()
 {
   switch(sr->getTypeCode()) {
@@ -211,7 +217,7 @@ ModelChange::ModelChange(SedParameter* param)
   , m_variable()
   , m_values()
   , m_formula()
-  , m_astnode(NULL)
+  , m_astnode()
   , m_model()
 {
   m_variable.push_back("local");
@@ -224,7 +230,7 @@ ModelChange::ModelChange(SedSetValue* ssv, string source_range)
   , m_variable()
   , m_values()
   , m_formula()
-  , m_astnode(NULL)
+  , m_astnode()
   , m_model()
 {
   m_variable = getIdFromXPath(ssv->getTarget());
@@ -236,8 +242,7 @@ ModelChange::ModelChange(SedSetValue* ssv, string source_range)
   setASTNode(ssv->getMath());
   if (m_astnode != NULL && m_astnode->isNumber()) {
     m_values.push_back(m_astnode->getValue());
-    delete m_astnode;
-    m_astnode = NULL;
+    m_astnode.reset();
     m_formula.clear();
     m_type = ctype_val_assignment;
   }
@@ -251,13 +256,22 @@ ModelChange::ModelChange(const ModelChange& orig)
   , m_variable(orig.m_variable)
   , m_values(orig.m_values)
   , m_formula(orig.m_formula)
-  , m_astnode(orig.m_astnode)
+  , m_astnode(copyAST(orig.m_astnode.get()))
   , m_model(orig.m_model)
   , m_source_range(orig.m_source_range)
 {
-  if(m_astnode != NULL) {
-    m_astnode = m_astnode->deepCopy();
-  }
+}
+
+//Moving a change (as a vector of them does when it grows) takes its AST, instead of copying it.
+ModelChange::ModelChange(ModelChange&& orig) noexcept
+  : m_type(orig.m_type)
+  , m_variable(move(orig.m_variable))
+  , m_values(move(orig.m_values))
+  , m_formula(move(orig.m_formula))
+  , m_astnode(move(orig.m_astnode))
+  , m_model(move(orig.m_model))
+  , m_source_range(move(orig.m_source_range))
+{
 }
 
 ModelChange& ModelChange::operator=(const ModelChange& orig)
@@ -266,23 +280,26 @@ ModelChange& ModelChange::operator=(const ModelChange& orig)
   m_variable = orig.m_variable;
   m_values = orig.m_values;
   m_formula = orig.m_formula;
-  m_astnode = orig.m_astnode;
-  if (m_astnode != NULL) {
-    m_astnode = m_astnode->deepCopy();
-  }
+  m_astnode = copyAST(orig.m_astnode.get());
   m_model = orig.m_model;
   m_source_range = orig.m_source_range;
   return *this;
 }
 
+ModelChange& ModelChange::operator=(ModelChange&& orig) noexcept
+{
+  m_type = orig.m_type;
+  m_variable = move(orig.m_variable);
+  m_values = move(orig.m_values);
+  m_formula = move(orig.m_formula);
+  m_astnode = move(orig.m_astnode);
+  m_model = move(orig.m_model);
+  m_source_range = move(orig.m_source_range);
+  return *this;
+}
+
 ModelChange::~ModelChange()
 {
-  m_variable.clear();
-  m_values.clear();
-  m_formula.clear();
-  delete m_astnode;
-  m_astnode = NULL;
-  m_model.clear();
 }
 
 change_type ModelChange::getType() const
@@ -342,9 +359,21 @@ bool ModelChange::addModelChangeToSEDMLModel(SedModel* sedmodel) const
   }
   SedChangeAttribute* sca = NULL;
   PhrasedModel* mod = g_registry.getModel(m_model);
-  SBMLDocument* doc = mod->getSBMLDocument();
-  string attxpath = getValueXPathFromId(&m_variable, doc);
-  string elxpath = getElementXPathFromId(&m_variable, doc);
+  const SBMLIndex* index = mod->getSBMLIndex();
+  string elxpath = getElementXPathFromId(&m_variable, index);
+  if (g_registry.getStructural() && m_type == ctype_val_assignment) {
+    //Without the model, there's no telling which attribute holds the element's value, so the element itself is set, to a constant.
+    if (elxpath.empty()) {
+      return true;
+    }
+    SedComputeChange* scc = sedmodel->createComputeChange();
+    scc->setTarget(elxpath);
+    ASTNode value(AST_REAL);
+    value.setValue(m_values[0]);
+    scc->setMath(&value);
+    return false;
+  }
+  string attxpath = getValueXPathFromId(&m_variable, index);
   switch (m_type) {
   case ctype_val_assignment:
     if (attxpath.empty()) {
@@ -369,7 +398,7 @@ bool ModelChange::addModelChangeToSEDMLModel(SedModel* sedmodel) const
     {
       SedComputeChange* scc = sedmodel->createComputeChange();
       scc->setTarget(elxpath);
-      scc->setMath(m_astnode);
+      scc->setMath(m_astnode.get());
     }
     return false;
   default:
@@ -381,7 +410,7 @@ bool ModelChange::addModelChangeToSEDMLModel(SedModel* sedmodel) const
 bool ModelChange::addModelChangeToSEDMLRepeatedTask(SedRepeatedTask* sedrt, vector<string> tasks) const
 {
   SedSetValue* ssv = NULL;
-  set<SBMLDocument*> docs;
+  set<const SBMLIndex*> indexes;
   set<PhrasedModel*> models;
   for (size_t t=0; t<tasks.size(); t++) {
     set<PhrasedModel*> taskmodels = g_registry.getTask(tasks[t])->getModels();
@@ -389,28 +418,28 @@ bool ModelChange::addModelChangeToSEDMLRepeatedTask(SedRepeatedTask* sedrt, vect
   }
   for (set<PhrasedModel*>::iterator pm=models.begin(); pm!= models.end(); pm++) {
     if (*pm != NULL) {
-      docs.insert((*pm)->getSBMLDocument());
+      indexes.insert((*pm)->getSBMLIndex());
     }
   }
   //Figure out what we're referencing:
-  SBMLDocument* refdoc = NULL;
+  const SBMLIndex* refindex = NULL;
   string modref = "";
   string xpath = "";
   string type = "log";
   if (m_variable.size() > 1 && m_variable[0] != "local") {
     PhrasedModel* model = g_registry.getModel(m_variable[0]);
     if (model != NULL) {
-      refdoc = model->getSBMLDocument();
+      refindex = model->getSBMLIndex();
       vector<string> onlyelname = m_variable;
       onlyelname.erase(onlyelname.begin(), onlyelname.end()-onlyelname.size()+1);
-      xpath = getElementXPathFromId(&onlyelname, refdoc);
+      xpath = getElementXPathFromId(&onlyelname, refindex);
       modref = model->getId();
     }
   }
-  if (refdoc==NULL) {
+  if (refindex==NULL) {
     for (set<PhrasedModel*>::iterator rmod=models.begin(); rmod != models.end(); rmod++) {
       if (xpath.empty()) {
-        xpath = getElementXPathFromId(&m_variable, (*rmod)->getSBMLDocument());
+        xpath = getElementXPathFromId(&m_variable, (*rmod)->getSBMLIndex());
         modref = (*rmod)->getId();
       }
     }
@@ -494,7 +523,7 @@ bool ModelChange::addModelChangeToSEDMLRepeatedTask(SedRepeatedTask* sedrt, vect
         SedSetValue* ssv = sedrt->createTaskChange();
         ssv->setTarget(xpath);
         ssv->setModelReference(modref);
-        ssv->setMath(m_astnode);
+        ssv->setMath(m_astnode.get());
         ssv->setRange(m_source_range);
       }
     }
@@ -508,13 +537,13 @@ bool ModelChange::addModelChangeToSEDMLRepeatedTask(SedRepeatedTask* sedrt, vect
             sfr->setId(m_variable[1]);
         }
         sfr->setRange(m_source_range);
-        sfr->setMath(m_astnode);
+        sfr->setMath(m_astnode.get());
       }
       else {
         SedSetValue* ssv = sedrt->createTaskChange();
         ssv->setTarget(xpath);
         ssv->setModelReference(modref);
-        ssv->setMath(m_astnode);
+        ssv->setMath(m_astnode.get());
       }
     }
     break;
@@ -528,13 +557,13 @@ bool ModelChange::addModelChangeToSEDMLRepeatedTask(SedRepeatedTask* sedrt, vect
 bool ModelChange::setFormulaString(const std::string& formula)
 {
   m_formula = formula;
-  m_astnode = g_registry.parseFormula(formula);
+  m_astnode.reset(g_registry.parseFormula(formula));
   return (m_astnode == NULL);
 }
 
 bool ModelChange::setASTNode(const ASTNode* astnode)
 {
-  m_astnode = astnode->deepCopy();
+  m_astnode = copyAST(astnode);
   char* formula = SBML_formulaToL3String(astnode);
   m_formula = formula;
   free(formula);
@@ -567,7 +596,101 @@ vector<double> ModelChange::getValues() const
 
 const ASTNode* ModelChange::getASTNode() const
 {
-  return m_astnode;
+  return m_astnode.get();
+}
+
+//For functional ranges:  the range whose values the formula is calculated from.
+string ModelChange::getSourceRange() const
+{
+  return m_source_range;
+}
+
+//Uniform ranges run from the start to the end value inclusive, in 'numberOfPoints' steps (renamed 'numberOfSteps' in SED-ML L1V4), so have one more value than that, as uniform time courses do.  Functional ranges take their length from the range they are defined on, so have no values of their own.
+size_t ModelChange::getNumRangeValues() const
+{
+  switch (m_type) {
+  case ctype_loop_uniformLinear:
+  case ctype_loop_uniformLog:
+    if (m_values.size() < 3 || m_values[2] < 0) {
+      return 0;
+    }
+    return static_cast<size_t>(m_values[2]) + 1;
+  case ctype_loop_vector:
+    return m_values.size();
+  case ctype_val_assignment:
+  case ctype_formula_assignment:
+  case ctype_loop_functional:
+    break;
+  }
+  return 0;
+}
+
+double ModelChange::getRangeValue(size_t index) const
+{
+  switch (m_type) {
+  case ctype_loop_uniformLinear:
+  case ctype_loop_uniformLog:
+    {
+      size_t num = getNumRangeValues();
+      double start = m_values[0];
+      double end = m_values[1];
+      if (num <= 1) {
+        return start;
+      }
+      double frac = static_cast<double>(index) / static_cast<double>(num-1);
+      if (m_type == ctype_loop_uniformLinear) {
+        return start + frac*(end-start);
+      }
+      return start * pow(end/start, frac);
+    }
+  case ctype_loop_vector:
+    if (index < m_values.size()) {
+      return m_values[index];
+    }
+    break;
+  case ctype_val_assignment:
+  case ctype_formula_assignment:
+  case ctype_loop_functional:
+    break;
+  }
+  return numeric_limits<double>::quiet_NaN();
+}
+
+//Returns a copy of this change that only loops over the values [begin, end).  Uniform ranges are re-based so they still start and end on the values they would have had at those points; a slice with only one value becomes a vector.  Functional ranges and assignments are unchanged, since they are defined in terms of other ranges.
+ModelChange ModelChange::getRangeSlice(size_t begin, size_t end) const
+{
+  ModelChange ret(*this);
+  switch (m_type) {
+  case ctype_loop_uniformLinear:
+  case ctype_loop_uniformLog:
+    if (end - begin < 2) {
+      ret.m_type = ctype_loop_vector;
+      ret.m_values.clear();
+      for (size_t i=begin; i<end; i++) {
+        ret.m_values.push_back(getRangeValue(i));
+      }
+    }
+    else {
+      ret.m_values[0] = getRangeValue(begin);
+      ret.m_values[1] = getRangeValue(end-1);
+      ret.m_values[2] = static_cast<double>(end-begin-1);
+    }
+    break;
+  case ctype_loop_vector:
+    if (end > m_values.size()) {
+      end = m_values.size();
+    }
+    if (begin > end) {
+      begin = end;
+    }
+    ret.m_values.assign(m_values.begin() + begin, m_values.begin() + end);
+    break;
+  case ctype_val_assignment:
+  case ctype_formula_assignment:
+  case ctype_loop_functional:
+    break;
+  }
+  return ret;
 }
 
 //This version of finalize is called when the ModelChange is part of a Model.
@@ -578,8 +701,8 @@ bool ModelChange::finalize() const
     g_registry.setError("Unable to find the model '" + m_model + "' for a model change.  This is likely a programming error.", 0);
     return true;
   }
-  SBMLDocument* doc = mod->getSBMLDocument();
-  if (doc==NULL) {
+  const SBMLIndex* index = mod->getSBMLIndex();
+  if (index==NULL) {
     //Error already set.
     return true;
   }
@@ -589,7 +712,7 @@ bool ModelChange::finalize() const
   }
   if (m_variable[0] != "local") {
     //Make sure m_variable points to existing/creatable elements.
-    string xpath = getElementXPathFromId(&m_variable, doc);
+    string xpath = getElementXPathFromId(&m_variable, index);
     if (xpath.empty()) {
       //Error already set.
       return true;
@@ -628,13 +751,22 @@ bool ModelChange::finalize(set<PhrasedModel*> models)
       m_model = refmod->getId();
     }
   }
+  //Without the models, the variable can only be placed if there's just the one.
+  if (m_model.empty() && g_registry.getStructural()) {
+    if (models.size() != 1) {
+      g_registry.setError("Error in repeated task:  unable to tell which model the variable '" + getStringFrom(&m_variable) + "' belongs to without loading the models.  Name it as 'model.variable' instead.", 0);
+      return true;
+    }
+    m_variable.insert(m_variable.begin(), (*models.begin())->getId());
+    m_model = (*models.begin())->getId();
+  }
   //If we didn't find it, look for it in the passed-in models
   if (m_model.empty()) {
     //Add the model name to m_variable
     for (set<PhrasedModel*>::iterator model = models.begin(); model != models.end(); model++) {
-      const SBMLDocument* doc = (*model)->getSBMLDocument();
-      string xpath = getElementXPathFromId(&m_variable, doc);
-      if (!xpath.empty() && doc->getModel() != NULL) {
+      const SBMLIndex* index = (*model)->getSBMLIndex();
+      string xpath = getElementXPathFromId(&m_variable, index);
+      if (!xpath.empty() && index->hasModel()) {
         m_variable.insert(m_variable.begin(), (*model)->getId());
         m_model = (*model)->getId();
         break;
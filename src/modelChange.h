@@ -4,6 +4,7 @@
 #include <string>
 #include "phrasedml-namespace.h"
 #include "sbml/math/ASTNode.h"
+#include "sbmlx.h"
 #include "sedml/SedBase.h"
 #include "sedml/SedChange.h"
 #include "sedml/SedDocument.h"
@@ -36,10 +37,10 @@ private:
   std::vector<std::string> m_variable;
   std::vector<double> m_values;
   std::string m_formula;
-  libsbml::ASTNode* m_astnode;
+  OwnedAST m_astnode;
 
   std::string m_model;
-  std::string sbml_source_;
+  std::string sbml_source_; //The SBML the change's XPath was read against:  only needed while reading it, so never copied or moved.
   // for functional ranges
   std::string m_source_range;
 
@@ -54,7 +55,9 @@ public:
   ModelChange(libsedml::SedParameter* parameter);
   ModelChange(libsedml::SedSetValue* ssv, std::string source_range="");
   ModelChange(const ModelChange& orig);
+  ModelChange(ModelChange&& orig) noexcept;
   ModelChange& operator=(const ModelChange& rhs);
+  ModelChange& operator=(ModelChange&& rhs) noexcept;
   ~ModelChange();
 
   change_type getType() const;
@@ -73,6 +76,12 @@ public:
   std::vector<std::string> getVariable() const;
   std::vector<double> getValues() const;
   const libsbml::ASTNode* getASTNode() const;
+  std::string getSourceRange() const;
+
+  //For looping changes:  the values the loop steps through, one per iteration.
+  size_t getNumRangeValues() const;
+  double getRangeValue(size_t index) const;
+  ModelChange getRangeSlice(size_t begin, size_t end) const;
 
   virtual bool finalize() const;
   virtual bool finalize(std::set<PhrasedModel*> models);
@@ -0,0 +1,343 @@
+#include <map>
+
+#include "modelMaterializer.h"
+#include "compiledFormula.h"
+#include "model.h"
+#include "modelChange.h"
+#include "registry.h"
+#include "sbmlLoader.h"
+#include "stringx.h"
+#include "sbml/SBMLTypes.h"
+
+using namespace std;
+using namespace libsbml;
+
+PHRASEDML_CPP_NAMESPACE_BEGIN
+
+typedef multimap<string, SBase*> SBaseIdMap;
+
+//Whether 'element' is inside an element with the id 'id'.
+static bool isInside(const string& id, const SBase* element)
+{
+  const SBase* parent = element->getParentSBMLObject();
+  while (parent != NULL) {
+    if (parent->isSetId() && parent->getId() == id) {
+      return true;
+    }
+    parent = parent->getParentSBMLObject();
+  }
+  return false;
+}
+
+//As SBMLIndex::find, but for the elements of a document:  the first whose id is the last of 'id', and which is inside elements with each of the others.
+static SBase* findElement(const SBaseIdMap& ids, const vector<string>& id)
+{
+  if (id.empty()) {
+    return NULL;
+  }
+  pair<SBaseIdMap::const_iterator, SBaseIdMap::const_iterator> found = ids.equal_range(id[id.size()-1]);
+  for (SBaseIdMap::const_iterator e=found.first; e != found.second; e++) {
+    bool inside = true;
+    for (size_t n=0; n<id.size()-1 && inside; n++) {
+      inside = isInside(id[n], e->second);
+    }
+    if (inside) {
+      return e->second;
+    }
+  }
+  return NULL;
+}
+
+//The value of a species, compartment, or parameter, as it would be set by a change to it:  a species' initial amount if it has one, and its initial concentration otherwise.  Returns true if the element has no value phraSED-ML can change.
+static bool getElementValue(const SBase* element, double& value)
+{
+  switch(element->getTypeCode()) {
+  case SBML_SPECIES:
+    {
+      const Species* species = static_cast<const Species*>(element);
+      value = species->isSetInitialAmount() ? species->getInitialAmount() : species->getInitialConcentration();
+    }
+    return false;
+  case SBML_COMPARTMENT:
+    value = static_cast<const Compartment*>(element)->getSize();
+    return false;
+  case SBML_PARAMETER:
+  case SBML_LOCAL_PARAMETER:
+    value = static_cast<const Parameter*>(element)->getValue();
+    return false;
+  default:
+    return true;
+  }
+}
+
+//Sets the value of a species, compartment, or parameter, in the same attribute a ChangeAttribute for it would target.  Returns true if the element has no value phraSED-ML can change.
+static bool setElementValue(SBase* element, double value)
+{
+  switch(element->getTypeCode()) {
+  case SBML_SPECIES:
+    {
+      Species* species = static_cast<Species*>(element);
+      if (species->isSetInitialAmount()) {
+        species->setInitialAmount(value);
+      }
+      else {
+        species->setInitialConcentration(value);
+      }
+    }
+    return false;
+  case SBML_COMPARTMENT:
+    static_cast<Compartment*>(element)->setSize(value);
+    return false;
+  case SBML_PARAMETER:
+  case SBML_LOCAL_PARAMETER:
+    static_cast<Parameter*>(element)->setValue(value);
+    return false;
+  default:
+    return true;
+  }
+}
+
+//Whether the attribute setElementValue sets has a value yet.
+static bool isElementValueSet(const SBase* element)
+{
+  switch(element->getTypeCode()) {
+  case SBML_SPECIES:
+    {
+      const Species* species = static_cast<const Species*>(element);
+      return species->isSetInitialAmount() || species->isSetInitialConcentration();
+    }
+  case SBML_COMPARTMENT:
+    return static_cast<const Compartment*>(element)->isSetSize();
+  case SBML_PARAMETER:
+  case SBML_LOCAL_PARAMETER:
+    return static_cast<const Parameter*>(element)->isSetValue();
+  default:
+    return false;
+  }
+}
+
+//Unsets the attribute setElementValue sets on an element that had no value.  A species with neither an initial amount nor an initial concentration only ever has its concentration set.
+static void unsetElementValue(SBase* element)
+{
+  switch(element->getTypeCode()) {
+  case SBML_SPECIES:
+    static_cast<Species*>(element)->unsetInitialConcentration();
+    break;
+  case SBML_COMPARTMENT:
+    static_cast<Compartment*>(element)->unsetSize();
+    break;
+  case SBML_PARAMETER:
+  case SBML_LOCAL_PARAMETER:
+    static_cast<Parameter*>(element)->unsetValue();
+    break;
+  default:
+    break;
+  }
+}
+
+PhrasedModelMaterializer::PhrasedModelMaterializer()
+  : m_documents()
+  , m_workingCopies()
+  , m_revision(0)
+{
+}
+
+PhrasedModelMaterializer::~PhrasedModelMaterializer()
+{
+}
+
+//Sets 'doc' to the SBML of the model 'modelid', with its changes applied.  The document must not be changed:  it may be the one shared by every model of the same file.  Returns true on error, which is set in the registry.
+bool PhrasedModelMaterializer::materialize(const string& modelid, shared_ptr<const SBMLDocument>& doc)
+{
+  doc.reset();
+  const PhrasedModel* model = g_registry.getModel(modelid);
+  if (model == NULL) {
+    g_registry.setError("Unable to materialize the model '" + modelid + "':  no such model has been defined.", 0);
+    return true;
+  }
+  if (g_registry.getStructural()) {
+    g_registry.setError("Unable to materialize the model '" + modelid + "':  models are never loaded in a structural conversion.", 0);
+    return true;
+  }
+  const PhrasedModel* root = model->getRootModel();
+  if (root == NULL) {
+    return true;
+  }
+  //The changes of the models the chain is based on come first, so that each model's changes are made on top of those of its base.
+  vector<const PhrasedModel*> chain;
+  for (const PhrasedModel* link=model; link != root; link = g_registry.getModel(link->getSource())) {
+    chain.push_back(link);
+  }
+  chain.push_back(root);
+  vector<const ModelChange*> changes;
+  for (size_t m=chain.size(); m>0; m--) {
+    const vector<ModelChange>& modelchanges = chain[m-1]->getChanges();
+    for (size_t c=0; c<modelchanges.size(); c++) {
+      changes.push_back(&modelchanges[c]);
+    }
+  }
+  shared_ptr<const SBMLDocument> source = getDocument(root);
+  if (!source) {
+    g_registry.setError("Unable to materialize the model '" + modelid + "':  the SBML model '" + root->getSource() + "' could not be found or read.", 0);
+    return true;
+  }
+  if (changes.empty()) {
+    doc = source;
+    return false;
+  }
+  WorkingCopy* working = getWorkingCopy(source);
+  vector<SavedValue> saved;
+  if (applyChanges(changes, working, saved)) {
+    revertChanges(saved);
+    g_registry.addErrorPrefix("Unable to materialize the model '" + modelid + "':  ");
+    return true;
+  }
+  doc.reset(working->doc->clone());
+  revertChanges(saved);
+  return false;
+}
+
+//The full document for a model of a file:  the one it was given as, if any, or the file, read once and kept until g_registry is cleared.  Only then are libsbml's own checks run on a file (its index only checks that it is valid XML), so this is where any errors they find are warned of.
+shared_ptr<const SBMLDocument> PhrasedModelMaterializer::getDocument(const PhrasedModel* root)
+{
+  if (g_registry.getRevision() != m_revision) {
+    m_documents.clear();
+    m_workingCopies.clear();
+    m_revision = g_registry.getRevision();
+  }
+  if (root->getSBMLDocument() != NULL) {
+    return root->getSharedSBMLDocument();
+  }
+  string filename = g_registry.getWorkingFilename(root->getSource());
+  if (filename.empty()) {
+    return shared_ptr<const SBMLDocument>();
+  }
+  map<string, shared_ptr<const SBMLDocument> >::iterator found = m_documents.find(filename);
+  if (found != m_documents.end()) {
+    return found->second;
+  }
+  shared_ptr<const SBMLDocument> doc = readSBMLFile(filename);
+  if (doc && doc->getModel() != NULL) {
+    if (doc->getNumErrors(LIBSBML_SEV_ERROR) != 0 || doc->getNumErrors(LIBSBML_SEV_FATAL) != 0) {
+      g_registry.addWarning("The SBML model '" + root->getSource() + "' has one or more validation errors, and may not be simulatable on all systems.");
+    }
+    m_documents.insert(make_pair(filename, doc));
+    return doc;
+  }
+  return shared_ptr<const SBMLDocument>();
+}
+
+//The working copy of 'source', copying it and mapping its elements by id the first time it is needed.
+PhrasedModelMaterializer::WorkingCopy* PhrasedModelMaterializer::getWorkingCopy(shared_ptr<const SBMLDocument> source)
+{
+  map<const SBMLDocument*, shared_ptr<WorkingCopy> >::iterator found = m_workingCopies.find(source.get());
+  if (found != m_workingCopies.end()) {
+    return found->second.get();
+  }
+  shared_ptr<WorkingCopy> working(new WorkingCopy());
+  working->source = source;
+  working->doc.reset(source->clone());
+  List* all = working->doc->getAllElements();
+  for (unsigned int e=0; e<all->getSize(); e++) {
+    SBase* element = static_cast<SBase*>(all->get(e));
+    if (element->isSetId()) {
+      working->ids.insert(make_pair(element->getId(), element));
+    }
+  }
+  delete all;
+  m_workingCopies.insert(make_pair(source.get(), working));
+  return working.get();
+}
+
+//Makes each change to the working copy in turn, so that a formula sees the values set by any change before it, saving each value it replaces in 'saved'.  Values set for local variables are only used in formulas, and, as in addLocalVariablesToComputeChange, a local variable set to a number can be used by any formula, even one before it (as when a ComputeChange read from SED-ML comes before its own parameters).  Returns true on error, which is set in the registry.
+bool PhrasedModelMaterializer::applyChanges(const vector<const ModelChange*>& changes, WorkingCopy* copy, vector<SavedValue>& saved) const
+{
+  map<string, double> locals;
+  for (size_t c=0; c<changes.size(); c++) {
+    vector<string> variable = changes[c]->getVariable();
+    if (changes[c]->getType() == ctype_val_assignment && variable.size() > 1 && variable[0] == "local") {
+      locals[variable[1]] = changes[c]->getValues()[0];
+    }
+  }
+
+  //Every element is found through the working copy's map, rather than by searching the document for each change.
+  const SBaseIdMap& ids = copy->ids;
+  for (size_t c=0; c<changes.size(); c++) {
+    const ModelChange* change = changes[c];
+    vector<string> variable = change->getVariable();
+    bool local = (variable.size() && variable[0] == "local");
+    double value = 0;
+    switch(change->getType()) {
+    case ctype_val_assignment:
+      value = change->getValues()[0];
+      break;
+    case ctype_formula_assignment:
+      {
+        CompiledFormula formula;
+        if (formula.compile(change->getASTNode())) {
+          return true;
+        }
+        //As in the SED-ML, an element of the model is used in preference to a local variable of the same name.
+        vector<string> names = formula.getVariables();
+        vector<double> values;
+        for (size_t n=0; n<names.size(); n++) {
+          vector<string> nameid(1, names[n]);
+          SBase* element = findElement(ids, nameid);
+          double namevalue = 0;
+          if (element != NULL && !getElementValue(element, namevalue)) {
+            values.push_back(namevalue);
+            continue;
+          }
+          map<string, double>::iterator found = locals.find(names[n]);
+          if (found == locals.end()) {
+            g_registry.setError("the formula for '" + getStringFrom(&variable) + "' uses '" + names[n] + "', which has no value in the model, and is not a local variable.", 0);
+            return true;
+          }
+          values.push_back(found->second);
+        }
+        value = formula.evaluate(values);
+      }
+      break;
+    default:
+      g_registry.setError("it is not legal to have a looping change construct in a model directly.", 0);
+      return true;
+    }
+    if (local) {
+      if (variable.size() > 1) {
+        locals[variable[1]] = value;
+      }
+      continue;
+    }
+    SBase* element = findElement(ids, variable);
+    if (element == NULL) {
+      g_registry.setError("the variable '" + getStringFrom(&variable) + "' is not in the model.", 0);
+      return true;
+    }
+    SavedValue old;
+    old.element = element;
+    old.isSet = isElementValueSet(element);
+    if (getElementValue(element, old.value)) {
+      g_registry.setError("the variable '" + getStringFrom(&variable) + "' is not a species, compartment, or parameter, so phraSED-ML cannot set its value.", 0);
+      return true;
+    }
+    saved.push_back(old);
+    setElementValue(element, value);
+  }
+  return false;
+}
+
+//Sets every saved value back, latest first, so that an element changed more than once gets its original value.
+void PhrasedModelMaterializer::revertChanges(vector<SavedValue>& saved) const
+{
+  for (size_t s=saved.size(); s>0; s--) {
+    if (saved[s-1].isSet) {
+      setElementValue(saved[s-1].element, saved[s-1].value);
+    }
+    else {
+      unsetElementValue(saved[s-1].element);
+    }
+  }
+  saved.clear();
+}
+
+PHRASEDML_CPP_NAMESPACE_END
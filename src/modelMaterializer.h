@@ -0,0 +1,55 @@
+#ifndef PHRASEDMODELMATERIALIZER_H
+#define PHRASEDMODELMATERIALIZER_H
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "sbml/SBMLDocument.h"
+#include "phrasedml-namespace.h"
+
+PHRASEDML_CPP_NAMESPACE_BEGIN
+class PhrasedModel;
+class ModelChange;
+
+//The SBML of a model with its changes, and those of every model it is based on, applied:  the model as a simulator should see it.  Each SBML file is read in full only once, and kept until g_registry is next cleared.  A model with no changes shares that document.  Changes are made directly on the elements of a working copy of it, made the first time a model of it has changes, and whose elements are only mapped by id once:  the changed copy is copied for the caller, and the changes are then reverted.  So no XPaths are ever built or evaluated, and each call for a model with changes costs one copy of the document, but nothing more that grows with the size of the model.
+class PhrasedModelMaterializer
+{
+private:
+  //A copy of a document, for changes to be made on and then reverted, with its elements mapped by id.  The source is kept so that no other document can take its place in m_workingCopies.
+  struct WorkingCopy
+  {
+    std::shared_ptr<const libsbml::SBMLDocument> source;
+    std::unique_ptr<libsbml::SBMLDocument> doc;
+    std::multimap<std::string, libsbml::SBase*> ids;
+  };
+
+  //The value an element had before a change, so that the change can be reverted.
+  struct SavedValue
+  {
+    libsbml::SBase* element;
+    double value;
+    bool isSet;
+  };
+
+  std::map<std::string, std::shared_ptr<const libsbml::SBMLDocument> > m_documents;
+  std::map<const libsbml::SBMLDocument*, std::shared_ptr<WorkingCopy> > m_workingCopies;
+  size_t m_revision;
+
+public:
+  PhrasedModelMaterializer();
+  ~PhrasedModelMaterializer();
+
+  bool materialize(const std::string& modelid, std::shared_ptr<const libsbml::SBMLDocument>& doc);
+
+private:
+  std::shared_ptr<const libsbml::SBMLDocument> getDocument(const PhrasedModel* root);
+  WorkingCopy* getWorkingCopy(std::shared_ptr<const libsbml::SBMLDocument> source);
+  bool applyChanges(const std::vector<const ModelChange*>& changes, WorkingCopy* copy, std::vector<SavedValue>& saved) const;
+  void revertChanges(std::vector<SavedValue>& saved) const;
+};
+
+PHRASEDML_CPP_NAMESPACE_END
+
+#endif //PHRASEDMODELMATERIALIZER_H
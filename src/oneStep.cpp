@@ -51,6 +51,12 @@ void PhrasedOneStep::addSimulationToSEDML(SedDocument* sedml) const
   addKisaoAndAlgorithmParametersToSEDML(oneStep);
 }
 
+//The state before the step and the state after it.
+size_t PhrasedOneStep::getNumOutputPoints() const
+{
+  return 2;
+}
+
 bool PhrasedOneStep::kisaoIsDefault() const
 {
   return m_kisao == 19;
@@ -23,9 +23,12 @@ public:
   PhrasedOneStep(libsedml::SedOneStep* sedOneStep);
   ~PhrasedOneStep();
 
+  double getStep() const {return m_step;};
+
   virtual std::string getPhraSEDML() const;
   virtual void addSimulationToSEDML(libsedml::SedDocument* sedml) const;
   virtual bool kisaoIsDefault() const;
+  virtual size_t getNumOutputPoints() const;
 
   virtual bool finalize();
 
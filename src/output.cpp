@@ -19,22 +19,23 @@ using namespace libsedml;
 #define DEFAULTCOMP "default_compartment" //Also defined in antimony_api.cpp
 
 PHRASEDML_CPP_NAMESPACE_BEGIN
-PhrasedOutput::PhrasedOutput(const vector<ASTNode*>& inputs)
+//The output takes ownership of every AST it is given.
+PhrasedOutput::PhrasedOutput(vector<OwnedAST> inputs)
   : Variable("_none")
   , m_isPlot(false)
   , m_outputVariables()
 {
-  m_outputVariables.push_back(inputs);
+  m_outputVariables.push_back(move(inputs));
 }
 
-PhrasedOutput::PhrasedOutput(const std::vector<std::vector<ASTNode*> >& outputs)
+PhrasedOutput::PhrasedOutput(vector<vector<OwnedAST> > outputs)
   : Variable("_none")
   , m_isPlot(true)
-  , m_outputVariables(outputs)
+  , m_outputVariables(move(outputs))
 {
 }
 
-ASTNode* getASTNodeFrom(SedDataGenerator* datagen, SedDocument* seddoc, bool isLog)
+OwnedAST getASTNodeFrom(SedDataGenerator* datagen, SedDocument* seddoc, bool isLog)
 {
   ASTNode* astn = datagen->getMath()->deepCopy();
   //Here is where we would make sure we could find things again!
@@ -45,7 +46,7 @@ ASTNode* getASTNodeFrom(SedDataGenerator* datagen, SedDocument* seddoc, bool isL
     ten.setValue(10);
     newroot->addChild(ten.deepCopy());
     newroot->addChild(astn);
-    return newroot;
+    return OwnedAST(newroot);
   }
   //And now we need to fix the IDs so that they match the actual thing they point to.
   map<string, string> dg2modvar;
@@ -86,7 +87,7 @@ ASTNode* getASTNodeFrom(SedDataGenerator* datagen, SedDocument* seddoc, bool isL
     assert(false); 
   }
   replaceVariablesInASTNodeWith(astn, dg2modvar);
-  return astn;
+  return OwnedAST(astn);
 }
 
 PhrasedOutput::PhrasedOutput(SedOutput* sedout, SedDocument* seddoc)
@@ -105,7 +106,7 @@ PhrasedOutput::PhrasedOutput(SedOutput* sedout, SedDocument* seddoc)
     {
       SedPlot2D* plot2d = static_cast<SedPlot2D*>(sedout);
       for (unsigned long p=0; p<plot2d->getNumCurves(); p++) {
-        vector<ASTNode*> astns;
+        vector<OwnedAST> astns;
         SedAbstractCurve* abstractcurve = plot2d->getCurve(p);
         if (abstractcurve->getTypeCode() == SEDML_OUTPUT_CURVE) {
             SedCurve* curve = static_cast<SedCurve*>(abstractcurve);
@@ -113,7 +114,7 @@ PhrasedOutput::PhrasedOutput(SedOutput* sedout, SedDocument* seddoc)
             astns.push_back(getASTNodeFrom(datagen, seddoc, curve->getLogX()));
             datagen = seddoc->getDataGenerator(curve->getYDataReference());
             astns.push_back(getASTNodeFrom(datagen, seddoc, curve->getLogY()));
-            m_outputVariables.push_back(astns);
+            m_outputVariables.push_back(move(astns));
         }
         else {
             //It's a SedShadedArea, which we don't handle.
@@ -125,7 +126,7 @@ PhrasedOutput::PhrasedOutput(SedOutput* sedout, SedDocument* seddoc)
     {
       SedPlot3D* plot3d = static_cast<SedPlot3D*>(sedout);
       for (unsigned long s=0; s<plot3d->getNumSurfaces(); s++) {
-        vector<ASTNode*> astns;
+        vector<OwnedAST> astns;
         SedSurface* surface = plot3d->getSurface(s);
         SedDataGenerator* datagen = seddoc->getDataGenerator(surface->getXDataReference());
         astns.push_back(getASTNodeFrom(datagen, seddoc, surface->getLogX()));
@@ -133,7 +134,7 @@ PhrasedOutput::PhrasedOutput(SedOutput* sedout, SedDocument* seddoc)
         astns.push_back(getASTNodeFrom(datagen, seddoc, surface->getLogY()));
         datagen = seddoc->getDataGenerator(surface->getZDataReference());
         astns.push_back(getASTNodeFrom(datagen, seddoc, surface->getLogZ()));
-        m_outputVariables.push_back(astns);
+        m_outputVariables.push_back(move(astns));
       }
     }
     break;
@@ -144,10 +145,9 @@ PhrasedOutput::PhrasedOutput(SedOutput* sedout, SedDocument* seddoc)
       for (unsigned long r=0; r<report->getNumDataSets(); r++) {
         SedDataSet* dataset = report->getDataSet(r);
         SedDataGenerator* datagen = seddoc->getDataGenerator(dataset->getDataReference());
-        ASTNode* astn = getASTNodeFrom(datagen, seddoc, false);
-        vector<ASTNode*> astns;
-        astns.push_back(astn);
-        m_outputVariables.push_back(astns);
+        vector<OwnedAST> astns;
+        astns.push_back(getASTNodeFrom(datagen, seddoc, false));
+        m_outputVariables.push_back(move(astns));
       }
     }
     break;
@@ -158,10 +158,59 @@ PhrasedOutput::PhrasedOutput(SedOutput* sedout, SedDocument* seddoc)
 }
 
 
+//Copying an output copies its ASTs; moving it (as a vector of them does when it grows) takes them instead.
+PhrasedOutput::PhrasedOutput(const PhrasedOutput& orig)
+  : Variable(orig)
+  , m_isPlot(orig.m_isPlot)
+  , m_outputVariables()
+  , m_variableMap(orig.m_variableMap)
+{
+  copyOutputVariables(orig);
+}
+
+PhrasedOutput::PhrasedOutput(PhrasedOutput&& orig) noexcept
+  : Variable(move(orig))
+  , m_isPlot(orig.m_isPlot)
+  , m_outputVariables(move(orig.m_outputVariables))
+  , m_variableMap(move(orig.m_variableMap))
+{
+}
+
+PhrasedOutput& PhrasedOutput::operator=(const PhrasedOutput& rhs)
+{
+  if (this != &rhs) {
+    Variable::operator=(rhs);
+    m_isPlot = rhs.m_isPlot;
+    copyOutputVariables(rhs);
+    m_variableMap = rhs.m_variableMap;
+  }
+  return *this;
+}
+
+PhrasedOutput& PhrasedOutput::operator=(PhrasedOutput&& rhs) noexcept
+{
+  Variable::operator=(move(rhs));
+  m_isPlot = rhs.m_isPlot;
+  m_outputVariables = move(rhs.m_outputVariables);
+  m_variableMap = move(rhs.m_variableMap);
+  return *this;
+}
+
 PhrasedOutput::~PhrasedOutput()
 {
 }
 
+void PhrasedOutput::copyOutputVariables(const PhrasedOutput& orig)
+{
+  m_outputVariables.clear();
+  m_outputVariables.resize(orig.m_outputVariables.size());
+  for (size_t c=0; c<orig.m_outputVariables.size(); c++) {
+    for (size_t a=0; a<orig.m_outputVariables[c].size(); a++) {
+      m_outputVariables[c].push_back(copyAST(orig.m_outputVariables[c][a].get()));
+    }
+  }
+}
+
 string PhrasedOutput::getPhraSEDML() const
 {
   string ret = "";
@@ -174,7 +223,12 @@ string PhrasedOutput::getPhraSEDML() const
   if (!m_name.empty()) {
     ret += "\"" + m_name + "\" ";
   }
-  std::vector<std::vector<ASTNode*> > truncatedvars = m_outputVariables;
+  vector<vector<const ASTNode*> > truncatedvars(m_outputVariables.size());
+  for (size_t p=0; p<m_outputVariables.size(); p++) {
+    for (size_t a=0; a<m_outputVariables[p].size(); a++) {
+      truncatedvars[p].push_back(m_outputVariables[p][a].get());
+    }
+  }
   if (m_isPlot) {
     char* firstx = SBML_formulaToL3String(truncatedvars[0][0]);
     for (size_t p=1; p<truncatedvars.size(); p++) {
@@ -199,7 +253,9 @@ string PhrasedOutput::getPhraSEDML() const
           ret += ", ";
         }
       }
-      ret += SBML_formulaToL3String(truncatedvars[p][a]);
+      char* formula = SBML_formulaToL3String(truncatedvars[p][a]);
+      ret += formula;
+      free(formula);
     }
   }
   string sep = g_registry.getSeparator();
@@ -236,6 +292,46 @@ string PhrasedOutput::getPhraSEDML() const
   return ret + "\n";
 }
 
+//The IDs of the tasks this output uses data from.  Only valid after finalize().
+set<string> PhrasedOutput::getTaskReferences() const
+{
+  set<string> ret;
+  for (map<string, vector<string> >::const_iterator var = m_variableMap.begin(); var != m_variableMap.end(); var++) {
+    if (!var->second.empty()) {
+      ret.insert(var->second[0]);
+    }
+  }
+  return ret;
+}
+
+//A report with the same ID and name, with one column for each distinct value this output uses.  Axes plotted on a log scale are reported with their original values.
+PhrasedOutput PhrasedOutput::getAsReport() const
+{
+  PhrasedOutput ret(*this);
+  if (!m_isPlot) {
+    return ret;
+  }
+  vector<OwnedAST> columns;
+  set<string> formulas;
+  for (size_t c=0; c<m_outputVariables.size(); c++) {
+    for (size_t a=0; a<m_outputVariables[c].size(); a++) {
+      const ASTNode* astn = m_outputVariables[c][a].get();
+      if (astn->isLog10()) {
+        astn = astn->getChild(1);
+      }
+      char* formula = SBML_formulaToL3String(astn);
+      if (formulas.insert(formula).second) {
+        columns.push_back(copyAST(astn));
+      }
+      free(formula);
+    }
+  }
+  ret.m_isPlot = false;
+  ret.m_outputVariables.clear();
+  ret.m_outputVariables.push_back(move(columns));
+  return ret;
+}
+
 string PhrasedOutput::getMatchingDataGenerator(SedDocument* sedml, ASTNode* astnode) const
 {
   string ret = "";
@@ -301,11 +397,11 @@ void PhrasedOutput::addOutputToSEDML(SedDocument* sedml) const
   for (size_t ov=0; ov<m_outputVariables.size(); ov++) {
     vector<string> datagennames;
     vector<string> datagenlabels;
-    const vector<ASTNode*>* vec = &(m_outputVariables[ov]);
+    const vector<OwnedAST>* vec = &(m_outputVariables[ov]);
     //Create Data Generators for each element.
     for (size_t an=0; an<vec->size(); an++) {
-      datagennames.push_back(addDataGeneratorToSEDML(sedml, (*vec)[an], (int)ov, (int)an));
-      char* cformula = SBML_formulaToL3String((*vec)[an]);
+      datagennames.push_back(addDataGeneratorToSEDML(sedml, (*vec)[an].get(), (int)ov, (int)an));
+      char* cformula = SBML_formulaToL3String((*vec)[an].get());
       datagenlabels.push_back(getSimpleString(cformula));
       free(cformula);
     }
@@ -365,7 +461,7 @@ bool PhrasedOutput::finalize()
   set<string> variables;
   for (size_t c=0; c<m_outputVariables.size(); c++) {
     for (size_t a=0; a<m_outputVariables[c].size(); a++) {
-      getVariablesFromASTNode(m_outputVariables[c][a], variables);
+      getVariablesFromASTNode(m_outputVariables[c][a].get(), variables);
     }
   }
   for (set<string>::iterator var = variables.begin(); var != variables.end(); var++) {
@@ -458,7 +554,7 @@ bool getVariable(vector<string>& varname, vector<string>& mapname, const Phrased
     mapname.push_back(fullvarname);
     return false;
   }
-  string xpath = getElementXPathFromId(&varname, model->getSBMLDocument());
+  string xpath = getElementXPathFromId(&varname, model->getSBMLIndex());
   if (xpath.empty()) {
     err << "which cannot be found in task '" << task->getId() << "'s model '" << model->getId() << "'.";
     g_registry.setError(err.str(), 0);
@@ -523,9 +619,9 @@ void PhrasedOutput::replaceASTNamesAndAdd(ASTNode* astnode, SedDataGenerator* sd
           var->setSymbol("urn:sedml:symbol:time");
           return;
         }
-        SBMLDocument* doc = g_registry.getModel(fullname[1])->getSBMLDocument();
+        const SBMLIndex* index = g_registry.getModel(fullname[1])->getSBMLIndex();
         vector<string> idonly = getStringVecFromDelimitedString(fullname[2]);
-        string xpath = getElementXPathFromId(&idonly, doc);
+        string xpath = getElementXPathFromId(&idonly, index);
         var->setTarget(xpath);
       }
     }
@@ -4,11 +4,13 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <set>
 
 #include "variable.h"
 #include "sbml/SBMLDocument.h"
 #include "sbml/math/ASTNode.h"
 #include "modelChange.h"
+#include "sbmlx.h"
 #include "phrasedml-namespace.h"
 
 #include "sedml/SedPlot.h"
@@ -24,24 +26,33 @@ private:
   PhrasedOutput(); //undefined
 
   bool m_isPlot;
-  std::vector<std::vector<libsbml::ASTNode*> > m_outputVariables;
+  std::vector<std::vector<OwnedAST> > m_outputVariables;
   std::map<std::string, std::vector<std::string> > m_variableMap;
 
 public:
 
-  PhrasedOutput(const std::vector<libsbml::ASTNode*>& inputs);
-  PhrasedOutput(const std::vector<std::vector<libsbml::ASTNode*> >& curves);
+  PhrasedOutput(std::vector<OwnedAST> inputs);
+  PhrasedOutput(std::vector<std::vector<OwnedAST> > curves);
   PhrasedOutput(libsedml::SedOutput* sedout, libsedml::SedDocument* seddoc);
+  PhrasedOutput(const PhrasedOutput& orig);
+  PhrasedOutput(PhrasedOutput&& orig) noexcept;
+  PhrasedOutput& operator=(const PhrasedOutput& rhs);
+  PhrasedOutput& operator=(PhrasedOutput&& rhs) noexcept;
   ~PhrasedOutput();
 
   bool isPlot() const {return m_isPlot;};
+  const std::vector<std::vector<OwnedAST> >& getOutputVariables() const {return m_outputVariables;};
+  const std::map<std::string, std::vector<std::string> >& getVariableMap() const {return m_variableMap;};
 
   std::string getPhraSEDML() const;
+  std::set<std::string> getTaskReferences() const;
+  PhrasedOutput getAsReport() const;
   std::string addDataGeneratorToSEDML(libsedml::SedDocument* sedml, libsbml::ASTNode* astnodes, int num1, int num2) const;
   void addOutputToSEDML(libsedml::SedDocument* sedml) const;
 
   virtual bool finalize();
 private:
+  void copyOutputVariables(const PhrasedOutput& orig);
   bool addVariableToMap(const std::string& var);
   std::string getMatchingDataGenerator(libsedml::SedDocument* sedml, libsbml::ASTNode* astnode) const;
   void replaceASTNamesAndAdd(libsbml::ASTNode* astnode, libsedml::SedDataGenerator* sdg) const;
@@ -0,0 +1,256 @@
+#include <limits>
+#include <set>
+#include <sstream>
+
+#include "outputShape.h"
+#include "dataGeneratorEvaluator.h"
+#include "registry.h"
+#include "repeatedTask.h"
+#include "simulation.h"
+#include "task.h"
+
+#include "sedml/SedPlot2D.h"
+#include "sedml/SedPlot3D.h"
+#include "sedml/SedReport.h"
+#include "sedml/SedDataSet.h"
+
+using namespace std;
+using namespace libsbml;
+using namespace libsedml;
+
+PHRASEDML_CPP_NAMESPACE_BEGIN
+
+//The total number of values, or the largest size_t if there are too many to count.
+size_t getNumValues(const OutputShape& shape)
+{
+  size_t ret = 1;
+  for (size_t e=0; e<shape.extents.size(); e++) {
+    if (shape.extents[e] != 0 && ret > numeric_limits<size_t>::max() / shape.extents[e]) {
+      return numeric_limits<size_t>::max();
+    }
+    ret *= shape.extents[e];
+  }
+  return ret;
+}
+
+static void setByteSize(OutputShape& shape)
+{
+  size_t num = getNumValues(shape);
+  if (num > numeric_limits<size_t>::max() / sizeof(double)) {
+    shape.byteSize = numeric_limits<size_t>::max();
+  }
+  else {
+    shape.byteSize = num * sizeof(double);
+  }
+}
+
+static void clearShape(OutputShape& shape, const string& id)
+{
+  shape.id = id;
+  shape.dimensions.clear();
+  shape.extents.clear();
+  shape.exact = true;
+  shape.byteSize = sizeof(double);
+}
+
+//Combines two shapes, aligned on their innermost dimension:  each extent becomes the larger of the two.  A scalar fits any shape exactly; anything else that doesn't match makes the result inexact.
+static void mergeShape(OutputShape& merged, const OutputShape& other)
+{
+  if (!other.exact) {
+    merged.exact = false;
+  }
+  if (other.extents.empty()) {
+    return;
+  }
+  if (other.extents.size() > merged.extents.size()) {
+    size_t extra = other.extents.size() - merged.extents.size();
+    if (!merged.extents.empty()) {
+      merged.exact = false;
+    }
+    merged.extents.insert(merged.extents.begin(), other.extents.begin(), other.extents.begin() + extra);
+    merged.dimensions.insert(merged.dimensions.begin(), other.dimensions.begin(), other.dimensions.begin() + extra);
+  }
+  else if (other.extents.size() < merged.extents.size()) {
+    merged.exact = false;
+  }
+  size_t offset = merged.extents.size() - other.extents.size();
+  for (size_t e=0; e<other.extents.size(); e++) {
+    if (merged.extents[offset+e] != other.extents[e]) {
+      merged.exact = false;
+      if (other.extents[e] > merged.extents[offset+e]) {
+        merged.extents[offset+e] = other.extents[e];
+      }
+    }
+  }
+}
+
+static bool getTaskShape(const string& taskid, set<string>& parents, OutputShape& shape)
+{
+  clearShape(shape, taskid);
+  const PhrasedTask* task = g_registry.getTask(taskid);
+  if (task == NULL) {
+    g_registry.setError("Unable to find the shape of the results of task '" + taskid + "':  no such task exists.", 0);
+    return true;
+  }
+  if (!task->isRepeated()) {
+    const PhrasedSimulation* sim = g_registry.getSimulation(task->getSimulationReference());
+    if (sim == NULL) {
+      g_registry.setError("Unable to find the shape of the results of task '" + taskid + "':  its simulation '" + task->getSimulationReference() + "' does not exist.", 0);
+      return true;
+    }
+    shape.dimensions.push_back(sim->getId());
+    shape.extents.push_back(sim->getNumOutputPoints());
+    setByteSize(shape);
+    return false;
+  }
+  if (parents.find(taskid) != parents.end()) {
+    g_registry.setError("Unable to find the shape of the results of task '" + taskid + "':  it references itself.", 0);
+    return true;
+  }
+  parents.insert(taskid);
+  const PhrasedRepeatedTask* rt = static_cast<const PhrasedRepeatedTask*>(task);
+  vector<string> subtasks = rt->getTasks();
+  for (size_t t=0; t<subtasks.size(); t++) {
+    OutputShape subshape;
+    if (getTaskShape(subtasks[t], parents, subshape)) {
+      return true;
+    }
+    if (t==0) {
+      shape.dimensions = subshape.dimensions;
+      shape.extents = subshape.extents;
+      shape.exact = subshape.exact;
+    }
+    else {
+      mergeShape(shape, subshape);
+    }
+  }
+  parents.erase(taskid);
+  shape.dimensions.insert(shape.dimensions.begin(), taskid);
+  shape.extents.insert(shape.extents.begin(), rt->getNumIterations());
+  setByteSize(shape);
+  return false;
+}
+
+//The shape of the results of every variable of the task.  Returns true on error.
+bool getTaskShape(const string& taskid, OutputShape& shape)
+{
+  set<string> parents;
+  return getTaskShape(taskid, parents, shape);
+}
+
+static bool getFormulaShape(const ASTNode* astn, SedDataGenerator* sdg, OutputShape& shape)
+{
+  bool isMax;
+  if (isAggregateFunction(astn, isMax)) {
+    //Reduced to a single value.
+    return false;
+  }
+  if (astn->getType() == AST_NAME) {
+    SedVariable* var = sdg->getVariable(astn->getName());
+    if (var == NULL || var->getTaskReference().empty()) {
+      //A parameter, or a variable that only references a model:  a single value.
+      return false;
+    }
+    OutputShape varshape;
+    if (getTaskShape(var->getTaskReference(), varshape)) {
+      return true;
+    }
+    mergeShape(shape, varshape);
+    return false;
+  }
+  for (unsigned int c=0; c<astn->getNumChildren(); c++) {
+    if (getFormulaShape(astn->getChild(c), sdg, shape)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+//The shape of the values of the data generator:  its variables' tasks' shapes, combined.  Returns true on error.
+bool getDataGeneratorShape(SedDataGenerator* sdg, OutputShape& shape)
+{
+  clearShape(shape, sdg->getId());
+  if (sdg->getMath() != NULL && getFormulaShape(sdg->getMath(), sdg, shape)) {
+    g_registry.addErrorPrefix("Unable to find the shape of data generator '" + sdg->getId() + "':  ");
+    return true;
+  }
+  setByteSize(shape);
+  return false;
+}
+
+//The shape of an output:  one entry per dataset, curve, or surface, each of which is shaped like its data generators, combined.  Unlike the other shapes, the byte size is that of the output's (distinct) data generators, not of the extents.  Returns true on error.
+bool getOutputShape(SedOutput* output, const vector<OutputShape>& generators, OutputShape& shape)
+{
+  clearShape(shape, output->getId());
+  string dimension;
+  size_t numentries = 0;
+  vector<string> references;
+  switch(output->getTypeCode()) {
+  case SEDML_OUTPUT_REPORT:
+    {
+      SedReport* report = static_cast<SedReport*>(output);
+      dimension = "dataSet";
+      numentries = report->getNumDataSets();
+      for (unsigned int d=0; d<report->getNumDataSets(); d++) {
+        references.push_back(report->getDataSet(d)->getDataReference());
+      }
+    }
+    break;
+  case SEDML_OUTPUT_PLOT2D:
+    {
+      SedPlot2D* plot2d = static_cast<SedPlot2D*>(output);
+      dimension = "curve";
+      numentries = plot2d->getNumCurves();
+      for (unsigned int c=0; c<plot2d->getNumCurves(); c++) {
+        SedAbstractCurve* abstractcurve = plot2d->getCurve(c);
+        references.push_back(abstractcurve->getXDataReference());
+        if (abstractcurve->getTypeCode() == SEDML_OUTPUT_CURVE) {
+          references.push_back(static_cast<SedCurve*>(abstractcurve)->getYDataReference());
+        }
+      }
+    }
+    break;
+  case SEDML_OUTPUT_PLOT3D:
+    {
+      SedPlot3D* plot3d = static_cast<SedPlot3D*>(output);
+      dimension = "surface";
+      numentries = plot3d->getNumSurfaces();
+      for (unsigned int s=0; s<plot3d->getNumSurfaces(); s++) {
+        SedSurface* surface = plot3d->getSurface(s);
+        references.push_back(surface->getXDataReference());
+        references.push_back(surface->getYDataReference());
+        references.push_back(surface->getZDataReference());
+      }
+    }
+    break;
+  default:
+    g_registry.setError("Unable to find the shape of output '" + output->getId() + "':  unknown output type.", 0);
+    return true;
+  }
+
+  set<string> counted;
+  size_t bytes = 0;
+  for (size_t r=0; r<references.size(); r++) {
+    const OutputShape* dgshape = NULL;
+    for (size_t g=0; g<generators.size(); g++) {
+      if (generators[g].id == references[r]) {
+        dgshape = &generators[g];
+        break;
+      }
+    }
+    if (dgshape == NULL) {
+      g_registry.setError("Unable to find the shape of output '" + output->getId() + "':  the data generator '" + references[r] + "' does not exist.", 0);
+      return true;
+    }
+    mergeShape(shape, *dgshape);
+    if (counted.insert(references[r]).second) {
+      bytes = (bytes > numeric_limits<size_t>::max() - dgshape->byteSize) ? numeric_limits<size_t>::max() : bytes + dgshape->byteSize;
+    }
+  }
+  shape.dimensions.insert(shape.dimensions.begin(), dimension);
+  shape.extents.insert(shape.extents.begin(), numentries);
+  shape.byteSize = bytes;
+  return false;
+}
+
+PHRASEDML_CPP_NAMESPACE_END
@@ -0,0 +1,33 @@
+#ifndef PHRASEDOUTPUTSHAPE_H
+#define PHRASEDOUTPUTSHAPE_H
+
+#include <string>
+#include <vector>
+
+#include "phrasedml-namespace.h"
+
+#include "sbml/math/ASTNode.h"
+#include "sedml/SedDataGenerator.h"
+#include "sedml/SedOutput.h"
+
+PHRASEDML_CPP_NAMESPACE_BEGIN
+
+//The dimensions of the results of a task, data generator, or output, outermost first.  For a task, each enclosing repeated task adds a dimension (named after it) of its iterations, in front of the simulation's time points (named after the simulation).  If subtasks differ in shape, each extent is the largest of them, and 'exact' is false.  A scalar has no dimensions.
+struct OutputShape
+{
+  std::string id;
+  std::vector<std::string> dimensions;
+  std::vector<size_t> extents;
+  bool exact;
+  size_t byteSize;
+};
+
+size_t getNumValues(const OutputShape& shape);
+
+bool getTaskShape(const std::string& taskid, OutputShape& shape);
+bool getDataGeneratorShape(libsedml::SedDataGenerator* sdg, OutputShape& shape);
+bool getOutputShape(libsedml::SedOutput* output, const std::vector<OutputShape>& generators, OutputShape& shape);
+
+PHRASEDML_CPP_NAMESPACE_END
+
+#endif //PHRASEDOUTPUTSHAPE_H
@@ -0,0 +1,58 @@
+#include <atomic>
+#include <exception>
+#include <thread>
+#include <vector>
+
+#include "parallelJobs.h"
+
+using namespace std;
+
+PHRASEDML_CPP_NAMESPACE_BEGIN
+
+static void runJobs(ParallelJobs* jobs, size_t numJobs, atomic<size_t>* next, exception_ptr* failure)
+{
+  try {
+    for (size_t job = (*next)++; job < numJobs; job = (*next)++) {
+      jobs->run(job);
+    }
+  }
+  catch (...) {
+    *failure = current_exception();
+    //Let the other threads finish early.
+    *next = numJobs;
+  }
+}
+
+void runParallelJobs(ParallelJobs& jobs, size_t numJobs, size_t numThreads, size_t minJobsPerThread)
+{
+  if (numThreads == 0) {
+    numThreads = thread::hardware_concurrency();
+  }
+  if (minJobsPerThread > 0 && numThreads > numJobs / minJobsPerThread) {
+    numThreads = numJobs / minJobsPerThread;
+  }
+  if (numThreads <= 1) {
+    for (size_t job=0; job<numJobs; job++) {
+      jobs.run(job);
+    }
+    return;
+  }
+
+  atomic<size_t> next(0);
+  vector<exception_ptr> failures(numThreads);
+  vector<thread> threads;
+  for (size_t t=1; t<numThreads; t++) {
+    threads.push_back(thread(runJobs, &jobs, numJobs, &next, &failures[t]));
+  }
+  runJobs(&jobs, numJobs, &next, &failures[0]);
+  for (size_t t=0; t<threads.size(); t++) {
+    threads[t].join();
+  }
+  for (size_t t=0; t<failures.size(); t++) {
+    if (failures[t]) {
+      rethrow_exception(failures[t]);
+    }
+  }
+}
+
+PHRASEDML_CPP_NAMESPACE_END
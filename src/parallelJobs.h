@@ -0,0 +1,23 @@
+#ifndef PHRASEDPARALLELJOBS_H
+#define PHRASEDPARALLELJOBS_H
+
+#include <cstddef>
+
+#include "phrasedml-namespace.h"
+
+PHRASEDML_CPP_NAMESPACE_BEGIN
+
+//A set of independent jobs, numbered from zero, that may be run in any order and on any thread.
+class ParallelJobs
+{
+public:
+  virtual ~ParallelJobs() {};
+  virtual void run(size_t job) = 0;
+};
+
+//Runs 'numJobs' jobs on up to 'numThreads' threads (one per core if zero), including this one, and returns once they have all finished.  Each thread takes the next job as soon as it finishes the last, so uneven jobs still balance.  With fewer than 'minJobsPerThread' jobs for each thread, fewer threads are used, since starting one costs more than a few small jobs.
+void runParallelJobs(ParallelJobs& jobs, size_t numJobs, size_t numThreads, size_t minJobsPerThread);
+
+PHRASEDML_CPP_NAMESPACE_END
+
+#endif //PHRASEDPARALLELJOBS_H
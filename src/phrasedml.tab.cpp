@@ -152,10 +152,10 @@ extern int phrased_yydebug;
     PHRASED_YYEOF = 0,             /* "end of file"  */
     PHRASED_YYerror = 256,         /* error  */
     PHRASED_YYUNDEF = 257,         /* "invalid token"  */
-    NUM = 259,                     /* "number"  */
-    PHRASEWORD = 260,              /* "element name"  */
-    TEXTSTRING = 261,              /* "text string in quotes"  */
-    ERROR = 262                    /* "an error"  */
+    NUM = 260,                     /* "number"  */
+    PHRASEWORD = 261,              /* "element name"  */
+    TEXTSTRING = 262,              /* "text string in quotes"  */
+    ERROR = 263                    /* "an error"  */
   };
   typedef enum phrased_yytokentype phrased_yytoken_kind_t;
 #endif
@@ -200,46 +200,47 @@ enum yysymbol_kind_t
   YYSYMBOL_YYerror = 1,                    /* error  */
   YYSYMBOL_YYUNDEF = 2,                    /* "invalid token"  */
   YYSYMBOL_3_mathematical_symbol_ = 3,     /* "mathematical symbol"  */
-  YYSYMBOL_4_ = 4,                         /* '&'  */
-  YYSYMBOL_5_ = 5,                         /* '|'  */
-  YYSYMBOL_6_ = 6,                         /* '-'  */
-  YYSYMBOL_7_ = 7,                         /* '+'  */
-  YYSYMBOL_8_ = 8,                         /* '*'  */
-  YYSYMBOL_9_ = 9,                         /* '/'  */
-  YYSYMBOL_10_ = 10,                       /* '%'  */
-  YYSYMBOL_11_ = 11,                       /* '^'  */
-  YYSYMBOL_NUM = 12,                       /* "number"  */
-  YYSYMBOL_PHRASEWORD = 13,                /* "element name"  */
-  YYSYMBOL_TEXTSTRING = 14,                /* "text string in quotes"  */
-  YYSYMBOL_ERROR = 15,                     /* "an error"  */
-  YYSYMBOL_16_ = 16,                       /* '.'  */
-  YYSYMBOL_17_ = 17,                       /* '='  */
-  YYSYMBOL_18_ = 18,                       /* ','  */
-  YYSYMBOL_19_ = 19,                       /* '['  */
-  YYSYMBOL_20_ = 20,                       /* ']'  */
-  YYSYMBOL_21_ = 21,                       /* '('  */
-  YYSYMBOL_22_ = 22,                       /* ')'  */
-  YYSYMBOL_23_ = 23,                       /* '>'  */
-  YYSYMBOL_24_ = 24,                       /* ':'  */
-  YYSYMBOL_25_ = 25,                       /* '!'  */
-  YYSYMBOL_26_ = 26,                       /* '<'  */
-  YYSYMBOL_27_ = 27,                       /* ';'  */
-  YYSYMBOL_28_n_ = 28,                     /* '\n'  */
-  YYSYMBOL_YYACCEPT = 29,                  /* $accept  */
-  YYSYMBOL_input = 30,                     /* input  */
-  YYSYMBOL_varOrKeyword = 31,              /* varOrKeyword  */
-  YYSYMBOL_equals = 32,                    /* equals  */
-  YYSYMBOL_changelist = 33,                /* changelist  */
-  YYSYMBOL_numlist = 34,                   /* numlist  */
-  YYSYMBOL_plot = 35,                      /* plot  */
-  YYSYMBOL_name = 36,                      /* name  */
-  YYSYMBOL_number = 37,                    /* number  */
-  YYSYMBOL_taskslist = 38,                 /* taskslist  */
-  YYSYMBOL_vslist = 39,                    /* vslist  */
-  YYSYMBOL_formula = 40,                   /* formula  */
-  YYSYMBOL_commaformula = 41,              /* commaformula  */
-  YYSYMBOL_mathThing = 42,                 /* mathThing  */
-  YYSYMBOL_lineend = 43                    /* lineend  */
+  YYSYMBOL_4_end_of_line_ = 4,             /* "end of line"  */
+  YYSYMBOL_5_ = 5,                         /* '&'  */
+  YYSYMBOL_6_ = 6,                         /* '|'  */
+  YYSYMBOL_7_ = 7,                         /* '-'  */
+  YYSYMBOL_8_ = 8,                         /* '+'  */
+  YYSYMBOL_9_ = 9,                         /* '*'  */
+  YYSYMBOL_10_ = 10,                       /* '/'  */
+  YYSYMBOL_11_ = 11,                       /* '%'  */
+  YYSYMBOL_12_ = 12,                       /* '^'  */
+  YYSYMBOL_NUM = 13,                       /* "number"  */
+  YYSYMBOL_PHRASEWORD = 14,                /* "element name"  */
+  YYSYMBOL_TEXTSTRING = 15,                /* "text string in quotes"  */
+  YYSYMBOL_ERROR = 16,                     /* "an error"  */
+  YYSYMBOL_17_ = 17,                       /* '.'  */
+  YYSYMBOL_18_ = 18,                       /* '='  */
+  YYSYMBOL_19_ = 19,                       /* ','  */
+  YYSYMBOL_20_ = 20,                       /* '['  */
+  YYSYMBOL_21_ = 21,                       /* ']'  */
+  YYSYMBOL_22_ = 22,                       /* '('  */
+  YYSYMBOL_23_ = 23,                       /* ')'  */
+  YYSYMBOL_24_ = 24,                       /* '>'  */
+  YYSYMBOL_25_ = 25,                       /* ':'  */
+  YYSYMBOL_26_ = 26,                       /* '!'  */
+  YYSYMBOL_27_ = 27,                       /* '<'  */
+  YYSYMBOL_28_ = 28,                       /* ';'  */
+  YYSYMBOL_29_n_ = 29,                     /* '\n'  */
+  YYSYMBOL_YYACCEPT = 30,                  /* $accept  */
+  YYSYMBOL_input = 31,                     /* input  */
+  YYSYMBOL_varOrKeyword = 32,              /* varOrKeyword  */
+  YYSYMBOL_equals = 33,                    /* equals  */
+  YYSYMBOL_changelist = 34,                /* changelist  */
+  YYSYMBOL_numlist = 35,                   /* numlist  */
+  YYSYMBOL_plot = 36,                      /* plot  */
+  YYSYMBOL_name = 37,                      /* name  */
+  YYSYMBOL_number = 38,                    /* number  */
+  YYSYMBOL_taskslist = 39,                 /* taskslist  */
+  YYSYMBOL_vslist = 40,                    /* vslist  */
+  YYSYMBOL_formula = 41,                   /* formula  */
+  YYSYMBOL_commaformula = 42,              /* commaformula  */
+  YYSYMBOL_mathThing = 43,                 /* mathThing  */
+  YYSYMBOL_lineend = 44                    /* lineend  */
 };
 typedef enum yysymbol_kind_t yysymbol_kind_t;
 
@@ -570,7 +571,7 @@ union yyalloc
 #define YYLAST   274
 
 /* YYNTOKENS -- Number of terminals.  */
-#define YYNTOKENS  29
+#define YYNTOKENS  30
 /* YYNNTS -- Number of nonterminals.  */
 #define YYNNTS  15
 /* YYNRULES -- Number of rules.  */
@@ -579,7 +580,7 @@ union yyalloc
 #define YYNSTATES  144
 
 /* YYMAXUTOK -- Last valid token kind.  */
-#define YYMAXUTOK   262
+#define YYMAXUTOK   263
 
 
 /* YYTRANSLATE(TOKEN-NUM) -- Symbol number corresponding to TOKEN-NUM
@@ -594,18 +595,18 @@ union yyalloc
 static const yytype_int8 yytranslate[] =
 {
        0,     2,     2,     2,     2,     2,     2,     2,     2,     2,
-      28,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+      29,     2,     2,     2,     2,     2,     2,     2,     2,     2,
        2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
-       2,     2,     2,    25,     2,     2,     2,    10,     4,     2,
-      21,    22,     8,     7,    18,     6,    16,     9,     2,     2,
-       2,     2,     2,     2,     2,     2,     2,     2,    24,    27,
-      26,    17,    23,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,    26,     2,     2,     2,    11,     5,     2,
+      22,    23,     9,     8,    19,     7,    17,    10,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,    25,    28,
+      27,    18,    24,     2,     2,     2,     2,     2,     2,     2,
        2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
        2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
-       2,    19,     2,    20,    11,     2,     2,     2,     2,     2,
+       2,    20,     2,    21,    12,     2,     2,     2,     2,     2,
        2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
        2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
-       2,     2,     2,     2,     5,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     6,     2,     2,     2,     2,     2,
        2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
        2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
        2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
@@ -618,23 +619,23 @@ static const yytype_int8 yytranslate[] =
        2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
        2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
        2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
-       2,     2,     2,     2,     2,     2,     1,     2,     3,    12,
-      13,    14,    15
+       2,     2,     2,     2,     2,     2,     1,     2,     3,     4,
+      13,    14,    15,    16
 };
 
 #if PHRASED_YYDEBUG
 /* YYRLINE[YYN] -- Source line where rule number YYN was defined.  */
 static const yytype_uint8 yyrline[] =
 {
-       0,    92,    92,    93,    94,    95,    96,    97,    98,   101,
-     102,   103,   106,   107,   108,   109,   110,   111,   112,   113,
-     114,   115,   116,   117,   118,   121,   122,   123,   124,   125,
-     126,   127,   128,   129,   130,   131,   132,   133,   134,   135,
-     136,   137,   140,   141,   142,   145,   146,   149,   152,   153,
-     156,   157,   160,   162,   166,   167,   168,   169,   170,   171,
-     172,   173,   174,   182,   183,   184,   185,   197,   198,   201,
-     202,   203,   204,   205,   206,   207,   208,   209,   210,   213,
-     214
+       0,    93,    93,    94,    95,    96,    97,    98,    99,   102,
+     103,   104,   107,   108,   109,   110,   111,   112,   113,   114,
+     115,   116,   117,   118,   119,   122,   123,   124,   125,   126,
+     127,   128,   129,   130,   131,   132,   133,   134,   135,   136,
+     137,   138,   141,   142,   143,   146,   147,   150,   153,   154,
+     157,   158,   161,   163,   167,   168,   169,   170,   171,   172,
+     173,   174,   175,   183,   184,   185,   186,   198,   199,   202,
+     203,   204,   205,   206,   207,   208,   209,   210,   211,   214,
+     215
 };
 #endif
 
@@ -651,8 +652,8 @@ static const char *yysymbol_name (yysymbol_kind_t yysymbol) YY_ATTRIBUTE_UNUSED;
 static const char *const yytname[] =
 {
   "\"end of file\"", "error", "\"invalid token\"",
-  "\"mathematical symbol\"", "'&'", "'|'", "'-'", "'+'", "'*'", "'/'",
-  "'%'", "'^'", "\"number\"", "\"element name\"",
+  "\"mathematical symbol\"", "\"end of line\"", "'&'", "'|'", "'-'", "'+'",
+  "'*'", "'/'", "'%'", "'^'", "\"number\"", "\"element name\"",
   "\"text string in quotes\"", "\"an error\"", "'.'", "'='", "','", "'['",
   "']'", "'('", "')'", "'>'", "':'", "'!'", "'<'", "';'", "'\\n'",
   "$accept", "input", "varOrKeyword", "equals", "changelist", "numlist",
@@ -681,21 +682,21 @@ yysymbol_name (yysymbol_kind_t yysymbol)
    STATE-NUM.  */
 static const yytype_int16 yypact[] =
 {
-     -69,    10,   -69,   -69,   -69,   -69,   -69,   -69,   239,   -22,
-     -22,   -22,   -69,   -69,   -69,    37,    55,   128,    37,   -69,
-      65,    -3,   223,   -69,   -69,   -69,    11,    -3,    62,   -69,
-     -69,   -69,    99,   -69,   139,   -69,    37,    79,    94,   -69,
-     -69,   -69,   -69,   -69,   -69,   -69,   -69,    12,     7,   -69,
-     -69,   -69,    11,   -69,   -69,   110,   110,    32,   -69,   223,
-     -69,   -69,    69,   -69,   -69,   223,   -14,   101,    11,   149,
-      12,   101,    12,   -69,    37,   -69,    88,   120,   110,   110,
-      41,    88,   120,   -69,   223,    37,    23,   110,    11,   101,
-     -69,   111,   223,    37,   110,    12,    37,    90,   241,    88,
-     120,   110,   223,   120,   152,   177,    12,    12,    35,    37,
-     158,   246,   120,   -69,   -69,   -69,    47,    12,     6,   223,
-      37,    12,    37,   253,   -69,   -69,   134,    37,   223,   173,
-     200,    12,    12,   137,    37,   223,   -69,   -69,   -69,    54,
-      12,   223,   -69,   -69
+     -69,    11,   -69,   -69,   -69,   -69,   -69,   -69,   238,    15,
+      15,    15,   -69,   -69,   -69,    23,   127,   156,    23,   -69,
+      -9,    42,   222,   -69,   -69,   -69,     1,    42,    56,   -69,
+     -69,   -69,    98,   -69,   138,   -69,    23,    76,    93,   -69,
+     -69,   -69,   -69,   -69,   -69,   -69,   -69,    -3,     6,   -69,
+     -69,   -69,     1,   -69,   -69,    90,    90,    36,   -69,   222,
+     -69,   -69,     3,   -69,   -69,   222,    49,   100,     1,    55,
+      -3,   100,    -3,   -69,    23,   -69,    24,   104,    90,    90,
+      60,    24,   104,   -69,   222,    23,   110,    90,     1,   100,
+     -69,   157,   222,    23,    90,    -3,    23,    89,    34,    24,
+     104,    90,   222,   104,    68,   176,    -3,    -3,   197,    23,
+      45,   245,   104,   -69,   -69,   -69,    82,    -3,    -2,   222,
+      23,    -3,    23,   252,   -69,   -69,   114,    23,   222,   172,
+     199,    -3,    -3,   220,    23,   222,   -69,   -69,   -69,   134,
+      -3,   222,   -69,   -69
 };
 
 /* YYDEFACT[STATE-NUM] -- Default reduction number in state STATE-NUM.
@@ -724,7 +725,7 @@ static const yytype_int8 yydefact[] =
 static const yytype_int16 yypgoto[] =
 {
      -69,   -69,    -1,   -69,   -68,   -61,   -69,   -69,   -15,   -69,
-     144,    46,   -69,   -69,   126
+     139,    46,   -69,   -69,   126
 };
 
 /* YYDEFGOTO[NTERM-NUM].  */
@@ -739,101 +740,101 @@ static const yytype_int8 yydefgoto[] =
    number is the opposite.  If YYTABLE_NINF, syntax error.  */
 static const yytype_uint8 yytable[] =
 {
-       8,    31,    33,    82,    74,     6,     7,    20,    75,    80,
-       2,     3,   126,    13,    26,    36,    32,    26,    28,    14,
-       4,   100,    16,     4,    29,     5,   103,    16,    18,    64,
-     127,    57,    19,   112,   104,    26,     4,     6,     7,    16,
-      93,    94,    95,    13,    96,     4,   116,    26,    16,    14,
-       4,    16,   117,    70,    67,    68,    71,    83,    18,    72,
-     129,    28,    19,    90,    34,    72,    76,    29,    30,   124,
-      81,   139,    72,    26,    54,    86,   142,    88,    89,    35,
-      91,    16,    59,    60,    26,    97,    98,    72,    99,    73,
+       8,    31,    33,    82,    28,   126,    35,    20,    16,    80,
+      29,     2,     3,    13,    26,    16,    32,    26,    16,    14,
+       4,   100,    72,   127,    73,     4,   103,     5,    18,    64,
+      13,    57,    19,   112,   104,    26,    14,     4,     4,     6,
+       7,    16,    85,     6,     7,    18,   116,    26,     4,    19,
+       4,    16,   109,    16,    67,    68,    71,    83,    70,     4,
+     129,    36,    16,   120,    34,   121,    76,   122,    74,    54,
+      81,   139,    75,    26,    78,    86,    79,    88,    89,    72,
+      91,    60,    59,    90,    26,    97,    98,    72,    99,   113,
       97,   115,    26,    99,    65,    26,   108,   110,   111,    61,
-      99,     4,   125,     4,    16,    85,    16,   106,   118,   123,
+      99,    72,   125,     4,     4,   124,    16,   106,   118,   123,
       97,   107,     4,    55,     4,    16,   138,    16,    56,    26,
-      84,    26,   133,     4,     4,   143,    26,    16,    93,   101,
-      95,    92,    96,    26,    28,    23,    24,    25,    87,   102,
-      29,     4,   105,    37,    38,    39,    40,    41,    42,    43,
-      44,    45,     4,    16,   140,   119,    46,   134,    47,    27,
-      48,    58,    49,     0,    50,    51,   128,    78,   130,    79,
-      72,     4,   113,   135,    16,   120,     0,   121,     0,   122,
+      84,    26,   133,    87,     4,   143,    26,    16,    93,    94,
+      95,    92,    96,    26,    28,    23,    24,    25,   134,   102,
+      29,    30,   105,    37,    38,    39,    40,    41,    42,    43,
+      44,    45,     4,    72,    27,   119,    46,   142,    47,     0,
+      48,    58,    49,    28,    50,    51,   128,     0,   130,    29,
+       4,     4,     0,   135,    16,    93,   101,    95,     0,    96,
      141,    37,    38,    39,    40,    41,    42,    43,    44,    45,
        4,    72,     0,   136,    46,     0,    47,     0,    48,   114,
       49,     0,    50,    51,    37,    38,    39,    40,    41,    42,
-      43,    44,    45,     4,     0,     0,     0,    46,     0,    47,
+      43,    44,    45,     4,    16,   117,     0,    46,     0,    47,
        0,    48,   137,    49,     0,    50,    51,    37,    38,    39,
-      40,    41,    42,    43,    44,    45,     4,     0,     0,     0,
+      40,    41,    42,    43,    44,    45,     4,    16,   140,     0,
       46,     0,    47,     0,    48,    13,    49,     0,    50,    51,
-       0,    14,     4,    15,     4,    16,    17,    16,   109,     4,
+       0,    14,     4,    15,     0,    16,    17,     0,     0,     4,
       18,     0,    16,    93,    19,    95,     4,    96,     0,    16,
      131,     0,     0,     0,   132
 };
 
 static const yytype_int16 yycheck[] =
 {
-       1,    16,    17,    71,    18,    27,    28,     8,    22,    70,
-       0,     1,     6,     6,    15,    18,    17,    18,     6,    12,
-      13,    89,    16,    13,    12,    15,    94,    16,    21,    22,
-      24,    32,    25,   101,    95,    36,    13,    27,    28,    16,
-      17,    18,    19,     6,    21,    13,   107,    48,    16,    12,
-      13,    16,    17,    21,    55,    56,    57,    72,    21,    18,
-     121,     6,    25,    22,    18,    18,    67,    12,    13,    22,
-      71,   132,    18,    74,    12,    76,    22,    78,    79,    14,
-      81,    16,    36,     4,    85,    86,    87,    18,    89,    20,
-      91,   106,    93,    94,    48,    96,    97,    98,    99,     5,
-     101,    13,   117,    13,    16,    17,    16,    17,   109,   110,
-     111,    21,    13,    14,    13,    16,   131,    16,    19,   120,
-      74,   122,   123,    13,    13,   140,   127,    16,    17,    18,
-      19,    85,    21,   134,     6,     9,    10,    11,    18,    93,
-      12,    13,    96,     4,     5,     6,     7,     8,     9,    10,
-      11,    12,    13,    16,    17,   109,    17,    23,    19,    15,
-      21,    22,    23,    -1,    25,    26,   120,    18,   122,    20,
-      18,    13,    20,   127,    16,    17,    -1,    19,    -1,    21,
-     134,     4,     5,     6,     7,     8,     9,    10,    11,    12,
-      13,    18,    -1,    20,    17,    -1,    19,    -1,    21,    22,
-      23,    -1,    25,    26,     4,     5,     6,     7,     8,     9,
-      10,    11,    12,    13,    -1,    -1,    -1,    17,    -1,    19,
-      -1,    21,    22,    23,    -1,    25,    26,     4,     5,     6,
-       7,     8,     9,    10,    11,    12,    13,    -1,    -1,    -1,
-      17,    -1,    19,    -1,    21,     6,    23,    -1,    25,    26,
-      -1,    12,    13,    14,    13,    16,    17,    16,    17,    13,
-      21,    -1,    16,    17,    25,    19,    13,    21,    -1,    16,
-      17,    -1,    -1,    -1,    21
+       1,    16,    17,    71,     7,     7,    15,     8,    17,    70,
+      13,     0,     1,     7,    15,    17,    17,    18,    17,    13,
+      14,    89,    19,    25,    21,    14,    94,    16,    22,    23,
+       7,    32,    26,   101,    95,    36,    13,    14,    14,    28,
+      29,    17,    18,    28,    29,    22,   107,    48,    14,    26,
+      14,    17,    18,    17,    55,    56,    57,    72,    22,    14,
+     121,    19,    17,    18,    18,    20,    67,    22,    19,    13,
+      71,   132,    23,    74,    19,    76,    21,    78,    79,    19,
+      81,     5,    36,    23,    85,    86,    87,    19,    89,    21,
+      91,   106,    93,    94,    48,    96,    97,    98,    99,     6,
+     101,    19,   117,    14,    14,    23,    17,    18,   109,   110,
+     111,    22,    14,    15,    14,    17,   131,    17,    20,   120,
+      74,   122,   123,    19,    14,   140,   127,    17,    18,    19,
+      20,    85,    22,   134,     7,     9,    10,    11,    24,    93,
+      13,    14,    96,     5,     6,     7,     8,     9,    10,    11,
+      12,    13,    14,    19,    15,   109,    18,    23,    20,    -1,
+      22,    23,    24,     7,    26,    27,   120,    -1,   122,    13,
+      14,    14,    -1,   127,    17,    18,    19,    20,    -1,    22,
+     134,     5,     6,     7,     8,     9,    10,    11,    12,    13,
+      14,    19,    -1,    21,    18,    -1,    20,    -1,    22,    23,
+      24,    -1,    26,    27,     5,     6,     7,     8,     9,    10,
+      11,    12,    13,    14,    17,    18,    -1,    18,    -1,    20,
+      -1,    22,    23,    24,    -1,    26,    27,     5,     6,     7,
+       8,     9,    10,    11,    12,    13,    14,    17,    18,    -1,
+      18,    -1,    20,    -1,    22,     7,    24,    -1,    26,    27,
+      -1,    13,    14,    15,    -1,    17,    18,    -1,    -1,    14,
+      22,    -1,    17,    18,    26,    20,    14,    22,    -1,    17,
+      18,    -1,    -1,    -1,    22
 };
 
 /* YYSTOS[STATE-NUM] -- The symbol kind of the accessing symbol of
    state STATE-NUM.  */
 static const yytype_int8 yystos[] =
 {
-       0,    30,     0,     1,    13,    15,    27,    28,    31,    32,
-      35,    36,    43,     6,    12,    14,    16,    17,    21,    25,
-      31,    39,    40,    43,    43,    43,    31,    39,     6,    12,
-      13,    37,    31,    37,    40,    14,    18,     4,     5,     6,
-       7,     8,     9,    10,    11,    12,    17,    19,    21,    23,
-      25,    26,    31,    42,    12,    14,    19,    31,    22,    40,
-       4,     5,    34,    37,    22,    40,    41,    31,    31,    38,
-      21,    31,    18,    20,    18,    22,    31,    33,    18,    20,
-      34,    31,    33,    37,    40,    17,    31,    18,    31,    31,
-      22,    31,    40,    17,    18,    19,    21,    31,    31,    31,
-      33,    18,    40,    33,    34,    40,    17,    21,    31,    17,
-      31,    31,    33,    20,    22,    37,    34,    17,    31,    40,
-      17,    19,    21,    31,    22,    37,     6,    24,    40,    34,
-      40,    17,    21,    31,    23,    40,    20,    22,    37,    34,
-      17,    40,    22,    37
+       0,    31,     0,     1,    14,    16,    28,    29,    32,    33,
+      36,    37,    44,     7,    13,    15,    17,    18,    22,    26,
+      32,    40,    41,    44,    44,    44,    32,    40,     7,    13,
+      14,    38,    32,    38,    41,    15,    19,     5,     6,     7,
+       8,     9,    10,    11,    12,    13,    18,    20,    22,    24,
+      26,    27,    32,    43,    13,    15,    20,    32,    23,    41,
+       5,     6,    35,    38,    23,    41,    42,    32,    32,    39,
+      22,    32,    19,    21,    19,    23,    32,    34,    19,    21,
+      35,    32,    34,    38,    41,    18,    32,    19,    32,    32,
+      23,    32,    41,    18,    19,    20,    22,    32,    32,    32,
+      34,    19,    41,    34,    35,    41,    18,    22,    32,    18,
+      32,    32,    34,    21,    23,    38,    35,    18,    32,    41,
+      18,    20,    22,    32,    23,    38,     7,    25,    41,    35,
+      41,    18,    22,    32,    24,    41,    21,    23,    38,    35,
+      18,    41,    23,    38
 };
 
 /* YYR1[RULE-NUM] -- Symbol kind of the left-hand side of rule RULE-NUM.  */
 static const yytype_int8 yyr1[] =
 {
-       0,    29,    30,    30,    30,    30,    30,    30,    30,    31,
-      31,    31,    32,    32,    32,    32,    32,    32,    32,    32,
-      32,    32,    32,    32,    32,    33,    33,    33,    33,    33,
-      33,    33,    33,    33,    33,    33,    33,    33,    33,    33,
-      33,    33,    34,    34,    34,    35,    35,    36,    37,    37,
-      38,    38,    39,    39,    40,    40,    40,    40,    40,    40,
-      40,    40,    40,    40,    40,    40,    40,    41,    41,    42,
-      42,    42,    42,    42,    42,    42,    42,    42,    42,    43,
-      43
+       0,    30,    31,    31,    31,    31,    31,    31,    31,    32,
+      32,    32,    33,    33,    33,    33,    33,    33,    33,    33,
+      33,    33,    33,    33,    33,    34,    34,    34,    34,    34,
+      34,    34,    34,    34,    34,    34,    34,    34,    34,    34,
+      34,    34,    35,    35,    35,    36,    36,    37,    38,    38,
+      39,    39,    40,    40,    41,    41,    41,    41,    41,    41,
+      41,    41,    41,    41,    41,    41,    41,    42,    42,    43,
+      43,    43,    43,    43,    43,    43,    43,    43,    43,    44,
+      44
 };
 
 /* YYR2[RULE-NUM] -- Number of symbols on the right-hand side of rule RULE-NUM.  */
@@ -1581,361 +1582,361 @@ yyreduce:
   switch (yyn)
     {
   case 3: /* input: input equals lineend  */
-#line 93 "phrasedml.ypp"
-                                     {}
-#line 1587 "phrasedml.tab.cpp"
+#line 94 "phrasedml.ypp"
+                                     {if (g_registry.endStatement((yyvsp[0].character))) YYABORT;}
+#line 1588 "phrasedml.tab.cpp"
     break;
 
   case 4: /* input: input plot lineend  */
-#line 94 "phrasedml.ypp"
-                                   {}
-#line 1593 "phrasedml.tab.cpp"
+#line 95 "phrasedml.ypp"
+                                   {if (g_registry.endStatement((yyvsp[0].character))) YYABORT;}
+#line 1594 "phrasedml.tab.cpp"
     break;
 
   case 5: /* input: input name lineend  */
-#line 95 "phrasedml.ypp"
-                                   {}
-#line 1599 "phrasedml.tab.cpp"
+#line 96 "phrasedml.ypp"
+                                   {if (g_registry.endStatement((yyvsp[0].character))) YYABORT;}
+#line 1600 "phrasedml.tab.cpp"
     break;
 
   case 6: /* input: input lineend  */
-#line 96 "phrasedml.ypp"
+#line 97 "phrasedml.ypp"
                               {}
-#line 1605 "phrasedml.tab.cpp"
+#line 1606 "phrasedml.tab.cpp"
     break;
 
   case 7: /* input: input error  */
-#line 97 "phrasedml.ypp"
+#line 98 "phrasedml.ypp"
                             {YYABORT;}
-#line 1611 "phrasedml.tab.cpp"
+#line 1612 "phrasedml.tab.cpp"
     break;
 
   case 8: /* input: input "an error"  */
-#line 98 "phrasedml.ypp"
+#line 99 "phrasedml.ypp"
                             {YYABORT;}
-#line 1617 "phrasedml.tab.cpp"
+#line 1618 "phrasedml.tab.cpp"
     break;
 
   case 9: /* varOrKeyword: "element name"  */
-#line 101 "phrasedml.ypp"
+#line 102 "phrasedml.ypp"
                            {(yyval.words) = new vector<const string*>; (yyval.words)->push_back((yyvsp[0].word));}
-#line 1623 "phrasedml.tab.cpp"
+#line 1624 "phrasedml.tab.cpp"
     break;
 
   case 10: /* varOrKeyword: varOrKeyword '.' "element name"  */
-#line 102 "phrasedml.ypp"
+#line 103 "phrasedml.ypp"
                                             {(yyval.words) = (yyvsp[-2].words); (yyval.words)->push_back((yyvsp[0].word));}
-#line 1629 "phrasedml.tab.cpp"
+#line 1630 "phrasedml.tab.cpp"
     break;
 
   case 11: /* varOrKeyword: varOrKeyword '.' number  */
-#line 103 "phrasedml.ypp"
+#line 104 "phrasedml.ypp"
                                         {(yyval.words) = (yyvsp[-2].words); (yyval.words)->push_back(g_registry.addWord(DoubleToString((yyvsp[0].number))));}
-#line 1635 "phrasedml.tab.cpp"
+#line 1636 "phrasedml.tab.cpp"
     break;
 
   case 12: /* equals: varOrKeyword '=' varOrKeyword "text string in quotes"  */
-#line 106 "phrasedml.ypp"
+#line 107 "phrasedml.ypp"
                                                          {if (g_registry.addModelDef((yyvsp[-3].words), (yyvsp[-1].words), (yyvsp[0].word))) YYABORT;}
-#line 1641 "phrasedml.tab.cpp"
+#line 1642 "phrasedml.tab.cpp"
     break;
 
   case 13: /* equals: varOrKeyword '=' varOrKeyword "text string in quotes" varOrKeyword changelist  */
-#line 107 "phrasedml.ypp"
+#line 108 "phrasedml.ypp"
                                                                                  {if (g_registry.addModelDef((yyvsp[-5].words), (yyvsp[-3].words), (yyvsp[-2].word), (yyvsp[-1].words), (yyvsp[0].changelist))) YYABORT;}
-#line 1647 "phrasedml.tab.cpp"
+#line 1648 "phrasedml.tab.cpp"
     break;
 
   case 14: /* equals: varOrKeyword '=' varOrKeyword "text string in quotes" varOrKeyword varOrKeyword varOrKeyword  */
-#line 108 "phrasedml.ypp"
+#line 109 "phrasedml.ypp"
                                                                                                 {if (g_registry.addModelDef((yyvsp[-6].words), (yyvsp[-4].words), (yyvsp[-3].word), (yyvsp[-2].words), (yyvsp[-1].words), (yyvsp[0].words))) YYABORT;}
-#line 1653 "phrasedml.tab.cpp"
+#line 1654 "phrasedml.tab.cpp"
     break;
 
   case 15: /* equals: varOrKeyword '=' varOrKeyword "text string in quotes" varOrKeyword varOrKeyword varOrKeyword ',' changelist  */
-#line 109 "phrasedml.ypp"
+#line 110 "phrasedml.ypp"
                                                                                                                {if (g_registry.addModelDef((yyvsp[-8].words), (yyvsp[-6].words), (yyvsp[-5].word), (yyvsp[-4].words), (yyvsp[-3].words), (yyvsp[-2].words), (yyvsp[0].changelist))) YYABORT;}
-#line 1659 "phrasedml.tab.cpp"
+#line 1660 "phrasedml.tab.cpp"
     break;
 
   case 16: /* equals: varOrKeyword '=' varOrKeyword varOrKeyword  */
-#line 110 "phrasedml.ypp"
+#line 111 "phrasedml.ypp"
                                                            {if (g_registry.addEquals((yyvsp[-3].words), (yyvsp[-1].words), (yyvsp[0].words))) YYABORT;}
-#line 1665 "phrasedml.tab.cpp"
+#line 1666 "phrasedml.tab.cpp"
     break;
 
   case 17: /* equals: varOrKeyword '=' varOrKeyword varOrKeyword varOrKeyword changelist  */
-#line 111 "phrasedml.ypp"
+#line 112 "phrasedml.ypp"
                                                                                    {if (g_registry.addEquals((yyvsp[-5].words), (yyvsp[-3].words), (yyvsp[-2].words), (yyvsp[-1].words), (yyvsp[0].changelist))) YYABORT;}
-#line 1671 "phrasedml.tab.cpp"
+#line 1672 "phrasedml.tab.cpp"
     break;
 
   case 18: /* equals: varOrKeyword '=' varOrKeyword varOrKeyword varOrKeyword varOrKeyword  */
-#line 112 "phrasedml.ypp"
+#line 113 "phrasedml.ypp"
                                                                                      {if (g_registry.addEquals((yyvsp[-5].words), (yyvsp[-3].words), (yyvsp[-2].words), (yyvsp[-1].words), (yyvsp[0].words))) YYABORT;}
-#line 1677 "phrasedml.tab.cpp"
+#line 1678 "phrasedml.tab.cpp"
     break;
 
   case 19: /* equals: varOrKeyword '=' varOrKeyword varOrKeyword varOrKeyword varOrKeyword varOrKeyword  */
-#line 113 "phrasedml.ypp"
+#line 114 "phrasedml.ypp"
                                                                                                   {if (g_registry.addEquals((yyvsp[-6].words), (yyvsp[-4].words), (yyvsp[-3].words), (yyvsp[-2].words), (yyvsp[-1].words), (yyvsp[0].words))) YYABORT;}
-#line 1683 "phrasedml.tab.cpp"
+#line 1684 "phrasedml.tab.cpp"
     break;
 
   case 20: /* equals: varOrKeyword '=' varOrKeyword varOrKeyword varOrKeyword varOrKeyword varOrKeyword ',' changelist  */
-#line 114 "phrasedml.ypp"
+#line 115 "phrasedml.ypp"
                                                                                                                  {if (g_registry.addEquals((yyvsp[-8].words), (yyvsp[-6].words), (yyvsp[-5].words), (yyvsp[-4].words), (yyvsp[-3].words), (yyvsp[-2].words))) YYABORT;}
-#line 1689 "phrasedml.tab.cpp"
+#line 1690 "phrasedml.tab.cpp"
     break;
 
   case 21: /* equals: varOrKeyword '=' varOrKeyword '[' taskslist ']' varOrKeyword changelist  */
-#line 115 "phrasedml.ypp"
+#line 116 "phrasedml.ypp"
                                                                                         {if (g_registry.addRepeatedTask((yyvsp[-7].words), (yyvsp[-5].words), (yyvsp[-3].nameslist), (yyvsp[-1].words), (yyvsp[0].changelist))) YYABORT;}
-#line 1695 "phrasedml.tab.cpp"
+#line 1696 "phrasedml.tab.cpp"
     break;
 
   case 22: /* equals: varOrKeyword '=' varOrKeyword varOrKeyword '(' numlist ')'  */
-#line 116 "phrasedml.ypp"
+#line 117 "phrasedml.ypp"
                                                                            {if (g_registry.addEquals((yyvsp[-6].words), (yyvsp[-4].words), (yyvsp[-3].words), (yyvsp[-1].nums))) YYABORT;}
-#line 1701 "phrasedml.tab.cpp"
+#line 1702 "phrasedml.tab.cpp"
     break;
 
   case 23: /* equals: varOrKeyword '=' varOrKeyword  */
-#line 117 "phrasedml.ypp"
+#line 118 "phrasedml.ypp"
                                               {if (g_registry.addEquals((yyvsp[-2].words), (yyvsp[0].words))) YYABORT;}
-#line 1707 "phrasedml.tab.cpp"
+#line 1708 "phrasedml.tab.cpp"
     break;
 
   case 24: /* equals: varOrKeyword '=' number  */
-#line 118 "phrasedml.ypp"
+#line 119 "phrasedml.ypp"
                                               {if (g_registry.addEquals((yyvsp[-2].words), (yyvsp[0].number))) YYABORT;}
-#line 1713 "phrasedml.tab.cpp"
+#line 1714 "phrasedml.tab.cpp"
     break;
 
   case 25: /* changelist: varOrKeyword '=' formula  */
-#line 121 "phrasedml.ypp"
+#line 122 "phrasedml.ypp"
                                          {(yyval.changelist) = new vector<ModelChange>; if (g_registry.addToChangeList((yyval.changelist), (yyvsp[-2].words), (yyvsp[0].wordstr))) YYABORT;}
-#line 1719 "phrasedml.tab.cpp"
+#line 1720 "phrasedml.tab.cpp"
     break;
 
   case 26: /* changelist: varOrKeyword varOrKeyword '=' formula  */
-#line 122 "phrasedml.ypp"
+#line 123 "phrasedml.ypp"
                                                       {(yyval.changelist) = new vector<ModelChange>; if (g_registry.addToChangeList((yyval.changelist), (yyvsp[-3].words), (yyvsp[-2].words), (yyvsp[0].wordstr), true)) YYABORT;}
-#line 1725 "phrasedml.tab.cpp"
+#line 1726 "phrasedml.tab.cpp"
     break;
 
   case 27: /* changelist: varOrKeyword varOrKeyword varOrKeyword '=' number  */
-#line 123 "phrasedml.ypp"
+#line 124 "phrasedml.ypp"
                                                                   {(yyval.changelist) = new vector<ModelChange>; if (g_registry.addToChangeList((yyval.changelist), (yyvsp[-4].words), (yyvsp[-3].words), (yyvsp[-2].words), (yyvsp[0].number))) YYABORT;}
-#line 1731 "phrasedml.tab.cpp"
+#line 1732 "phrasedml.tab.cpp"
     break;
 
   case 28: /* changelist: varOrKeyword varOrKeyword varOrKeyword varOrKeyword '=' number  */
-#line 124 "phrasedml.ypp"
+#line 125 "phrasedml.ypp"
                                                                                {(yyval.changelist) = new vector<ModelChange>; if (g_registry.addToChangeList((yyval.changelist), (yyvsp[-5].words), (yyvsp[-4].words), (yyvsp[-3].words), (yyvsp[-2].words), (yyvsp[0].number))) YYABORT;}
-#line 1737 "phrasedml.tab.cpp"
+#line 1738 "phrasedml.tab.cpp"
     break;
 
   case 29: /* changelist: varOrKeyword varOrKeyword varOrKeyword '(' numlist ')'  */
-#line 125 "phrasedml.ypp"
+#line 126 "phrasedml.ypp"
                                                                        {(yyval.changelist) = new vector<ModelChange>; if (g_registry.addToChangeList((yyval.changelist), (yyvsp[-5].words), (yyvsp[-4].words), (yyvsp[-3].words), (yyvsp[-1].nums))) YYABORT;}
-#line 1743 "phrasedml.tab.cpp"
+#line 1744 "phrasedml.tab.cpp"
     break;
 
   case 30: /* changelist: varOrKeyword varOrKeyword '[' numlist ']'  */
-#line 126 "phrasedml.ypp"
+#line 127 "phrasedml.ypp"
                                                           {(yyval.changelist) = new vector<ModelChange>; if (g_registry.addToChangeList((yyval.changelist), (yyvsp[-4].words), (yyvsp[-3].words), (yyvsp[-1].nums))) YYABORT;}
-#line 1749 "phrasedml.tab.cpp"
+#line 1750 "phrasedml.tab.cpp"
     break;
 
   case 31: /* changelist: varOrKeyword varOrKeyword '(' formula ')'  */
-#line 127 "phrasedml.ypp"
+#line 128 "phrasedml.ypp"
                                                           {(yyval.changelist) = new vector<ModelChange>; if (g_registry.addToChangeList((yyval.changelist), (yyvsp[-4].words), (yyvsp[-3].words), (yyvsp[-1].wordstr), false)) YYABORT;}
-#line 1755 "phrasedml.tab.cpp"
+#line 1756 "phrasedml.tab.cpp"
     break;
 
   case 32: /* changelist: changelist ',' varOrKeyword varOrKeyword  */
-#line 128 "phrasedml.ypp"
+#line 129 "phrasedml.ypp"
                                                          {(yyval.changelist) = (yyvsp[-3].changelist); if (g_registry.addToChangeList((yyval.changelist), (yyvsp[-1].words), (yyvsp[0].words))) YYABORT;}
-#line 1761 "phrasedml.tab.cpp"
+#line 1762 "phrasedml.tab.cpp"
     break;
 
   case 33: /* changelist: changelist ',' varOrKeyword '=' varOrKeyword '-' '>' formula  */
-#line 129 "phrasedml.ypp"
+#line 130 "phrasedml.ypp"
                                                                              {(yyval.changelist) = (yyvsp[-7].changelist); if (g_registry.addMapToChangeList((yyval.changelist), (yyvsp[-5].words), (yyvsp[-3].words), (yyvsp[0].wordstr))) YYABORT;}
-#line 1767 "phrasedml.tab.cpp"
+#line 1768 "phrasedml.tab.cpp"
     break;
 
   case 34: /* changelist: changelist ',' varOrKeyword '=' formula  */
-#line 130 "phrasedml.ypp"
+#line 131 "phrasedml.ypp"
                                                         {(yyval.changelist) = (yyvsp[-4].changelist); if (g_registry.addToChangeList((yyval.changelist), (yyvsp[-2].words), (yyvsp[0].wordstr))) YYABORT;}
-#line 1773 "phrasedml.tab.cpp"
+#line 1774 "phrasedml.tab.cpp"
     break;
 
   case 35: /* changelist: changelist ',' varOrKeyword '=' varOrKeyword ':' formula  */
-#line 131 "phrasedml.ypp"
+#line 132 "phrasedml.ypp"
                                                                          {(yyval.changelist) = (yyvsp[-6].changelist); if (g_registry.addToChangeListFromRange((yyval.changelist), (yyvsp[-4].words), (yyvsp[-2].words), (yyvsp[0].wordstr))) YYABORT;}
-#line 1779 "phrasedml.tab.cpp"
+#line 1780 "phrasedml.tab.cpp"
     break;
 
   case 36: /* changelist: changelist ',' varOrKeyword varOrKeyword '=' formula  */
-#line 132 "phrasedml.ypp"
+#line 133 "phrasedml.ypp"
                                                                      {(yyval.changelist) = (yyvsp[-5].changelist); if (g_registry.addToChangeList((yyval.changelist), (yyvsp[-3].words), (yyvsp[-2].words), (yyvsp[0].wordstr), true)) YYABORT;}
-#line 1785 "phrasedml.tab.cpp"
+#line 1786 "phrasedml.tab.cpp"
     break;
 
   case 37: /* changelist: changelist ',' varOrKeyword varOrKeyword varOrKeyword '=' number  */
-#line 133 "phrasedml.ypp"
+#line 134 "phrasedml.ypp"
                                                                                  {(yyval.changelist) = (yyvsp[-6].changelist); if (g_registry.addToChangeList((yyval.changelist), (yyvsp[-4].words), (yyvsp[-3].words), (yyvsp[-2].words), (yyvsp[0].number))) YYABORT;}
-#line 1791 "phrasedml.tab.cpp"
+#line 1792 "phrasedml.tab.cpp"
     break;
 
   case 38: /* changelist: changelist ',' varOrKeyword varOrKeyword varOrKeyword varOrKeyword '=' number  */
-#line 134 "phrasedml.ypp"
+#line 135 "phrasedml.ypp"
                                                                                               {(yyval.changelist) = (yyvsp[-7].changelist); if (g_registry.addToChangeList((yyval.changelist), (yyvsp[-5].words), (yyvsp[-4].words), (yyvsp[-3].words), (yyvsp[-2].words), (yyvsp[0].number))) YYABORT;}
-#line 1797 "phrasedml.tab.cpp"
+#line 1798 "phrasedml.tab.cpp"
     break;
 
   case 39: /* changelist: changelist ',' varOrKeyword varOrKeyword varOrKeyword '(' numlist ')'  */
-#line 135 "phrasedml.ypp"
+#line 136 "phrasedml.ypp"
                                                                                       {(yyval.changelist) = (yyvsp[-7].changelist); if (g_registry.addToChangeList((yyval.changelist), (yyvsp[-5].words), (yyvsp[-4].words), (yyvsp[-3].words), (yyvsp[-1].nums))) YYABORT;}
-#line 1803 "phrasedml.tab.cpp"
+#line 1804 "phrasedml.tab.cpp"
     break;
 
   case 40: /* changelist: changelist ',' varOrKeyword varOrKeyword '[' numlist ']'  */
-#line 136 "phrasedml.ypp"
+#line 137 "phrasedml.ypp"
                                                                          {(yyval.changelist) = (yyvsp[-6].changelist); if (g_registry.addToChangeList((yyval.changelist), (yyvsp[-4].words), (yyvsp[-3].words), (yyvsp[-1].nums))) YYABORT;}
-#line 1809 "phrasedml.tab.cpp"
+#line 1810 "phrasedml.tab.cpp"
     break;
 
   case 41: /* changelist: changelist ',' varOrKeyword varOrKeyword '(' formula ')'  */
-#line 137 "phrasedml.ypp"
+#line 138 "phrasedml.ypp"
                                                                          {(yyval.changelist) = (yyvsp[-6].changelist); if (g_registry.addToChangeList((yyval.changelist), (yyvsp[-4].words), (yyvsp[-3].words), (yyvsp[-1].wordstr), false)) YYABORT;}
-#line 1815 "phrasedml.tab.cpp"
+#line 1816 "phrasedml.tab.cpp"
     break;
 
   case 42: /* numlist: %empty  */
-#line 140 "phrasedml.ypp"
+#line 141 "phrasedml.ypp"
                             {(yyval.nums) = new vector<double>;}
-#line 1821 "phrasedml.tab.cpp"
+#line 1822 "phrasedml.tab.cpp"
     break;
 
   case 43: /* numlist: number  */
-#line 141 "phrasedml.ypp"
+#line 142 "phrasedml.ypp"
                        {(yyval.nums) = new vector<double>; (yyval.nums)->push_back((yyvsp[0].number));}
-#line 1827 "phrasedml.tab.cpp"
+#line 1828 "phrasedml.tab.cpp"
     break;
 
   case 44: /* numlist: numlist ',' number  */
-#line 142 "phrasedml.ypp"
+#line 143 "phrasedml.ypp"
                                    {(yyval.nums) = (yyvsp[-2].nums); (yyval.nums)->push_back((yyvsp[0].number));}
-#line 1833 "phrasedml.tab.cpp"
+#line 1834 "phrasedml.tab.cpp"
     break;
 
   case 45: /* plot: varOrKeyword vslist  */
-#line 145 "phrasedml.ypp"
+#line 146 "phrasedml.ypp"
                                     {if (g_registry.addOutput((yyvsp[-1].words), (yyvsp[0].wordstrvec))) YYABORT;}
-#line 1839 "phrasedml.tab.cpp"
+#line 1840 "phrasedml.tab.cpp"
     break;
 
   case 46: /* plot: varOrKeyword "text string in quotes" vslist  */
-#line 146 "phrasedml.ypp"
+#line 147 "phrasedml.ypp"
                                                {if (g_registry.addOutput((yyvsp[-2].words), (yyvsp[0].wordstrvec), (yyvsp[-1].word))) YYABORT;}
-#line 1845 "phrasedml.tab.cpp"
+#line 1846 "phrasedml.tab.cpp"
     break;
 
   case 47: /* name: varOrKeyword varOrKeyword "text string in quotes"  */
-#line 149 "phrasedml.ypp"
+#line 150 "phrasedml.ypp"
                                                      {if (g_registry.setName((yyvsp[-2].words), (yyvsp[-1].words), (yyvsp[0].word))) YYABORT;}
-#line 1851 "phrasedml.tab.cpp"
+#line 1852 "phrasedml.tab.cpp"
     break;
 
   case 48: /* number: "number"  */
-#line 152 "phrasedml.ypp"
+#line 153 "phrasedml.ypp"
                     {(yyval.number) = (yyvsp[0].number);}
-#line 1857 "phrasedml.tab.cpp"
+#line 1858 "phrasedml.tab.cpp"
     break;
 
   case 49: /* number: '-' "number"  */
-#line 153 "phrasedml.ypp"
+#line 154 "phrasedml.ypp"
                         {(yyval.number) = -(yyvsp[0].number);}
-#line 1863 "phrasedml.tab.cpp"
+#line 1864 "phrasedml.tab.cpp"
     break;
 
   case 50: /* taskslist: varOrKeyword  */
-#line 156 "phrasedml.ypp"
+#line 157 "phrasedml.ypp"
                              {(yyval.nameslist) = new vector<vector<const string*>*>; (yyval.nameslist)->push_back((yyvsp[0].words));}
-#line 1869 "phrasedml.tab.cpp"
+#line 1870 "phrasedml.tab.cpp"
     break;
 
   case 51: /* taskslist: taskslist ',' varOrKeyword  */
-#line 157 "phrasedml.ypp"
+#line 158 "phrasedml.ypp"
                                            {(yyval.nameslist) = (yyvsp[-2].nameslist); (yyval.nameslist)->push_back((yyvsp[0].words));}
-#line 1875 "phrasedml.tab.cpp"
+#line 1876 "phrasedml.tab.cpp"
     break;
 
   case 52: /* vslist: formula  */
-#line 160 "phrasedml.ypp"
+#line 161 "phrasedml.ypp"
                         {(yyval.wordstrvec) = new vector<vector<string>* >; (yyval.wordstrvec)->push_back((yyvsp[0].wordstr));}
-#line 1881 "phrasedml.tab.cpp"
+#line 1882 "phrasedml.tab.cpp"
     break;
 
   case 53: /* vslist: vslist ',' formula  */
-#line 162 "phrasedml.ypp"
+#line 163 "phrasedml.ypp"
                                    {(yyval.wordstrvec) = (yyvsp[-2].wordstrvec); (yyval.wordstrvec)->push_back((yyvsp[0].wordstr));}
-#line 1887 "phrasedml.tab.cpp"
+#line 1888 "phrasedml.tab.cpp"
     break;
 
   case 54: /* formula: varOrKeyword  */
-#line 166 "phrasedml.ypp"
+#line 167 "phrasedml.ypp"
                              {(yyval.wordstr) = new vector<string>(); (yyval.wordstr)->push_back(getStringFrom((yyvsp[0].words), g_registry.getSeparator())); }
-#line 1893 "phrasedml.tab.cpp"
+#line 1894 "phrasedml.tab.cpp"
     break;
 
   case 55: /* formula: "number"  */
-#line 167 "phrasedml.ypp"
+#line 168 "phrasedml.ypp"
                     {(yyval.wordstr) = new vector<string>(); (yyval.wordstr)->push_back(g_registry.ftoa((yyvsp[0].number))); }
-#line 1899 "phrasedml.tab.cpp"
+#line 1900 "phrasedml.tab.cpp"
     break;
 
   case 56: /* formula: '(' formula ')'  */
-#line 168 "phrasedml.ypp"
+#line 169 "phrasedml.ypp"
                                 {(yyval.wordstr) = (yyvsp[-1].wordstr); (yyval.wordstr)->insert((yyval.wordstr)->begin(), "("); (yyval.wordstr)->push_back(")"); }
-#line 1905 "phrasedml.tab.cpp"
+#line 1906 "phrasedml.tab.cpp"
     break;
 
   case 57: /* formula: '-'  */
-#line 169 "phrasedml.ypp"
+#line 170 "phrasedml.ypp"
                     {(yyval.wordstr) = new vector<string>(); (yyval.wordstr)->push_back("-"); }
-#line 1911 "phrasedml.tab.cpp"
+#line 1912 "phrasedml.tab.cpp"
     break;
 
   case 58: /* formula: '!'  */
-#line 170 "phrasedml.ypp"
+#line 171 "phrasedml.ypp"
                     {(yyval.wordstr) = new vector<string>(); (yyval.wordstr)->push_back("!"); }
-#line 1917 "phrasedml.tab.cpp"
+#line 1918 "phrasedml.tab.cpp"
     break;
 
   case 59: /* formula: formula varOrKeyword  */
-#line 171 "phrasedml.ypp"
+#line 172 "phrasedml.ypp"
                                      {(yyval.wordstr) = (yyvsp[-1].wordstr); (yyval.wordstr)->push_back(getStringFrom((yyvsp[0].words), g_registry.getSeparator())); }
-#line 1923 "phrasedml.tab.cpp"
+#line 1924 "phrasedml.tab.cpp"
     break;
 
   case 60: /* formula: formula "number"  */
-#line 172 "phrasedml.ypp"
+#line 173 "phrasedml.ypp"
                              {(yyval.wordstr) = (yyvsp[-1].wordstr); (yyvsp[-1].wordstr)->push_back(g_registry.ftoa((yyvsp[0].number))); }
-#line 1929 "phrasedml.tab.cpp"
+#line 1930 "phrasedml.tab.cpp"
     break;
 
   case 61: /* formula: formula '(' ')'  */
-#line 173 "phrasedml.ypp"
+#line 174 "phrasedml.ypp"
                                 {(yyval.wordstr) = (yyvsp[-2].wordstr); (yyval.wordstr)->push_back("()");}
-#line 1935 "phrasedml.tab.cpp"
+#line 1936 "phrasedml.tab.cpp"
     break;
 
   case 62: /* formula: formula '(' commaformula ')'  */
-#line 175 "phrasedml.ypp"
+#line 176 "phrasedml.ypp"
                 {
                   (yyval.wordstr) = (yyvsp[-3].wordstr);
                   (yyval.wordstr)->push_back("(");
@@ -1943,29 +1944,29 @@ yyreduce:
                   (yyval.wordstr)->push_back(")");
                   delete (yyvsp[-1].wordstr);
                 }
-#line 1947 "phrasedml.tab.cpp"
+#line 1948 "phrasedml.tab.cpp"
     break;
 
   case 63: /* formula: formula mathThing  */
-#line 182 "phrasedml.ypp"
+#line 183 "phrasedml.ypp"
                                   {(yyval.wordstr) = (yyvsp[-1].wordstr); string mt; mt.push_back((yyvsp[0].character)); (yyvsp[-1].wordstr)->push_back(mt); }
-#line 1953 "phrasedml.tab.cpp"
+#line 1954 "phrasedml.tab.cpp"
     break;
 
   case 64: /* formula: formula '&' '&'  */
-#line 183 "phrasedml.ypp"
+#line 184 "phrasedml.ypp"
                                 {(yyval.wordstr) = (yyvsp[-2].wordstr); (yyvsp[-2].wordstr)->push_back("&&"); }
-#line 1959 "phrasedml.tab.cpp"
+#line 1960 "phrasedml.tab.cpp"
     break;
 
   case 65: /* formula: formula '|' '|'  */
-#line 184 "phrasedml.ypp"
+#line 185 "phrasedml.ypp"
                                 {(yyval.wordstr) = (yyvsp[-2].wordstr); (yyvsp[-2].wordstr)->push_back("||"); }
-#line 1965 "phrasedml.tab.cpp"
+#line 1966 "phrasedml.tab.cpp"
     break;
 
   case 66: /* formula: formula '[' numlist ']'  */
-#line 186 "phrasedml.ypp"
+#line 187 "phrasedml.ypp"
                 {
                   (yyval.wordstr) = (yyvsp[-3].wordstr);
                   (yyval.wordstr)->push_back("[");
@@ -1975,95 +1976,95 @@ yyreduce:
                   (yyval.wordstr)->push_back("]");
                   delete (yyvsp[-1].nums);
                 }
-#line 1979 "phrasedml.tab.cpp"
+#line 1980 "phrasedml.tab.cpp"
     break;
 
   case 67: /* commaformula: formula  */
-#line 197 "phrasedml.ypp"
+#line 198 "phrasedml.ypp"
                         {(yyval.wordstr) = (yyvsp[0].wordstr);}
-#line 1985 "phrasedml.tab.cpp"
+#line 1986 "phrasedml.tab.cpp"
     break;
 
   case 68: /* commaformula: commaformula ',' formula  */
-#line 198 "phrasedml.ypp"
+#line 199 "phrasedml.ypp"
                                          {(yyval.wordstr) = (yyvsp[-2].wordstr); (yyval.wordstr)->push_back(","); (yyval.wordstr)->insert((yyval.wordstr)->end(), (yyvsp[0].wordstr)->begin(), (yyvsp[0].wordstr)->end()); }
-#line 1991 "phrasedml.tab.cpp"
+#line 1992 "phrasedml.tab.cpp"
     break;
 
   case 69: /* mathThing: '+'  */
-#line 201 "phrasedml.ypp"
+#line 202 "phrasedml.ypp"
                     {(yyval.character) = '+';}
-#line 1997 "phrasedml.tab.cpp"
+#line 1998 "phrasedml.tab.cpp"
     break;
 
   case 70: /* mathThing: '-'  */
-#line 202 "phrasedml.ypp"
+#line 203 "phrasedml.ypp"
                     {(yyval.character) = '-';}
-#line 2003 "phrasedml.tab.cpp"
+#line 2004 "phrasedml.tab.cpp"
     break;
 
   case 71: /* mathThing: '*'  */
-#line 203 "phrasedml.ypp"
+#line 204 "phrasedml.ypp"
                     {(yyval.character) = '*';}
-#line 2009 "phrasedml.tab.cpp"
+#line 2010 "phrasedml.tab.cpp"
     break;
 
   case 72: /* mathThing: '/'  */
-#line 204 "phrasedml.ypp"
+#line 205 "phrasedml.ypp"
                     {(yyval.character) = '/';}
-#line 2015 "phrasedml.tab.cpp"
+#line 2016 "phrasedml.tab.cpp"
     break;
 
   case 73: /* mathThing: '^'  */
-#line 205 "phrasedml.ypp"
+#line 206 "phrasedml.ypp"
                     {(yyval.character) = '^';}
-#line 2021 "phrasedml.tab.cpp"
+#line 2022 "phrasedml.tab.cpp"
     break;
 
   case 74: /* mathThing: '>'  */
-#line 206 "phrasedml.ypp"
+#line 207 "phrasedml.ypp"
                     {(yyval.character) = '>';}
-#line 2027 "phrasedml.tab.cpp"
+#line 2028 "phrasedml.tab.cpp"
     break;
 
   case 75: /* mathThing: '<'  */
-#line 207 "phrasedml.ypp"
+#line 208 "phrasedml.ypp"
                     {(yyval.character) = '<';}
-#line 2033 "phrasedml.tab.cpp"
+#line 2034 "phrasedml.tab.cpp"
     break;
 
   case 76: /* mathThing: '!'  */
-#line 208 "phrasedml.ypp"
+#line 209 "phrasedml.ypp"
                     {(yyval.character) = '!';}
-#line 2039 "phrasedml.tab.cpp"
+#line 2040 "phrasedml.tab.cpp"
     break;
 
   case 77: /* mathThing: '%'  */
-#line 209 "phrasedml.ypp"
+#line 210 "phrasedml.ypp"
                     {(yyval.character) = '%';}
-#line 2045 "phrasedml.tab.cpp"
+#line 2046 "phrasedml.tab.cpp"
     break;
 
   case 78: /* mathThing: '='  */
-#line 210 "phrasedml.ypp"
+#line 211 "phrasedml.ypp"
                     {(yyval.character) = '=';}
-#line 2051 "phrasedml.tab.cpp"
+#line 2052 "phrasedml.tab.cpp"
     break;
 
   case 79: /* lineend: ';'  */
-#line 213 "phrasedml.ypp"
-                    {}
-#line 2057 "phrasedml.tab.cpp"
+#line 214 "phrasedml.ypp"
+                    {(yyval.character) = ';';}
+#line 2058 "phrasedml.tab.cpp"
     break;
 
   case 80: /* lineend: '\n'  */
-#line 214 "phrasedml.ypp"
-                     {}
-#line 2063 "phrasedml.tab.cpp"
+#line 215 "phrasedml.ypp"
+                     {(yyval.character) = '\n';}
+#line 2064 "phrasedml.tab.cpp"
     break;
 
 
-#line 2067 "phrasedml.tab.cpp"
+#line 2068 "phrasedml.tab.cpp"
 
       default: break;
     }
@@ -2287,7 +2288,7 @@ yyreturnlab:
   return yyresult;
 }
 
-#line 217 "phrasedml.ypp"
+#line 218 "phrasedml.ypp"
 
 
 
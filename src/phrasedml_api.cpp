@@ -1,6 +1,8 @@
 #include <cassert>
 #include <clocale>
 #include <string>
+#include <sstream>
+#include <locale>
 #include <iostream>
 #include <cstdlib>
 #include <cassert>
@@ -9,6 +11,19 @@
 
 #include "phrasedml_api.h"
 #include "registry.h"
+#include "outputShape.h"
+#include "jobPlanner.h"
+#include "contentHash.h"
+#include "experimentDiff.h"
+#include "editSession.h"
+#include "statementStream.h"
+#include "sbmlLoader.h"
+#include "model.h"
+#include "modelMaterializer.h"
+#include "output.h"
+#include "simulation.h"
+#include "task.h"
+#include "stringx.h"
 #include "phrasedml-namespace.h"
 #include <sbml/SBMLReader.h>
 #include <sbml/SBMLTypes.h>
@@ -87,11 +102,50 @@ LIB_EXTERN void setWorkingDirectory(const char* directory)
 
 LIB_EXTERN bool setReferencedSBML(const char* filename, const char* docstr)
 {
-  SBMLDocument* doc = readSBMLFromString(docstr);
-  g_registry.setReferencedSBML(filename, doc);
+  return setReferencedSBMLBuffer(filename, docstr, strlen(docstr));
+}
+
+LIB_EXTERN bool setReferencedSBMLBuffer(const char* filename, const char* buffer, size_t length)
+{
+  SBMLDocument* doc = readSBMLFromBuffer(buffer, length);
+  g_registry.setReferencedSBML(filename, shared_ptr<const SBMLDocument>(doc));
   return (doc->getErrorLog()->getNumFailsWithSeverity(LIBSBML_SEV_ERROR) == 0);
 }
 
+LIB_EXTERN bool setReferencedSBMLBuffers(int numDocuments, const char** URIs, const char** buffers, const size_t* lengths, bool validate)
+{
+  if (numDocuments < 0) {
+    g_registry.setError("Unable to set a negative number of SBML documents.", 0);
+    return false;
+  }
+  size_t num = static_cast<size_t>(numDocuments);
+  vector<string> uris(URIs, URIs + num);
+  vector<const char*> bufferlist(buffers, buffers + num);
+  vector<size_t> lengthlist(lengths, lengths + num);
+  vector<shared_ptr<const SBMLDocument> > docs;
+  readSBMLFromBuffers(bufferlist, lengthlist, validate, g_registry.getNumThreads(), docs);
+  for (size_t d=0; d<num; d++) {
+    if (docs[d]->getNumErrors(LIBSBML_SEV_ERROR) != 0 || docs[d]->getNumErrors(LIBSBML_SEV_FATAL) != 0) {
+      stringstream err;
+      err << "The SBML document for '" << uris[d] << "' has one or more " << (validate ? "validation " : "") << "errors, so none of the " << num << " documents were set.";
+      g_registry.setError(err.str(), 0);
+      return false;
+    }
+  }
+  g_registry.setReferencedSBML(uris, docs);
+  return true;
+}
+
+LIB_EXTERN void setReferencedSBMLDocument(const char* URI, shared_ptr<const SBMLDocument> document)
+{
+  g_registry.setReferencedSBML(URI, document);
+}
+
+LIB_EXTERN void setReferencedSBMLDocument(const char* URI, unique_ptr<SBMLDocument> document)
+{
+  g_registry.setReferencedSBML(URI, shared_ptr<const SBMLDocument>(move(document)));
+}
+
 LIB_EXTERN void clearReferencedSBML()
 {
   g_registry.clearReferencedSBML();
@@ -102,6 +156,361 @@ LIB_EXTERN void addDotXMLToModelSources(bool force)
   g_registry.addDotXMLToModelSources(force);
 }
 
+LIB_EXTERN int shardRepeatedTask(const char* taskId, int numShards)
+{
+  if (numShards <= 0) {
+    g_registry.setError("Unable to shard a repeated task into fewer than one shard.", 0);
+    return 0;
+  }
+  string oldlocale = setlocale(LC_ALL, NULL);
+  setlocale(LC_ALL, "C");
+  bool error = g_registry.shardRepeatedTask(taskId, static_cast<size_t>(numShards));
+  setlocale(LC_ALL, oldlocale.c_str());
+  if (error) {
+    return 0;
+  }
+  return static_cast<int>(g_registry.getNumShards());
+}
+
+LIB_EXTERN char* getShardPhraSEDML(int shard)
+{
+  if (shard < 0) {
+    g_registry.setError("No such shard:  shards are numbered from zero.", 0);
+    return NULL;
+  }
+  return g_registry.getShardPhraSEDML(static_cast<size_t>(shard));
+}
+
+LIB_EXTERN char* getShardSEDML(int shard)
+{
+  if (shard < 0) {
+    g_registry.setError("No such shard:  shards are numbered from zero.", 0);
+    return NULL;
+  }
+  return g_registry.getShardSEDML(static_cast<size_t>(shard));
+}
+
+LIB_EXTERN int convertCombineArchive(const char* filename)
+{
+  string oldlocale = setlocale(LC_ALL, NULL);
+  setlocale(LC_ALL, "C");
+  bool error = g_registry.convertArchive(filename);
+  setlocale(LC_ALL, oldlocale.c_str());
+  if (error) {
+    return -1;
+  }
+  return static_cast<int>(g_registry.getNumArchiveDocuments());
+}
+
+LIB_EXTERN char* getArchiveDocumentLocation(int document)
+{
+  if (document < 0) {
+    g_registry.setError("No such archive document:  documents are numbered from zero.", 0);
+    return NULL;
+  }
+  return g_registry.getArchiveDocumentLocation(static_cast<size_t>(document));
+}
+
+LIB_EXTERN char* getArchivePhraSEDML(int document)
+{
+  if (document < 0) {
+    g_registry.setError("No such archive document:  documents are numbered from zero.", 0);
+    return NULL;
+  }
+  return g_registry.getArchivePhraSEDML(static_cast<size_t>(document));
+}
+
+static void writeOutputShape(stringstream& stream, const string& type, const OutputShape& shape)
+{
+  stream << type << "\t" << shape.id << "\t" << shape.byteSize << "\t" << (shape.exact ? "exact" : "upperBound");
+  for (size_t d=0; d<shape.dimensions.size(); d++) {
+    stream << "\t" << shape.dimensions[d] << "=" << shape.extents[d];
+  }
+  stream << endl;
+}
+
+LIB_EXTERN char* getOutputShapes()
+{
+  vector<OutputShape> dataGenerators;
+  vector<OutputShape> outputs;
+  if (g_registry.getOutputShapes(dataGenerators, outputs)) {
+    return NULL;
+  }
+  stringstream ret;
+  for (size_t d=0; d<dataGenerators.size(); d++) {
+    writeOutputShape(ret, "dataGenerator", dataGenerators[d]);
+  }
+  for (size_t o=0; o<outputs.size(); o++) {
+    writeOutputShape(ret, "output", outputs[o]);
+  }
+  return g_registry.getCharStar(ret.str().c_str());
+}
+
+LIB_EXTERN void setSimulationCost(int kisao, double secondsPerRun, double secondsPerPoint)
+{
+  g_registry.setRunCost(kisao, secondsPerRun, secondsPerPoint);
+}
+
+LIB_EXTERN void clearSimulationCosts()
+{
+  g_registry.clearRunCosts();
+}
+
+static void writeTaskCost(stringstream& stream, const string& type, const TaskCost& cost)
+{
+  stream << type << "\t" << cost.task << "\t" << cost.numRuns << "\t" << cost.numOutputPoints << "\t" << cost.numRecordedVariables << "\t" << cost.resultBytes << "\t" << cost.seconds << "\t" << (cost.calibrated ? "calibrated" : "uncalibrated") << endl;
+}
+
+LIB_EXTERN char* getCostEstimate()
+{
+  vector<TaskCost> tasks;
+  TaskCost total;
+  if (g_registry.getCostEstimate(tasks, total)) {
+    return NULL;
+  }
+  stringstream ret;
+  ret.imbue(locale::classic());
+  for (size_t t=0; t<tasks.size(); t++) {
+    writeTaskCost(ret, "task", tasks[t]);
+  }
+  writeTaskCost(ret, "total", total);
+  return g_registry.getCharStar(ret.str().c_str());
+}
+
+LIB_EXTERN char* getJobPlan(int maxRuns)
+{
+  if (maxRuns < 0) {
+    g_registry.setError("Unable to plan the jobs for this experiment:  the maximum number of runs must not be negative.", 0);
+    return NULL;
+  }
+  PhrasedJobPlanner planner;
+  if (planner.plan(static_cast<size_t>(maxRuns))) {
+    return NULL;
+  }
+  stringstream ret;
+  const vector<PlannedJob>& jobs = planner.getJobs();
+  for (size_t j=0; j<jobs.size(); j++) {
+    vector<string> tasks(jobs[j].tasks.begin(), jobs[j].tasks.end());
+    vector<string> outputs(jobs[j].outputs.begin(), jobs[j].outputs.end());
+    ret << "job\t" << HashToString(jobs[j].hash) << "\t" << jobs[j].runs.size() << "\t" << jobs[j].task << "\t" << getStringFrom(&tasks, ",") << "\t" << getStringFrom(&outputs, ",") << endl;
+  }
+  ret << "total\t" << planner.getNumJobs() << "\t" << planner.getNumRuns() << endl;
+  return g_registry.getCharStar(ret.str().c_str());
+}
+
+LIB_EXTERN char* getContentHashes()
+{
+  PhrasedContentHasher hasher;
+  stringstream ret;
+  unsigned long long hash;
+  for (size_t m=0; m<g_registry.getNumModels(); m++) {
+    string id = g_registry.getModel(m)->getId();
+    if (hasher.getModelHash(id, hash)) {
+      return NULL;
+    }
+    ret << "model\t" << id << "\t" << HashToString(hash) << endl;
+  }
+  for (size_t s=0; s<g_registry.getNumSimulations(); s++) {
+    string id = g_registry.getSimulation(s)->getId();
+    if (hasher.getSimulationHash(id, hash)) {
+      return NULL;
+    }
+    ret << "simulation\t" << id << "\t" << HashToString(hash) << endl;
+  }
+  for (size_t t=0; t<g_registry.getNumTasks(); t++) {
+    string id = g_registry.getTask(t)->getId();
+    if (hasher.getTaskHash(id, hash)) {
+      return NULL;
+    }
+    ret << "task\t" << id << "\t" << HashToString(hash) << endl;
+  }
+  for (size_t o=0; o<g_registry.getNumOutputs(); o++) {
+    const PhrasedOutput* output = g_registry.getOutput(o);
+    if (hasher.getOutputHash(output, hash)) {
+      return NULL;
+    }
+    ret << "output\t" << output->getId() << "\t" << HashToString(hash) << endl;
+  }
+  return g_registry.getCharStar(ret.str().c_str());
+}
+
+LIB_EXTERN char* getExperimentDiff(const char* before, const char* after)
+{
+  ExperimentSnapshot beforesnapshot, aftersnapshot;
+  char* converted = convertString(before);
+  if (converted == NULL) {
+    g_registry.addErrorPrefix("Unable to convert the earlier version of the experiment:  ");
+    return NULL;
+  }
+  free(converted);
+  if (takeExperimentSnapshot(beforesnapshot)) {
+    return NULL;
+  }
+  converted = convertString(after);
+  if (converted == NULL) {
+    g_registry.addErrorPrefix("Unable to convert the later version of the experiment:  ");
+    return NULL;
+  }
+  free(converted);
+  if (takeExperimentSnapshot(aftersnapshot)) {
+    return NULL;
+  }
+  vector<ExperimentDifference> differences;
+  diffExperimentSnapshots(beforesnapshot, aftersnapshot, differences);
+  stringstream ret;
+  for (size_t d=0; d<differences.size(); d++) {
+    ret << getDiffStatusString(differences[d].status) << "\t" << differences[d].kind << "\t" << differences[d].id << "\t" << differences[d].oldId << "\t" << getStringFrom(&differences[d].causes, ",") << endl;
+  }
+  return g_registry.getCharStar(ret.str().c_str());
+}
+
+static PhrasedEditSession g_editSession;
+
+LIB_EXTERN bool setEditedPhraSEDML(const char* phrasedml)
+{
+  string oldlocale = setlocale(LC_ALL, NULL);
+  setlocale(LC_ALL, "C");
+  bool error = g_editSession.setText(phrasedml);
+  setlocale(LC_ALL, oldlocale.c_str());
+  return !error;
+}
+
+LIB_EXTERN bool editPhraSEDML(int firstLine, int numLines, const char* text)
+{
+  if (firstLine < 1 || numLines < 0) {
+    g_registry.setError("Unable to edit the document:  lines are counted from 1, and at least zero lines must be replaced.", 0);
+    return false;
+  }
+  string oldlocale = setlocale(LC_ALL, NULL);
+  setlocale(LC_ALL, "C");
+  bool error = g_editSession.edit(static_cast<size_t>(firstLine), static_cast<size_t>(numLines), text);
+  setlocale(LC_ALL, oldlocale.c_str());
+  return !error;
+}
+
+LIB_EXTERN void setNumThreads(int numThreads)
+{
+  g_registry.setNumThreads(numThreads > 0 ? static_cast<size_t>(numThreads) : 0);
+}
+
+LIB_EXTERN void setStructuralConversion(bool structural)
+{
+  g_registry.setStructural(structural);
+}
+
+LIB_EXTERN void setFormulaCacheSize(int maxFormulas)
+{
+  g_registry.setFormulaCacheSize(maxFormulas > 0 ? static_cast<size_t>(maxFormulas) : 0);
+}
+
+struct StatementCallbackData
+{
+  phrased_statement_callback callback;
+  void* userData;
+};
+
+static bool passStatement(const ParsedStatement& statement, void* userData)
+{
+  StatementCallbackData* data = static_cast<StatementCallbackData*>(userData);
+  return !data->callback(getStatementTypeString(statement.type).c_str(), statement.id.c_str(), statement.line, statement.phrasedml.c_str(), data->userData);
+}
+
+LIB_EXTERN bool streamPhraSEDMLFile(const char* filename, phrased_statement_callback callback, void* userData)
+{
+  StatementCallbackData data;
+  data.callback = callback;
+  data.userData = userData;
+  string oldlocale = setlocale(LC_ALL, NULL);
+  setlocale(LC_ALL, "C");
+  bool error = g_registry.streamFile(filename, passStatement, &data);
+  setlocale(LC_ALL, oldlocale.c_str());
+  return !error;
+}
+
+LIB_EXTERN bool streamPhraSEDMLString(const char* phrasedml, phrased_statement_callback callback, void* userData)
+{
+  StatementCallbackData data;
+  data.callback = callback;
+  data.userData = userData;
+  istringstream stream(string(phrasedml) + "\n");
+  string oldlocale = setlocale(LC_ALL, NULL);
+  setlocale(LC_ALL, "C");
+  bool error = g_registry.streamStatements(&stream, passStatement, &data);
+  setlocale(LC_ALL, oldlocale.c_str());
+  return !error;
+}
+
+LIB_EXTERN bool finalizeStreamedPhraSEDML()
+{
+  string oldlocale = setlocale(LC_ALL, NULL);
+  setlocale(LC_ALL, "C");
+  bool error = g_registry.finalizeParsedStatements();
+  setlocale(LC_ALL, oldlocale.c_str());
+  return !error;
+}
+
+static PhrasedModelMaterializer g_materializer;
+
+LIB_EXTERN shared_ptr<const SBMLDocument> getMaterializedModel(const char* modelId)
+{
+  shared_ptr<const SBMLDocument> doc;
+  string oldlocale = setlocale(LC_ALL, NULL);
+  setlocale(LC_ALL, "C");
+  g_materializer.materialize(modelId, doc);
+  setlocale(LC_ALL, oldlocale.c_str());
+  return doc;
+}
+
+LIB_EXTERN char* materializeModel(const char* modelId)
+{
+  shared_ptr<const SBMLDocument> doc = getMaterializedModel(modelId);
+  if (!doc) {
+    return NULL;
+  }
+  string oldlocale = setlocale(LC_ALL, NULL);
+  setlocale(LC_ALL, "C");
+  SBMLWriter writer;
+  char* sbml = writer.writeSBMLToString(doc.get());
+  setlocale(LC_ALL, oldlocale.c_str());
+  char* ret = g_registry.getCharStar(sbml);
+  free(sbml);
+  return ret;
+}
+
+LIB_EXTERN bool writeMaterializedModel(const char* modelId, const char* filename)
+{
+  shared_ptr<const SBMLDocument> doc = getMaterializedModel(modelId);
+  if (!doc) {
+    return false;
+  }
+  string oldlocale = setlocale(LC_ALL, NULL);
+  setlocale(LC_ALL, "C");
+  SBMLWriter writer;
+  bool written = writer.writeSBML(doc.get(), string(filename));
+  setlocale(LC_ALL, oldlocale.c_str());
+  if (!written) {
+    g_registry.setError("Unable to write the model '" + string(modelId) + "' to the file '" + filename + "'.", 0);
+  }
+  return written;
+}
+
+LIB_EXTERN bool writeMaterializedModel(const char* modelId, ostream& stream)
+{
+  shared_ptr<const SBMLDocument> doc = getMaterializedModel(modelId);
+  if (!doc) {
+    return false;
+  }
+  string oldlocale = setlocale(LC_ALL, NULL);
+  setlocale(LC_ALL, "C");
+  SBMLWriter writer;
+  bool written = writer.writeSBML(doc.get(), stream);
+  setlocale(LC_ALL, oldlocale.c_str());
+  if (!written) {
+    g_registry.setError("Unable to write the model '" + string(modelId) + "'.", 0);
+  }
+  return written;
+}
+
 LIB_EXTERN void freeAllPhrased()
 {
   g_registry.freeAllPhrased();
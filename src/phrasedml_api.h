@@ -36,6 +36,8 @@
 #define LIBPHRASEDML_VERSION_STRING "v1.1.0"
 #endif
 
+#include <stddef.h>
+
 #include "libutil.h"
 #include "phrasedml-namespace.h"
 
@@ -125,6 +127,35 @@ LIB_EXTERN void setWorkingDirectory(const char* directory);
  */
 LIB_EXTERN bool setReferencedSBML(const char* URI, const char* sbmlstring);
 
+/**
+ * As setReferencedSBML(), but reading the SBML from the first @p length characters of @p buffer, which need not be NUL-terminated, such as part of a larger file read or mapped into memory.  The buffer is only read during the call, and is copied just once on its way to the SBML parser, which for very large models uses less memory than setReferencedSBML().
+ *
+ * @param URI the string that, when used in phrasedml, should reference the SBML in @p buffer.
+ * @param buffer the SBML document, as XML.
+ * @param length the number of characters of @p buffer to read.
+ *
+ * @return a boolean indicating whether the document is valid SBML or not.  Either way, the document is saved as the reference document for the given filename string.
+ */
+LIB_EXTERN bool setReferencedSBMLBuffer(const char* URI, const char* buffer, size_t length);
+
+/**
+ * As setReferencedSBMLBuffer(), but for many documents at once, which are parsed in parallel (see setNumThreads()).  Either every document is set, replacing any set before for the same URI, or, if any has errors, none are.
+ *
+ * @param numDocuments the number of documents.
+ * @param URIs the filename or URI of each document.
+ * @param buffers the SBML of each document, which need not be NUL-terminated.
+ * @param lengths the length of each buffer.
+ * @param validate whether to also run libSBML's full consistency checks on each document, which takes longer, but catches more problems.  Documents that fail them are treated as having errors.
+ *
+ * @return 'true' if every document was read without errors, and set, or 'false' if none were set because of an error, which can be retrieved with
+ * @if python
+ * getLastError().
+ * @else
+ * getLastPhrasedError().
+ * @endif
+ */
+LIB_EXTERN bool setReferencedSBMLBuffers(int numDocuments, const char** URIs, const char** buffers, const size_t* lengths, bool validate);
+
 /**
  * Clears and removes all referenced SBML documents.
  */
@@ -135,6 +166,248 @@ LIB_EXTERN void clearReferencedSBML();
  */
 LIB_EXTERN void addDotXMLToModelSources(bool force=false);
 
+/**
+ * Splits the repeated task @p taskId from the last successful conversion into @p numShards standalone documents, so that a large parameter scan can be run on several machines at once.  Each document runs a disjoint, contiguous slice of the repeated task's range, in order:  vector ranges are split, uniform ranges are re-based so they start and end on the values of their slice, and functional ranges are kept as they are.  Each document contains only the models, simulations, and tasks needed to run the repeated task, which keeps its original ID.  Outputs that only use data from the repeated task are kept as reports with the same IDs in every shard, so their results can be concatenated in shard order; other outputs are dropped (with a warning).  If the repeated task has fewer iterations than @p numShards, one shard per iteration is created.  Retrieve the documents with getShardPhraSEDML() or getShardSEDML().
+ *
+ * @param taskId the ID of the repeated task to shard.
+ * @param numShards the number of documents to create.
+ *
+ * @return the number of shards created, or 0 if an error occurred, which can be retrieved with
+ * @if python
+ * getLastError().
+ * @else
+ * getLastPhrasedError().
+ * @endif
+ */
+LIB_EXTERN int shardRepeatedTask(const char* taskId, int numShards);
+
+/**
+ * Returns the phraSED-ML of shard number @p shard (starting from zero) from the last call to shardRepeatedTask(), or NULL if there is no such shard.
+ */
+LIB_EXTERN char* getShardPhraSEDML(int shard);
+
+/**
+ * Returns the SED-ML of shard number @p shard (starting from zero) from the last call to shardRepeatedTask(), or NULL if there is no such shard.
+ */
+LIB_EXTERN char* getShardSEDML(int shard);
+
+/**
+ * Converts every SED-ML document in the COMBINE archive (.omex file) @p filename to phraSED-ML, without unpacking it to disk.  The documents are those the archive's manifest lists as SED-ML (or, if it has no manifest, those ending in '.sedml').  Model sources are found in the archive, relative to the document that uses them, instead of in the working directory; models set with setReferencedSBML() are still used first.  The archive's documents are read, and each SBML model in it is indexed, in parallel (see setNumThreads()), and each model is indexed only once, no matter how many documents use it.  Retrieve the results with getArchiveDocumentLocation() and getArchivePhraSEDML().  Afterwards, the last conversion is that of the last document in the archive.
+ *
+ * @param filename the archive.  Only archives in the plain zip format (with entries stored or deflated) can be read.
+ *
+ * @return the number of SED-ML documents converted, or -1 if any could not be converted or an error occurred, which can be retrieved with
+ * @if python
+ * getLastError().
+ * @else
+ * getLastPhrasedError().
+ * @endif
+ */
+LIB_EXTERN int convertCombineArchive(const char* filename);
+
+/**
+ * Returns the location in the archive of document number @p document (starting from zero) from the last call to convertCombineArchive(), or NULL if there is no such document.
+ */
+LIB_EXTERN char* getArchiveDocumentLocation(int document);
+
+/**
+ * Returns the phraSED-ML of document number @p document (starting from zero) from the last call to convertCombineArchive(), or NULL if there is no such document.
+ */
+LIB_EXTERN char* getArchivePhraSEDML(int document);
+
+/**
+ * Returns the shape of the results of every data generator and output from the last successful conversion, so that result arrays can be allocated before a simulation is run.  Each line describes one element, as tab-separated fields:  'dataGenerator' or 'output', its ID, its size in bytes (at eight bytes per value), 'exact' or 'upperBound', and then one 'dimension=extent' field per dimension, outermost first.  The dimensions of a data generator are the repeated tasks its results are nested in (by iteration), then the simulation's time points:  a uniform time course has one more point than its number of steps, a one-step simulation has two, and a steady state has one.  An output's first dimension is its datasets, curves, or surfaces, and its size is that of the data generators it uses.  If subtasks of a repeated task differ in shape, each extent is the largest of them, and the shape is marked 'upperBound'.
+ *
+ * @return the shapes, or NULL if an error occurred, which can be retrieved with
+ * @if python
+ * getLastError().
+ * @else
+ * getLastPhrasedError().
+ * @endif
+ */
+LIB_EXTERN char* getOutputShapes();
+
+/**
+ * Calibrates the cost estimates from getCostEstimate() with measured timings:  simulations using the algorithm with KiSAO ID @p kisao (such as 19 for CVODE) are expected to take @p secondsPerRun, plus @p secondsPerPoint for each output point.  A @p kisao of 0 sets the cost for any algorithm without a cost of its own.  Costs are kept across conversions until clearSimulationCosts() is called.
+ */
+LIB_EXTERN void setSimulationCost(int kisao, double secondsPerRun, double secondsPerPoint);
+
+/**
+ * Clears all costs set with setSimulationCost().
+ */
+LIB_EXTERN void clearSimulationCosts();
+
+/**
+ * Returns an estimate of what running every task from the last successful conversion would take, so that very large experiments can be rejected or split (for example with shardRepeatedTask()) before they are run.  Each line describes one task, as tab-separated fields:  'task', its ID, the number of simulation runs, the total number of output points, the number of variables the outputs record from it, the size of those results in bytes (at eight bytes per value), the estimated time in seconds, and 'calibrated' or 'uncalibrated'.  A final line starting with 'total' sums them up.  The time is only 'calibrated' if every simulation uses an algorithm whose cost was set with setSimulationCost(); otherwise the time given for it is zero.
+ *
+ * @return the estimate, or NULL if an error occurred, which can be retrieved with
+ * @if python
+ * getLastError().
+ * @else
+ * getLastPhrasedError().
+ * @endif
+ */
+LIB_EXTERN char* getCostEstimate();
+
+/**
+ * Expands every task from the last successful conversion into the individual simulation runs it performs, and collapses runs that are identical (the same model source and changes, the same values set by repeated tasks, and the same simulation settings), even if they come from different tasks.  Each line describes one distinct job, as tab-separated fields:  'job', its canonical hash (16 hexadecimal digits), the number of runs it stands for, the (non-repeated) task it runs, a comma-separated list of the tasks whose results include it, and a comma-separated list of the outputs that use those tasks.  A final line gives 'total', the number of distinct jobs, and the number of runs before collapsing.  Runs that continue from the model state of the run before them are only identical if that run was, too, and runs of stochastic simulations are never collapsed.
+ *
+ * @param maxRuns the largest number of runs to expand; experiments with more are an error.
+ *
+ * @return the plan, or NULL if an error occurred, which can be retrieved with
+ * @if python
+ * getLastError().
+ * @else
+ * getLastPhrasedError().
+ * @endif
+ */
+LIB_EXTERN char* getJobPlan(int maxRuns);
+
+/**
+ * Returns a stable hash of the content of every model, simulation, task, and output from the last successful conversion, suitable as a key for caching their results across edits of the experiment.  Hashes do not depend on the IDs or names of the elements, nor on how they were written:  a model is hashed by the content of its source file (or the hash of the model it is based on) and its changes, a simulation by its type, times, algorithm, and algorithm parameters, a task by the hashes of its model and simulation, a repeated task by the hashes of its subtasks and its changes, and an output by its formulas, with the tasks they reference replaced by their hashes.  Each line gives the type of the element ('model', 'simulation', 'task', or 'output'), its ID, and its hash (16 hexadecimal digits), separated by tabs.
+ *
+ * @return the hashes, or NULL if an error occurred, which can be retrieved with
+ * @if python
+ * getLastError().
+ * @else
+ * getLastPhrasedError().
+ * @endif
+ */
+LIB_EXTERN char* getContentHashes();
+
+/**
+ * Converts two versions of an experiment (each either phraSED-ML or SED-ML) and reports which of their models, simulations, tasks, repeated tasks, and outputs differ in meaning, so that only the results that depend on them need to be calculated again.  Elements are matched by ID and compared by their content hashes (see getContentHashes), so a change to a model or simulation also changes every task and output that uses it.  Each line describes one element that differs, as tab-separated fields:  its status ('added', 'removed', 'changed', or 'renamed'), its kind ('model', 'simulation', 'task', 'repeatedTask', or 'output'), its ID, its old ID (for renamed elements only), and a comma-separated list of the dependencies that caused it to change (for changed elements only; if empty, the element's own definition changed).  Elements that are the same in both versions are not listed.  Afterwards, the last conversion is that of the second version.
+ *
+ * @param before the earlier version of the experiment.
+ * @param after the later version of the experiment.
+ *
+ * @return the differences, or NULL if either version could not be converted or an error occurred, which can be retrieved with
+ * @if python
+ * getLastError().
+ * @else
+ * getLastPhrasedError().
+ * @endif
+ */
+LIB_EXTERN char* getExperimentDiff(const char* before, const char* after);
+
+/**
+ * Starts an editing session for the phraSED-ML document @p phrasedml, for editors that convert the document again every time it is changed.  The document is converted as with convertString, and the results can be retrieved in the same way (with getLastSEDML(), getLastPhraSEDML(), getPhrasedWarnings(), etc.).  Subsequent changes should then be made with editPhraSEDML().
+ *
+ * @param phrasedml the phraSED-ML document.  SED-ML cannot be edited this way.
+ *
+ * @return 'true' if the document was converted, or 'false' if an error occurred, which can be retrieved with
+ * @if python
+ * getLastError().
+ * @else
+ * getLastPhrasedError().
+ * @endif
+ */
+LIB_EXTERN bool setEditedPhraSEDML(const char* phrasedml);
+
+/**
+ * Replaces lines of the document from setEditedPhraSEDML(), and converts it again.  Only the statements that changed are parsed again, along with any statements that mention an ID they define (so that editing a simulation re-creates the tasks that use it, but not the models).  The SED-ML itself is only re-created when next retrieved.  If the last edit failed, or if any other conversion happened in between, the whole document is parsed again.
+ *
+ * @param firstLine the first line to replace, counting from 1.
+ * @param numLines the number of lines to replace.  If 0, @p text is inserted before @p firstLine.
+ * @param text the new lines, separated by newlines.  If empty, the lines are deleted.
+ *
+ * @return 'true' if the edited document was converted, or 'false' if an error occurred, which can be retrieved with
+ * @if python
+ * getLastError().
+ * @else
+ * getLastPhrasedError().
+ * @endif
+ */
+LIB_EXTERN bool editPhraSEDML(int firstLine, int numLines, const char* text);
+
+/**
+ * Sets how many threads are used to check the elements of an experiment against each other after it has been parsed, which for experiments with many model changes or outputs is most of the time taken by a conversion, and to read SBML models in bulk (with setReferencedSBMLBuffers() and convertCombineArchive()).  Any errors and warnings are the same as if only one thread had been used.
+ *
+ * @param numThreads the number of threads to use, or 0 (the default) for one per processor core.
+ */
+LIB_EXTERN void setNumThreads(int numThreads);
+
+/**
+ * Sets whether conversions are purely structural, translating the syntax alone without ever loading the models, for when they are unavailable or not needed.  Model elements are then referenced by generic XPaths (of the form "/sbml:sbml/sbml:model/descendant::*[@id='S1']"), and none are checked to exist, so that a conversion takes no longer for a large model than for a small one.  Because the attribute holding an element's value can't be known, a change to a value in a model becomes a ComputeChange to a constant, instead of a ChangeAttribute.  Models set with setReferencedSBML() and those in COMBINE archives are not used, either.
+ *
+ * @param structural 'true' to convert without loading models, or 'false' (the default) to load and check them.
+ */
+LIB_EXTERN void setStructuralConversion(bool structural);
+
+/**
+ * Sets how many formulas are kept once parsed, so that any formula used again, in the same conversion or a later one, is copied instead of parsed again.  When the limit is reached, the formula used longest ago is dropped.
+ *
+ * @param maxFormulas the most formulas to keep (10000 by default), or 0 to parse every formula afresh.
+ */
+LIB_EXTERN void setFormulaCacheSize(int maxFormulas);
+
+/**
+ * A function to be given each statement of a phraSED-ML document as soon as it is parsed:  the type of the statement ('model', 'simulation', 'task', 'repeatedTask', 'output', 'name', or 'algorithm'), the ID of the element it defined or changed (outputs are given the IDs they will have in the SED-ML), the line it ends on, that element as phraSED-ML, and the @p userData given to streamPhraSEDMLFile() or streamPhraSEDMLString().  The strings are only valid during the call.  Nothing defined after the statement has been checked yet, and any element may still be found to be invalid by finalizeStreamedPhraSEDML().  Return 'false' to stop parsing.
+ */
+typedef bool (*phrased_statement_callback)(const char* type, const char* id, int line, const char* phrasedml, void* userData);
+
+/**
+ * Parses the phraSED-ML file @p filename a line at a time, passing each statement to @p callback as soon as it has been parsed, so that the caller can start working with (for example) the models before the rest of the file has been read.  Models start loading in the background as they are parsed, but nothing is checked against anything defined after it:  once this returns, call finalizeStreamedPhraSEDML() to check the whole experiment and create its SED-ML.  SED-ML files cannot be streamed.
+ *
+ * @param filename the phraSED-ML file to parse.  Models are found relative to its directory.
+ * @param callback the function to be given each statement.
+ * @param userData passed to every call of @p callback.
+ *
+ * @return 'true' if every statement was parsed, or 'false' if an error occurred or @p callback stopped parsing.  The error can be retrieved with
+ * @if python
+ * getLastError().
+ * @else
+ * getLastPhrasedError().
+ * @endif
+ */
+LIB_EXTERN bool streamPhraSEDMLFile(const char* filename, phrased_statement_callback callback, void* userData);
+
+/**
+ * As streamPhraSEDMLFile(), but parsing the phraSED-ML in @p phrasedml.  Models are found relative to the working directory.
+ */
+LIB_EXTERN bool streamPhraSEDMLString(const char* phrasedml, phrased_statement_callback callback, void* userData);
+
+/**
+ * Checks every statement parsed by the last call to streamPhraSEDMLFile() or streamPhraSEDMLString() against the others (that the models, simulations, and tasks they use exist, that the variables they change are in their models, etc.), as the last step of any conversion.  Afterwards, the experiment can be retrieved like the results of any other conversion, with getLastSEDML(), getLastPhraSEDML(), etc.
+ *
+ * @return 'true' if the experiment is valid, or 'false' if an error occurred, which can be retrieved with
+ * @if python
+ * getLastError().
+ * @else
+ * getLastPhrasedError().
+ * @endif
+ */
+LIB_EXTERN bool finalizeStreamedPhraSEDML();
+
+/**
+ * Retrieves the SBML of a model from the last conversion, with every change the experiment makes to it (and to any model it is based on) already applied, for simulators that need the model as it is to be simulated instead of as a model plus a list of SED-ML changes.  Values are set in the same attributes the SED-ML would change, and formulas are evaluated in order, with the values set by any changes before them.  Each SBML file is only read once for all the models that use it, and its elements are only looked up once, but the result is not kept:  every call for a model with changes returns a new copy of the whole document, so for a large model, keep the result rather than asking for it again.  Local variables set to a number can be used by any formula of the model, as in the SED-ML.  Not available after a structural conversion, which never loads the models.
+ *
+ * @param modelId the ID of the model in the phraSED-ML or SED-ML.
+ *
+ * @return the SBML of the model as a string, or NULL if an error occurred, which can be retrieved with
+ * @if python
+ * getLastError().
+ * @else
+ * getLastPhrasedError().
+ * @endif
+ */
+LIB_EXTERN char* materializeModel(const char* modelId);
+
+/**
+ * As materializeModel(), but writing the SBML straight to the file @p filename, without creating it as a string first.
+ *
+ * @param modelId the ID of the model in the phraSED-ML or SED-ML.
+ * @param filename the file to write the SBML to.
+ *
+ * @return 'true' if the file was written, or 'false' if an error occurred, which can be retrieved with
+ * @if python
+ * getLastError().
+ * @else
+ * getLastPhrasedError().
+ * @endif
+ */
+LIB_EXTERN bool writeMaterializedModel(const char* modelId, const char* filename);
+
 /**
  * Frees all pointers handed to you by libphraSEDML.
  * All libphraSEDML functions above that return pointers return malloc'ed pointers that you now own.  If you wish, you can ignore this and never free anything, as long as you call 'freeAllPhrased' at the very end of your program.  If you free *anything* yourself, however, calling this function will cause the program to crash!  It won't know that you already freed that pointer, and will attempt to free it again.  So either keep track of all memory management yourself, or only use this function every time you want to clean up memory.
@@ -151,4 +424,49 @@ LIB_EXTERN void setWriteSEDMLTimestamp(bool writeTimestamp);
 PHRASEDML_CPP_NAMESPACE_END
 END_C_DECLS
 
+#if defined(__cplusplus) && !defined(SWIG)
+#include <memory>
+#include <ostream>
+#include "sbml/SBMLDocument.h"
+
+PHRASEDML_CPP_NAMESPACE_BEGIN
+
+/**
+ * As setReferencedSBML(), but for programs that already hold the model as a libSBML document, which is then used as it is, instead of being written out as a string and parsed again.  The document is shared, not copied:  phraSED-ML keeps a reference to it until it is replaced, or clearReferencedSBML() is called, and never changes it, so the caller must not change it either while it is shared.  Only available from C++.
+ *
+ * @param URI the filename or URI that phraSED-ML and SED-ML documents will use to refer to the model.
+ * @param document the model.
+ */
+LIB_EXTERN void setReferencedSBMLDocument(const char* URI, std::shared_ptr<const libsbml::SBMLDocument> document);
+
+/**
+ * As the other setReferencedSBMLDocument(), but handing the document over to phraSED-ML, which deletes it once it is replaced or cleared.  Only available from C++.
+ *
+ * @param URI the filename or URI that phraSED-ML and SED-ML documents will use to refer to the model.
+ * @param document the model.
+ */
+LIB_EXTERN void setReferencedSBMLDocument(const char* URI, std::unique_ptr<libsbml::SBMLDocument> document);
+
+/**
+ * As materializeModel(), but returning the model as a libSBML document.  A model with no changes shares the document read for its file (or given to setReferencedSBMLDocument()), which must not be changed; copy it first, if need be.  Only available from C++.
+ *
+ * @param modelId the ID of the model in the phraSED-ML or SED-ML.
+ *
+ * @return the model, or an empty pointer if an error occurred.
+ */
+LIB_EXTERN std::shared_ptr<const libsbml::SBMLDocument> getMaterializedModel(const char* modelId);
+
+/**
+ * As writeMaterializedModel(), but writing the SBML to @p stream.  Only available from C++.
+ *
+ * @param modelId the ID of the model in the phraSED-ML or SED-ML.
+ * @param stream the stream to write the SBML to.
+ *
+ * @return 'true' if the model was written, or 'false' if an error occurred.
+ */
+LIB_EXTERN bool writeMaterializedModel(const char* modelId, std::ostream& stream);
+
+PHRASEDML_CPP_NAMESPACE_END
+#endif
+
 #endif //PHRASEDML_API_H
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <cassert>
 #include <vector>
 #include <string>
@@ -6,6 +7,8 @@
 #include <fstream>
 
 #include "registry.h"
+#include "combineArchive.h"
+#include "compressedInput.h"
 #include "stringx.h"
 #include "model.h"
 #include "repeatedTask.h"
@@ -15,6 +18,9 @@
 #include "oneStep.h"
 #include "output.h"
 #include "sbmlx.h"
+#include "iterationSpace.h"
+#include "outputShape.h"
+#include "parallelJobs.h"
 
 #include "sedml/SedDocument.h"
 
@@ -45,7 +51,35 @@ Registry::Registry()
   , m_repeatedTasks()
   , m_outputs()
   , m_referencedSBML()
+  , m_referencedIndexes()
+  , m_pendingSBML()
+  , m_archive(NULL)
+  , m_archiveDirectory()
+  , m_archiveLocations()
+  , m_archivePhraSEDML()
   , m_l3ps()
+  , m_formulaCache()
+  , m_shardPhraSEDML()
+  , m_shardSEDML()
+  , m_runCosts()
+  , m_finalizedModels(0)
+  , m_finalizedSimulations(0)
+  , m_finalizedTasks(0)
+  , m_finalizedRepeatedTasks(0)
+  , m_finalizedOutputs(0)
+  , m_deferFinalize(false)
+  , m_sedmlStale(false)
+  , m_revision(0)
+  , m_statementCallback(NULL)
+  , m_statementUserData(NULL)
+  , m_streamedModels(0)
+  , m_streamedSimulations(0)
+  , m_streamedTasks(0)
+  , m_streamedRepeatedTasks(0)
+  , m_streamedOutputs(0)
+  , m_statement()
+  , m_numThreads(0)
+  , m_structural(false)
   , input(NULL)
 {
   m_l3ps.setParseCollapseMinus(true);
@@ -88,9 +122,10 @@ char* Registry::convertString(string model)
   }
 }
 
-char* Registry::convertFile(const string& filename)
+//Finds 'filename' either as given or in the working directory.  Returns true on error.
+bool Registry::findInputFile(const string& filename, string& file)
 {
-  string file = filename;
+  file = filename;
   if (!file_exists(file)) {
     file = m_workingDirectory + file;
     if (!file_exists(file)) {
@@ -98,9 +133,18 @@ char* Registry::convertFile(const string& filename)
       error += filename;
       error += "' cannot be found.  Check to see if the file exists and that the permissions are correct, and try again.  If this still does not work, contact us letting us know how you got this error.";
       setError(error, 0);
-      return NULL;
+      return true;
     }
   }
+  return false;
+}
+
+char* Registry::convertFile(const string& filename)
+{
+  string file;
+  if (findInputFile(filename, file)) {
+    return NULL;
+  }
   string old_wd = m_workingDirectory;
   m_workingDirectory = file;
   size_t lastslash = m_workingDirectory.rfind('/');
@@ -110,6 +154,19 @@ char* Registry::convertFile(const string& filename)
   if (lastslash!=string::npos) {
     m_workingDirectory.erase(lastslash+1, m_workingDirectory.size()-lastslash-1);
   }
+  //libsedml can only read plain files, so a compressed one is decompressed into a string first.
+  compression_type compression = getFileCompression(file);
+  if (compression != compression_none) {
+    string contents, error;
+    if (readDecompressedFile(file, contents, error)) {
+      setError(error, 0);
+      m_workingDirectory = old_wd;
+      return NULL;
+    }
+    char* ret = convertString(contents);
+    m_workingDirectory = old_wd;
+    return ret;
+  }
   //Try to read it as SED-ML first
   m_sedml = readSedMLFromFile(file.c_str());
   if (m_sedml->getNumErrors(LIBSEDML_SEV_ERROR) == 0 && m_sedml->getNumErrors(LIBSEDML_SEV_FATAL) == 0) {
@@ -156,7 +213,7 @@ bool Registry::addModelDef(vector<const string*>* name, vector<const string*>* m
     return true;
   }
   PhrasedModel pm(namestr, *modelloc, true);
-  m_models.push_back(pm);
+  m_models.push_back(move(pm));
   return false;
 }
 
@@ -180,8 +237,8 @@ bool Registry::addModelDef(vector<const string*>* name, vector<const string*>* m
     setError(err.str(), phrased_yylloc_last_line-1);
     return true;
   }
-  PhrasedModel pm(namestr, *modelloc, *changelist, true);
-  m_models.push_back(pm);
+  PhrasedModel pm(namestr, *modelloc, move(*changelist), true);
+  m_models.push_back(move(pm));
   return false;
 }
 
@@ -222,7 +279,7 @@ bool Registry::addEquals(vector<const string*>* name, vector<const string*>* key
       return true;
     }
     PhrasedModel pm(namestr, key2str, false);
-    m_models.push_back(pm);
+    m_models.push_back(move(pm));
     return false;
   }
   if (CaselessStrCmp(key1str,"simulate")) {
@@ -271,11 +328,11 @@ bool Registry::addEquals(vector<const string*>* name, vector<const string*>* key
     setError(err.str(), phrased_yylloc_last_line-1);
     return true;
     }
-    PhrasedModel pm(namestr, key2str, *changelist, false);
+    PhrasedModel pm(namestr, key2str, move(*changelist), false);
     if (pm.changeListIsInappropriate(err)) {
       return true;
     }
-    m_models.push_back(pm);
+    m_models.push_back(move(pm));
     return false;
   }
   else if (CaselessStrCmp(key1str,"repeat")) {
@@ -291,7 +348,7 @@ bool Registry::addEquals(vector<const string*>* name, vector<const string*>* key
     if (rt.changeListIsInappropriate(err)) {
       return true;
     }
-    m_repeatedTasks.push_back(rt);
+    m_repeatedTasks.push_back(move(rt));
   }
   else {
     err << "unsupported keyword '" << key1str << "'.  Try 'model' or 'repeat' in this context.";
@@ -321,7 +378,7 @@ bool Registry::addEquals(vector<const string*>* name, vector<const string*>* key
     return true;
     }
     PhrasedTask pt(namestr, key2str, key4str);
-    m_tasks.push_back(pt);
+    m_tasks.push_back(move(pt));
     return false;
   }
   else {
@@ -464,6 +521,8 @@ bool Registry::addEquals(std::vector<const std::string*>* name, std::vector<cons
     else {
       if (phrasedsim->addAlgorithmParameter((*name)[2], &valstr, err)) return true;
     }
+    m_statement.type = stmt_algorithm;
+    m_statement.id = phrasedsim->getId();
   }
   else {
     err << "'" << namestr << "' has too many subvariables.  This formulation is only used to set the specifics of simulation algorithms.  Try lines like 'sim1.algorithm = CVODE' or 'sim1.algorithm.relative_tolerance = 2.2'.";
@@ -497,6 +556,8 @@ bool Registry::addEquals(std::vector<const std::string*>* name, double value)
   if (phrasedsim->addAlgorithmParameter((*name)[2], value, err)) {
     return true;
   }
+  m_statement.type = stmt_algorithm;
+  m_statement.id = phrasedsim->getId();
   return false;
 }
 
@@ -554,7 +615,7 @@ bool Registry::addMapToChangeList(vector<ModelChange>* cl, vector<const string*>
   if (arg->size())
     source = *(*arg).at(0);
   ModelChange mc(name, source, formula, true);
-  cl->push_back(mc);
+  cl->push_back(move(mc));
   return false;
 }
 
@@ -562,7 +623,7 @@ bool Registry::addMapToChangeList(vector<ModelChange>* cl, vector<const string*>
 bool Registry::addToChangeList(vector<ModelChange>* cl, vector<const string*>* name, vector<string>* formula)
 {
   ModelChange mc(name, formula);
-  cl->push_back(mc);
+  cl->push_back(move(mc));
   return false;
 }
 
@@ -574,7 +635,7 @@ bool Registry::addToChangeListFromRange(vector<ModelChange>* cl, vector<const st
     source_range = *range->at(0);
   }
   ModelChange mc(name, source_range, formula, false);
-  cl->push_back(mc);
+  cl->push_back(move(mc));
   return false;
 }
 
@@ -645,7 +706,7 @@ bool Registry::addToChangeList(std::vector<ModelChange>* cl, std::vector<const s
     return true;
   }
   ModelChange mc(type, key1, numlist);
-  cl->push_back(mc);
+  cl->push_back(move(mc));
   return false;
 }
 
@@ -670,7 +731,7 @@ bool Registry::addToChangeList(std::vector<ModelChange>* cl, std::vector<const s
   }
 
   ModelChange mc(ctype_loop_vector, key1, numlist);
-  cl->push_back(mc);
+  cl->push_back(move(mc));
   return false;
 }
 
@@ -687,6 +748,9 @@ bool Registry::setName(vector<const string*>* id, vector<const string*>* is, con
   if (checkId(id)) {
     return true;
   }
+  m_statement.type = stmt_name;
+  m_statement.id = idstr;
+  m_statement.phrasedml = idstr + " is \"" + *name + "\"\n";
   for (size_t m=0; m<m_models.size(); m++) {
     if (m_models[m].getId() == idstr) {
       m_models[m].setName(*name);
@@ -746,11 +810,20 @@ void Registry::setWorkingDirectory(const char* directory)
   m_workingDirectory = directory;
 }
 
+//Finds 'filename' either as given or in the working directory.  If neither exists, a compressed copy ('filename.gz' or 'filename.zst') is used instead.
 string Registry::getWorkingFilename(const string& filename)
 {
-  if (file_exists(filename)) return filename;
-  string newfile = m_workingDirectory + "/" + filename;
-  if (file_exists(newfile)) return newfile;
+  if (m_archive != NULL) {
+    //Models are only looked for in the archive.
+    return "";
+  }
+  const char* suffixes[] = {"", ".gz", ".zst"};
+  for (size_t s=0; s<3; s++) {
+    string file = filename + suffixes[s];
+    if (file_exists(file)) return file;
+    string newfile = m_workingDirectory + "/" + file;
+    if (file_exists(newfile)) return newfile;
+  }
   return "";
 }
 
@@ -817,19 +890,25 @@ char* Registry::getPhraSEDML() const
   return ret;
 }
 
-char* Registry::getSEDML() const
+char* Registry::getSEDML()
 {
+  refreshSEDML();
   if (m_sedml==NULL) {
     return NULL;
   }
-  if (m_sedml->getVersion() < 4) {
-      m_sedml->setVersion(4);
+  return g_registry.getCharStar(writeSEDML(m_sedml).c_str());
+}
+
+string Registry::writeSEDML(SedDocument* sedml) const
+{
+  if (sedml->getVersion() < 4) {
+      sedml->setVersion(4);
   }
   ostringstream stream;
   SedWriter sw;
   sw.setProgramName("phraSED-ML");
   sw.setProgramVersion(LIBPHRASEDML_VERSION_STRING);
-  sw.writeSedML(m_sedml, stream);
+  sw.writeSedML(sedml, stream);
   string ret = stream.str();
   // fix single quotes
   size_t replace = ret.find("&apos;");
@@ -844,8 +923,7 @@ char* Registry::getSEDML() const
     replace = ret.find("&quot;");
   }
   // fix min/max symbols
-  ret = fixMinMaxSymbolsXMLStr(ret);
-  return g_registry.getCharStar(ret.c_str());
+  return fixMinMaxSymbolsXMLStr(ret);
 }
 
 size_t Registry::getNumModels() const
@@ -853,6 +931,27 @@ size_t Registry::getNumModels() const
   return m_models.size();
 }
 
+const PhrasedModel* Registry::getModel(size_t num) const
+{
+  if (num >= m_models.size()) {
+    return NULL;
+  }
+  return &m_models[num];
+}
+
+size_t Registry::getNumSimulations() const
+{
+  return m_simulations.size();
+}
+
+const PhrasedSimulation* Registry::getSimulation(size_t num) const
+{
+  if (num >= m_simulations.size()) {
+    return NULL;
+  }
+  return m_simulations[num];
+}
+
 const PhrasedModel* Registry::getModel(string modid) const
 {
   for (size_t m=0; m<m_models.size(); m++) {
@@ -928,6 +1027,19 @@ size_t Registry::getNumTasks() const
   return m_tasks.size() + m_repeatedTasks.size();
 }
 
+size_t Registry::getNumOutputs() const
+{
+  return m_outputs.size();
+}
+
+const PhrasedOutput* Registry::getOutput(size_t num) const
+{
+  if (num >= m_outputs.size()) {
+    return NULL;
+  }
+  return &m_outputs[num];
+}
+
 const PhrasedTask* Registry::getTask(size_t num) const
 {
   if (num >= m_tasks.size()) {
@@ -942,6 +1054,7 @@ const PhrasedTask* Registry::getTask(size_t num) const
 
 void Registry::createSEDML()
 {
+  m_sedmlStale = false;
   delete m_sedml;
   m_sedml = new SedDocument(1, 4);
   for (size_t m=0; m<m_models.size(); m++) {
@@ -961,33 +1074,152 @@ void Registry::createSEDML()
   }
 }
 
-bool Registry::finalize()
+//While an element is being finalized, its error and warnings go here instead, so that elements can be finalized on several threads at once.
+static thread_local FinalizeResult* t_finalizeResult = NULL;
+
+//Sends this thread's errors and warnings to 'result' until it goes out of scope, even if finalizing throws, so the thread never keeps a pointer to a result that is gone.
+class FinalizeResultScope
 {
-  //Check the models
-  for (size_t m=0; m<m_models.size(); m++) {
-    if (m_models[m].finalize()) {
-      return true;
-    }
+public:
+  FinalizeResultScope(FinalizeResult* result) {t_finalizeResult = result;};
+  ~FinalizeResultScope() {t_finalizeResult = NULL;};
+};
+
+void Registry::setError(string error, int line)
+{
+  if (t_finalizeResult != NULL) {
+    t_finalizeResult->error = error;
+    t_finalizeResult->errorLine = line;
+    return;
   }
-  for (size_t s=0; s<m_simulations.size(); s++) {
-    if (m_simulations[s]->finalize()) {
-      return true;
-    }
+  m_error = error;
+  m_errorLine = line;
+}
+
+void Registry::addErrorPrefix(string error)
+{
+  if (t_finalizeResult != NULL) {
+    t_finalizeResult->error = error + t_finalizeResult->error;
+    return;
   }
-  for (size_t t=0; t<m_tasks.size(); t++) {
-    if (m_tasks[t].finalize()) {
-      return true;
+  m_error = error + m_error;
+}
+
+void Registry::addWarning(string warning)
+{
+  if (t_finalizeResult != NULL) {
+    t_finalizeResult->warnings.push_back(warning);
+    return;
+  }
+  m_warnings.push_back(warning);
+}
+
+//Checking a few elements is faster than starting a thread.
+static const size_t MIN_ELEMENTS_PER_THREAD = 8;
+
+static bool finalizeElement(PhrasedModel& element) {return element.finalize();}
+static bool finalizeElement(PhrasedSimulation* element) {return element->finalize();}
+static bool finalizeElement(PhrasedTask& element) {return element.finalize();}
+static bool finalizeElement(PhrasedRepeatedTask& element) {return element.finalize();}
+static bool finalizeElement(PhrasedOutput& element) {return element.finalize();}
+
+template<class T>
+class FinalizeJobs : public ParallelJobs
+{
+private:
+  vector<T>& m_elements;
+  size_t m_first;
+  vector<FinalizeResult>& m_results;
+
+public:
+  FinalizeJobs(vector<T>& elements, size_t first, vector<FinalizeResult>& results)
+    : m_elements(elements)
+    , m_first(first)
+    , m_results(results)
+  {
+  }
+
+  virtual void run(size_t job)
+  {
+    FinalizeResult& result = m_results[job];
+    if (result.failed) {
+      return;
     }
+    FinalizeResultScope scope(&result);
+    result.failed = finalizeElement(m_elements[m_first + job]);
   }
-  for (size_t t=0; t<m_repeatedTasks.size(); t++) {
-    if (m_repeatedTasks[t].finalize()) {
+};
+
+//Finalizes every element from 'first' on, in parallel.  While being finalized, elements only read each other and the kinds of elements finalized before them, so each kind can be finalized all at once.
+template<class T>
+static void finalizeInParallel(vector<T>& elements, size_t first, vector<FinalizeResult>& results, size_t numThreads)
+{
+  results.resize(elements.size() - first);
+  FinalizeJobs<T> jobs(elements, first, results);
+  runParallelJobs(jobs, results.size(), numThreads, MIN_ELEMENTS_PER_THREAD);
+}
+
+//Only elements added since the last call are finalized; after clearAll, that's all of them.
+bool Registry::finalize()
+{
+  if (m_deferFinalize) {
+    return false;
+  }
+  //Check the models, once every SBML file being read in the background has been.  A model based on another looks up the SBML of the model at the end of its chain, possibly later in the list, so every file is finished with here, before anything runs in parallel.
+  for (size_t m=m_finalizedModels; m<m_models.size(); m++) {
+    m_models[m].loadSBML();
+  }
+  vector<FinalizeResult> results;
+  finalizeInParallel(m_models, m_finalizedModels, results, m_numThreads);
+  if (reportFinalizeResults(results)) {
+    return true;
+  }
+  m_finalizedModels = m_models.size();
+  results.clear();
+  finalizeInParallel(m_simulations, m_finalizedSimulations, results, m_numThreads);
+  if (reportFinalizeResults(results)) {
+    return true;
+  }
+  m_finalizedSimulations = m_simulations.size();
+  results.clear();
+  finalizeInParallel(m_tasks, m_finalizedTasks, results, m_numThreads);
+  if (reportFinalizeResults(results)) {
+    return true;
+  }
+  m_finalizedTasks = m_tasks.size();
+  results.clear();
+  finalizeInParallel(m_repeatedTasks, m_finalizedRepeatedTasks, results, m_numThreads);
+  if (reportFinalizeResults(results)) {
+    return true;
+  }
+  m_finalizedRepeatedTasks = m_repeatedTasks.size();
+  results.clear();
+  finalizeInParallel(m_outputs, m_finalizedOutputs, results, m_numThreads);
+  if (reportFinalizeResults(results)) {
+    return true;
+  }
+  m_finalizedOutputs = m_outputs.size();
+  setOutputIds();
+
+  return false;
+}
+
+//Passes on the warnings of every element up to the first one that failed, and that one's error, just as if they had been finalized one at a time.  Returns true if any failed.
+bool Registry::reportFinalizeResults(const vector<FinalizeResult>& results)
+{
+  for (size_t r=0; r<results.size(); r++) {
+    m_warnings.insert(m_warnings.end(), results[r].warnings.begin(), results[r].warnings.end());
+    if (results[r].failed) {
+      setError(results[r].error, results[r].errorLine);
       return true;
     }
   }
+  return false;
+}
+
+void Registry::setOutputIds()
+{
   for (size_t o=0; o<m_outputs.size(); o++) {
-    if (m_outputs[o].finalize()) {
-      return true;
-    }
     stringstream id;
     if (m_outputs[o].isPlot()) {
       id << "plot";
@@ -998,21 +1230,299 @@ bool Registry::finalize()
     id << "_" << o;
     m_outputs[o].setId(id.str());
   }
+}
+
+//The SED-ML document is only rebuilt when needed, since re-parsing a few statements is much faster.
+void Registry::refreshSEDML()
+{
+  if (m_sedmlStale) {
+    createSEDML();
+  }
+}
 
+//Removes every model, simulation, and task with the given ID.
+void Registry::removeElement(const string& id)
+{
+  for (size_t m=m_models.size(); m>0; m--) {
+    if (m_models[m-1].getId() == id) {
+      m_models.erase(m_models.begin() + (m-1));
+      if (m-1 < m_finalizedModels) {
+        m_finalizedModels--;
+      }
+    }
+  }
+  for (size_t s=m_simulations.size(); s>0; s--) {
+    if (m_simulations[s-1]->getId() == id) {
+      delete m_simulations[s-1];
+      m_simulations.erase(m_simulations.begin() + (s-1));
+      if (s-1 < m_finalizedSimulations) {
+        m_finalizedSimulations--;
+      }
+    }
+  }
+  for (size_t t=m_tasks.size(); t>0; t--) {
+    if (m_tasks[t-1].getId() == id) {
+      m_tasks.erase(m_tasks.begin() + (t-1));
+      if (t-1 < m_finalizedTasks) {
+        m_finalizedTasks--;
+      }
+    }
+  }
+  for (size_t rt=m_repeatedTasks.size(); rt>0; rt--) {
+    if (m_repeatedTasks[rt-1].getId() == id) {
+      m_repeatedTasks.erase(m_repeatedTasks.begin() + (rt-1));
+      if (rt-1 < m_finalizedRepeatedTasks) {
+        m_finalizedRepeatedTasks--;
+      }
+    }
+  }
+}
+
+//Removes every element, so that statements can be parsed from scratch.
+void Registry::clearElements()
+{
+  clearAll();
+  clearSEDML();
+  m_sedmlStale = true;
+}
+
+void Registry::removeOutput(size_t num)
+{
+  if (num >= m_outputs.size()) {
+    return;
+  }
+  m_outputs.erase(m_outputs.begin() + num);
+  if (num < m_finalizedOutputs) {
+    m_finalizedOutputs--;
+  }
+}
+
+//Parses phraSED-ML statements, adding what they define to what is already there.  Nothing is finalized until finalizeParsedStatements is called, so statements may refer to anything parsed with them.  Line numbers in errors start at 'firstLine'.  Returns true on error.
+bool Registry::parseStatements(const string& statements, int firstLine)
+{
+  istringstream* inputstring = new istringstream(statements + "\n");
+  phrased_yylloc_last_line = firstLine;
+  input = inputstring;
+  m_deferFinalize = true;
+  int failed = phrased_yyparse();
+  m_deferFinalize = false;
+  input = NULL;
+  delete inputstring;
+  if (failed != 0) {
+    if (getError().empty()) {
+      setError("Unable to parse line " + ftoa(phrased_yylloc_last_line-1) + ".", phrased_yylloc_last_line-1);
+    }
+    return true;
+  }
   return false;
 }
 
-void Registry::setReferencedSBML(const char* filename, SBMLDocument* doc)
+//Finalizes everything added by parseStatements.  Returns true on error.
+bool Registry::finalizeParsedStatements()
 {
-  m_referencedSBML.insert(make_pair(filename, doc));
+  m_sedmlStale = true;
+  return finalize();
 }
 
-void Registry::clearReferencedSBML()
+//Reorders 'elements' by their 'positions', moving each one rather than copying it (and its math).
+template<class T>
+static void sortByPosition(vector<T>& elements, const vector<size_t>& positions)
+{
+  vector<pair<size_t, size_t> > order;
+  bool sorted = true;
+  for (size_t e=0; e<elements.size(); e++) {
+    order.push_back(make_pair(positions[e], e));
+    if (e > 0 && positions[e] < positions[e-1]) {
+      sorted = false;
+    }
+  }
+  if (sorted) {
+    return;
+  }
+  sort(order.begin(), order.end());
+  vector<T> sortedElements;
+  sortedElements.reserve(elements.size());
+  for (size_t e=0; e<order.size(); e++) {
+    sortedElements.push_back(move(elements[order[e].second]));
+  }
+  elements.swap(sortedElements);
+}
+
+//Puts every element back in the order of the statements that defined them:  'positions' gives the position of each ID, and 'outputPositions' that of each output in their current order.  Anything without a position goes last.
+void Registry::sortElements(const map<string, size_t>& positions, const vector<size_t>& outputPositions)
+{
+  vector<size_t> modelPositions, simPositions, taskPositions, rtPositions;
+  for (size_t m=0; m<m_models.size(); m++) {
+    map<string, size_t>::const_iterator pos = positions.find(m_models[m].getId());
+    modelPositions.push_back(pos == positions.end() ? positions.size() + m : pos->second);
+  }
+  for (size_t s=0; s<m_simulations.size(); s++) {
+    map<string, size_t>::const_iterator pos = positions.find(m_simulations[s]->getId());
+    simPositions.push_back(pos == positions.end() ? positions.size() + s : pos->second);
+  }
+  for (size_t t=0; t<m_tasks.size(); t++) {
+    map<string, size_t>::const_iterator pos = positions.find(m_tasks[t].getId());
+    taskPositions.push_back(pos == positions.end() ? positions.size() + t : pos->second);
+  }
+  for (size_t rt=0; rt<m_repeatedTasks.size(); rt++) {
+    map<string, size_t>::const_iterator pos = positions.find(m_repeatedTasks[rt].getId());
+    rtPositions.push_back(pos == positions.end() ? positions.size() + rt : pos->second);
+  }
+  sortByPosition(m_models, modelPositions);
+  sortByPosition(m_simulations, simPositions);
+  sortByPosition(m_tasks, taskPositions);
+  sortByPosition(m_repeatedTasks, rtPositions);
+  if (outputPositions.size() == m_outputs.size()) {
+    sortByPosition(m_outputs, outputPositions);
+  }
+  setOutputIds();
+  m_sedmlStale = true;
+}
+
+//Parses the phraSED-ML in 'stream', passing each statement to 'callback' as soon as the line it ends on is parsed.  Nothing is finalized:  once everything has been parsed, call finalizeParsedStatements to check the references between the statements and create the SED-ML.  Returns true on error, including if 'callback' stopped parsing.
+bool Registry::streamStatements(istream* stream, StatementCallback callback, void* userData)
+{
+  clearElements();
+  m_statementCallback = callback;
+  m_statementUserData = userData;
+  m_streamedModels = 0;
+  m_streamedSimulations = 0;
+  m_streamedTasks = 0;
+  m_streamedRepeatedTasks = 0;
+  m_streamedOutputs = 0;
+  m_statement.id.clear();
+  phrased_yylloc_last_line = 1;
+  input = stream;
+  m_deferFinalize = true;
+  int failed = phrased_yyparse();
+  m_deferFinalize = false;
+  input = NULL;
+  m_statementCallback = NULL;
+  m_statementUserData = NULL;
+  if (failed != 0) {
+    if (getError().empty()) {
+      setError("Unable to parse line " + ftoa(phrased_yylloc_last_line-1) + ".", phrased_yylloc_last_line-1);
+    }
+    return true;
+  }
+  return false;
+}
+
+//As streamStatements, but reading the file a line at a time, so that the whole file is never in memory.  Models are found relative to the file's directory.  Returns true on error.
+bool Registry::streamFile(const string& filename, StatementCallback callback, void* userData)
 {
-  for (map<string, SBMLDocument*>::iterator el = m_referencedSBML.begin(); el!= m_referencedSBML.end(); el++) {
-    delete el->second;
+  string file;
+  if (findInputFile(filename, file)) {
+    return true;
+  }
+  DecompressingInputStream inputfile(file);
+  if (!inputfile.isOpen()) {
+    setError("Input file '" + filename + "' cannot be read.  Check to see if the file exists and that the permissions are correct, and try again.", 0);
+    return true;
+  }
+  string old_wd = m_workingDirectory;
+  size_t lastslash = file.find_last_of("/\\");
+  if (lastslash != string::npos) {
+    m_workingDirectory = file.substr(0, lastslash+1);
   }
+  bool ret = streamStatements(&inputfile, callback, userData);
+  m_workingDirectory = old_wd;
+  if (!ret && !inputfile.getError().empty()) {
+    setError(inputfile.getError(), 0);
+    return true;
+  }
+  return ret;
+}
+
+//Called by the parser at the end of every statement, to pass it on to the statement callback, if there is one.  A statement defines at most one new element; if it defined none, it changed the one in m_statement.  Returns true if parsing should stop.
+bool Registry::endStatement(char lineend)
+{
+  if (m_statementCallback == NULL) {
+    return false;
+  }
+  ParsedStatement statement;
+  statement.line = (lineend == '\n') ? phrased_yylloc_last_line-1 : phrased_yylloc_last_line;
+  if (m_models.size() > m_streamedModels) {
+    statement.type = stmt_model;
+    statement.id = m_models.back().getId();
+    statement.phrasedml = m_models.back().getPhraSEDML();
+  }
+  else if (m_simulations.size() > m_streamedSimulations) {
+    statement.type = stmt_simulation;
+    statement.id = m_simulations.back()->getId();
+    statement.phrasedml = m_simulations.back()->getPhraSEDML();
+  }
+  else if (m_tasks.size() > m_streamedTasks) {
+    statement.type = stmt_task;
+    statement.id = m_tasks.back().getId();
+    statement.phrasedml = m_tasks.back().getPhraSEDML();
+  }
+  else if (m_repeatedTasks.size() > m_streamedRepeatedTasks) {
+    statement.type = stmt_repeatedTask;
+    statement.id = m_repeatedTasks.back().getId();
+    statement.phrasedml = m_repeatedTasks.back().getPhraSEDML();
+  }
+  else if (m_outputs.size() > m_streamedOutputs) {
+    //The ID it will be given by setOutputIds.
+    statement.type = stmt_output;
+    statement.id = (m_outputs.back().isPlot() ? "plot_" : "report_") + SizeTToString(m_outputs.size()-1);
+    statement.phrasedml = m_outputs.back().getPhraSEDML();
+  }
+  else if (!m_statement.id.empty()) {
+    statement.type = m_statement.type;
+    statement.id = m_statement.id;
+    statement.phrasedml = m_statement.phrasedml;
+    if (m_statement.type == stmt_algorithm) {
+      statement.phrasedml = getSimulation(m_statement.id)->getPhraSEDML();
+    }
+  }
+  else {
+    return false;
+  }
+  m_streamedModels = m_models.size();
+  m_streamedSimulations = m_simulations.size();
+  m_streamedTasks = m_tasks.size();
+  m_streamedRepeatedTasks = m_repeatedTasks.size();
+  m_streamedOutputs = m_outputs.size();
+  m_statement.id.clear();
+  if (m_statementCallback(statement, m_statementUserData)) {
+    if (getError().empty()) {
+      setError("Parsing was stopped after line " + ftoa(statement.line) + ".", statement.line);
+    }
+    return true;
+  }
+  return false;
+}
+
+//Replaces any document already set for 'filename'.  The document is never changed, and is only released once nothing else (including the caller) shares it.
+void Registry::setReferencedSBML(const char* filename, shared_ptr<const SBMLDocument> doc)
+{
+  m_referencedSBML[filename] = doc;
+  m_referencedIndexes.erase(filename);
+}
+
+//Sets every document at once.  If a filename appears more than once, its last document is used.
+void Registry::setReferencedSBML(const vector<string>& filenames, const vector<shared_ptr<const SBMLDocument> >& docs)
+{
+  for (size_t d=0; d<filenames.size() && d<docs.size(); d++) {
+    m_referencedSBML[filenames[d]] = docs[d];
+    m_referencedIndexes.erase(filenames[d]);
+  }
+}
+
+void Registry::clearReferencedSBML()
+{
   m_referencedSBML.clear();
+  m_referencedIndexes.clear();
+}
+
+//'.xml' and '.sbml' count wherever they are, as before.  A compressed file ('model.gz', 'model.xml.zst') already has the suffix it was saved with, so '.xml' is never added after the compression suffix.
+static bool hasModelSuffix(const string& filename)
+{
+  if (removeCompressionSuffix(filename) != filename) {
+    return true;
+  }
+  return filename.find(".xml") != string::npos || filename.find(".sbml") != string::npos;
 }
 
 void Registry::addDotXMLToModelSources(bool force)
@@ -1020,7 +1530,7 @@ void Registry::addDotXMLToModelSources(bool force)
   for (size_t m=0; m<m_models.size(); m++) {
     if (m_models[m].getIsFile()) {
       string modelname = m_models[m].getSource();
-      if (modelname.find(".xml") == string::npos && modelname.find(".sbml") == string::npos && modelname.find("urn:") == string::npos) {
+      if (!hasModelSuffix(modelname) && modelname.find("urn:") == string::npos) {
         m_models[m].setSource(modelname + ".xml");
       }
     }
@@ -1029,7 +1539,7 @@ void Registry::addDotXMLToModelSources(bool force)
     for (unsigned long sm=0; sm<m_sedml->getNumModels(); sm++) {
       SedModel* sedmodel = m_sedml->getModel(sm);
       string modelstr = sedmodel->getSource();
-      if ((m_sedml->getModel(modelstr) == NULL || m_sedml->getModel(modelstr) == sedmodel) && modelstr.find(".xml") == string::npos && modelstr.find(".sbml") == string::npos) {
+      if ((m_sedml->getModel(modelstr) == NULL || m_sedml->getModel(modelstr) == sedmodel) && !hasModelSuffix(modelstr)) {
         //It's a filename without ".xml"
         sedmodel->setSource(modelstr + ".xml");
       }
@@ -1037,6 +1547,305 @@ void Registry::addDotXMLToModelSources(bool force)
   }
 }
 
+//Creates 'numShards' standalone documents from the repeated task 'taskid', each running a contiguous, disjoint slice of the task's own range:  vector ranges are split, uniform ranges are re-based to the slice, and functional ranges and assignments are kept as-is.  Each shard has the same ID for the repeated task, and only the models, simulations, and tasks it needs.  Outputs that use only that task are kept as reports, with the same IDs and columns in every shard, so the shards' results can be concatenated in order; other outputs are dropped.  Returns true on error.
+bool Registry::shardRepeatedTask(const string& taskid, size_t numShards)
+{
+  m_shardPhraSEDML.clear();
+  m_shardSEDML.clear();
+  const PhrasedTask* task = getTask(taskid);
+  if (task == NULL || !task->isRepeated()) {
+    setError("Unable to shard '" + taskid + "':  no such repeated task.", 0);
+    return true;
+  }
+  const PhrasedRepeatedTask* rt = static_cast<const PhrasedRepeatedTask*>(task);
+  size_t numIterations = rt->getNumIterations();
+  if (numShards == 0 || numIterations == 0) {
+    setError("Unable to shard '" + taskid + "':  there must be at least one shard and at least one iteration.", 0);
+    return true;
+  }
+  if (numShards > numIterations) {
+    stringstream warning;
+    warning << "The repeated task '" << taskid << "' only has " << numIterations << " iterations, so only " << numIterations << " shards were created.";
+    addWarning(warning.str());
+    numShards = numIterations;
+  }
+
+  set<string> taskids, modelids, simids;
+  addTaskDependencies(taskid, taskids, modelids, simids);
+  vector<PhrasedOutput> outputs;
+  for (size_t o=0; o<m_outputs.size(); o++) {
+    set<string> refs = m_outputs[o].getTaskReferences();
+    if (refs.size() == 1 && *refs.begin() == taskid) {
+      outputs.push_back(m_outputs[o].getAsReport());
+    }
+    else {
+      addWarning("The output '" + m_outputs[o].getId() + "' uses tasks other than '" + taskid + "', and was not included in the shards.");
+    }
+  }
+
+  for (size_t shard=0; shard<numShards; shard++) {
+    size_t begin = getChunkStart(numIterations, shard, numShards);
+    size_t end = getChunkStart(numIterations, shard+1, numShards);
+    PhrasedRepeatedTask slice = rt->getSlice(taskid, begin, end);
+    slice.setName(rt->getName());
+
+    stringstream phrased;
+    phrased << "// Created by libphrasedml " << LIBPHRASEDML_VERSION_STRING << endl;
+    phrased << "// Shard " << shard << " of " << numShards << " of repeated task '" << taskid << "':  iterations " << begin << " to " << end << " of " << numIterations << endl;
+    string names;
+    SedDocument sedml(1, 4);
+    phrased << endl << "// Models" << endl;
+    for (size_t m=0; m<m_models.size(); m++) {
+      if (modelids.find(m_models[m].getId()) != modelids.end()) {
+        phrased << m_models[m].getPhraSEDML();
+        m_models[m].addModelToSEDML(&sedml);
+        if (m_models[m].getName() != "") {
+          names += m_models[m].getId() + " is \"" + m_models[m].getName() + "\"\n";
+        }
+      }
+    }
+    phrased << endl << "// Simulations" << endl;
+    for (size_t s=0; s<m_simulations.size(); s++) {
+      if (simids.find(m_simulations[s]->getId()) != simids.end()) {
+        phrased << m_simulations[s]->getPhraSEDML();
+        m_simulations[s]->addSimulationToSEDML(&sedml);
+        if (m_simulations[s]->getName() != "") {
+          names += m_simulations[s]->getId() + " is \"" + m_simulations[s]->getName() + "\"\n";
+        }
+      }
+    }
+    phrased << endl << "// Tasks" << endl;
+    for (size_t t=0; t<m_tasks.size(); t++) {
+      if (taskids.find(m_tasks[t].getId()) != taskids.end()) {
+        phrased << m_tasks[t].getPhraSEDML();
+        m_tasks[t].addTaskToSEDML(&sedml);
+        if (m_tasks[t].getName() != "") {
+          names += m_tasks[t].getId() + " is \"" + m_tasks[t].getName() + "\"\n";
+        }
+      }
+    }
+    phrased << endl << "// Repeated Tasks" << endl;
+    for (size_t t=0; t<m_repeatedTasks.size(); t++) {
+      const PhrasedRepeatedTask* repeated = &m_repeatedTasks[t];
+      if (repeated->getId() == taskid) {
+        repeated = &slice;
+      }
+      else if (taskids.find(repeated->getId()) == taskids.end()) {
+        continue;
+      }
+      phrased << repeated->getPhraSEDML();
+      repeated->addRepeatedTaskToSEDML(&sedml);
+      if (repeated->getName() != "") {
+        names += repeated->getId() + " is \"" + repeated->getName() + "\"\n";
+      }
+    }
+    if (!outputs.empty()) {
+      phrased << endl << "// Outputs" << endl;
+    }
+    for (size_t o=0; o<outputs.size(); o++) {
+      phrased << outputs[o].getPhraSEDML();
+      outputs[o].addOutputToSEDML(&sedml);
+    }
+    if (names != "") {
+      phrased << endl << "// Names" << endl << names << endl;
+    }
+    m_shardPhraSEDML.push_back(phrased.str());
+    m_shardSEDML.push_back(writeSEDML(&sedml));
+  }
+  return false;
+}
+
+size_t Registry::getNumShards() const
+{
+  return m_shardPhraSEDML.size();
+}
+
+char* Registry::getShardPhraSEDML(size_t shard)
+{
+  if (shard >= m_shardPhraSEDML.size()) {
+    stringstream err;
+    err << "No such shard " << shard << ":  there are " << m_shardPhraSEDML.size() << " shards.";
+    setError(err.str(), 0);
+    return NULL;
+  }
+  return getCharStar(m_shardPhraSEDML[shard].c_str());
+}
+
+char* Registry::getShardSEDML(size_t shard)
+{
+  if (shard >= m_shardSEDML.size()) {
+    stringstream err;
+    err << "No such shard " << shard << ":  there are " << m_shardSEDML.size() << " shards.";
+    setError(err.str(), 0);
+    return NULL;
+  }
+  return getCharStar(m_shardSEDML[shard].c_str());
+}
+
+//Converts each SED-ML document in the COMBINE archive 'filename' to phraSED-ML, in the order of its manifest.  The archive's documents are read, and its models indexed, in parallel; model sources are then found relative to each document's location in the archive, never on disk.  The documents themselves are converted one at a time.  Returns true on error.
+bool Registry::convertArchive(const string& filename)
+{
+  m_archiveLocations.clear();
+  m_archivePhraSEDML.clear();
+  string file;
+  if (findInputFile(filename, file)) {
+    return true;
+  }
+  CombineArchive archive;
+  string error;
+  if (archive.open(file, error) || archive.load(m_numThreads, !m_structural, error)) {
+    setError(error, 0);
+    return true;
+  }
+  m_archive = &archive;
+  bool failed = false;
+  for (size_t d=0; d<archive.getNumSEDML(); d++) {
+    const string& location = archive.getSEDMLLocation(d);
+    m_archiveDirectory = location.substr(0, location.rfind('/')+1);
+    char* phrasedml = convertString(archive.getSEDML(d));
+    if (phrasedml == NULL) {
+      addErrorPrefix("Unable to convert '" + location + "' in the archive '" + filename + "':  ");
+      failed = true;
+      break;
+    }
+    m_archiveLocations.push_back(location);
+    m_archivePhraSEDML.push_back(phrasedml);
+  }
+  m_archive = NULL;
+  m_archiveDirectory.clear();
+  if (failed) {
+    m_archiveLocations.clear();
+    m_archivePhraSEDML.clear();
+  }
+  return failed;
+}
+
+size_t Registry::getNumArchiveDocuments() const
+{
+  return m_archiveLocations.size();
+}
+
+char* Registry::getArchiveDocumentLocation(size_t document)
+{
+  if (document >= m_archiveLocations.size()) {
+    stringstream err;
+    err << "No such archive document " << document << ":  there are " << m_archiveLocations.size() << " documents.";
+    setError(err.str(), 0);
+    return NULL;
+  }
+  return getCharStar(m_archiveLocations[document].c_str());
+}
+
+char* Registry::getArchivePhraSEDML(size_t document)
+{
+  if (document >= m_archivePhraSEDML.size()) {
+    stringstream err;
+    err << "No such archive document " << document << ":  there are " << m_archivePhraSEDML.size() << " documents.";
+    setError(err.str(), 0);
+    return NULL;
+  }
+  return getCharStar(m_archivePhraSEDML[document].c_str());
+}
+
+//Records a measured cost for simulations using the algorithm with this KiSAO ID (or, for 0, any algorithm without a cost of its own).  Costs are kept until cleared, across conversions.
+void Registry::setRunCost(int kisao, double secondsPerRun, double secondsPerPoint)
+{
+  m_runCosts[kisao] = make_pair(secondsPerRun, secondsPerPoint);
+}
+
+void Registry::clearRunCosts()
+{
+  m_runCosts.clear();
+}
+
+//Estimates the cost of every task of the last conversion, as each is run by itself.  Results are only recorded for the variables the outputs use.  Returns true on error.
+bool Registry::getCostEstimate(vector<TaskCost>& tasks, TaskCost& total)
+{
+  tasks.clear();
+  total.task = "";
+  total.numRuns = 0;
+  total.numOutputPoints = 0;
+  total.numRecordedVariables = 0;
+  total.resultBytes = 0;
+  total.seconds = 0;
+  total.calibrated = true;
+  refreshSEDML();
+  if (m_sedml == NULL) {
+    g_registry.setError("Unable to estimate the cost of running the tasks:  no model has been successfully converted.", 0);
+    return true;
+  }
+  map<string, set<string> > recorded;
+  for (unsigned int d=0; d<m_sedml->getNumDataGenerators(); d++) {
+    SedDataGenerator* sdg = m_sedml->getDataGenerator(d);
+    for (unsigned int v=0; v<sdg->getNumVariables(); v++) {
+      SedVariable* var = sdg->getVariable(v);
+      recorded[var->getTaskReference()].insert(var->getTarget() + " " + var->getSymbol());
+    }
+  }
+  for (size_t t=0; t<getNumTasks(); t++) {
+    string taskid = getTask(t)->getId();
+    TaskCost cost;
+    if (getTaskCost(taskid, m_runCosts, cost)) {
+      return true;
+    }
+    cost.numRecordedVariables = recorded[taskid].size();
+    cost.resultBytes = multiplySaturated(multiplySaturated(cost.numOutputPoints, cost.numRecordedVariables), sizeof(double));
+    addTaskCost(total, cost);
+    tasks.push_back(cost);
+  }
+  return false;
+}
+
+//Fills in the shape of every data generator and output of the last conversion, in document order.  Returns true on error.
+bool Registry::getOutputShapes(vector<OutputShape>& dataGenerators, vector<OutputShape>& outputs)
+{
+  dataGenerators.clear();
+  outputs.clear();
+  refreshSEDML();
+  if (m_sedml == NULL) {
+    setError("Unable to find the shapes of the outputs:  no model has been successfully converted.", 0);
+    return true;
+  }
+  for (unsigned int d=0; d<m_sedml->getNumDataGenerators(); d++) {
+    OutputShape shape;
+    if (getDataGeneratorShape(m_sedml->getDataGenerator(d), shape)) {
+      return true;
+    }
+    dataGenerators.push_back(shape);
+  }
+  for (unsigned int o=0; o<m_sedml->getNumOutputs(); o++) {
+    OutputShape shape;
+    if (getOutputShape(m_sedml->getOutput(o), dataGenerators, shape)) {
+      return true;
+    }
+    outputs.push_back(shape);
+  }
+  return false;
+}
+
+//Collects the IDs of everything needed to run the task:  its subtasks, their models (and any models those are based on), and their simulations.
+void Registry::addTaskDependencies(const string& taskid, set<string>& tasks, set<string>& models, set<string>& simulations) const
+{
+  const PhrasedTask* task = getTask(taskid);
+  if (task == NULL || !tasks.insert(taskid).second) {
+    return;
+  }
+  if (task->isRepeated()) {
+    vector<string> subtasks = static_cast<const PhrasedRepeatedTask*>(task)->getTasks();
+    for (size_t t=0; t<subtasks.size(); t++) {
+      addTaskDependencies(subtasks[t], tasks, models, simulations);
+    }
+    return;
+  }
+  simulations.insert(task->getSimulationReference());
+  string modelid = task->getModelReference();
+  const PhrasedModel* model = getModel(modelid);
+  while (model != NULL && models.insert(modelid).second && !model->getIsFile()) {
+    modelid = model->getSource();
+    model = getModel(modelid);
+  }
+}
+
 void Registry::SetWriteSEDMLTimestamp(bool set)
 {
 #if LIBSBML_VERSION >= 51201
@@ -1052,13 +1861,46 @@ bool Registry::GetWriteSEDMLTimestamp()
   return true;
 }
 
-SBMLDocument* Registry::getSavedSBML(std::string filename)
+//Starts indexing the SBML file 'filename' in the background, unless it already is.  Every model from the same file shares the one index.
+PendingSBMLIndex Registry::indexSBMLFile(const string& filename)
+{
+  map<string, PendingSBMLIndex>::iterator found = m_pendingSBML.find(filename);
+  if (found != m_pendingSBML.end()) {
+    return found->second;
+  }
+  PendingSBMLIndex pending = indexSBMLInBackground(filename);
+  m_pendingSBML.insert(make_pair(filename, pending));
+  return pending;
+}
+
+//The document set for 'filename' with setReferencedSBML, if any.
+shared_ptr<const SBMLDocument> Registry::getSavedSBML(std::string filename)
 {
-  map<string, SBMLDocument*>::iterator ret = m_referencedSBML.find(filename);
+  map<string, shared_ptr<const SBMLDocument> >::iterator ret = m_referencedSBML.find(filename);
   if (ret != m_referencedSBML.end()) {
     return ret->second;
   }
-  return NULL;
+  return shared_ptr<const SBMLDocument>();
+}
+
+//The index of the document set for 'filename', or, while converting an archive, of the model at 'filename' in it.
+shared_ptr<const SBMLIndex> Registry::getSavedSBMLIndex(std::string filename)
+{
+  map<string, shared_ptr<const SBMLIndex> >::iterator found = m_referencedIndexes.find(filename);
+  if (found != m_referencedIndexes.end()) {
+    return found->second;
+  }
+  shared_ptr<const SBMLDocument> doc = getSavedSBML(filename);
+  if (doc) {
+    shared_ptr<SBMLIndex> index(new SBMLIndex());
+    index->read(doc.get());
+    m_referencedIndexes.insert(make_pair(filename, index));
+    return index;
+  }
+  if (m_archive != NULL) {
+    return m_archive->getSBMLIndex(normalizeArchivePath(m_archiveDirectory + filename));
+  }
+  return shared_ptr<const SBMLIndex>();
 }
 
 
@@ -1099,7 +1941,7 @@ bool Registry::parseSEDML()
   clearAll();
   for (unsigned long m=0; m<m_sedml->getNumModels(); m++) {
     PhrasedModel mod(m_sedml->getModel(m), m_sedml);
-    m_models.push_back(mod);
+    m_models.push_back(move(mod));
   }
   for (unsigned long s=0; s<m_sedml->getNumSimulations(); s++) {
     SedSimulation* sedsim = m_sedml->getSimulation(s);
@@ -1128,12 +1970,12 @@ bool Registry::parseSEDML()
     SedAbstractTask* sedtask = m_sedml->getTask(t);
     if (sedtask->getTypeCode() == SEDML_TASK) {
       PhrasedTask pt(static_cast<SedTask*>(sedtask));
-      m_tasks.push_back(pt);
+      m_tasks.push_back(move(pt));
     }
     else if (sedtask->getTypeCode() == SEDML_TASK_REPEATEDTASK) {
       SedRepeatedTask* srt = static_cast<SedRepeatedTask*>(sedtask);
       PhrasedRepeatedTask rt(srt);
-      m_repeatedTasks.push_back(rt);
+      m_repeatedTasks.push_back(move(rt));
     }
     else {
       setError("SED-ML task '" + sedtask->getId() + "' has unknown type.", 0);
@@ -1143,7 +1985,7 @@ bool Registry::parseSEDML()
   for (unsigned int out=0; out<m_sedml->getNumOutputs(); out++) {
     SedOutput* output = m_sedml->getOutput(out);
     PhrasedOutput phrasedout(output, m_sedml);
-    m_outputs.push_back(phrasedout);
+    m_outputs.push_back(move(phrasedout));
   }
   return finalize();
 }
@@ -1201,6 +2043,13 @@ bool Registry::isValidSId(vector<const string*>* name)
 
 void Registry::clearAll()
 {
+  m_revision++;
+  m_finalizedModels = 0;
+  m_finalizedSimulations = 0;
+  m_finalizedTasks = 0;
+  m_finalizedRepeatedTasks = 0;
+  m_finalizedOutputs = 0;
+  m_sedmlStale = false;
   m_error.clear();
   m_errorLine = 0;
   m_warnings.clear();
@@ -1212,6 +2061,9 @@ void Registry::clearAll()
   m_tasks.clear();
   m_repeatedTasks.clear();
   m_outputs.clear();
+  m_shardPhraSEDML.clear();
+  m_shardSEDML.clear();
+  m_pendingSBML.clear();
 }
 
 void Registry::clearSEDML()
@@ -1231,24 +2083,31 @@ bool Registry::file_exists (const string& filename)
   return stat(filename.c_str(), &buf) == 0;
 }
 
-bool Registry::addASTToCurve(const vector<string>* x, vector<ASTNode*>& curve, stringstream& err)
+bool Registry::addASTToCurve(const vector<string>* x, vector<OwnedAST>& curve, stringstream& err)
 {
-  ASTNode* xAST = parseFormula(getStringFrom(x, " "));
+  OwnedAST xAST(parseFormula(getStringFrom(x, " ")));
   if (xAST==NULL) {
     err << "unable to parse the formula '" << getStringFrom(x, " ") << "' as a valid mathematical expression.";
     setError(err.str(), phrased_yylloc_last_line-1);
     return true;
   }
-  curve.push_back(xAST);
+  curve.push_back(move(xAST));
   return false;
 }
 
+//Parses 'formula', or copies the AST it was parsed to before.  The caller owns the result, which is NULL if the formula could not be parsed (which is never cached).
 ASTNode* Registry::parseFormula(const string& formula)
 {
-  ASTNode* ret = SBML_parseL3FormulaWithSettings(formula.c_str(), &m_l3ps);
-  //set<string> variables;
-  //getVariablesFromASTNode(ret->deepCopy(), variables);
-  return fixTime(ret);
+  shared_ptr<const ASTNode> cached = m_formulaCache.find(formula);
+  if (!cached) {
+    ASTNode* parsed = fixTime(SBML_parseL3FormulaWithSettings(formula.c_str(), &m_l3ps));
+    if (parsed == NULL) {
+      return NULL;
+    }
+    cached.reset(parsed);
+    m_formulaCache.insert(formula, cached);
+  }
+  return cached->deepCopy();
 }
 
 ASTNode* Registry::fixTime(ASTNode* astn)
@@ -1271,8 +2130,8 @@ bool Registry::addPlot( vector<vector<string>*>* plotlist, stringstream& err, co
   vector<string> x;
   vector<string> y;
   vector<string> z;
-  vector<ASTNode*> curve;
-  vector<vector<ASTNode*> > curves;
+  vector<OwnedAST> curve;
+  vector<vector<OwnedAST> > curves;
   vector<string> thisoutput;
   int axis = 0;
   for (size_t pl=0; pl<plotlist->size(); pl++) {
@@ -1321,7 +2180,7 @@ bool Registry::addPlot( vector<vector<string>*>* plotlist, stringstream& err, co
         return true;
       }
     }
-    curves.push_back(curve);
+    curves.push_back(move(curve));
     axis = 0;
     y.clear();
     z.clear();
@@ -1336,11 +2195,11 @@ bool Registry::addPlot( vector<vector<string>*>* plotlist, stringstream& err, co
       return true;
     }
   }
-  PhrasedOutput pout(curves);
+  PhrasedOutput pout(move(curves));
   if (name) {
     pout.setName(*name);
   }
-  m_outputs.push_back(pout);
+  m_outputs.push_back(move(pout));
   return false;
 }
 
@@ -1364,22 +2223,22 @@ bool Registry::addReport( vector<vector<string>*>* plotlist, stringstream& err,
     outputs.push_back(thisoutput);
     thisoutput.clear();
   }
-  vector<ASTNode*> outputASTs;
+  vector<OwnedAST> outputASTs;
   for (size_t i=0; i<outputs.size(); i++) {
     string wholeoutput = getStringFrom(&(outputs[i]), " ");
-    ASTNode* astn = parseFormula(wholeoutput);
+    OwnedAST astn(parseFormula(wholeoutput));
     if (astn == NULL) {
       err << "unable to parse the formula '" << wholeoutput << "' as a valid mathematical expression.";
       setError(err.str(), phrased_yylloc_last_line-1);
       return true;
     }
-    outputASTs.push_back(astn);
+    outputASTs.push_back(move(astn));
   }
-  PhrasedOutput pout(outputASTs);
+  PhrasedOutput pout(move(outputASTs));
   if (name) {
     pout.setName(*name);
   }
-  m_outputs.push_back(pout);
+  m_outputs.push_back(move(pout));
   return false;
 }
 
@@ -6,7 +6,14 @@
 #include <sstream>
 #include <set>
 #include <map>
+#include <memory>
 #include "phrasedml-namespace.h"
+#include "costEstimate.h"
+#include "formulaCache.h"
+#include "statementStream.h"
+#include "sbmlIndex.h"
+#include "sbmlLoader.h"
+#include "sbmlx.h"
 
 #include "sedml/SedTypes.h"
 #include "sbml/math/L3ParserSettings.h"
@@ -19,6 +26,18 @@ class PhrasedTask;
 class PhrasedRepeatedTask;
 class PhrasedOutput;
 class ModelChange;
+class CombineArchive;
+struct OutputShape;
+
+//The outcome of finalizing one element, which may happen on another thread:  its error, if it failed, and any warnings.
+struct FinalizeResult
+{
+  FinalizeResult() : failed(false), error(), errorLine(0), warnings() {};
+  bool failed;
+  std::string error;
+  int errorLine;
+  std::vector<std::string> warnings;
+};
 
 class Registry
 {
@@ -39,10 +58,55 @@ private:
   std::vector<PhrasedRepeatedTask> m_repeatedTasks;
   std::vector<PhrasedOutput>       m_outputs;
 
-  //Any saved SBML documents the user has set:
-  std::map<std::string, libsbml::SBMLDocument*> m_referencedSBML;
+  //Any saved SBML documents the user has set, which may be shared with the user:
+  std::map<std::string, std::shared_ptr<const libsbml::SBMLDocument> > m_referencedSBML;
+  //And their indexes, made the first time each is used:
+  std::map<std::string, std::shared_ptr<const SBMLIndex> > m_referencedIndexes;
+
+  //SBML files being indexed in the background for this conversion, by filename:
+  std::map<std::string, PendingSBMLIndex> m_pendingSBML;
+
+  //While converting the documents of a COMBINE archive:  the archive, which models are found in instead of on disk, and the directory of the document being converted.  Afterwards, each document's location and phraSED-ML:
+  const CombineArchive*    m_archive;
+  std::string              m_archiveDirectory;
+  std::vector<std::string> m_archiveLocations;
+  std::vector<std::string> m_archivePhraSEDML;
 
   L3ParserSettings         m_l3ps;
+  //Every formula parsed with m_l3ps, kept from one conversion to the next:
+  FormulaCache             m_formulaCache;
+
+  //Standalone documents from the last call to shardRepeatedTask:
+  std::vector<std::string> m_shardPhraSEDML;
+  std::vector<std::string> m_shardSEDML;
+
+  RunCosts                 m_runCosts;
+
+  //For re-parsing only some statements:  how many of each element have been finalized, whether finalizing is put off until every statement is parsed, and whether m_sedml is out of date.
+  size_t                   m_finalizedModels;
+  size_t                   m_finalizedSimulations;
+  size_t                   m_finalizedTasks;
+  size_t                   m_finalizedRepeatedTasks;
+  size_t                   m_finalizedOutputs;
+  bool                     m_deferFinalize;
+  bool                     m_sedmlStale;
+  size_t                   m_revision;
+
+  //For streaming statements to a callback as they are parsed:  how many of each element have been passed on already, and the last statement that only changed an element.
+  StatementCallback        m_statementCallback;
+  void*                    m_statementUserData;
+  size_t                   m_streamedModels;
+  size_t                   m_streamedSimulations;
+  size_t                   m_streamedTasks;
+  size_t                   m_streamedRepeatedTasks;
+  size_t                   m_streamedOutputs;
+  ParsedStatement          m_statement;
+
+  //How many threads to finalize elements on (zero for one per core).
+  size_t                   m_numThreads;
+
+  //Whether to convert without ever loading the SBML models, using generic XPaths for their elements.
+  bool                     m_structural;
 
 public:
   Registry();
@@ -53,26 +117,32 @@ public:
   char* convertFile(const std::string& filename);
   char* convertString(std::string model);
 
-  L3ParserSettings* getL3ParserSettings() {return &m_l3ps;};
+  //The settings may be changed, which would make any formula parsed with the old ones wrong.
+  L3ParserSettings* getL3ParserSettings() {m_formulaCache.clear(); return &m_l3ps;};
 
-  void setError(std::string error, int line) {m_error = error; m_errorLine=line;};
-  void addErrorPrefix(std::string error) {m_error = error + m_error;};
-  void addWarning(std::string warning) {m_warnings.push_back(warning);};
+  void setError(std::string error, int line);
+  void addErrorPrefix(std::string error);
+  void addWarning(std::string warning);
   void clearWarnings() {m_warnings.clear();};
 
   std::string getSeparator() const {return m_separator;};
 
   char* getPhraSEDML() const;
-  char* getSEDML() const;
+  char* getSEDML();
   size_t getNumModels() const;
+  const PhrasedModel* getModel(size_t num) const;
   const PhrasedModel* getModel(std::string modid) const;
   PhrasedModel* getModel(std::string modid);
   const PhrasedSimulation* getSimulation(std::string simid) const;
   PhrasedSimulation* getSimulation(std::string simid);
+  size_t getNumSimulations() const;
+  const PhrasedSimulation* getSimulation(size_t num) const;
   size_t getNumTasks() const;
   const PhrasedTask* getTask(size_t num) const;
   const PhrasedTask* getTask(std::string taskid) const;
   PhrasedTask* getTask(std::string taskid);
+  size_t getNumOutputs() const;
+  const PhrasedOutput* getOutput(size_t num) const;
 
   std::string getError() {return m_error;};
   int getErrorLine() {return m_errorLine;};
@@ -125,16 +195,59 @@ public:
   std::string getWorkingFilename(const std::string& filename);
 
   libsbml::ASTNode* parseFormula(const std::string& formula);
+  void setFormulaCacheSize(size_t maxSize) {m_formulaCache.setMaxSize(maxSize);};
+  const FormulaCache& getFormulaCache() const {return m_formulaCache;};
 
   //When we're done, make sure the whole thing is coherent.
   bool finalize();
+  void setNumThreads(size_t numThreads) {m_numThreads = numThreads;};
+  size_t getNumThreads() const {return m_numThreads;};
+  void setStructural(bool structural) {m_structural = structural;};
+  bool getStructural() const {return m_structural;};
 
   //For parsing filenames that the user has given to us in memory instead:
-  void setReferencedSBML(const char* filename, libsbml::SBMLDocument* doc);
+  void setReferencedSBML(const char* filename, std::shared_ptr<const libsbml::SBMLDocument> doc);
+  void setReferencedSBML(const std::vector<std::string>& filenames, const std::vector<std::shared_ptr<const libsbml::SBMLDocument> >& docs);
   void clearReferencedSBML();
-  libsbml::SBMLDocument* getSavedSBML(std::string filename);
+  std::shared_ptr<const libsbml::SBMLDocument> getSavedSBML(std::string filename);
+  std::shared_ptr<const SBMLIndex> getSavedSBMLIndex(std::string filename);
+  PendingSBMLIndex indexSBMLFile(const std::string& filename);
   void addDotXMLToModelSources(bool force=false);
 
+  //Splitting a repeated task into standalone documents, each running one slice of its range:
+  bool shardRepeatedTask(const std::string& taskid, size_t numShards);
+  size_t getNumShards() const;
+  char* getShardPhraSEDML(size_t shard);
+  char* getShardSEDML(size_t shard);
+
+  //Converting every SED-ML document in a COMBINE archive, with each model in it parsed only once:
+  bool convertArchive(const std::string& filename);
+  size_t getNumArchiveDocuments() const;
+  char* getArchiveDocumentLocation(size_t document);
+  char* getArchivePhraSEDML(size_t document);
+
+  //The shapes of the results of every data generator and output, so they can be allocated in advance:
+  bool getOutputShapes(std::vector<OutputShape>& dataGenerators, std::vector<OutputShape>& outputs);
+
+  //Estimating what running every task will take, calibrated with measured costs per algorithm:
+  void setRunCost(int kisao, double secondsPerRun, double secondsPerPoint);
+  void clearRunCosts();
+  bool getCostEstimate(std::vector<TaskCost>& tasks, TaskCost& total);
+
+  //Re-parsing only the statements of an edited phraSED-ML document that changed, in place of everything they defined:
+  void clearElements();
+  void removeElement(const std::string& id);
+  void removeOutput(size_t num);
+  bool parseStatements(const std::string& statements, int firstLine);
+  bool finalizeParsedStatements();
+  void sortElements(const std::map<std::string, size_t>& positions, const std::vector<size_t>& outputPositions);
+  size_t getRevision() const {return m_revision;};
+
+  //Passing each statement to a callback as soon as it is parsed, with finalizing (via finalizeParsedStatements) as a separate step:
+  bool streamStatements(std::istream* stream, StatementCallback callback, void* userData);
+  bool streamFile(const std::string& filename, StatementCallback callback, void* userData);
+  bool endStatement(char lineend);
+
   //Some people might not want to write the Timestamp to SBML files.
   void SetWriteSEDMLTimestamp(bool set);
   bool GetWriteSEDMLTimestamp();
@@ -161,8 +274,14 @@ private:
   void clearSEDML();
 
   void createSEDML();
+  void refreshSEDML();
+  void setOutputIds();
+  bool reportFinalizeResults(const std::vector<FinalizeResult>& results);
+  std::string writeSEDML(libsedml::SedDocument* sedml) const;
+  void addTaskDependencies(const std::string& taskid, std::set<std::string>& tasks, std::set<std::string>& models, std::set<std::string>& simulations) const;
   bool file_exists (const std::string& filename);
-  bool addASTToCurve(const std::vector<std::string>* x, std::vector<libsbml::ASTNode*>& curve, std::stringstream& err);
+  bool findInputFile(const std::string& filename, std::string& file);
+  bool addASTToCurve(const std::vector<std::string>* x, std::vector<OwnedAST>& curve, std::stringstream& err);
   bool addPlot(std::vector<std::vector<std::string>*>* plotlist, std::stringstream& err, const std::string* name);
   bool addReport(std::vector<std::vector<std::string>*>* plotlist, std::stringstream& err, const std::string* name);
 
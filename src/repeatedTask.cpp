@@ -2,10 +2,12 @@
 #include <cassert>
 #include <functional>
 #include <iostream>
+#include <limits>
 #include <sstream>
 #include <ostream>
 #include <set>
 
+#include "compiledFormula.h"
 #include "registry.h"
 #include "repeatedTask.h"
 #include "stringx.h"
@@ -22,7 +24,7 @@ PHRASEDML_CPP_NAMESPACE_BEGIN
 PhrasedRepeatedTask::PhrasedRepeatedTask(std::string id, std::string task, vector<ModelChange>* changes)
   : PhrasedTask(id, "", "")
   , m_tasks()
-  , m_changes(*changes)
+  , m_changes(move(*changes))
   , m_resetModel(false)
 {
   m_tasks.push_back(task);
@@ -47,12 +49,12 @@ PhrasedRepeatedTask::PhrasedRepeatedTask(SedRepeatedTask* sedRepeatedTask)
   for (unsigned long r=0; r<sedRepeatedTask->getNumRanges(); r++) {
     SedRange* sr = sedRepeatedTask->getRange(r);
     ModelChange mc(sr);
-    m_changes.push_back(mc);
+    m_changes.push_back(move(mc));
     if (sr->getTypeCode() == SEDML_RANGE_FUNCTIONALRANGE) {
       SedFunctionalRange* sfr = static_cast<SedFunctionalRange*>(sr);
       for (unsigned long v=0; v<sfr->getNumVariables(); v++) {
         ModelChange mc_v(sfr);
-        m_changes.push_back(mc_v);
+        m_changes.push_back(move(mc_v));
       }
     }
   }
@@ -63,10 +65,10 @@ PhrasedRepeatedTask::PhrasedRepeatedTask(SedRepeatedTask* sedRepeatedTask)
       source = ssv->getRange();
     }
     ModelChange mc(ssv, source);
-    m_changes.push_back(mc);
+    m_changes.push_back(move(mc));
     for (unsigned long p=0; p<ssv->getNumParameters(); p++) {
       ModelChange mc_p(ssv->getParameter(p));
-      m_changes.push_back(mc_p);
+      m_changes.push_back(move(mc_p));
     }
   }
 }
@@ -189,6 +191,159 @@ const ModelChange* PhrasedRepeatedTask::getModelChangeFor(std::string varname) c
   return NULL;
 }
 
+vector<string> PhrasedRepeatedTask::getTasks() const
+{
+  return m_tasks;
+}
+
+const vector<ModelChange>& PhrasedRepeatedTask::getChanges() const
+{
+  return m_changes;
+}
+
+bool PhrasedRepeatedTask::getResetModel() const
+{
+  return m_resetModel;
+}
+
+void PhrasedRepeatedTask::setTasks(vector<string> tasks)
+{
+  m_tasks = tasks;
+}
+
+//SED-ML requires every range to be at least as long as the repeated task's master range, so the shortest range is the number of times the subtasks are run.
+size_t PhrasedRepeatedTask::getNumIterations() const
+{
+  size_t ret = 0;
+  bool found = false;
+  for (size_t c=0; c<m_changes.size(); c++) {
+    change_type type = m_changes[c].getType();
+    if (isLoop(type) && type != ctype_loop_functional) {
+      size_t num = m_changes[c].getNumRangeValues();
+      if (!found || num < ret) {
+        ret = num;
+      }
+      found = true;
+    }
+  }
+  return ret;
+}
+
+//Fills 'values' with the value each uniform or vector range takes on the given iteration.  Functional ranges and assignments are calculated from those by the simulator, and are not included.
+void PhrasedRepeatedTask::getRangeValues(size_t iteration, vector<pair<string, double> >& values) const
+{
+  for (size_t c=0; c<m_changes.size(); c++) {
+    change_type type = m_changes[c].getType();
+    if (isLoop(type) && type != ctype_loop_functional) {
+      vector<string> variable = m_changes[c].getVariable();
+      values.push_back(make_pair(getStringFrom(&variable, "."), m_changes[c].getRangeValue(iteration)));
+    }
+  }
+}
+
+//Returns a copy of this repeated task with the new ID that only runs iterations [begin, end).
+PhrasedRepeatedTask PhrasedRepeatedTask::getSlice(string id, size_t begin, size_t end) const
+{
+  PhrasedRepeatedTask ret(*this);
+  ret.setId(id);
+  ret.setName("");
+  ret.m_changes.clear();
+  for (size_t c=0; c<m_changes.size(); c++) {
+    ret.m_changes.push_back(m_changes[c].getRangeSlice(begin, end));
+  }
+  return ret;
+}
+
+//Calculates the value the change to 'id' takes on every iteration, without running a simulation:  ranges give their own values, and functional ranges and formula assignments are evaluated over all iterations at once from the ranges and local parameters they use.  Returns true on error, including when a formula uses a model variable, whose value is only known during a simulation.
+bool PhrasedRepeatedTask::getChangeValues(const string& id, vector<double>& values) const
+{
+  values.clear();
+  size_t change = getChangeIndex(id);
+  if (change == m_changes.size()) {
+    g_registry.setError("Unable to calculate the values of '" + id + "' in repeated task '" + m_id + "':  no such change exists.", 0);
+    return true;
+  }
+  return getChangeValues(change, values);
+}
+
+//The same, for the change at this position in getChanges().
+bool PhrasedRepeatedTask::getChangeValues(size_t change, vector<double>& values) const
+{
+  values.clear();
+  if (change >= m_changes.size()) {
+    stringstream err;
+    err << "Unable to calculate the values of change " << change << " in repeated task '" << m_id << "':  it only has " << m_changes.size() << " changes.";
+    g_registry.setError(err.str(), 0);
+    return true;
+  }
+  set<size_t> visiting;
+  return evaluateChange(change, visiting, values);
+}
+
+bool PhrasedRepeatedTask::evaluateChange(size_t change, set<size_t>& visiting, vector<double>& values) const
+{
+  const ModelChange& mc = m_changes[change];
+  size_t num = getNumIterations();
+  values.clear();
+  switch(mc.getType()) {
+  case ctype_val_assignment:
+    {
+      vector<double> value = mc.getValues();
+      values.resize(num, value.empty() ? numeric_limits<double>::quiet_NaN() : value[0]);
+      return false;
+    }
+  case ctype_loop_uniformLinear:
+  case ctype_loop_uniformLog:
+  case ctype_loop_vector:
+    for (size_t i=0; i<num; i++) {
+      values.push_back(mc.getRangeValue(i));
+    }
+    return false;
+  case ctype_formula_assignment:
+  case ctype_loop_functional:
+    break;
+  }
+
+  vector<string> changeid = mc.getVariable();
+  string changename = getStringFrom(&changeid, ".");
+  CompiledFormula formula;
+  if (formula.compile(mc.getASTNode())) {
+    g_registry.addErrorPrefix("Unable to calculate the values of '" + changename + "' in repeated task '" + m_id + "':  ");
+    return true;
+  }
+  visiting.insert(change);
+  vector<string> variables = formula.getVariables();
+  vector<vector<double> > columns(variables.size());
+  vector<FormulaInput> inputs;
+  for (size_t v=0; v<variables.size(); v++) {
+    size_t source = getChangeIndex(variables[v]);
+    if (source == m_changes.size() || source == change) {
+      g_registry.setError("Unable to calculate the values of '" + changename + "' in repeated task '" + m_id + "':  it uses '" + variables[v] + "', whose value is only known during a simulation.", 0);
+      return true;
+    }
+    if (visiting.find(source) != visiting.end()) {
+      g_registry.setError("Unable to calculate the values of '" + changename + "' in repeated task '" + m_id + "':  its formula depends on itself through '" + variables[v] + "'.", 0);
+      return true;
+    }
+    if (evaluateChange(source, visiting, columns[v])) {
+      return true;
+    }
+  }
+  visiting.erase(change);
+  if (num == 0) {
+    return false;
+  }
+  for (size_t v=0; v<columns.size(); v++) {
+    FormulaInput input;
+    input.values = &columns[v][0];
+    input.stride = 1;
+    inputs.push_back(input);
+  }
+  values.resize(num);
+  formula.evaluate(inputs, num, &values[0]);
+  return false;
+}
+
 bool PhrasedRepeatedTask::changeListIsInappropriate(stringstream& err)
 {
   for (size_t c=0; c<m_changes.size(); c++) {
@@ -400,4 +555,17 @@ ModelChange* PhrasedRepeatedTask::getModelChange(std::string id)
   }
   return NULL;
 }
+
+//The index of the change whose variable ends with 'id', or m_changes.size() if there is none.
+size_t PhrasedRepeatedTask::getChangeIndex(const string& id) const
+{
+  for (size_t c=0; c<m_changes.size(); c++) {
+    vector<string> changeId = m_changes[c].getVariable();
+    if (!changeId.empty() && changeId[changeId.size()-1] == id) {
+      return c;
+    }
+  }
+  return m_changes.size();
+}
+
 PHRASEDML_CPP_NAMESPACE_END
@@ -3,6 +3,7 @@
 
 #include <string>
 #include <vector>
+#include <set>
 
 #include "variable.h"
 #include "modelChange.h"
@@ -30,6 +31,10 @@ public:
 
   PhrasedRepeatedTask(std::string id, std::string task, std::vector<ModelChange>*);
   PhrasedRepeatedTask(libsedml::SedRepeatedTask* sedRepeatedTask);
+  PhrasedRepeatedTask(const PhrasedRepeatedTask& orig) = default;
+  PhrasedRepeatedTask(PhrasedRepeatedTask&& orig) = default;
+  PhrasedRepeatedTask& operator=(const PhrasedRepeatedTask& rhs) = default;
+  PhrasedRepeatedTask& operator=(PhrasedRepeatedTask&& rhs) = default;
   ~PhrasedRepeatedTask();
 
   virtual bool isRepeated() const;
@@ -39,6 +44,16 @@ public:
 
   virtual const ModelChange* getModelChangeFor(std::string varname) const;
 
+  virtual std::vector<std::string> getTasks() const;
+  virtual const std::vector<ModelChange>& getChanges() const;
+  virtual bool getResetModel() const;
+  virtual void setTasks(std::vector<std::string> tasks);
+  virtual size_t getNumIterations() const;
+  virtual void getRangeValues(size_t iteration, std::vector<std::pair<std::string, double> >& values) const;
+  virtual PhrasedRepeatedTask getSlice(std::string id, size_t begin, size_t end) const;
+  virtual bool getChangeValues(const std::string& id, std::vector<double>& values) const;
+  virtual bool getChangeValues(size_t change, std::vector<double>& values) const;
+
   virtual bool changeListIsInappropriate(std::stringstream& err);
   virtual std::set<PhrasedModel*> getModels() const;
   virtual bool isRecursive(std::set<PhrasedTask*>& tasks);
@@ -47,6 +62,8 @@ public:
 private:
   void addLocalVariablesToSetValue(libsedml::SedSetValue* ssv, libsedml::SedRepeatedTask* srt) const;
   ModelChange* getModelChange(std::string id);
+  size_t getChangeIndex(const std::string& id) const;
+  bool evaluateChange(size_t change, std::set<size_t>& visiting, std::vector<double>& values) const;
 
 };
 
@@ -0,0 +1,262 @@
+#include <cstring>
+#include <locale>
+#include <sstream>
+
+#include "reportWriter.h"
+#include "registry.h"
+
+#include "sedml/SedDataSet.h"
+
+using namespace std;
+using namespace libsedml;
+
+PHRASEDML_CPP_NAMESPACE_BEGIN
+
+ReportWriter::ReportWriter(SedReport* report, ostream& out, report_format format)
+  : m_out(out)
+  , m_format(format)
+  , m_id()
+  , m_indexLabels()
+  , m_labels()
+  , m_dataReferences()
+  , m_started(false)
+  , m_finished(false)
+  , m_numRows(0)
+  , m_scratch()
+{
+  if (report == NULL) {
+    return;
+  }
+  m_id = report->getId();
+  for (unsigned int d=0; d<report->getNumDataSets(); d++) {
+    SedDataSet* dataset = report->getDataSet(d);
+    string label = dataset->getLabel();
+    if (label.empty()) {
+      label = dataset->getDataReference();
+    }
+    m_labels.push_back(label);
+    m_dataReferences.push_back(dataset->getDataReference());
+  }
+}
+
+ReportWriter::~ReportWriter()
+{
+}
+
+//Adds a column that comes before the datasets, such as the iteration of an enclosing repeated task.  Must be called before the first block is written.  Returns true on error.
+bool ReportWriter::addIndexColumn(const string& label)
+{
+  if (m_started) {
+    g_registry.setError("Unable to add the index column '" + label + "' to report '" + m_id + "':  rows have already been written.", 0);
+    return true;
+  }
+  m_indexLabels.push_back(label);
+  return false;
+}
+
+//The labels of every column, index columns first.
+vector<string> ReportWriter::getLabels() const
+{
+  vector<string> ret = m_indexLabels;
+  ret.insert(ret.end(), m_labels.begin(), m_labels.end());
+  return ret;
+}
+
+//The data generators of the report's datasets, in order.
+vector<string> ReportWriter::getDataReferences() const
+{
+  return m_dataReferences;
+}
+
+size_t ReportWriter::getNumColumns() const
+{
+  return m_indexLabels.size() + m_labels.size();
+}
+
+size_t ReportWriter::getNumRows() const
+{
+  return m_numRows;
+}
+
+string ReportWriter::getCSVLabel(const string& label) const
+{
+  if (label.find_first_of(",\"\n\r") == string::npos) {
+    return label;
+  }
+  string ret = "\"";
+  for (size_t c=0; c<label.size(); c++) {
+    if (label[c] == '"') {
+      ret += '"';
+    }
+    ret += label[c];
+  }
+  return ret + "\"";
+}
+
+void ReportWriter::writeUInt32(size_t value)
+{
+  unsigned int val = static_cast<unsigned int>(value);
+  m_out.write(reinterpret_cast<const char*>(&val), sizeof(val));
+}
+
+bool ReportWriter::writeHeader()
+{
+  m_started = true;
+  vector<string> labels = getLabels();
+  if (m_format == rformat_csv) {
+    for (size_t l=0; l<labels.size(); l++) {
+      if (l > 0) {
+        m_out << ",";
+      }
+      m_out << getCSVLabel(labels[l]);
+    }
+    m_out << "\n";
+  }
+  else {
+    m_out.write("PHRSDRPT", 8);
+    writeUInt32(1);
+    writeUInt32(0x01020304);
+    writeUInt32(labels.size());
+    for (size_t l=0; l<labels.size(); l++) {
+      writeUInt32(labels[l].size());
+      m_out.write(labels[l].data(), labels[l].size());
+    }
+  }
+  if (!m_out) {
+    g_registry.setError("Unable to write the header of report '" + m_id + "'.", 0);
+    return true;
+  }
+  return false;
+}
+
+//Writes 'numRows' rows, taking one pointer per column (index columns first, then datasets, in order); each must have at least 'numRows' values.  Returns true on error.
+bool ReportWriter::writeBlock(const vector<const double*>& columns, size_t numRows)
+{
+  if (m_finished) {
+    g_registry.setError("Unable to write to report '" + m_id + "':  it has already been finished.", 0);
+    return true;
+  }
+  if (columns.size() != getNumColumns()) {
+    stringstream err;
+    err << "Unable to write to report '" << m_id << "':  it has " << getNumColumns() << " columns, but " << columns.size() << " were provided.";
+    g_registry.setError(err.str(), 0);
+    return true;
+  }
+  if (!m_started && writeHeader()) {
+    return true;
+  }
+  if (numRows == 0) {
+    return false;
+  }
+  if (m_format == rformat_csv) {
+    //Format a block at a time, always in the "C" locale, with enough digits to read the same doubles back.
+    stringstream block;
+    block.imbue(locale::classic());
+    block.precision(17);
+    for (size_t r=0; r<numRows; r++) {
+      for (size_t c=0; c<columns.size(); c++) {
+        if (c > 0) {
+          block << ",";
+        }
+        block << columns[c][r];
+      }
+      block << "\n";
+    }
+    m_out << block.rdbuf();
+  }
+  else {
+    unsigned long long rows = numRows;
+    m_out.write(reinterpret_cast<const char*>(&rows), sizeof(rows));
+    for (size_t c=0; c<columns.size(); c++) {
+      m_out.write(reinterpret_cast<const char*>(columns[c]), numRows*sizeof(double));
+    }
+  }
+  if (!m_out) {
+    g_registry.setError("Unable to write to report '" + m_id + "'.", 0);
+    return true;
+  }
+  m_numRows += numRows;
+  return false;
+}
+
+//Evaluates each dataset's data generator over the evaluator's current columns, and writes the results as the next block.  The evaluator should hold just this block's simulation results, so a data generator with an aggregate like 'max' (which would only be over the block, not the whole report) is an error:  evaluate those over the whole report, and write them with the other writeBlock.  Returns true on error.
+bool ReportWriter::writeBlock(const DataGeneratorEvaluator& evaluator, const vector<const double*>& indices, size_t numRows)
+{
+  if (indices.size() != m_indexLabels.size()) {
+    stringstream err;
+    err << "Unable to write to report '" << m_id << "':  it has " << m_indexLabels.size() << " index columns, but " << indices.size() << " were provided.";
+    g_registry.setError(err.str(), 0);
+    return true;
+  }
+  for (size_t d=0; d<m_dataReferences.size(); d++) {
+    if (evaluator.hasAggregates(m_dataReferences[d])) {
+      g_registry.setError("Unable to write to report '" + m_id + "' a block at a time:  the data generator '" + m_dataReferences[d] + "' uses an aggregate (like max or min), whose value depends on every row of the report, not just those of one block.", 0);
+      return true;
+    }
+  }
+  m_scratch.resize(m_dataReferences.size() * numRows);
+  vector<const double*> columns = indices;
+  vector<double> single;
+  for (size_t d=0; d<m_dataReferences.size(); d++) {
+    double* column = m_scratch.empty() ? NULL : &m_scratch[d*numRows];
+    size_t length = 0;
+    if (evaluator.getLength(m_dataReferences[d], length)) {
+      g_registry.setError("Unable to write to report '" + m_id + "':  the data generator '" + m_dataReferences[d] + "' does not exist, or not all of its variables have values.", 0);
+      return true;
+    }
+    if (length == 1 && numRows > 1) {
+      //A single value (like a constant) is repeated in every row.
+      if (evaluator.evaluate(m_dataReferences[d], single)) {
+        return true;
+      }
+      for (size_t r=0; r<numRows; r++) {
+        column[r] = single[0];
+      }
+    }
+    else if (length < numRows) {
+      stringstream err;
+      err << "Unable to write to report '" << m_id << "':  the data generator '" << m_dataReferences[d] << "' only has " << length << " values, but the block has " << numRows << " rows.";
+      g_registry.setError(err.str(), 0);
+      return true;
+    }
+    else if (numRows > 0) {
+      if (length == numRows) {
+        if (evaluator.evaluate(m_dataReferences[d], column)) {
+          return true;
+        }
+      }
+      else {
+        if (evaluator.evaluate(m_dataReferences[d], single)) {
+          return true;
+        }
+        memcpy(column, &single[0], numRows*sizeof(double));
+      }
+    }
+    columns.push_back(column);
+  }
+  return writeBlock(columns, numRows);
+}
+
+//Ends the report, writing the header first if no rows were written, and flushes the stream.  Returns true on error.
+bool ReportWriter::finish()
+{
+  if (m_finished) {
+    return false;
+  }
+  if (!m_started && writeHeader()) {
+    return true;
+  }
+  if (m_format == rformat_binary) {
+    unsigned long long rows = 0;
+    m_out.write(reinterpret_cast<const char*>(&rows), sizeof(rows));
+  }
+  m_out.flush();
+  m_finished = true;
+  if (!m_out) {
+    g_registry.setError("Unable to finish writing report '" + m_id + "'.", 0);
+    return true;
+  }
+  return false;
+}
+
+PHRASEDML_CPP_NAMESPACE_END
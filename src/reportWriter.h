@@ -0,0 +1,64 @@
+#ifndef PHRASEDREPORTWRITER_H
+#define PHRASEDREPORTWRITER_H
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "dataGeneratorEvaluator.h"
+#include "phrasedml-namespace.h"
+
+#include "sedml/SedReport.h"
+
+PHRASEDML_CPP_NAMESPACE_BEGIN
+
+enum report_format {
+    rformat_csv
+  , rformat_binary
+};
+
+//Writes the results of a SED-ML report to a stream, a block of rows at a time, so that nothing more than one block is ever held in memory.  Columns follow the order of the report's datasets and use their labels, after any index columns (for example, the iteration of each enclosing repeated task) added before the first block is written.
+//
+//The binary format is:  the eight bytes 'PHRSDRPT', a uint32 format version (1), a uint32 byte-order mark (0x01020304, written in native order), a uint32 column count, then for each column a uint32 length and that many bytes of label.  Each block follows as a uint64 row count and then each column's values in turn, as native doubles.  A final block with zero rows ends the report.
+class ReportWriter
+{
+private:
+  ReportWriter(); //undefined
+  ReportWriter(const ReportWriter&); //undefined
+  ReportWriter& operator=(const ReportWriter&); //undefined
+
+  std::ostream& m_out;
+  report_format m_format;
+  std::string m_id;
+  std::vector<std::string> m_indexLabels;
+  std::vector<std::string> m_labels;
+  std::vector<std::string> m_dataReferences;
+  bool m_started;
+  bool m_finished;
+  size_t m_numRows;
+  std::vector<double> m_scratch;
+
+public:
+  ReportWriter(libsedml::SedReport* report, std::ostream& out, report_format format);
+  ~ReportWriter();
+
+  bool addIndexColumn(const std::string& label);
+
+  std::vector<std::string> getLabels() const;
+  std::vector<std::string> getDataReferences() const;
+  size_t getNumColumns() const;
+  size_t getNumRows() const;
+
+  bool writeBlock(const std::vector<const double*>& columns, size_t numRows);
+  bool writeBlock(const DataGeneratorEvaluator& evaluator, const std::vector<const double*>& indices, size_t numRows);
+  bool finish();
+
+private:
+  bool writeHeader();
+  void writeUInt32(size_t value);
+  std::string getCSVLabel(const std::string& label) const;
+};
+
+PHRASEDML_CPP_NAMESPACE_END
+
+#endif //PHRASEDREPORTWRITER_H
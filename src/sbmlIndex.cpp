@@ -0,0 +1,441 @@
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <expat.h>
+
+#include "sbmlIndex.h"
+#include "compressedInput.h"
+#include "stringx.h"
+#include "sbml/SBMLTypes.h"
+
+using namespace std;
+using namespace libsbml;
+
+PHRASEDML_CPP_NAMESPACE_BEGIN
+
+//The type of an SBML core element, from its name, if it's one an XPath needs to know.  Level 1 called species 'specie'.
+static int getTypeFromName(const string& name)
+{
+  if (name == "species" || name == "specie") {
+    return SBML_SPECIES;
+  }
+  if (name == "compartment") {
+    return SBML_COMPARTMENT;
+  }
+  if (name == "parameter") {
+    return SBML_PARAMETER;
+  }
+  if (name == "localParameter") {
+    return SBML_LOCAL_PARAMETER;
+  }
+  if (name == "reaction") {
+    return SBML_REACTION;
+  }
+  if (name == "model") {
+    return SBML_MODEL;
+  }
+  return SBML_UNKNOWN;
+}
+
+SBMLIndex::SBMLIndex()
+  : m_elements()
+  , m_ids()
+  , m_level(3)
+  , m_version(1)
+  , m_namespaces()
+  , m_hasModel(false)
+  , m_hasErrors(false)
+  , m_contentHash(0)
+{
+  m_namespaces.add("http://www.sbml.org/sbml/level3/version1/core");
+}
+
+SBMLIndex::~SBMLIndex()
+{
+}
+
+void SBMLIndex::clear()
+{
+  m_elements.clear();
+  m_ids.clear();
+  m_hasModel = false;
+  m_hasErrors = false;
+  m_contentHash = 0;
+}
+
+size_t SBMLIndex::addElement(const string& id, int type, size_t parent)
+{
+  SBMLIndexElement element;
+  element.id = id;
+  element.type = type;
+  element.parent = parent;
+  element.hasInitialAmount = false;
+  element.hasInitialConcentration = false;
+  m_elements.push_back(element);
+  m_ids.insert(make_pair(id, m_elements.size()-1));
+  return m_elements.size()-1;
+}
+
+//The state of a scan, passed to each of expat's callbacks.  A scan that isn't indexing only hashes.
+struct SBMLIndexScan
+{
+  SBMLIndex* index;
+  XML_Parser parser;
+  bool indexing;
+  //For each open element, the closest one with an id, at or above it.
+  vector<size_t> parents;
+  size_t skipDepth;
+  string coreURI;
+  //The namespaces declared on the element about to start.
+  XMLNamespaces declared;
+  //The text since the last start or end of an element.
+  string text;
+
+  SBMLIndexScan(SBMLIndex* scanned, bool indexElements);
+  ~SBMLIndexScan();
+
+  void hash(const string& token);
+  void hashText();
+
+  static void XMLCALL startNamespace(void* data, const XML_Char* prefix, const XML_Char* uri);
+  static void XMLCALL startElement(void* data, const XML_Char* qname, const XML_Char** attrs);
+  static void XMLCALL endElement(void* data, const XML_Char* qname);
+  static void XMLCALL characterData(void* data, const XML_Char* chars, int length);
+};
+
+//With a namespace separator, expat gives each name as 'uri name', or just 'name' if it has no namespace.
+static void splitName(const XML_Char* qname, string& uri, string& name)
+{
+  name = qname;
+  uri.clear();
+  size_t space = name.find(' ');
+  if (space != string::npos) {
+    uri = name.substr(0, space);
+    name = name.substr(space+1);
+  }
+}
+
+static const XML_Char* getAttribute(const XML_Char** attrs, const char* name)
+{
+  for (size_t a=0; attrs[a] != NULL; a+=2) {
+    if (strcmp(attrs[a], name) == 0) {
+      return attrs[a+1];
+    }
+  }
+  return NULL;
+}
+
+//Each token ends with a zero byte, which XML can't contain, so that no two sequences of tokens hash the same text.
+void SBMLIndexScan::hash(const string& token)
+{
+  index->m_contentHash = getFNV1aHash(token.c_str(), token.size()+1, index->m_contentHash);
+}
+
+//Only the text between the whitespace counts, so that indenting the XML differently doesn't change its hash.
+void SBMLIndexScan::hashText()
+{
+  size_t first = text.find_first_not_of(" \t\r\n");
+  if (first != string::npos) {
+    size_t last = text.find_last_not_of(" \t\r\n");
+    hash("text");
+    hash(text.substr(first, last-first+1));
+  }
+  text.clear();
+}
+
+void XMLCALL SBMLIndexScan::startNamespace(void* data, const XML_Char* prefix, const XML_Char* uri)
+{
+  SBMLIndexScan* scan = static_cast<SBMLIndexScan*>(data);
+  scan->declared.add(uri == NULL ? "" : uri, prefix == NULL ? "" : prefix);
+}
+
+void XMLCALL SBMLIndexScan::startElement(void* data, const XML_Char* qname, const XML_Char** attrs)
+{
+  SBMLIndexScan* scan = static_cast<SBMLIndexScan*>(data);
+  SBMLIndex* index = scan->index;
+  //Names are hashed with their namespace URIs, not their prefixes, and attributes in order of their names, not as written.
+  scan->hashText();
+  scan->hash("start");
+  scan->hash(qname);
+  vector<pair<string, string> > attributes;
+  for (size_t a=0; attrs[a] != NULL; a+=2) {
+    attributes.push_back(make_pair(string(attrs[a]), string(attrs[a+1])));
+  }
+  sort(attributes.begin(), attributes.end());
+  for (size_t a=0; a<attributes.size(); a++) {
+    scan->hash(attributes[a].first);
+    scan->hash(attributes[a].second);
+  }
+  if (!scan->indexing) {
+    return;
+  }
+  string uri, name;
+  splitName(qname, uri, name);
+  size_t parent = scan->parents.empty() ? string::npos : scan->parents.back();
+  if (scan->skipDepth > 0 || name == "annotation" || name == "notes" || name == "math") {
+    scan->skipDepth++;
+  }
+  else if (scan->parents.empty() && name == "sbml") {
+    scan->coreURI = uri;
+    index->m_namespaces = scan->declared;
+    const XML_Char* level = getAttribute(attrs, "level");
+    const XML_Char* version = getAttribute(attrs, "version");
+    index->m_level = static_cast<unsigned int>(atoi(level == NULL ? "" : level));
+    index->m_version = static_cast<unsigned int>(atoi(version == NULL ? "" : version));
+  }
+  else {
+    //Package elements have ids too, but their types are only needed for core elements.
+    int type = (uri == scan->coreURI) ? getTypeFromName(name) : SBML_UNKNOWN;
+    if (type == SBML_MODEL) {
+      index->m_hasModel = true;
+    }
+    //Level 1 elements were identified by their names.
+    const XML_Char* id = getAttribute(attrs, index->m_level == 1 ? "name" : "id");
+    if (id != NULL && id[0] != '\0') {
+      parent = index->addElement(id, type, parent);
+      if (type == SBML_SPECIES) {
+        index->m_elements[parent].hasInitialAmount = (getAttribute(attrs, "initialAmount") != NULL);
+        index->m_elements[parent].hasInitialConcentration = (getAttribute(attrs, "initialConcentration") != NULL);
+      }
+    }
+  }
+  scan->parents.push_back(parent);
+  scan->declared.clear();
+}
+
+void XMLCALL SBMLIndexScan::endElement(void* data, const XML_Char*)
+{
+  SBMLIndexScan* scan = static_cast<SBMLIndexScan*>(data);
+  scan->hashText();
+  scan->hash("end");
+  if (!scan->parents.empty()) {
+    scan->parents.pop_back();
+  }
+  if (scan->skipDepth > 0) {
+    scan->skipDepth--;
+  }
+}
+
+void XMLCALL SBMLIndexScan::characterData(void* data, const XML_Char* chars, int length)
+{
+  SBMLIndexScan* scan = static_cast<SBMLIndexScan*>(data);
+  scan->text.append(chars, static_cast<size_t>(length));
+}
+
+SBMLIndexScan::SBMLIndexScan(SBMLIndex* scanned, bool indexElements)
+  : index(scanned)
+  , parser(XML_ParserCreateNS(NULL, ' '))
+  , indexing(indexElements)
+  , parents()
+  , skipDepth(0)
+  , coreURI()
+  , declared()
+  , text()
+{
+  index->m_contentHash = getFNV1aHash("");
+  XML_SetUserData(parser, this);
+  XML_SetElementHandler(parser, startElement, endElement);
+  XML_SetCharacterDataHandler(parser, characterData);
+  if (indexing) {
+    XML_SetStartNamespaceDeclHandler(parser, startNamespace);
+  }
+}
+
+SBMLIndexScan::~SBMLIndexScan()
+{
+  XML_ParserFree(parser);
+}
+
+//Scans the SBML in 'xml', keeping only the elements with ids.  Returns true if 'xml' is not valid XML, with the reason in 'error'.
+bool SBMLIndex::read(const string& xml, string& error)
+{
+  clear();
+  SBMLIndexScan scan(this, true);
+  if (XML_Parse(scan.parser, xml.data(), static_cast<int>(xml.size()), 1) == XML_STATUS_ERROR) {
+    return setXMLError(error);
+  }
+  return false;
+}
+
+//Scans the SBML from 'stream' a block at a time, as it is read, so that the whole file is never in memory; each block is read straight into expat's own buffer.  Annotations, notes, and math are skipped entirely.  Returns true if the stream is not valid XML (or stops partway through), with the reason in 'error'.
+bool SBMLIndex::read(istream& stream, string& error)
+{
+  clear();
+  SBMLIndexScan scan(this, true);
+  const int blocksize = 65536;
+  bool done = false;
+  while (!done) {
+    char* block = static_cast<char*>(XML_GetBuffer(scan.parser, blocksize));
+    if (block == NULL) {
+      return setXMLError(error);
+    }
+    stream.read(block, blocksize);
+    streamsize got = stream.gcount();
+    done = (got < blocksize);
+    if (XML_ParseBuffer(scan.parser, static_cast<int>(got), done) == XML_STATUS_ERROR) {
+      return setXMLError(error);
+    }
+  }
+  return false;
+}
+
+bool SBMLIndex::setXMLError(string& error)
+{
+  error = "The SBML is not valid XML.";
+  clear();
+  m_hasErrors = true;
+  return true;
+}
+
+//Indexes a document that has already been read, for SBML given to phraSED-ML directly.
+void SBMLIndex::read(const SBMLDocument* doc)
+{
+  clear();
+  m_level = doc->getLevel();
+  m_version = doc->getVersion();
+  m_namespaces = *doc->getNamespaces();
+  m_hasModel = (doc->getModel() != NULL);
+  m_hasErrors = (doc->getNumErrors(LIBSBML_SEV_ERROR) != 0 || doc->getNumErrors(LIBSBML_SEV_FATAL) != 0);
+  List* all = const_cast<SBMLDocument*>(doc)->getAllElements();
+  map<const SBase*, size_t> indexes;
+  for (unsigned int e=0; e<all->getSize(); e++) {
+    const SBase* element = static_cast<const SBase*>(all->get(e));
+    if (!element->isSetId()) {
+      continue;
+    }
+    int type = (element->getPackageName() == "core") ? element->getTypeCode() : SBML_UNKNOWN;
+    size_t index = addElement(element->getId(), type, string::npos);
+    if (type == SBML_SPECIES) {
+      const Species* species = static_cast<const Species*>(element);
+      m_elements[index].hasInitialAmount = species->isSetInitialAmount();
+      m_elements[index].hasInitialConcentration = species->isSetInitialConcentration();
+    }
+    indexes.insert(make_pair(element, index));
+  }
+  delete all;
+  //The document is written out just this once, so that it's hashed in the same form as a scanned file.
+  char* sbml = writeSBMLToString(doc);
+  if (sbml != NULL) {
+    SBMLIndexScan scan(this, false);
+    XML_Parse(scan.parser, sbml, static_cast<int>(strlen(sbml)), 1);
+    free(sbml);
+  }
+  //Only once every element is in the index can each be given its parent.
+  for (map<const SBase*, size_t>::iterator i=indexes.begin(); i != indexes.end(); i++) {
+    const SBase* parent = i->first->getParentSBMLObject();
+    while (parent != NULL) {
+      map<const SBase*, size_t>::iterator found = indexes.find(parent);
+      if (found != indexes.end()) {
+        m_elements[i->second].parent = found->second;
+        break;
+      }
+      parent = parent->getParentSBMLObject();
+    }
+  }
+}
+
+bool SBMLIndex::hasModel() const
+{
+  return m_hasModel;
+}
+
+//Whether the SBML had errors when it was read.  A scan only finds XML errors; libsbml's own checks are only run on documents read in full, so for a file, they are only warned of once it is materialized.
+bool SBMLIndex::hasErrors() const
+{
+  return m_hasErrors;
+}
+
+unsigned int SBMLIndex::getLevel() const
+{
+  return m_level;
+}
+
+unsigned int SBMLIndex::getVersion() const
+{
+  return m_version;
+}
+
+const XMLNamespaces& SBMLIndex::getNamespaces() const
+{
+  return m_namespaces;
+}
+
+//The hash of the SBML's elements, attributes, and text, but not of how it was written:  namespace prefixes, the order of attributes, and whitespace around text don't change it.  A scanned file and a document read from the same SBML have the same hash (as long as libsbml writes the document the way the file was written).  Zero if the SBML was not valid XML.
+unsigned long long SBMLIndex::getContentHash() const
+{
+  return m_contentHash;
+}
+
+size_t SBMLIndex::getNumElements() const
+{
+  return m_elements.size();
+}
+
+//The first element whose id is the last of 'id', and which is inside elements with each of the others.  Returns NULL if there is none.
+const SBMLIndexElement* SBMLIndex::find(const vector<string>& id) const
+{
+  if (id.empty()) {
+    return NULL;
+  }
+  pair<multimap<string, size_t>::const_iterator, multimap<string, size_t>::const_iterator> found = m_ids.equal_range(id[id.size()-1]);
+  for (multimap<string, size_t>::const_iterator e=found.first; e != found.second; e++) {
+    const SBMLIndexElement* element = &m_elements[e->second];
+    bool inside = true;
+    for (size_t n=0; n<id.size()-1 && inside; n++) {
+      inside = isAncestor(id[n], element);
+    }
+    if (inside) {
+      return element;
+    }
+  }
+  return NULL;
+}
+
+bool SBMLIndex::isAncestor(const string& id, const SBMLIndexElement* element) const
+{
+  size_t parent = element->parent;
+  while (parent != string::npos) {
+    if (m_elements[parent].id == id) {
+      return true;
+    }
+    parent = m_elements[parent].parent;
+  }
+  return false;
+}
+
+//The id of the closest element of type 'type' that 'element' is inside, or an empty string if there is none.
+string SBMLIndex::getAncestorId(const SBMLIndexElement* element, int type) const
+{
+  size_t parent = element->parent;
+  while (parent != string::npos) {
+    if (m_elements[parent].type == type) {
+      return m_elements[parent].id;
+    }
+    parent = m_elements[parent].parent;
+  }
+  return "";
+}
+
+//Scans and indexes 'filename' as it is read, decompressing it if need be.  If it cannot be read or decompressed, there is no index at all; if it is not valid XML, the index is empty.
+shared_ptr<const SBMLIndex> indexSBMLFile(const string& filename)
+{
+  DecompressingInputStream stream(filename);
+  if (!stream.isOpen()) {
+    return shared_ptr<const SBMLIndex>();
+  }
+  shared_ptr<SBMLIndex> index(new SBMLIndex());
+  string error;
+  index->read(stream, error);
+  if (!stream.getError().empty()) {
+    return shared_ptr<const SBMLIndex>();
+  }
+  return index;
+}
+
+//Starts indexing the SBML file 'filename' on a thread of its own, and returns right away.
+PendingSBMLIndex indexSBMLInBackground(const string& filename)
+{
+  return async(launch::async, indexSBMLFile, filename).share();
+}
+
+PHRASEDML_CPP_NAMESPACE_END
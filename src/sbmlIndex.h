@@ -0,0 +1,78 @@
+#ifndef PHRASEDSBMLINDEX_H
+#define PHRASEDSBMLINDEX_H
+
+#include <future>
+#include <istream>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "sbml/SBMLDocument.h"
+#include "sbml/xml/XMLNamespaces.h"
+#include "phrasedml-namespace.h"
+
+PHRASEDML_CPP_NAMESPACE_BEGIN
+
+struct SBMLIndexScan;
+
+//One element of an SBML model with an id:  all phraSED-ML needs to know of it to build XPaths to it.
+struct SBMLIndexElement
+{
+  std::string id;
+  int type; //The libsbml type code, or SBML_UNKNOWN for any element an XPath doesn't need to know the type of.
+  size_t parent; //The closest ancestor with an id, or string::npos.
+  bool hasInitialAmount;
+  bool hasInitialConcentration;
+};
+
+//The ids of an SBML model's elements, with their types and which elements they are in, read either by scanning the XML (without building the libsbml objects for it) or from a document that has already been read.  An empty index has no model, and is for SBML that couldn't be found.
+class SBMLIndex
+{
+private:
+  std::vector<SBMLIndexElement> m_elements;
+  std::multimap<std::string, size_t> m_ids;
+  unsigned int m_level;
+  unsigned int m_version;
+  libsbml::XMLNamespaces m_namespaces;
+  bool m_hasModel;
+  bool m_hasErrors;
+  unsigned long long m_contentHash;
+
+public:
+  SBMLIndex();
+  ~SBMLIndex();
+
+  bool read(const std::string& xml, std::string& error);
+  bool read(std::istream& stream, std::string& error);
+  void read(const libsbml::SBMLDocument* doc);
+
+  bool hasModel() const;
+  bool hasErrors() const;
+  unsigned int getLevel() const;
+  unsigned int getVersion() const;
+  const libsbml::XMLNamespaces& getNamespaces() const;
+  unsigned long long getContentHash() const;
+  size_t getNumElements() const;
+
+  const SBMLIndexElement* find(const std::vector<std::string>& id) const;
+  std::string getAncestorId(const SBMLIndexElement* element, int type) const;
+
+private:
+  void clear();
+  bool setXMLError(std::string& error);
+  size_t addElement(const std::string& id, int type, size_t parent);
+  bool isAncestor(const std::string& id, const SBMLIndexElement* element) const;
+
+  friend struct SBMLIndexScan;
+};
+
+//An index of an SBML file that may still be being read.  Any number of models may wait for the same one, and none may change it.
+typedef std::shared_future<std::shared_ptr<const SBMLIndex> > PendingSBMLIndex;
+
+PendingSBMLIndex indexSBMLInBackground(const std::string& filename);
+std::shared_ptr<const SBMLIndex> indexSBMLFile(const std::string& filename);
+
+PHRASEDML_CPP_NAMESPACE_END
+
+#endif //PHRASEDSBMLINDEX_H
@@ -0,0 +1,75 @@
+#include <cstring>
+
+#include "sbmlLoader.h"
+#include "compressedInput.h"
+#include "parallelJobs.h"
+#include "sbml/SBMLReader.h"
+
+using namespace std;
+using namespace libsbml;
+
+PHRASEDML_CPP_NAMESPACE_BEGIN
+
+//Reads the whole of an SBML file, for when more than its index is needed.  A compressed file is decompressed as it is read, straight into the string libsbml parses.  If it cannot be decompressed, there is no document at all.
+shared_ptr<const SBMLDocument> readSBMLFile(const string& filename)
+{
+  if (getFileCompression(filename) == compression_none) {
+    return shared_ptr<const SBMLDocument>(readSBMLFromFile(filename.c_str()));
+  }
+  string xml, error;
+  if (readDecompressedFile(filename, xml, error)) {
+    return shared_ptr<const SBMLDocument>();
+  }
+  return shared_ptr<const SBMLDocument>(readSBMLFromBuffer(xml.data(), xml.size()));
+}
+
+//Reads SBML from the first 'length' characters of 'buffer', which need not end in a NUL.  libsbml only parses from a file or from a std::string, so this makes exactly one copy, with the XML declaration libsbml would otherwise add (by copying the whole string again) already in place.
+SBMLDocument* readSBMLFromBuffer(const char* buffer, size_t length)
+{
+  static const char declaration[] = "<?xml version='1.0'?>";
+  string xml;
+  //The same check libsbml uses.
+  if (length < 14 || strncmp(buffer, declaration, 14) != 0) {
+    xml.reserve(sizeof(declaration) + length);
+    xml += declaration;
+  }
+  xml.append(buffer, length);
+  SBMLReader reader;
+  return reader.readSBMLFromString(xml);
+}
+
+class SBMLBufferJobs : public ParallelJobs
+{
+public:
+  const vector<const char*>& buffers;
+  const vector<size_t>& lengths;
+  bool validate;
+  vector<shared_ptr<const SBMLDocument> > docs;
+
+  SBMLBufferJobs(const vector<const char*>& b, const vector<size_t>& l, bool v)
+    : buffers(b)
+    , lengths(l)
+    , validate(v)
+    , docs(b.size())
+  {
+  }
+
+  virtual void run(size_t job)
+  {
+    SBMLDocument* doc = readSBMLFromBuffer(buffers[job], lengths[job]);
+    if (validate) {
+      doc->checkConsistency();
+    }
+    docs[job].reset(doc);
+  }
+};
+
+//Reads each buffer as in readSBMLFromBuffer, on up to 'numThreads' threads (one per core if zero).  With 'validate', each document is also fully checked with libsbml, which adds any problems to its error log.
+void readSBMLFromBuffers(const vector<const char*>& buffers, const vector<size_t>& lengths, bool validate, size_t numThreads, vector<shared_ptr<const SBMLDocument> >& docs)
+{
+  SBMLBufferJobs jobs(buffers, lengths, validate);
+  runParallelJobs(jobs, buffers.size(), numThreads, 1);
+  docs.swap(jobs.docs);
+}
+
+PHRASEDML_CPP_NAMESPACE_END
@@ -0,0 +1,19 @@
+#ifndef PHRASEDSBMLLOADER_H
+#define PHRASEDSBMLLOADER_H
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "sbml/SBMLDocument.h"
+#include "phrasedml-namespace.h"
+
+PHRASEDML_CPP_NAMESPACE_BEGIN
+
+std::shared_ptr<const libsbml::SBMLDocument> readSBMLFile(const std::string& filename);
+libsbml::SBMLDocument* readSBMLFromBuffer(const char* buffer, size_t length);
+void readSBMLFromBuffers(const std::vector<const char*>& buffers, const std::vector<size_t>& lengths, bool validate, size_t numThreads, std::vector<std::shared_ptr<const libsbml::SBMLDocument> >& docs);
+
+PHRASEDML_CPP_NAMESPACE_END
+
+#endif //PHRASEDSBMLLOADER_H
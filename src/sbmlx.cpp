@@ -8,6 +8,15 @@ using namespace std;
 using namespace libsbml;
 
 PHRASEDML_CPP_NAMESPACE_BEGIN
+//A deep copy of 'astn', which may be NULL.
+OwnedAST copyAST(const ASTNode* astn)
+{
+  if (astn == NULL) {
+    return OwnedAST();
+  }
+  return OwnedAST(astn->deepCopy());
+}
+
 void getVariablesFromASTNode(ASTNode* astn, set<string>& variables)
 {
   if (astn->getType() == AST_NAME) {
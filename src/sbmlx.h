@@ -5,10 +5,15 @@
 #include <vector>
 #include <set>
 #include <map>
+#include <memory>
 #include "phrasedml-namespace.h"
 #include "sbml/math/ASTNode.h"
 
 PHRASEDML_CPP_NAMESPACE_BEGIN
+//The sole owner of an AST, which is deleted along with it.  It can be moved, but never copied:  any copy of the AST must be made explicitly, with copyAST.
+typedef std::unique_ptr<libsbml::ASTNode> OwnedAST;
+
+OwnedAST copyAST(const libsbml::ASTNode* astn);
 void getVariablesFromASTNode(libsbml::ASTNode* astn, std::set<std::string>& variables);
 void replaceVariablesInASTNodeWith(libsbml::ASTNode* astn, const std::map<std::string, std::string>& replacements);
 std::string fixMinMaxSymbolsXMLStr(std::string input);
@@ -62,6 +62,22 @@ simtype PhrasedSimulation::getType() const
   return m_type;
 }
 
+int PhrasedSimulation::getKisao() const
+{
+  return m_kisao;
+}
+
+const map<int, string>& PhrasedSimulation::getAlgorithmParameters() const
+{
+  return m_algparams;
+}
+
+//The number of time points each run of the simulation produces for every variable.  A steady state has just the one.
+size_t PhrasedSimulation::getNumOutputPoints() const
+{
+  return 1;
+}
+
 bool PhrasedSimulation::setAlgorithmKisao(int kisao)
 {
   m_kisao = kisao;
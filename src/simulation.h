@@ -37,6 +37,8 @@ public:
   virtual ~PhrasedSimulation();
 
   simtype getType() const;
+  int getKisao() const;
+  const std::map<int, std::string>& getAlgorithmParameters() const;
 
   virtual std::string getPhraSEDML() const = 0;
   virtual void addSimulationToSEDML(libsedml::SedDocument* sedml) const = 0;
@@ -54,6 +56,7 @@ public:
 
   virtual void writePhraSEDMLKisao(std::stringstream& stream) const;
   virtual bool kisaoIsDefault() const = 0;
+  virtual size_t getNumOutputPoints() const;
 
   virtual bool finalize();
 
@@ -0,0 +1,28 @@
+#include "statementStream.h"
+
+using namespace std;
+
+PHRASEDML_CPP_NAMESPACE_BEGIN
+
+string getStatementTypeString(statement_type type)
+{
+  switch(type) {
+  case stmt_model:
+    return "model";
+  case stmt_simulation:
+    return "simulation";
+  case stmt_task:
+    return "task";
+  case stmt_repeatedTask:
+    return "repeatedTask";
+  case stmt_output:
+    return "output";
+  case stmt_name:
+    return "name";
+  case stmt_algorithm:
+    return "algorithm";
+  }
+  return "unknown";
+}
+
+PHRASEDML_CPP_NAMESPACE_END
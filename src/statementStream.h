@@ -0,0 +1,36 @@
+#ifndef PHRASEDSTATEMENTSTREAM_H
+#define PHRASEDSTATEMENTSTREAM_H
+
+#include <string>
+
+#include "phrasedml-namespace.h"
+
+PHRASEDML_CPP_NAMESPACE_BEGIN
+
+enum statement_type {
+    stmt_model
+  , stmt_simulation
+  , stmt_task
+  , stmt_repeatedTask
+  , stmt_output
+  , stmt_name
+  , stmt_algorithm
+};
+
+//One top-level phraSED-ML statement, as soon as the line it ends on has been parsed:  what it defined (or, for names and algorithm settings, changed), and that element as phraSED-ML.  Nothing defined after it has been checked yet.
+struct ParsedStatement
+{
+  statement_type type;
+  std::string id;
+  int line;
+  std::string phrasedml;
+};
+
+//Called for each statement as it is parsed.  Return true to stop parsing.
+typedef bool (*StatementCallback)(const ParsedStatement& statement, void* userData);
+
+std::string getStatementTypeString(statement_type type);
+
+PHRASEDML_CPP_NAMESPACE_END
+
+#endif //PHRASEDSTATEMENTSTREAM_H
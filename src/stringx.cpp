@@ -3,7 +3,7 @@
 #include <iostream>
 #include "stringx.h"
 #include "registry.h"
-#include "sbml/SBMLDocument.h"
+#include "sbml/SBMLTypes.h"
 #include "model.h"
 
 #ifdef PHRASEDML_ENABLE_XPATH_EVAL
@@ -207,48 +207,31 @@ vector<string> getIdFromXPath(const string& xpath)
   return ret;
 }
 
-string getValueXPathFromId(const vector<string>* id, const SBMLDocument* doc)
+string getValueXPathFromId(const vector<string>* id, const SBMLIndex* index)
 {
   if (id == NULL || id->size()==0) {
     g_registry.setError("The ID of the model element is missing entirely.", 0);
     return "";
   }
+  if (index == NULL) {
+    //getSBMLIndex has already set the reason.
+    g_registry.addErrorPrefix("Unable to find the model element '" + getStringFrom(id, ".") + "', because its model has no SBML:  ");
+    return "";
+  }
   string lastid = (*id)[id->size()-1];
-  SBMLDocument* vdoc = const_cast<SBMLDocument*>(doc);
-  const SBase* ref = vdoc->getElementBySId(lastid);
+  const SBMLIndexElement* ref = index->find(*id);
   if (ref==NULL) {
     g_registry.setError("No such id in SBML document: '" + getStringFrom(id, ".") + "'.", 0);
     return "";
   }
-  const SBase* parent = ref;
-  for (size_t n = id->size()-1; n != 0; n--) {
-    string parentid = (*id)[n-1];
-    bool foundparent = false;
-    parent = ref->getParentSBMLObject();
-    while (parent != NULL && parent->getTypeCode() != SBML_DOCUMENT) {
-      if (parent->getId() == parentid) {
-        foundparent = true;
-        parent = NULL;
-      }
-      else {
-        parent = parent->getParentSBMLObject();
-      }
-    }
-    if (!foundparent) {
-      g_registry.setError("No such id in SBML document: '" + getStringFrom(id, ".") + "'.", 0);
-      return "";
-    }
-  }
-  const Species* species;
   string ret = "/sbml:sbml/sbml:model/";
-  switch(ref->getTypeCode()) {
+  switch(ref->type) {
   case SBML_SPECIES:
     ret += "sbml:listOfSpecies/sbml:species[@id='" + lastid + "']/@";
-    species = static_cast<const Species*>(ref);
-    if (species->isSetInitialAmount()) {
+    if (ref->hasInitialAmount) {
       ret += "initialAmount";
     }
-    else if (species->isSetInitialConcentration()) {
+    else if (ref->hasInitialConcentration) {
       ret += "initialConcentration";
     }
     else {
@@ -264,7 +247,7 @@ string getValueXPathFromId(const vector<string>* id, const SBMLDocument* doc)
     break;
   case SBML_LOCAL_PARAMETER:
     ret += "sbml:listOfReactions/sbml:reaction[@id='";
-    ret += ref->getAncestorOfType(SBML_REACTION)->getId();
+    ret += index->getAncestorId(ref, SBML_REACTION);
     ret += "']/sbml:kineticLaw/sbml:listOfLocalParameters/sbml:localParameter[@id='" + lastid + "']/@value";
   default:
     //Set a warning? LS DEBUG
@@ -275,42 +258,27 @@ string getValueXPathFromId(const vector<string>* id, const SBMLDocument* doc)
 
 }
 
-string getElementXPathFromId(const vector<string>* id, const SBMLDocument* doc)
+string getElementXPathFromId(const vector<string>* id, const SBMLIndex* index)
 {
   if (id == NULL || id->size()==0) {
     g_registry.setError("The ID of the model element is missing entirely.", 0);
     return "";
   }
+  if (index == NULL) {
+    //getSBMLIndex has already set the reason.
+    g_registry.addErrorPrefix("Unable to find the model element '" + getStringFrom(id, ".") + "', because its model has no SBML:  ");
+    return "";
+  }
   string lastid = (*id)[id->size()-1];
-  SBMLDocument* vdoc = const_cast<SBMLDocument*>(doc);
-  const SBase* ref = vdoc->getElementBySId(lastid);
-  if (doc->getModel() != NULL) {
+  if (index->hasModel()) {
     //We can error check.  Otherwise, we assume the model has the relevant ID.
+    const SBMLIndexElement* ref = index->find(*id);
     if (ref==NULL) {
       g_registry.setError("No such id in SBML document: '" + getStringFrom(id, ".") + "'.", 0);
       return "";
     }
-    const SBase* parent = ref;
-    for (size_t n = id->size()-1; n != 0; n--) {
-      string parentid = (*id)[n-1];
-      bool foundparent = false;
-      parent = ref->getParentSBMLObject();
-      while (parent != NULL && parent->getTypeCode() != SBML_DOCUMENT) {
-        if (parent->getId() == parentid) {
-          foundparent = true;
-          parent = NULL;
-        }
-        else {
-          parent = parent->getParentSBMLObject();
-        }
-      }
-      if (!foundparent) {
-        g_registry.setError("No such id in SBML document: '" + getStringFrom(id, ".") + "'.", 0);
-        return "";
-      }
-    }
     string ret = "/sbml:sbml/sbml:model/";
-    switch(ref->getTypeCode()) {
+    switch(ref->type) {
     case SBML_SPECIES:
       ret += "sbml:listOfSpecies/sbml:species[@id='" + lastid + "']";
       break;
@@ -322,7 +290,7 @@ string getElementXPathFromId(const vector<string>* id, const SBMLDocument* doc)
       break;
     case SBML_LOCAL_PARAMETER:
       ret += "sbml:listOfReactions/sbml:reaction[@id='";
-      ret += ref->getAncestorOfType(SBML_REACTION)->getId();
+      ret += index->getAncestorId(ref, SBML_REACTION);
       ret += "']/sbml:kineticLaw/sbml:listOfLocalParameters/sbml:localParameter[@id='" + lastid + "']";
     default:
       //Set a warning? LS DEBUG
@@ -344,7 +312,7 @@ void getElementXPathFromId(const string& id, set<PhrasedModel*> docs, string& xp
   vector<string> varid;
   varid.push_back(id);
   for (set<PhrasedModel*>::iterator d=docs.begin(); d != docs.end(); d++) {
-    xpath = getElementXPathFromId(&varid, (*d)->getSBMLDocument());
+    xpath = getElementXPathFromId(&varid, (*d)->getSBMLIndex());
     if (xpath != "") {
       modelref = (*d)->getId();
       return;
@@ -418,4 +386,31 @@ bool CaselessStrCmp(const string& lhs, const string& rhs)
   return true;
 
 } /* CaselessStrCmp */
+
+//The 64-bit FNV-1a hash of the text:  stable across platforms and runs, so it can be used to compare content between processes.
+unsigned long long getFNV1aHash(const string& text)
+{
+  return getFNV1aHash(text.data(), text.size(), 14695981039346656037ULL);
+}
+
+//Continues 'hash' over 'length' more bytes, so that text read a block at a time hashes the same as it would all at once.  Start with the hash of an empty string.
+unsigned long long getFNV1aHash(const char* text, size_t length, unsigned long long hash)
+{
+  for (size_t c=0; c<length; c++) {
+    hash ^= static_cast<unsigned char>(text[c]);
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+string HashToString(unsigned long long hash)
+{
+  ostringstream ostr;
+  ostr << hex;
+  ostr.width(16);
+  ostr.fill('0');
+  ostr << hash;
+  return ostr.str();
+}
+
 PHRASEDML_CPP_NAMESPACE_END
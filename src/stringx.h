@@ -6,7 +6,7 @@
 #include <set>
 #include "phrasedml-namespace.h"
 #include "sbmlx.h"
-#include "sbml/SBMLDocument.h"
+#include "sbmlIndex.h"
 
 class PhrasedModel;
 
@@ -23,13 +23,18 @@ std::string getStringFrom(const std::vector<std::string>* name, std::string cc="
 std::string getStringFrom(const std::vector<double>& numbers);
 std::vector<std::string> getStringVecFromDelimitedString(const std::string& var, std::string delimiter="_____");
 
+//Hash functions
+unsigned long long getFNV1aHash(const std::string& text);
+unsigned long long getFNV1aHash(const char* text, size_t length, unsigned long long hash);
+std::string HashToString(unsigned long long hash);
+
 //Xpath functions
 std::vector<std::string> getIdFromXPath(const std::string& xpath);
 #ifdef PHRASEDML_ENABLE_XPATH_EVAL
 std::vector<std::string> getIdFromXPathExtended(const std::string& xpath, const std::string& source_doc, const std::string& sbml_ns);
 #endif
-std::string getValueXPathFromId(const std::vector<std::string>* id, const libsbml::SBMLDocument* doc);
-std::string getElementXPathFromId(const std::vector<std::string>* id, const libsbml::SBMLDocument* doc);
+std::string getValueXPathFromId(const std::vector<std::string>* id, const SBMLIndex* index);
+std::string getElementXPathFromId(const std::vector<std::string>* id, const SBMLIndex* index);
 void getElementXPathFromId(const std::string& id, std::set<PhrasedModel*> docs, std::string& xpath, std::string& modelref);
 
 bool IsReal(const std::string& src);
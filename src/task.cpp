@@ -51,6 +51,16 @@ bool PhrasedTask::isRepeated() const
   return false;
 }
 
+string PhrasedTask::getSimulationReference() const
+{
+  return m_simulation;
+}
+
+string PhrasedTask::getModelReference() const
+{
+  return m_model;
+}
+
 set<PhrasedModel*> PhrasedTask::getModels() const
 {
   set<PhrasedModel*> ret;
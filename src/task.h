@@ -25,9 +25,15 @@ public:
 
   PhrasedTask(std::string id, std::string simulation, std::string model);
   PhrasedTask(libsedml::SedTask* sedtask);
+  PhrasedTask(const PhrasedTask& orig) = default;
+  PhrasedTask(PhrasedTask&& orig) = default;
+  PhrasedTask& operator=(const PhrasedTask& rhs) = default;
+  PhrasedTask& operator=(PhrasedTask&& rhs) = default;
   ~PhrasedTask();
 
   virtual bool isRepeated() const;
+  std::string getSimulationReference() const;
+  std::string getModelReference() const;
   virtual std::string getPhraSEDML() const;
   virtual void addTaskToSEDML(libsedml::SedDocument* sedml) const;
 
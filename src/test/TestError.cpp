@@ -29,6 +29,39 @@ void testError(const string& base, const string& err)
   free(errgen);
 }
 
+START_TEST (test_parallel_finalize_err)
+{
+  setWorkingDirectory(TestDataDirectory);
+  string base = "mod1 = model \"sbml_model.xml\"\nsim1 = simulate uniform(0,10,10)\ntask1 = run sim1 on mod1\n";
+  for (int r=0; r<40; r++) {
+    if (r==25) {
+      base += "report task1.S9\n";
+    }
+    else if (r==33) {
+      base += "report task1.S8\n";
+    }
+    else {
+      base += "report task1.S1\n";
+    }
+  }
+  setNumThreads(1);
+  char* sedgen = convertString(base.c_str());
+  fail_unless(sedgen == NULL);
+  string serial = getLastPhrasedError();
+  fail_unless(serial.find("S9") != string::npos);
+
+  //The first error is reported, no matter which thread found it first.
+  setNumThreads(4);
+  for (int rep=0; rep<10; rep++) {
+    sedgen = convertString(base.c_str());
+    fail_unless(sedgen == NULL);
+    fail_unless(serial == getLastPhrasedError());
+  }
+  setNumThreads(0);
+}
+END_TEST
+
+
 START_TEST (test_model_err1)
 {
   testError("sbml_model = mod \"sbml_model.xml\"", "Unable to parse line 1 ('sbml_model = mod \"sbml_model.xml\"'): the only type of phraSED-ML content that fits the syntax '[ID] = [keyword] \"[string]\"' is model definitions, where 'keyword' is the word 'model' (i.e. 'mod1 = model \"file.xml\"').");
@@ -785,6 +818,7 @@ create_suite_Errors (void)
   tcase_add_test( tcase, test_kisao_0_ss);
   tcase_add_test( tcase, test_kisao_0_unif);
   tcase_add_test( tcase, test_kisao_0_algparam);
+  tcase_add_test( tcase, test_parallel_finalize_err);
 
 
   suite_add_tcase(suite, tcase);
@@ -0,0 +1,469 @@
+/**
+ * \file    TestIteration.cpp
+ * \brief   Test the iteration space of nested repeated tasks.
+ * \author  Lucian Smith
+ * ---------------------------------------------------------------------- -->*/
+
+#include "libutil.h"
+#include "phrasedml_api.h"
+#include "registry.h"
+#include "iterationSpace.h"
+#include "outputShape.h"
+#include "jobPlanner.h"
+#include "contentHash.h"
+#include "compiledFormula.h"
+#include "stringx.h"
+#include "TestUtil.h"
+
+#include <string>
+#include <check.h>
+#include <iostream>
+
+using namespace std;
+
+BEGIN_C_DECLS
+
+extern char *TestDataDirectory;
+PHRASEDML_CPP_NAMESPACE_USE
+
+static const char* nested = "mod1 = model \"sbml_model.xml\"\nsim1 = simulate steadystate\ntask1 = run sim1 on mod1\ntask2 = repeat task1 for p1 in [0,1,5,100]\ntask3 = repeat [task2, task1] for S1 in uniform(0,10,2)";
+
+START_TEST (iteration_size)
+{
+  setWorkingDirectory(TestDataDirectory);
+  char* sedml = convertString(nested);
+  fail_unless(sedml != NULL);
+  PhrasedIterationSpace inner("task2");
+  fail_unless(inner.build() == false);
+  fail_unless(inner.getSize() == 4);
+  PhrasedIterationSpace space("task3");
+  fail_unless(space.build() == false);
+  fail_unless(space.getSize() == 15);
+  PhrasedIterationSpace plain("task1");
+  fail_unless(plain.build() == false);
+  fail_unless(plain.getSize() == 1);
+  PhrasedIterationSpace missing("task4");
+  fail_unless(missing.build() == true);
+  free(sedml);
+}
+END_TEST
+
+START_TEST (iteration_point)
+{
+  setWorkingDirectory(TestDataDirectory);
+  char* sedml = convertString(nested);
+  fail_unless(sedml != NULL);
+  PhrasedIterationSpace space("task3");
+  fail_unless(space.build() == false);
+  IterationPoint point;
+  fail_unless(space.getPoint(7, point) == false);
+  fail_unless(point.task == "task1");
+  fail_unless(point.indices.size() == 2);
+  fail_unless(point.indices[0].repeatedTask == "task3");
+  fail_unless(point.indices[0].iteration == 1);
+  fail_unless(point.indices[0].subtask == 0);
+  fail_unless(point.indices[1].repeatedTask == "task2");
+  fail_unless(point.indices[1].iteration == 2);
+  vector<pair<string, double> > values;
+  space.getRangeValues(point, values);
+  fail_unless(values.size() == 2);
+  fail_unless(values[0].second == 5);
+  fail_unless(values[1].second == 5);
+
+  fail_unless(space.getPoint(9, point) == false);
+  fail_unless(point.task == "task1");
+  fail_unless(point.indices.size() == 1);
+  fail_unless(point.indices[0].subtask == 1);
+  fail_unless(space.getPoint(15, point) == true);
+  free(sedml);
+}
+END_TEST
+
+START_TEST (iteration_chunks)
+{
+  setWorkingDirectory(TestDataDirectory);
+  char* sedml = convertString(nested);
+  fail_unless(sedml != NULL);
+  PhrasedIterationSpace space("task3");
+  fail_unless(space.build() == false);
+  size_t covered = 0;
+  for (size_t c=0; c<4; c++) {
+    fail_unless(space.getChunkBegin(c, 4) == covered);
+    covered = space.getChunkEnd(c, 4);
+  }
+  fail_unless(covered == 15);
+  fail_unless(space.getChunkEnd(0, 4) == 4);
+  fail_unless(space.getChunkEnd(3, 4) - space.getChunkBegin(3, 4) == 3);
+
+  //Chunk 1 is the last run of the first iteration, then the first three runs of the second.
+  vector<PhrasedRepeatedTask> tasks;
+  vector<string> toplevel;
+  fail_unless(space.getChunkTasks(4, 8, "chunk", tasks, toplevel) == false);
+  fail_unless(toplevel.size() == 2);
+  fail_unless(tasks.size() == 3);
+  fail_unless(tasks[0].getTasks().size() == 1);
+  fail_unless(tasks[0].getTasks()[0] == "task1");
+  fail_unless(tasks[0].getNumIterations() == 1);
+  fail_unless(tasks[1].getNumIterations() == 3);
+  fail_unless(tasks[2].getTasks()[0] == tasks[1].getId());
+  fail_unless(space.getChunkPhraSEDML(1, 4) != "");
+  fail_unless(space.getChunkTasks(4, 16, "chunk", tasks, toplevel) == true);
+  free(sedml);
+}
+END_TEST
+
+START_TEST (shard_repeated_task)
+{
+  setWorkingDirectory(TestDataDirectory);
+  string doc = (string)nested + "\nreport task3.time, task3.S1\nplot task1.time vs task1.S1";
+  char* sedml = convertString(doc.c_str());
+  fail_unless(sedml != NULL);
+  fail_unless(shardRepeatedTask("task1", 2) == 0);
+  fail_unless(shardRepeatedTask("task3", 0) == 0);
+  fail_unless(shardRepeatedTask("task3", 2) == 2);
+  char* shard0 = getShardPhraSEDML(0);
+  char* shard1 = getShardPhraSEDML(1);
+  fail_unless(getShardPhraSEDML(2) == NULL);
+  string first(shard0);
+  string second(shard1);
+  fail_unless(first.find("uniform(0, 5, 1)") != string::npos);
+  fail_unless(second.find("S1 in [10]") != string::npos);
+  fail_unless(first.find("task2 = repeat task1") != string::npos);
+  fail_unless(first.find("report ") != string::npos);
+  fail_unless(first.find("plot ") == string::npos);
+  char* shardsed = getShardSEDML(1);
+  fail_unless(shardsed != NULL);
+
+  //Each shard must stand on its own.
+  char* converted = convertString(shard1);
+  fail_unless(converted != NULL);
+  fail_unless(shardRepeatedTask("task3", 5) == 1);
+  free(converted);
+  free(shardsed);
+  free(shard0);
+  free(shard1);
+  free(sedml);
+}
+END_TEST
+
+START_TEST (range_slice_past_end)
+{
+  setWorkingDirectory(TestDataDirectory);
+  char* sedml = convertString(nested);
+  fail_unless(sedml != NULL);
+  const PhrasedTask* task = g_registry.getTask("task2");
+  fail_unless(task != NULL && task->isRepeated());
+  const vector<ModelChange>& changes = static_cast<const PhrasedRepeatedTask*>(task)->getChanges();
+  fail_unless(changes.size() == 1);
+  ModelChange slice = changes[0].getRangeSlice(2, 8);
+  fail_unless(slice.getValues().size() == 2);
+  fail_unless(slice.getValues()[1] == 100);
+  slice = changes[0].getRangeSlice(6, 8);
+  fail_unless(slice.getValues().empty());
+
+  //A uniform range has one more value than its number of steps, and so does each slice of it.
+  const vector<ModelChange>& uniform = static_cast<const PhrasedRepeatedTask*>(g_registry.getTask("task3"))->getChanges();
+  fail_unless(uniform[0].getNumRangeValues() == 3);
+  fail_unless(uniform[0].getRangeValue(1) == 5);
+  fail_unless(uniform[0].getRangeValue(2) == 10);
+  slice = uniform[0].getRangeSlice(1, 3);
+  fail_unless(slice.getValues()[2] == 1);
+  fail_unless(slice.getNumRangeValues() == 2);
+  fail_unless(slice.getRangeValue(0) == 5);
+  fail_unless(slice.getRangeValue(1) == 10);
+  free(sedml);
+}
+END_TEST
+
+START_TEST (change_values)
+{
+  setWorkingDirectory(TestDataDirectory);
+  string doc = "mod1 = model \"sbml_model.xml\"\nsim1 = simulate steadystate\ntask1 = run sim1 on mod1\ntask2 = repeat task1 for local.x in [1, 2, 3], local.k = 2, p1 = x*k + 1, local.y = x -> x^2, S2 = S2 + x";
+  char* sedml = convertString(doc.c_str());
+  fail_unless(sedml != NULL);
+  const PhrasedTask* task = g_registry.getTask("task2");
+  fail_unless(task != NULL && task->isRepeated());
+  const PhrasedRepeatedTask* rt = static_cast<const PhrasedRepeatedTask*>(task);
+  vector<double> values;
+  fail_unless(rt->getChangeValues("p1", values) == false);
+  fail_unless(values.size() == 3);
+  fail_unless(values[0] == 3);
+  fail_unless(values[2] == 7);
+  fail_unless(rt->getChangeValues("y", values) == false);
+  fail_unless(values.size() == 3);
+  fail_unless(values[1] == 4);
+  fail_unless(rt->getChangeValues("k", values) == false);
+  fail_unless(values.size() == 3);
+  fail_unless(values[2] == 2);
+  fail_unless(rt->getChangeValues("S2", values) == true);
+  fail_unless(rt->getChangeValues("S1", values) == true);
+  free(sedml);
+}
+END_TEST
+
+START_TEST (output_shapes)
+{
+  setWorkingDirectory(TestDataDirectory);
+  string doc = (string)nested + "\nsim2 = simulate uniform(0, 10, 100)\ntask4 = run sim2 on mod1\ntask5 = repeat task4 for p1 in [1, 2]\nreport task5.time, task5.S1, max(task5.S1)\nreport task3.S1";
+  char* sedml = convertString(doc.c_str());
+  fail_unless(sedml != NULL);
+  vector<OutputShape> generators;
+  vector<OutputShape> outputs;
+  fail_unless(g_registry.getOutputShapes(generators, outputs) == false);
+  fail_unless(generators.size() == 4);
+  fail_unless(outputs.size() == 2);
+  fail_unless(generators[0].extents.size() == 2);
+  fail_unless(generators[0].dimensions[0] == "task5");
+  fail_unless(generators[0].extents[0] == 2);
+  fail_unless(generators[0].extents[1] == 101);
+  fail_unless(generators[0].exact);
+  fail_unless(generators[0].byteSize == 2*101*8);
+  fail_unless(generators[2].extents.empty());
+  fail_unless(generators[2].byteSize == 8);
+  fail_unless(outputs[0].extents[0] == 3);
+  fail_unless(outputs[0].byteSize == 2*(2*101*8) + 8);
+
+  //task3 runs both task2 (four runs per iteration) and task1 directly.
+  fail_unless(generators[3].extents.size() == 3);
+  fail_unless(generators[3].extents[0] == 3);
+  fail_unless(generators[3].extents[1] == 4);
+  fail_unless(!generators[3].exact);
+
+  char* shapes = getOutputShapes();
+  fail_unless(shapes != NULL);
+  fail_unless(string(shapes).find("exact\ttask5=2\tsim2=101\n") != string::npos);
+  free(shapes);
+  free(sedml);
+}
+END_TEST
+
+START_TEST (cost_estimate)
+{
+  setWorkingDirectory(TestDataDirectory);
+  string doc = (string)nested + "\nreport task3.S1, task3.S2";
+  char* sedml = convertString(doc.c_str());
+  fail_unless(sedml != NULL);
+  clearSimulationCosts();
+  vector<TaskCost> tasks;
+  TaskCost total;
+  fail_unless(g_registry.getCostEstimate(tasks, total) == false);
+  fail_unless(tasks.size() == 3);
+  fail_unless(total.numRuns == 20);
+  fail_unless(!total.calibrated);
+  for (size_t t=0; t<tasks.size(); t++) {
+    if (tasks[t].task == "task3") {
+      fail_unless(tasks[t].numRuns == 15);
+      fail_unless(tasks[t].numRecordedVariables == 2);
+      fail_unless(tasks[t].resultBytes == 15*2*8);
+    }
+  }
+
+  setSimulationCost(407, 0.5, 0);
+  fail_unless(g_registry.getCostEstimate(tasks, total) == false);
+  fail_unless(total.calibrated);
+  fail_unless(total.seconds == 10);
+  char* estimate = getCostEstimate();
+  fail_unless(estimate != NULL);
+  fail_unless(string(estimate).find("total\t\t20\t20\t2\t240\t10\tcalibrated") != string::npos);
+  clearSimulationCosts();
+  free(estimate);
+  free(sedml);
+}
+END_TEST
+
+START_TEST (job_plan)
+{
+  setWorkingDirectory(TestDataDirectory);
+  const char* doc = "mod1 = model \"sbml_model.xml\"\nsim1 = simulate uniform(0,10,10)\ntask1 = run sim1 on mod1\ntask2 = run sim1 on mod1\nreport task2.S1";
+  char* sedml = convertString(doc);
+  fail_unless(sedml != NULL);
+  PhrasedJobPlanner planner;
+  fail_unless(planner.plan(100) == false);
+  fail_unless(planner.getNumRuns() == 2);
+  fail_unless(planner.getNumJobs() == 1);
+  const PlannedJob& job = planner.getJobs()[0];
+  fail_unless(job.runs.size() == 2);
+  fail_unless(job.tasks.size() == 2);
+  fail_unless(job.outputs.size() == 1);
+  fail_unless(planner.plan(1) == true);
+  free(sedml);
+
+  sedml = convertString(nested);
+  fail_unless(sedml != NULL);
+  fail_unless(planner.plan(100) == false);
+  //task1 once, task2 four times, and task3 fifteen times.  None of them collapse:  nothing resets the model, so each run of a task continues from the one before it, and the S1 set by task3 is not set by task2.
+  fail_unless(planner.getNumRuns() == 20);
+  fail_unless(planner.getNumJobs() == 20);
+  char* plan = getJobPlan(100);
+  fail_unless(plan != NULL);
+  fail_unless(string(plan).find("total\t") != string::npos);
+  free(plan);
+  free(sedml);
+
+  //Runs are keyed by content, not IDs:  the same changes to two models of the same file are the same jobs.
+  sedml = convertString("mod1 = model \"sbml_model.xml\"\nmod2 = model \"sbml_model.xml\"\nsim1 = simulate steadystate\ntask1 = run sim1 on mod1\ntask2 = run sim1 on mod2\ntask3 = repeat task1 for S1 in [1, 2], reset=true\ntask4 = repeat task2 for mod2.S1 in [1, 2], reset=true");
+  fail_unless(sedml != NULL);
+  fail_unless(planner.plan(100) == false);
+  fail_unless(planner.getNumRuns() == 6);
+  fail_unless(planner.getNumJobs() == 3);
+  fail_unless(planner.getJobs()[1].key.find("mod1") == string::npos);
+  free(sedml);
+}
+END_TEST
+
+START_TEST (content_hashes)
+{
+  setWorkingDirectory(TestDataDirectory);
+  char* sedml = convertString("mod1 = model \"sbml_model.xml\"\nsim1 = simulate uniform(0,10,10)\ntask1 = run sim1 on mod1\nreport task1.S1");
+  fail_unless(sedml != NULL);
+  PhrasedContentHasher hasher;
+  unsigned long long model1, sim1, task1, output1;
+  fail_unless(hasher.getModelHash("mod1", model1) == false);
+  fail_unless(hasher.getSimulationHash("sim1", sim1) == false);
+  fail_unless(hasher.getTaskHash("task1", task1) == false);
+  fail_unless(hasher.getOutputHash(g_registry.getOutput(0), output1) == false);
+  free(sedml);
+
+  //Different IDs, names, and formatting:  the same hashes.
+  sedml = convertString("modA = model \"sbml_model.xml\"\nsimA = simulate uniform(0, 10.0, 10)\ntaskA = run simA on modA\nreport \"Renamed\" taskA.S1");
+  fail_unless(sedml != NULL);
+  hasher.clear();
+  unsigned long long hash;
+  fail_unless(hasher.getModelHash("modA", hash) == false);
+  fail_unless(hash == model1);
+  fail_unless(hasher.getSimulationHash("simA", hash) == false);
+  fail_unless(hash == sim1);
+  fail_unless(hasher.getTaskHash("taskA", hash) == false);
+  fail_unless(hash == task1);
+  fail_unless(hasher.getOutputHash(g_registry.getOutput(0), hash) == false);
+  fail_unless(hash == output1);
+  free(sedml);
+
+  //A different simulation changes everything that depends on it, but not the model.
+  sedml = convertString("mod1 = model \"sbml_model.xml\"\nsim1 = simulate uniform(0,10,20)\ntask1 = run sim1 on mod1\nreport task1.S1");
+  fail_unless(sedml != NULL);
+  hasher.clear();
+  fail_unless(hasher.getModelHash("mod1", hash) == false);
+  fail_unless(hash == model1);
+  fail_unless(hasher.getSimulationHash("sim1", hash) == false);
+  fail_unless(hash != sim1);
+  fail_unless(hasher.getTaskHash("task1", hash) == false);
+  fail_unless(hash != task1);
+  fail_unless(hasher.getOutputHash(g_registry.getOutput(0), hash) == false);
+  fail_unless(hash != output1);
+  char* hashes = getContentHashes();
+  fail_unless(hashes != NULL);
+  fail_unless(string(hashes).find("model\tmod1\t" + HashToString(model1)) != string::npos);
+  free(hashes);
+  free(sedml);
+}
+END_TEST
+
+START_TEST (content_hashes_changes)
+{
+  setWorkingDirectory(TestDataDirectory);
+  //A model's own changes don't hash the model they are part of (which would never end), and a repeated task's changes don't hash the ID of their model.
+  char* sedml = convertString("mod1 = model \"sbml_model.xml\"\nmod2 = model mod1 with S1=3\nsim1 = simulate uniform(0,10,10)\ntask1 = run sim1 on mod2\ntask2 = repeat task1 for S2 in [1, 2, 3]");
+  fail_unless(sedml != NULL);
+  PhrasedContentHasher hasher;
+  unsigned long long model1, model2, task2;
+  fail_unless(hasher.getModelHash("mod1", model1) == false);
+  fail_unless(hasher.getModelHash("mod2", model2) == false);
+  fail_unless(model2 != model1);
+  fail_unless(hasher.getTaskHash("task2", task2) == false);
+  free(sedml);
+
+  //Renamed models and tasks, with the change's model written out:  the same hashes.
+  sedml = convertString("modA = model \"sbml_model.xml\"\nmodB = model modA with S1=3\nsim1 = simulate uniform(0,10,10)\ntaskA = run sim1 on modB\ntaskB = repeat taskA for modB.S2 in [1, 2, 3]");
+  fail_unless(sedml != NULL);
+  hasher.clear();
+  unsigned long long hash;
+  fail_unless(hasher.getModelHash("modB", hash) == false);
+  fail_unless(hash == model2);
+  fail_unless(hasher.getTaskHash("taskB", hash) == false);
+  fail_unless(hash == task2);
+  free(sedml);
+
+  //Different values in the repeated task:  a different hash.
+  sedml = convertString("mod1 = model \"sbml_model.xml\"\nmod2 = model mod1 with S1=3\nsim1 = simulate uniform(0,10,10)\ntask1 = run sim1 on mod2\ntask2 = repeat task1 for S2 in [1, 2, 4]");
+  fail_unless(sedml != NULL);
+  hasher.clear();
+  fail_unless(hasher.getTaskHash("task2", hash) == false);
+  fail_unless(hash != task2);
+  free(sedml);
+
+  //A document given directly is hashed by its content, not by the name it was given.
+  shared_ptr<const libsbml::SBMLDocument> doc(libsbml::readSBMLFromFile((string(TestDataDirectory) + "sbml_model.xml").c_str()));
+  setReferencedSBMLDocument("first.xml", doc);
+  setReferencedSBMLDocument("second.xml", doc);
+  sedml = convertString("mod1 = model \"first.xml\"\nmod2 = model \"second.xml\"\nmod3 = model mod1 with S1=3");
+  fail_unless(sedml != NULL);
+  hasher.clear();
+  fail_unless(hasher.getModelHash("mod1", model1) == false);
+  fail_unless(hasher.getModelHash("mod2", hash) == false);
+  fail_unless(hash == model1);
+  fail_unless(hasher.getModelHash("mod3", hash) == false);
+  fail_unless(hash != model1);
+  free(sedml);
+  clearReferencedSBML();
+}
+END_TEST
+
+START_TEST (change_values_many_variables)
+{
+  //More variables than registers:  each variable's index must never be read as a register.
+  ASTNode* astn = SBML_parseL3Formula("a+b+c+d+e+f");
+  fail_unless(astn != NULL);
+  CompiledFormula formula;
+  fail_unless(formula.compile(astn) == false);
+  delete astn;
+  fail_unless(formula.getVariables().size() == 6);
+  vector<double> inputs;
+  for (size_t v=1; v<=6; v++) {
+    inputs.push_back(static_cast<double>(v));
+  }
+  fail_unless(formula.evaluate(inputs) == 21);
+
+  setWorkingDirectory(TestDataDirectory);
+  string doc = "mod1 = model \"sbml_model.xml\"\nsim1 = simulate steadystate\ntask1 = run sim1 on mod1\ntask2 = repeat task1 for local.x in [1, 2], local.a = 1, local.b = 2, local.c = 3, local.d = 4, local.e = 5, local.f = 6, p1 = a+b+c+d+e+f+x";
+  char* sedml = convertString(doc.c_str());
+  fail_unless(sedml != NULL);
+  const PhrasedTask* task = g_registry.getTask("task2");
+  fail_unless(task != NULL && task->isRepeated());
+  const PhrasedRepeatedTask* rt = static_cast<const PhrasedRepeatedTask*>(task);
+  vector<double> values;
+  fail_unless(rt->getChangeValues("p1", values) == false);
+  fail_unless(values.size() == 2);
+  fail_unless(values[0] == 22);
+  fail_unless(values[1] == 23);
+  free(sedml);
+}
+END_TEST
+
+
+Suite *
+create_suite_Iteration (void)
+{
+  Suite *suite = suite_create("phraSED-ML Iteration");
+  TCase *tcase = tcase_create("phraSED-ML Iteration");
+
+  tcase_add_test( tcase, iteration_size);
+  tcase_add_test( tcase, iteration_point);
+  tcase_add_test( tcase, iteration_chunks);
+  tcase_add_test( tcase, shard_repeated_task);
+  tcase_add_test( tcase, range_slice_past_end);
+  tcase_add_test( tcase, change_values);
+  tcase_add_test( tcase, change_values_many_variables);
+  tcase_add_test( tcase, output_shapes);
+  tcase_add_test( tcase, cost_estimate);
+  tcase_add_test( tcase, job_plan);
+  tcase_add_test( tcase, content_hashes);
+  tcase_add_test( tcase, content_hashes_changes);
+
+  suite_add_tcase(suite, tcase);
+
+  return suite;
+}
+
+END_C_DECLS
+
@@ -7,6 +7,9 @@
 #include "libutil.h"
 #include "phrasedml_api.h"
 #include "registry.h"
+#include "model.h"
+#include "sbmlIndex.h"
+#include "stringx.h"
 #include "TestUtil.h"
 
 #include <string>
@@ -14,6 +17,7 @@
 #include <iostream>
 
 using namespace std;
+PHRASEDML_CPP_NAMESPACE_USE
 
 BEGIN_C_DECLS
 
@@ -131,6 +135,212 @@ END_TEST
 
 
 
+START_TEST (test_models_loaded_in_background)
+{
+  setWorkingDirectory(TestDataDirectory);
+  char* sedml = convertString("mod1 = model \"sbml_model.xml\" with S1=4\nmod2 = model \"sbml_model.xml\" with S2=3\nmod3 = model \"00001-sbml-l3v1.xml\"\nmod4 = model mod3 with S1=2");
+  fail_unless(sedml != NULL);
+  free(sedml);
+  sedml = convertString("mod1 = model \"00001-sbml-l3v1.xml\"\nmod2 = model \"sbml_model.xml\" with S3=4");
+  fail_unless(sedml == NULL);
+  fail_unless(string(getLastPhrasedError()).find("S3") != string::npos);
+}
+END_TEST
+
+START_TEST (test_compressed_files)
+{
+  setWorkingDirectory(TestDataDirectory);
+  char* sedml = convertString("mod1 = model \"sbml_model_compressed.xml.gz\" with S1=4");
+  fail_unless(sedml != NULL);
+  free(sedml);
+  //The compressed file is found even without its '.gz'.
+  sedml = convertString("mod1 = model \"sbml_model_compressed.xml\" with S3=4");
+  fail_unless(sedml == NULL);
+  fail_unless(string(getLastPhrasedError()).find("S3") != string::npos);
+
+  string dir(TestDataDirectory);
+  const char* bases[] = {"model1.txt", "model1.xml"};
+  for (size_t b=0; b<2; b++) {
+    char* plain = convertFile((dir + bases[b]).c_str());
+    fail_unless(plain != NULL);
+    string base(bases[b]);
+    base.insert(base.find('.'), "_compressed");
+    char* compressed = convertFile((dir + base + ".gz").c_str());
+    fail_unless(compressed != NULL);
+    fail_unless(string(plain) == string(compressed));
+    free(plain);
+    free(compressed);
+  }
+}
+END_TEST
+
+START_TEST (test_combine_archive)
+{
+  //Models are found in the archive, not the working directory.
+  setWorkingDirectory("/");
+  string archive(TestDataDirectory);
+  archive += "experiments.omex";
+  fail_unless(convertCombineArchive(archive.c_str()) == 2);
+  fail_unless(string(getArchiveDocumentLocation(0)) == "model1.sedml");
+  fail_unless(string(getArchiveDocumentLocation(1)) == "changes/model_attchange_spec_conc.sedml");
+  fail_unless(string(getArchivePhraSEDML(0)).find("sbml_model = model \"sbml_model.xml\"") != string::npos);
+  fail_unless(string(getArchivePhraSEDML(1)).find("sbml_model = model \"../sbml_model.xml\" with S1 = 4") != string::npos);
+  fail_unless(getArchivePhraSEDML(2) == NULL);
+
+  fail_unless(convertCombineArchive((archive + "_missing").c_str()) == -1);
+  setWorkingDirectory(TestDataDirectory);
+}
+END_TEST
+
+START_TEST (test_structural_conversion)
+{
+  setStructuralConversion(true);
+  char* sedml = convertString("mod1 = model \"no_such_model.xml\" with S1 = 4, S2 = S1 + 1");
+  setStructuralConversion(false);
+  fail_unless(sedml != NULL);
+  string sedstr(sedml);
+  fail_unless(sedstr.find("/sbml:sbml/sbml:model/descendant::*[@id='S1']") != string::npos);
+  fail_unless(sedstr.find("changeAttribute") == string::npos);
+
+  setStructuralConversion(true);
+  char* phrasedml = convertString(sedml);
+  setStructuralConversion(false);
+  fail_unless(phrasedml != NULL);
+  fail_unless(string(phrasedml).find("mod1 = model \"no_such_model.xml\" with S1 = 4, S2 = S1 + 1") != string::npos);
+  free(sedml);
+  free(phrasedml);
+
+  //Otherwise, the model has to be found.
+  sedml = convertString("mod1 = model \"no_such_model.xml\" with S1 = 4");
+  fail_unless(sedml == NULL);
+}
+END_TEST
+
+
+START_TEST (test_sbml_index)
+{
+  //A scanned file gives the same XPaths as the document libsbml reads from it.
+  string file(TestDataDirectory);
+  file += "sbml_model.xml";
+  shared_ptr<const SBMLIndex> scanned = indexSBMLFile(file);
+  fail_unless(scanned.get() != NULL);
+  fail_unless(scanned->hasModel());
+  fail_unless(scanned->getLevel() == 3 && scanned->getVersion() == 1);
+  libsbml::SBMLDocument* doc = libsbml::readSBMLFromFile(file.c_str());
+  SBMLIndex read;
+  read.read(doc);
+  delete doc;
+  fail_unless(scanned->getNumElements() == read.getNumElements());
+  const char* ids[] = {"S1", "S2", "C1", "p1", "_J0"};
+  for (size_t i=0; i<5; i++) {
+    vector<string> id(1, ids[i]);
+    fail_unless(getValueXPathFromId(&id, scanned.get()) == getValueXPathFromId(&id, &read));
+    fail_unless(getElementXPathFromId(&id, scanned.get()) == getElementXPathFromId(&id, &read));
+  }
+  vector<string> species(1, "S2");
+  fail_unless(getValueXPathFromId(&species, scanned.get()) == "/sbml:sbml/sbml:model/sbml:listOfSpecies/sbml:species[@id='S2']/@initialAmount");
+  species.insert(species.begin(), "case_01");
+  fail_unless(scanned->find(species) != NULL);
+  species[0] = "_J0";
+  fail_unless(scanned->find(species) == NULL);
+  fail_unless(indexSBMLFile(file + "_missing").get() == NULL);
+}
+END_TEST
+
+
+START_TEST (test_derived_model_chain)
+{
+  setWorkingDirectory(TestDataDirectory);
+  char* sedml = convertString("mod1 = model \"sbml_model.xml\"\nmod2 = model mod1 with S1=5\nmod3 = model mod2 with S2=6\nmod4 = model mod3 with p1=S1+S2");
+  fail_unless(sedml != NULL);
+  string sedstr(sedml);
+  free(sedml);
+  fail_unless(sedstr.find("<model id=\"mod4\" language=\"urn:sedml:language:sbml.level-3.version-1\" source=\"mod3\">") != string::npos);
+  //Every model in the chain shares the one index.
+  const SBMLIndex* index = g_registry.getModel("mod1")->getSBMLIndex();
+  fail_unless(index != NULL);
+  fail_unless(g_registry.getModel("mod4")->getSBMLIndex() == index);
+  fail_unless(g_registry.getModel("mod4")->getSBMLDocument() == NULL);
+  fail_unless(g_registry.getModel("mod4")->getRootModel() == g_registry.getModel("mod1"));
+
+  sedml = convertString("mod1 = model \"sbml_model.xml\"\nmod2 = model mod1 with S1=5\nmod3 = model mod2 with S3=6");
+  fail_unless(sedml == NULL);
+}
+END_TEST
+
+
+START_TEST (test_materialize_model)
+{
+  setWorkingDirectory(TestDataDirectory);
+  char* sedml = convertString("mod1 = model \"sbml_model.xml\"\nmod2 = model mod1 with S1=5, S2=4\nmod3 = model mod2 with p1=S1*2, C1=S2+p1");
+  fail_unless(sedml != NULL);
+  free(sedml);
+  //A model with no changes shares the document read for its file.
+  shared_ptr<const libsbml::SBMLDocument> mod1 = getMaterializedModel("mod1");
+  fail_unless(mod1.get() != NULL);
+  fail_unless(getMaterializedModel("mod1").get() == mod1.get());
+  fail_unless(mod1->getModel()->getSpecies("S1")->getInitialConcentration() == 3);
+
+  //Each formula sees the values set before it, including those of the models it is based on.
+  shared_ptr<const libsbml::SBMLDocument> mod3 = getMaterializedModel("mod3");
+  fail_unless(mod3.get() != NULL);
+  fail_unless(mod3.get() != mod1.get());
+  const libsbml::Model* model = mod3->getModel();
+  fail_unless(model->getSpecies("S1")->getInitialConcentration() == 5);
+  fail_unless(!model->getSpecies("S1")->isSetInitialAmount());
+  fail_unless(model->getSpecies("S2")->getInitialAmount() == 4);
+  fail_unless(model->getParameter("p1")->getValue() == 10);
+  fail_unless(model->getCompartment("C1")->getSize() == 14);
+  fail_unless(mod1->getModel()->getParameter("p1")->getValue() == 2);
+
+  //The changes of one model are never left behind for the next.
+  shared_ptr<const libsbml::SBMLDocument> mod2 = getMaterializedModel("mod2");
+  fail_unless(mod2.get() != NULL);
+  fail_unless(mod2->getModel()->getSpecies("S1")->getInitialConcentration() == 5);
+  fail_unless(mod2->getModel()->getParameter("p1")->getValue() == 2);
+  fail_unless(mod2->getModel()->getCompartment("C1")->getSize() == 1);
+  fail_unless(model->getParameter("p1")->getValue() == 10);
+
+  char* sbml = materializeModel("mod3");
+  fail_unless(sbml != NULL);
+  fail_unless(string(sbml).find("value=\"10\"") != string::npos);
+  free(sbml);
+
+  fail_unless(materializeModel("mod4") == NULL);
+}
+END_TEST
+
+START_TEST (test_materialize_invalid_model)
+{
+  setWorkingDirectory(TestDataDirectory);
+  //The parameter has no 'constant' attribute, which only libsbml's own checks find:  the file is only scanned when converted, so they are only run, and warned of, when it is read in full.
+  char* sedml = convertString("mod1 = model \"invalid_model.xml\"\nsim1 = simulate steadystate\ntask1 = run sim1 on mod1");
+  fail_unless(sedml != NULL);
+  free(sedml);
+  fail_unless(g_registry.getPhrasedWarnings().empty());
+  fail_unless(getMaterializedModel("mod1").get() != NULL);
+  vector<string> warnings = g_registry.getPhrasedWarnings();
+  fail_unless(warnings.size() == 1);
+  fail_unless(warnings[0].find("invalid_model.xml") != string::npos);
+}
+END_TEST
+
+START_TEST (test_materialize_sedml_model)
+{
+  //A ComputeChange read from SED-ML comes before the local variables for its own parameters.
+  string dir(TestDataDirectory);
+  setWorkingDirectory(TestDataDirectory);
+  char* phrased = convertFile((dir + "model_formchange_var_assignment.xml").c_str());
+  fail_unless(phrased != NULL);
+  free(phrased);
+  shared_ptr<const libsbml::SBMLDocument> doc = getMaterializedModel("sbml_model");
+  fail_unless(doc.get() != NULL);
+  fail_unless(doc->getModel()->getCompartment("C1")->getSize() == 16);
+}
+END_TEST
+
+
+
 Suite *
 create_suite_Models (void)
 {
@@ -154,6 +364,15 @@ create_suite_Models (void)
   tcase_add_test( tcase, test_twomodels_attchange_all);
   tcase_add_test( tcase, test_twomodels_attchange_mixed);
   tcase_add_test( tcase, test_model_formchange);
+  tcase_add_test( tcase, test_models_loaded_in_background);
+  tcase_add_test( tcase, test_compressed_files);
+  tcase_add_test( tcase, test_combine_archive);
+  tcase_add_test( tcase, test_structural_conversion);
+  tcase_add_test( tcase, test_sbml_index);
+  tcase_add_test( tcase, test_derived_model_chain);
+  tcase_add_test( tcase, test_materialize_model);
+  tcase_add_test( tcase, test_materialize_invalid_model);
+  tcase_add_test( tcase, test_materialize_sedml_model);
 
 
 
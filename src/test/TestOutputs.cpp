@@ -14,12 +14,16 @@
 #include <iostream>
 
 #include "output.h"
+#include "dataGeneratorEvaluator.h"
+#include "reportWriter.h"
+#include "sedml/SedDocument.h"
 
 using namespace std;
 
 BEGIN_C_DECLS
 
 extern char *TestDataDirectory;
+PHRASEDML_CPP_NAMESPACE_USE
 
 START_TEST (plot_basic)
 {
@@ -105,6 +109,180 @@ START_TEST (plot_named)
 }
 END_TEST
 
+START_TEST (evaluate_data_generators)
+{
+  setWorkingDirectory(TestDataDirectory);
+  char* sedml = convertString("mod1 = model \"sbml_model.xml\"\nsim1 = simulate uniform(0,10,4)\ntask1 = run sim1 on mod1\nreport S1/C1, max(S1), S1 - min(S1)\nplot time vs log(S2)");
+  fail_unless(sedml != NULL);
+  libsedml::SedDocument* doc = libsedml::readSedMLFromString(sedml);
+  DataGeneratorEvaluator evaluator;
+  fail_unless(evaluator.addDataGenerators(doc) == false);
+  vector<string> ids = evaluator.getDataGeneratorIds();
+  fail_unless(ids.size() == 5);
+
+  double s1[] = {1, 2, 3, 4, 5};
+  double c1 = 2;
+  double s2[] = {1, 10, 100, 1000, 10000};
+  evaluator.setVariableValues("S1", s1, 5);
+  evaluator.setVariableValues("C1", &c1, 5, 0);
+  size_t length = 0;
+  fail_unless(evaluator.getLength(ids[0], length) == false);
+  fail_unless(length == 5);
+  vector<double> values;
+  fail_unless(evaluator.evaluate(ids[0], values) == false);
+  fail_unless(values.size() == 5);
+  fail_unless(values[3] == 2);
+  fail_unless(evaluator.evaluate(ids[1], values) == false);
+  fail_unless(values.size() == 1);
+  fail_unless(values[0] == 5);
+  fail_unless(evaluator.evaluate(ids[2], values) == false);
+  fail_unless(values.size() == 5);
+  fail_unless(values[0] == 0);
+  fail_unless(values[4] == 4);
+
+  //Asking for the length never sets an error.
+  g_registry.setError("", 0);
+  fail_unless(evaluator.getLength(ids[4], length) == true);
+  fail_unless(length == 0);
+  fail_unless(g_registry.getError().empty());
+
+  //The plot's y axis is logarithmic, but its data generator is just S2.
+  fail_unless(evaluator.evaluate(ids[4], values, true) == true);
+  evaluator.setVariableValues("S2", s2, 5);
+  fail_unless(evaluator.evaluate(ids[4], values, true) == false);
+  fail_unless(values[2] == 2);
+  delete doc;
+  free(sedml);
+}
+END_TEST
+
+START_TEST (write_report_blocks)
+{
+  setWorkingDirectory(TestDataDirectory);
+  char* sedml = convertString("mod1 = model \"sbml_model.xml\"\nsim1 = simulate uniform(0,10,4)\ntask1 = run sim1 on mod1\nreport time, S1/C1");
+  fail_unless(sedml != NULL);
+  libsedml::SedDocument* doc = libsedml::readSedMLFromString(sedml);
+  libsedml::SedReport* report = static_cast<libsedml::SedReport*>(doc->getOutput(0));
+  DataGeneratorEvaluator evaluator;
+  fail_unless(evaluator.addDataGenerators(doc) == false);
+
+  stringstream csv;
+  ReportWriter writer(report, csv, rformat_csv);
+  fail_unless(writer.addIndexColumn("task1.iteration") == false);
+  fail_unless(writer.getNumColumns() == 3);
+  fail_unless(writer.getLabels()[2] == "S1/C1");
+  double time[] = {0, 2.5, 5, 7.5, 10};
+  double s1[] = {1, 2, 3, 4, 5};
+  double c1 = 2;
+  double index[] = {0, 0, 0, 0, 0};
+  vector<const double*> indices;
+  indices.push_back(index);
+  evaluator.setVariableValues("C1", &c1, 5, 0);
+  for (size_t block=0; block<5; block+=3) {
+    size_t rows = block==0 ? 3 : 2;
+    evaluator.setVariableValues("time", time+block, rows);
+    evaluator.setVariableValues("S1", s1+block, rows);
+    fail_unless(writer.writeBlock(evaluator, indices, rows) == false);
+  }
+  fail_unless(writer.finish() == false);
+  fail_unless(writer.getNumRows() == 5);
+  fail_unless(writer.addIndexColumn("late") == true);
+  fail_unless(csv.str() == "task1.iteration,time,S1/C1\n0,0,0.5\n0,2.5,1\n0,5,1.5\n0,7.5,2\n0,10,2.5\n");
+
+  stringstream binary;
+  ReportWriter binwriter(report, binary, rformat_binary);
+  vector<const double*> columns;
+  columns.push_back(time);
+  columns.push_back(s1);
+  fail_unless(binwriter.writeBlock(columns, 5) == false);
+  fail_unless(binwriter.finish() == false);
+  fail_unless(binary.str().substr(0, 8) == "PHRSDRPT");
+  fail_unless(binary.str().size() == 8 + 3*4 + 2*4 + 4 + 5 + 8 + 10*8 + 8);
+  delete doc;
+  free(sedml);
+
+  //An aggregate over one block would not be the aggregate over the whole report.
+  sedml = convertString("mod1 = model \"sbml_model.xml\"\nsim1 = simulate uniform(0,10,4)\ntask1 = run sim1 on mod1\nreport time, max(S1)");
+  fail_unless(sedml != NULL);
+  doc = libsedml::readSedMLFromString(sedml);
+  report = static_cast<libsedml::SedReport*>(doc->getOutput(0));
+  DataGeneratorEvaluator maxevaluator;
+  fail_unless(maxevaluator.addDataGenerators(doc) == false);
+  maxevaluator.setVariableValues("time", time, 5);
+  maxevaluator.setVariableValues("S1", s1, 5);
+  stringstream maxcsv;
+  ReportWriter maxwriter(report, maxcsv, rformat_csv);
+  vector<const double*> noindices;
+  fail_unless(maxwriter.writeBlock(maxevaluator, noindices, 5) == true);
+  fail_unless(g_registry.getError().find("aggregate") != string::npos);
+  delete doc;
+  free(sedml);
+}
+END_TEST
+
+START_TEST (formula_cache)
+{
+  setWorkingDirectory(TestDataDirectory);
+  const FormulaCache& cache = g_registry.getFormulaCache();
+  size_t hits = cache.getNumHits();
+  size_t misses = cache.getNumMisses();
+  char* sedml = convertString("mod1 = model \"sbml_model.xml\"\nsim1 = simulate uniform(0,10,100)\ntask1 = run sim1 on mod1\nreport task1.S1*2, task1.S1*2, task1.S2\nplot task1.time vs task1.S1*2");
+  fail_unless(sedml != NULL);
+  string first(sedml);
+  free(sedml);
+  //The repeated formula is only parsed once.
+  fail_unless(cache.getNumHits() > hits);
+  fail_unless(cache.getNumMisses() > misses);
+  hits = cache.getNumHits();
+  misses = cache.getNumMisses();
+  //The same experiment again is converted entirely from the cache, to the same SED-ML.
+  sedml = convertString("mod1 = model \"sbml_model.xml\"\nsim1 = simulate uniform(0,10,100)\ntask1 = run sim1 on mod1\nreport task1.S1*2, task1.S1*2, task1.S2\nplot task1.time vs task1.S1*2");
+  fail_unless(sedml != NULL);
+  fail_unless(first == sedml);
+  free(sedml);
+  fail_unless(cache.getNumHits() > hits);
+  fail_unless(cache.getNumMisses() == misses);
+
+  //Once full, the formula used longest ago is dropped.
+  FormulaCache small;
+  small.setMaxSize(2);
+  libsbml::ASTNode one(libsbml::AST_INTEGER);
+  one.setValue(1);
+  small.insert("1", shared_ptr<const libsbml::ASTNode>(one.deepCopy()));
+  small.insert("2", shared_ptr<const libsbml::ASTNode>(one.deepCopy()));
+  fail_unless(small.find("1").get() != NULL);
+  small.insert("3", shared_ptr<const libsbml::ASTNode>(one.deepCopy()));
+  fail_unless(small.getSize() == 2);
+  fail_unless(small.find("2").get() == NULL);
+  fail_unless(small.find("1").get() != NULL);
+  fail_unless(small.find("3").get() != NULL);
+  fail_unless(small.getNumHits() == 3 && small.getNumMisses() == 1);
+}
+END_TEST
+
+START_TEST (output_owns_asts)
+{
+  setWorkingDirectory(TestDataDirectory);
+  char* sedml = convertString("mod1 = model \"sbml_model.xml\"\nsim1 = simulate uniform(0,10,100)\ntask1 = run sim1 on mod1\nplot task1.time vs task1.S1*2, task1.S2");
+  fail_unless(sedml != NULL);
+  free(sedml);
+  const PhrasedOutput* plot = g_registry.getOutput(0);
+  fail_unless(plot != NULL);
+  //A copy has ASTs of its own, and moving it takes them.
+  PhrasedOutput copy(*plot);
+  fail_unless(copy.getOutputVariables().size() == 2);
+  fail_unless(copy.getOutputVariables()[0][1].get() != plot->getOutputVariables()[0][1].get());
+  fail_unless(copy.getPhraSEDML() == plot->getPhraSEDML());
+  const libsbml::ASTNode* astn = copy.getOutputVariables()[0][1].get();
+  PhrasedOutput moved(std::move(copy));
+  fail_unless(moved.getOutputVariables()[0][1].get() == astn);
+  PhrasedOutput report = moved.getAsReport();
+  fail_unless(!report.isPlot());
+  fail_unless(report.getOutputVariables()[0].size() == 3);
+  fail_unless(report.getOutputVariables()[0][1].get() != astn);
+}
+END_TEST
+
 Suite *
 create_suite_Outputs (void)
 {
@@ -126,6 +304,10 @@ create_suite_Outputs (void)
   tcase_add_test( tcase, report_log_formula);
   tcase_add_test( tcase, test_00001_sbml_l3v1_sedml);
   tcase_add_test( tcase, plot_named);
+  tcase_add_test( tcase, evaluate_data_generators);
+  tcase_add_test( tcase, write_report_blocks);
+  tcase_add_test( tcase, formula_cache);
+  tcase_add_test( tcase, output_owns_asts);
 
   suite_add_tcase(suite, tcase);
 
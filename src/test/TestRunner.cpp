@@ -55,6 +55,7 @@ Suite *create_suite_Outputs(void);
 Suite *create_suite_Errors(void);
 Suite *create_suite_Saved_Models(void);
 Suite *create_suite_Kisao(void);
+Suite *create_suite_Iteration(void);
 /**
  * Global.
  *
@@ -133,6 +134,7 @@ main (int argc, char* argv[])
   srunner_add_suite( runner, create_suite_Outputs() );
   srunner_add_suite( runner, create_suite_Errors() );
   srunner_add_suite( runner, create_suite_Kisao() );
+  srunner_add_suite( runner, create_suite_Iteration() );
 
 
 #ifdef TRACE_MEMORY
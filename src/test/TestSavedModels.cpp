@@ -9,6 +9,7 @@
 #include "registry.h"
 #include "TestUtil.h"
 
+#include <memory>
 #include <string>
 #include <check.h>
 #include <iostream>
@@ -56,6 +57,85 @@ START_TEST (test_saved_model_complete)
 END_TEST
 
 
+START_TEST (test_saved_model_buffer)
+{
+  SBMLDocument doc(3,1);
+  Model* model = doc.createModel();
+  Parameter* param = model->createParameter();
+  param->setId("p1");
+  param->setConstant(true);
+  param->setValue(3);
+  model->setId("memory_model");
+
+  //Only the start of the buffer is SBML.
+  char* docstr = writeSBMLToString(&doc);
+  string buffer = string(docstr) + "<not SBML>";
+  fail_unless(setReferencedSBMLBuffer("memory_model.xml", buffer.data(), strlen(docstr)));
+  compareStringAndFileTranslation("sbml_model = model \"memory_model.xml\"", "saved_model_basic");
+
+  //Setting the same URI again replaces the document.
+  fail_unless(!setReferencedSBMLBuffer("memory_model.xml", buffer.data(), 10));
+  setWorkingDirectory(TestDataDirectory);
+  fail_unless(convertString("sbml_model = model \"memory_model.xml\"") == NULL);
+  clearReferencedSBML();
+  free(docstr);
+}
+END_TEST
+
+START_TEST (test_saved_model_buffers)
+{
+  SBMLDocument doc(3,1);
+  Model* model = doc.createModel();
+  Parameter* param = model->createParameter();
+  param->setId("p1");
+  param->setConstant(true);
+  param->setValue(3);
+  model->setId("memory_model");
+  char* docstr = writeSBMLToString(&doc);
+
+  const char* uris[] = {"memory_model.xml", "memory_model2.xml", "memory_model3.xml"};
+  const char* buffers[] = {docstr, docstr, docstr};
+  size_t lengths[] = {strlen(docstr), strlen(docstr), strlen(docstr)};
+  fail_unless(setReferencedSBMLBuffers(3, uris, buffers, lengths, true));
+  compareStringAndFileTranslation("sbml_model = model \"memory_model.xml\"", "saved_model_basic");
+  fail_unless(convertString("mod2 = model \"memory_model2.xml\" with p1=4\nmod3 = model \"memory_model3.xml\" with p1=5") != NULL);
+
+  //One bad document, and none are set.
+  lengths[0] = 10;
+  fail_unless(!setReferencedSBMLBuffers(3, uris, buffers, lengths, false));
+  fail_unless(string(getLastPhrasedError()).find("memory_model.xml") != string::npos);
+  compareStringAndFileTranslation("sbml_model = model \"memory_model.xml\"", "saved_model_basic");
+  clearReferencedSBML();
+  free(docstr);
+}
+END_TEST
+
+START_TEST (test_saved_model_document)
+{
+  shared_ptr<SBMLDocument> doc(new SBMLDocument(3,1));
+  Model* model = doc->createModel();
+  Parameter* param = model->createParameter();
+  param->setId("p1");
+  param->setConstant(true);
+  param->setValue(3);
+  model->setId("memory_model");
+
+  //The document is shared, not copied, until it is cleared.
+  setReferencedSBMLDocument("memory_model.xml", doc);
+  fail_unless(doc.use_count() == 2);
+  compareStringAndFileTranslation("sbml_model = model \"memory_model.xml\"", "saved_model_basic");
+  clearReferencedSBML();
+  fail_unless(doc.use_count() == 1);
+
+  unique_ptr<SBMLDocument> owned(doc->clone());
+  setReferencedSBMLDocument("memory_model.xml", move(owned));
+  fail_unless(owned.get() == NULL);
+  compareStringAndFileTranslation("sbml_model = model \"memory_model.xml\"", "saved_model_basic");
+  clearReferencedSBML();
+}
+END_TEST
+
+
 START_TEST (test_add_dot_xml)
 {
   SBMLDocument doc(3,1);
@@ -107,6 +187,9 @@ create_suite_Saved_Models (void)
 
   tcase_add_test( tcase, test_saved_model_basic);
   tcase_add_test( tcase, test_saved_model_complete);
+  tcase_add_test( tcase, test_saved_model_buffer);
+  tcase_add_test( tcase, test_saved_model_buffers);
+  tcase_add_test( tcase, test_saved_model_document);
   tcase_add_test( tcase, test_add_dot_xml);
 
   suite_add_tcase(suite, tcase);
@@ -7,13 +7,16 @@
 #include "libutil.h"
 #include "phrasedml_api.h"
 #include "registry.h"
+#include "editSession.h"
 #include "TestUtil.h"
 
 #include <string>
 #include <check.h>
 #include <iostream>
+#include <sstream>
 
 using namespace std;
+PHRASEDML_CPP_NAMESPACE_USE
 
 BEGIN_C_DECLS
 
@@ -116,6 +119,145 @@ START_TEST (repeatedtask_3repeats)
 }
 END_TEST
 
+START_TEST (experiment_diff)
+{
+  setWorkingDirectory(TestDataDirectory);
+  const char* before = "mod1 = model \"sbml_model.xml\"\nsim1 = simulate uniform(0,10,10)\nsim2 = simulate steadystate\ntask1 = run sim1 on mod1\ntask2 = run sim2 on mod1\ntask3 = repeat task1 for S1 in [1, 2]\nreport task1.S1\nreport task2.S1";
+  const char* after = "mod1 = model \"sbml_model.xml\"\nsim1 = simulate uniform(0,10,20)\nsim2 = simulate steadystate\ntask1 = run sim1 on mod1\ntask2 = run sim2 on mod1\ntask3 = repeat task1 for S1 in [1, 2]\nreport task1.S1\nreport task2.S1";
+  char* diff = getExperimentDiff(before, after);
+  fail_unless(diff != NULL);
+  string diffstr(diff);
+  fail_unless(diffstr.find("changed\tsimulation\tsim1\t\t\n") != string::npos);
+  fail_unless(diffstr.find("changed\ttask\ttask1\t\tsim1\n") != string::npos);
+  fail_unless(diffstr.find("changed\trepeatedTask\ttask3\t\ttask1\n") != string::npos);
+  fail_unless(diffstr.find("\ttask1\n") != diffstr.rfind("\ttask1\n"));
+  fail_unless(diffstr.find("task2") == string::npos);
+  fail_unless(diffstr.find("mod1") == string::npos);
+  free(diff);
+
+  diff = getExperimentDiff(after, "mod1 = model \"sbml_model.xml\"\nsimA = simulate uniform(0,10,20)\nsim2 = simulate steadystate\ntask1 = run simA on mod1\ntask2 = run sim2 on mod1\ntask3 = repeat task1 for S1 in [1, 2]\nreport task1.S1\nreport task2.S1");
+  fail_unless(diff != NULL);
+  fail_unless(string(diff) == "renamed\tsimulation\tsimA\tsim1\t\n");
+  free(diff);
+
+  //A change to a model changes what uses it, but renaming it changes nothing else, even the repeated task that changes it.
+  before = "mod1 = model \"sbml_model.xml\"\nmod2 = model mod1 with S1=3\nsim1 = simulate uniform(0,10,10)\ntask1 = run sim1 on mod2\ntask2 = repeat task1 for S2 in [1, 2]\nreport task1.S1";
+  diff = getExperimentDiff(before, "mod1 = model \"sbml_model.xml\"\nmod2 = model mod1 with S1=4\nsim1 = simulate uniform(0,10,10)\ntask1 = run sim1 on mod2\ntask2 = repeat task1 for S2 in [1, 2]\nreport task1.S1");
+  fail_unless(diff != NULL);
+  diffstr = diff;
+  fail_unless(diffstr.find("changed\tmodel\tmod2\t\t\n") != string::npos);
+  fail_unless(diffstr.find("changed\ttask\ttask1\t\tmod2\n") != string::npos);
+  fail_unless(diffstr.find("changed\trepeatedTask\ttask2\t\ttask1,mod2\n") != string::npos);
+  fail_unless(diffstr.find("\tmod1\t") == string::npos);
+  free(diff);
+
+  diff = getExperimentDiff(before, "mod1 = model \"sbml_model.xml\"\nmodB = model mod1 with S1=3\nsim1 = simulate uniform(0,10,10)\ntask1 = run sim1 on modB\ntask2 = repeat task1 for S2 in [1, 2]\nreport task1.S1");
+  fail_unless(diff != NULL);
+  fail_unless(string(diff) == "renamed\tmodel\tmodB\tmod2\t\n");
+  free(diff);
+
+  //Tasks with the same content are each matched to the one with the same model and simulation, not just the first.
+  before = "mod1 = model \"sbml_model.xml\"\nsim1 = simulate steadystate\nsim2 = simulate steadystate\ntask1 = run sim1 on mod1\ntask2 = run sim2 on mod1";
+  diff = getExperimentDiff(before, "mod1 = model \"sbml_model.xml\"\nsim1 = simulate steadystate\nsim2 = simulate steadystate\ntaskB = run sim2 on mod1\ntaskA = run sim1 on mod1");
+  fail_unless(diff != NULL);
+  fail_unless(string(diff) == "renamed\ttask\ttaskB\ttask2\t\nrenamed\ttask\ttaskA\ttask1\t\n");
+  free(diff);
+}
+END_TEST
+
+START_TEST (incremental_edit)
+{
+  setWorkingDirectory(TestDataDirectory);
+  PhrasedEditSession session;
+  fail_unless(!session.setText("mod1 = model \"sbml_model.xml\"\nsim1 = simulate uniform(0,10,10)\ntask1 = run sim1 on mod1\nreport task1.S1"));
+  fail_unless(session.getNumReparsed() == 4);
+
+  //The model is not parsed (or loaded) again.
+  fail_unless(!session.edit(2, 1, "sim1 = simulate uniform(0,10,20)"));
+  fail_unless(session.getNumReparsed() == 3);
+  string edited = getLastPhraSEDML();
+  string sedml = getLastSEDML();
+  fail_unless(sedml.find("numberOfPoints=\"20\"") != string::npos);
+  char* full = convertString(session.getText().c_str());
+  fail_unless(full != NULL);
+  free(full);
+  fail_unless(edited == getLastPhraSEDML());
+
+  //A failed edit is parsed in full the next time.
+  fail_unless(session.edit(3, 1, "task1 = run sim2 on mod1"));
+  fail_unless(!session.edit(2, 0, "sim2 = simulate steadystate"));
+  fail_unless(session.getNumReparsed() == 5);
+  fail_unless(session.getText() == "mod1 = model \"sbml_model.xml\"\nsim2 = simulate steadystate\nsim1 = simulate uniform(0,10,20)\ntask1 = run sim2 on mod1\nreport task1.S1");
+}
+END_TEST
+
+START_TEST (incremental_edit_warnings)
+{
+  //A model with validation errors is warned about when it is parsed, and the warning must last until it is parsed again.
+  unique_ptr<SBMLDocument> doc(new SBMLDocument(3,1));
+  Model* model = doc->createModel();
+  model->setId("invalid_model");
+  Parameter* param = model->createParameter();
+  param->setId("p1");
+  param->setConstant(true);
+  param->setValue(3);
+  doc->getErrorLog()->logError(NotSchemaConformant, 3, 1, "Invalid on purpose.");
+  setReferencedSBMLDocument("invalid_model.xml", move(doc));
+
+  PhrasedEditSession session;
+  fail_unless(!session.setText("mod1 = model \"invalid_model.xml\"\nsim1 = simulate steadystate\ntask1 = run sim1 on mod1"));
+  fail_unless(g_registry.getPhrasedWarnings().size() == 1);
+
+  fail_unless(!session.edit(2, 0, "// A comment"));
+  fail_unless(session.getNumReparsed() == 0);
+  fail_unless(g_registry.getPhrasedWarnings().size() == 1);
+
+  fail_unless(!session.edit(3, 1, "sim1 = simulate uniform(0,10,10)"));
+  fail_unless(session.getNumReparsed() == 2);
+  vector<string> warnings = g_registry.getPhrasedWarnings();
+  fail_unless(warnings.size() == 1);
+  fail_unless(warnings[0].find("invalid_model.xml") != string::npos);
+  clearReferencedSBML();
+}
+END_TEST
+
+static bool collectStatement(const char* type, const char* id, int line, const char* phrasedml, void* userData)
+{
+  vector<string>* statements = static_cast<vector<string>*>(userData);
+  stringstream statement;
+  statement << type << " " << id << " " << line;
+  statements->push_back(statement.str());
+  return (string(id) != "stop");
+}
+
+START_TEST (stream_statements)
+{
+  setWorkingDirectory(TestDataDirectory);
+  vector<string> statements;
+  fail_unless(streamPhraSEDMLString("mod1 = model \"sbml_model.xml\"\nsim1 = simulate uniform(0,10,10); sim1.algorithm = kisao.19\ntask1 = run sim1 on mod1\ntask1 is \"First task\"\n// A comment\nreport task1.S1", collectStatement, &statements));
+  fail_unless(statements.size() == 6);
+  fail_unless(statements[0] == "model mod1 1");
+  fail_unless(statements[1] == "simulation sim1 2");
+  fail_unless(statements[2] == "algorithm sim1 2");
+  fail_unless(statements[3] == "task task1 3");
+  fail_unless(statements[4] == "name task1 4");
+  fail_unless(statements[5] == "output report_0 6");
+  fail_unless(finalizeStreamedPhraSEDML());
+  fail_unless(string(getLastSEDML()).find("First task") != string::npos);
+
+  //References are only checked when finalizing.
+  statements.clear();
+  fail_unless(streamPhraSEDMLString("task1 = run sim1 on mod1", collectStatement, &statements));
+  fail_unless(statements.size() == 1);
+  fail_unless(!finalizeStreamedPhraSEDML());
+
+  statements.clear();
+  fail_unless(!streamPhraSEDMLString("mod1 = model \"sbml_model.xml\"\nstop = simulate steadystate\nsim1 = simulate steadystate", collectStatement, &statements));
+  fail_unless(statements.size() == 2);
+  fail_unless(getLastPhrasedErrorLine() == 2);
+}
+END_TEST
+
 
 Suite *
 create_suite_Tasks (void)
@@ -140,6 +282,10 @@ create_suite_Tasks (void)
   tcase_add_test( tcase, repeatedtask_assignment_with_all_variables);
   tcase_add_test( tcase, repeatedtask_two_tasks);
   tcase_add_test( tcase, repeatedtask_uniform_stoch_reset);
+  tcase_add_test( tcase, experiment_diff);
+  tcase_add_test( tcase, incremental_edit);
+  tcase_add_test( tcase, incremental_edit_warnings);
+  tcase_add_test( tcase, stream_statements);
 
   suite_add_tcase(suite, tcase);
 
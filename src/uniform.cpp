@@ -111,6 +111,15 @@ bool PhrasedUniform::setAlgorithmKisao(int kisao)
   return false;
 }
 
+//SED-ML's numberOfPoints is the number of steps, so the output includes both ends:  one more point than that.
+size_t PhrasedUniform::getNumOutputPoints() const
+{
+  if (m_numpts < 0) {
+    return 0;
+  }
+  return static_cast<size_t>(m_numpts) + 1;
+}
+
 bool PhrasedUniform::kisaoIsDefault() const
 {
   if (m_stochastic) {
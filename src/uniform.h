@@ -30,7 +30,12 @@ public:
   virtual void addSimulationToSEDML(libsedml::SedDocument* sedml) const;
   virtual bool setAlgorithmKisao(int kisao);
   virtual bool getStochastic() const {return m_stochastic;};
+  double getStart() const {return m_start;};
+  double getOutputStart() const {return m_outstart;};
+  double getEnd() const {return m_end;};
+  long getNumPoints() const {return m_numpts;};
   virtual bool kisaoIsDefault() const;
+  virtual size_t getNumOutputPoints() const;
 
   virtual bool finalize();
 
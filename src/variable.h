@@ -19,6 +19,11 @@ public:
 
   Variable(std::string id);
   Variable(libsedml::SedBase* sedbase);
+  //Declared so that elements can still be moved, as they are into (and within) the registry's vectors of them.
+  Variable(const Variable& orig) = default;
+  Variable(Variable&& orig) = default;
+  Variable& operator=(const Variable& rhs) = default;
+  Variable& operator=(Variable&& rhs) = default;
   ~Variable();
 
   void setName(std::string name);
@@ -0,0 +1,212 @@
+#include <fstream>
+
+#include "zipArchive.h"
+#include "zlib.h"
+
+using namespace std;
+
+PHRASEDML_CPP_NAMESPACE_BEGIN
+
+static const unsigned long END_SIGNATURE = 0x06054b50;
+static const unsigned long DIRECTORY_SIGNATURE = 0x02014b50;
+static const unsigned long LOCAL_SIGNATURE = 0x04034b50;
+static const size_t END_SIZE = 22;
+static const size_t DIRECTORY_SIZE = 46;
+static const size_t LOCAL_SIZE = 30;
+//The end record may be followed by a comment of up to 65535 bytes.
+static const size_t MAX_END_SEARCH = END_SIZE + 65535;
+
+//Zip files are little-endian throughout.
+static unsigned long getLittleEndian(const char* bytes, size_t size)
+{
+  unsigned long ret = 0;
+  for (size_t b=size; b>0; b--) {
+    ret = (ret << 8) | static_cast<unsigned char>(bytes[b-1]);
+  }
+  return ret;
+}
+
+ZipArchive::ZipArchive()
+  : m_filename()
+  , m_entries()
+{
+}
+
+ZipArchive::~ZipArchive()
+{
+}
+
+//Reads the archive's central directory.  Returns true on error, with the reason in 'error'.
+bool ZipArchive::open(const string& filename, string& error)
+{
+  m_filename = filename;
+  m_entries.clear();
+  ifstream file(filename.c_str(), ios::in | ios::binary);
+  if (!file.is_open()) {
+    error = "Unable to open the archive '" + filename + "'.  Check to see if the file exists and that the permissions are correct, and try again.";
+    return true;
+  }
+  file.seekg(0, ios::end);
+  size_t filesize = static_cast<size_t>(file.tellg());
+  size_t searchsize = (filesize < MAX_END_SEARCH) ? filesize : MAX_END_SEARCH;
+  vector<char> tail(searchsize);
+  file.seekg(static_cast<streamoff>(filesize - searchsize));
+  file.read(tail.empty() ? NULL : &tail[0], static_cast<streamsize>(searchsize));
+  if (static_cast<size_t>(file.gcount()) != searchsize) {
+    error = "Unable to read the archive '" + filename + "'.";
+    return true;
+  }
+
+  //The end record is the last one with its signature.
+  size_t end = string::npos;
+  for (size_t pos=searchsize; pos>=END_SIZE; pos--) {
+    if (getLittleEndian(&tail[pos-END_SIZE], 4) == END_SIGNATURE) {
+      end = pos-END_SIZE;
+      break;
+    }
+  }
+  if (end == string::npos) {
+    error = "The file '" + filename + "' is not a zip archive.";
+    return true;
+  }
+  unsigned long numEntries = getLittleEndian(&tail[end+10], 2);
+  unsigned long directorySize = getLittleEndian(&tail[end+12], 4);
+  unsigned long directoryOffset = getLittleEndian(&tail[end+16], 4);
+  if (numEntries == 0xffff || directorySize == 0xffffffff || directoryOffset == 0xffffffff) {
+    error = "The archive '" + filename + "' uses the ZIP64 format for very large archives, which is not supported.";
+    return true;
+  }
+  if (directoryOffset + directorySize > filesize) {
+    error = "The archive '" + filename + "' is truncated or corrupt.";
+    return true;
+  }
+
+  vector<char> directory(directorySize);
+  file.seekg(static_cast<streamoff>(directoryOffset));
+  file.read(directory.empty() ? NULL : &directory[0], static_cast<streamsize>(directorySize));
+  size_t pos = 0;
+  for (unsigned long e=0; e<numEntries; e++) {
+    if (pos + DIRECTORY_SIZE > directory.size() || getLittleEndian(&directory[pos], 4) != DIRECTORY_SIGNATURE) {
+      error = "The archive '" + filename + "' is truncated or corrupt.";
+      m_entries.clear();
+      return true;
+    }
+    const char* record = &directory[pos];
+    size_t namelength = getLittleEndian(record+28, 2);
+    size_t extralength = getLittleEndian(record+30, 2);
+    size_t commentlength = getLittleEndian(record+32, 2);
+    if (pos + DIRECTORY_SIZE + namelength > directory.size()) {
+      error = "The archive '" + filename + "' is truncated or corrupt.";
+      m_entries.clear();
+      return true;
+    }
+    ZipEntry entry;
+    entry.name.assign(record+DIRECTORY_SIZE, namelength);
+    entry.method = getLittleEndian(record+10, 2);
+    entry.crc = getLittleEndian(record+16, 4);
+    entry.compressedSize = getLittleEndian(record+20, 4);
+    entry.size = getLittleEndian(record+24, 4);
+    entry.offset = getLittleEndian(record+42, 4);
+    if (getLittleEndian(record+8, 2) & 1) {
+      //Encrypted:  flag it, so it can't be read.
+      entry.method = 0xffff;
+    }
+    //Directories have entries of their own, but nothing to read.
+    if (!entry.name.empty() && entry.name[entry.name.size()-1] != '/') {
+      m_entries.push_back(entry);
+    }
+    pos += DIRECTORY_SIZE + namelength + extralength + commentlength;
+  }
+  return false;
+}
+
+const string& ZipArchive::getFilename() const
+{
+  return m_filename;
+}
+
+size_t ZipArchive::getNumEntries() const
+{
+  return m_entries.size();
+}
+
+const string& ZipArchive::getEntryName(size_t entry) const
+{
+  return m_entries[entry].name;
+}
+
+//Returns the index of the entry called 'name', or string::npos if there is none.
+size_t ZipArchive::findEntry(const string& name) const
+{
+  for (size_t e=0; e<m_entries.size(); e++) {
+    if (m_entries[e].name == name) {
+      return e;
+    }
+  }
+  return string::npos;
+}
+
+//Reads and, if it was deflated, inflates one entry.  Each call opens the archive afresh, so calls from different threads don't interfere.  Returns true on error, with the reason in 'error'.
+bool ZipArchive::readEntry(size_t e, string& contents, string& error) const
+{
+  const ZipEntry& entry = m_entries[e];
+  string where = "'" + entry.name + "' in the archive '" + m_filename + "'";
+  if (entry.method != 0 && entry.method != Z_DEFLATED) {
+    error = "Unable to read " + where + ":  it is encrypted, or compressed in a way other than 'deflate'.";
+    return true;
+  }
+  ifstream file(m_filename.c_str(), ios::in | ios::binary);
+  char local[LOCAL_SIZE];
+  file.seekg(static_cast<streamoff>(entry.offset));
+  file.read(local, LOCAL_SIZE);
+  if (!file.good() || getLittleEndian(local, 4) != LOCAL_SIGNATURE) {
+    error = "Unable to read " + where + ":  the archive is truncated or corrupt.";
+    return true;
+  }
+  //The local header's own name and extra field may differ in length from the central directory's.
+  size_t skip = getLittleEndian(local+26, 2) + getLittleEndian(local+28, 2);
+  file.seekg(static_cast<streamoff>(entry.offset + LOCAL_SIZE + skip));
+  vector<char> data(entry.compressedSize);
+  file.read(data.empty() ? NULL : &data[0], static_cast<streamsize>(data.size()));
+  if (static_cast<size_t>(file.gcount()) != data.size()) {
+    error = "Unable to read " + where + ":  the archive is truncated.";
+    return true;
+  }
+
+  if (entry.method == 0) {
+    contents.assign(data.begin(), data.end());
+  }
+  else {
+    //One byte more than expected, so that an entry that inflates to more than its recorded size is caught, and so zlib always has somewhere to write to.
+    contents.resize(entry.size + 1);
+    z_stream zstream = z_stream();
+    //Negative window bits:  raw deflate data, with no zlib header.
+    if (inflateInit2(&zstream, -MAX_WBITS) != Z_OK) {
+      error = "Unable to start decompressing " + where + ".";
+      return true;
+    }
+    zstream.next_in = data.empty() ? Z_NULL : reinterpret_cast<Bytef*>(&data[0]);
+    zstream.avail_in = static_cast<uInt>(data.size());
+    zstream.next_out = reinterpret_cast<Bytef*>(&contents[0]);
+    zstream.avail_out = static_cast<uInt>(contents.size());
+    int result = inflate(&zstream, Z_FINISH);
+    bool complete = (result == Z_STREAM_END && zstream.total_out == entry.size);
+    inflateEnd(&zstream);
+    contents.resize(entry.size);
+    if (!complete) {
+      error = "Unable to decompress " + where + ":  the archive is corrupt.";
+      return true;
+    }
+  }
+  unsigned long crc = crc32(0L, Z_NULL, 0);
+  if (!contents.empty()) {
+    crc = crc32(crc, reinterpret_cast<const Bytef*>(contents.data()), static_cast<uInt>(contents.size()));
+  }
+  if (crc != entry.crc) {
+    error = "Unable to read " + where + ":  its contents do not match its checksum, so the archive is corrupt.";
+    return true;
+  }
+  return false;
+}
+
+PHRASEDML_CPP_NAMESPACE_END
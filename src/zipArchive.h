@@ -0,0 +1,44 @@
+#ifndef PHRASEDZIPARCHIVE_H
+#define PHRASEDZIPARCHIVE_H
+
+#include <string>
+#include <vector>
+
+#include "phrasedml-namespace.h"
+
+PHRASEDML_CPP_NAMESPACE_BEGIN
+
+//Where one file is in a zip archive, and how it was stored.
+struct ZipEntry
+{
+  std::string name;
+  unsigned int method;
+  unsigned long crc;
+  unsigned long compressedSize;
+  unsigned long size;
+  unsigned long offset;
+};
+
+//A zip archive, read in place.  Only the central directory is read when it is opened; each entry is read (and inflated, if need be) only when asked for.  Entries may be read from several threads at once.
+class ZipArchive
+{
+private:
+  std::string m_filename;
+  std::vector<ZipEntry> m_entries;
+
+public:
+  ZipArchive();
+  ~ZipArchive();
+
+  bool open(const std::string& filename, std::string& error);
+
+  const std::string& getFilename() const;
+  size_t getNumEntries() const;
+  const std::string& getEntryName(size_t entry) const;
+  size_t findEntry(const std::string& name) const;
+  bool readEntry(size_t entry, std::string& contents, std::string& error) const;
+};
+
+PHRASEDML_CPP_NAMESPACE_END
+
+#endif //PHRASEDZIPARCHIVE_H